@@ -0,0 +1,134 @@
+/**
+ * @file heap_tracer.h
+ * @brief 轻量级堆分配跟踪和碎片化趋势记录
+ * @author TidyCraze
+ * @date 2025-10-18
+ *
+ * 分配跟踪基于 IDF 的堆钩子（CONFIG_HEAP_USE_HOOKS），运行时开关，关闭时钩子只做一次判断。
+ * 开启后记录每次分配的调用位置、大小、内存类型，释放时统计存活时间，按调用位置汇总，
+ * 用于找出长时间运行后的泄漏和碎片来源。调用位置是 PC 地址，用 addr2line 对照 elf 解析。
+ *
+ * 碎片化趋势与跟踪开关无关，初始化后按固定周期分别记录内部RAM和PSRAM的空闲量、最大空闲块和历史最低空闲。
+ */
+
+#ifndef HEAP_TRACER_H
+#define HEAP_TRACER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define HEAP_TRACER_MAX_LIVE 512          // 同时跟踪的存活分配数，须为2的幂
+#define HEAP_TRACER_MAX_SITES 48          // 汇总的调用位置数
+#define HEAP_TRACER_TREND_PERIOD_MS 30000 // 碎片化趋势采样周期
+#define HEAP_TRACER_TREND_SAMPLES 120     // 趋势环形缓冲区长度（默认周期下为1小时）
+
+// 内存类型
+typedef enum {
+    HEAP_TRACER_MEM_INTERNAL = 0,
+    HEAP_TRACER_MEM_PSRAM,
+    HEAP_TRACER_MEM_MAX
+} heap_tracer_mem_t;
+
+// 存活时间直方图分桶
+typedef enum {
+    HEAP_TRACER_LIFE_10MS = 0, // < 10ms
+    HEAP_TRACER_LIFE_100MS,    // < 100ms
+    HEAP_TRACER_LIFE_1S,       // < 1s
+    HEAP_TRACER_LIFE_10S,      // < 10s
+    HEAP_TRACER_LIFE_60S,      // < 60s
+    HEAP_TRACER_LIFE_LONG,     // >= 60s
+    HEAP_TRACER_LIFE_MAX
+} heap_tracer_life_t;
+
+// 一个调用位置的汇总
+typedef struct {
+    uintptr_t site;   // 第一个不在堆分配器内的调用者
+    uintptr_t parent; // site 的调用者
+    heap_tracer_mem_t mem;
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t live_bytes;
+    uint32_t peak_live_bytes;
+    uint32_t max_size;
+    uint64_t total_bytes;
+} heap_tracer_site_t;
+
+// 一次碎片化采样
+typedef struct {
+    uint32_t timestamp_s;
+    uint32_t free_bytes;
+    uint32_t largest_block;
+    uint32_t min_free; // 启动以来的最低空闲
+} heap_tracer_trend_t;
+
+/**
+ * @brief 输出回调，每次一行（不含换行）
+ */
+typedef void (*heap_tracer_out_t)(const char* line, void* ctx);
+
+/**
+ * @brief 初始化并启动碎片化趋势采样，启动时调用一次
+ * @return ESP_OK 成功
+ */
+esp_err_t heap_tracer_init(void);
+
+/**
+ * @brief 开始跟踪分配（清空之前的统计）
+ * @return ESP_OK 成功；ESP_ERR_NOT_SUPPORTED 未开启 CONFIG_HEAP_USE_HOOKS
+ */
+esp_err_t heap_tracer_start(void);
+
+/**
+ * @brief 停止跟踪，保留统计供 dump 查看
+ */
+void heap_tracer_stop(void);
+
+/**
+ * @brief 是否正在跟踪
+ */
+bool heap_tracer_is_running(void);
+
+/**
+ * @brief 获取按存活字节降序排列的调用位置
+ * @return 写入的条目数
+ */
+size_t heap_tracer_get_sites(heap_tracer_site_t* out, size_t max);
+
+/**
+ * @brief 获取存活时间直方图
+ * @param mem 内存类型
+ * @param out 输出 HEAP_TRACER_LIFE_MAX 个计数
+ */
+void heap_tracer_get_lifetimes(heap_tracer_mem_t mem, uint32_t* out);
+
+/**
+ * @brief 获取碎片化趋势（从旧到新）
+ * @return 写入的点数
+ */
+size_t heap_tracer_get_trend(heap_tracer_mem_t mem, heap_tracer_trend_t* out, size_t max);
+
+/**
+ * @brief 输出分配跟踪结果：调用位置、存活时间直方图
+ * @param out 输出回调，NULL 时写日志
+ * @param max_sites 最多输出的调用位置数
+ */
+void heap_tracer_dump(heap_tracer_out_t out, void* ctx, size_t max_sites);
+
+/**
+ * @brief 输出内部RAM和PSRAM的碎片化趋势
+ * @param out 输出回调，NULL 时写日志
+ * @param max_points 每种内存最多输出的点数（取最近的）
+ */
+void heap_tracer_dump_trend(heap_tracer_out_t out, void* ctx, size_t max_points);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HEAP_TRACER_H
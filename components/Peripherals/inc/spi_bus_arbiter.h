@@ -0,0 +1,101 @@
+/**
+ * @file spi_bus_arbiter.h
+ * @brief SPI2 总线仲裁 (ST7789 显示与 XPT2046 触摸共用)
+ * @author Your Name
+ * @date 2024
+ */
+
+#ifndef SPI_BUS_ARBITER_H
+#define SPI_BUS_ARBITER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+// ========================================
+// 总线客户端 (数值越小优先级越高)
+// ========================================
+typedef enum {
+    SPI_BUS_CLIENT_TOUCH = 0,   // 触摸：单次短事务，要求低延迟
+    SPI_BUS_CLIENT_DISPLAY,     // 显示：长时间DMA流，在分块边界让出总线
+    SPI_BUS_CLIENT_MAX,
+} spi_bus_client_t;
+
+// ========================================
+// 统计数据
+// ========================================
+typedef struct {
+    uint32_t acquires;      // 获取总线次数
+    uint32_t contended;     // 需要等待的次数
+    uint32_t timeouts;      // 等待超时次数
+    uint32_t yields;        // 因其他客户端等待而让出总线的次数
+    uint64_t total_wait_us; // 累计等待时间
+    uint32_t max_wait_us;   // 最大等待时间
+    uint64_t total_hold_us; // 累计占用时间
+    uint32_t max_hold_us;   // 最大单次占用时间
+} spi_bus_arbiter_stats_t;
+
+/**
+ * 总线调度策略：
+ * - 总线空闲时直接获得；被占用时登记等待，持有者释放时直接交给优先级最高的等待者
+ * - 显示在每个DMA分块边界调用 spi_bus_arbiter_should_yield()，有等待者就排空在途事务后让出，
+ *   因此触摸的等待时间上限约为一个DMA流水线 (队列深度 x 分块) 的传输时间
+ * - 触摸每次只持有一个事务，显示的等待时间上限为一次触摸采样
+ */
+
+/**
+ * @brief 初始化仲裁器 (可重复调用)
+ * @return ESP_OK 成功
+ */
+esp_err_t spi_bus_arbiter_init(void);
+
+/**
+ * @brief 获取总线
+ * @param client 客户端
+ * @param timeout 最长等待时间
+ * @return ESP_OK 成功, ESP_ERR_TIMEOUT 超时
+ */
+esp_err_t spi_bus_arbiter_acquire(spi_bus_client_t client, TickType_t timeout);
+
+/**
+ * @brief 释放总线，可在中断中调用
+ * @param client 客户端
+ */
+void spi_bus_arbiter_release(spi_bus_client_t client);
+
+/**
+ * @brief 是否有其他客户端在等待总线 (持有者在安全点调用)
+ */
+bool spi_bus_arbiter_should_yield(spi_bus_client_t client);
+
+/**
+ * @brief 让出总线给等待者，等待者用完后重新获得
+ * @param client 当前持有者
+ */
+void spi_bus_arbiter_yield(spi_bus_client_t client);
+
+/**
+ * @brief 获取统计数据
+ */
+void spi_bus_arbiter_get_stats(spi_bus_client_t client, spi_bus_arbiter_stats_t *stats);
+
+/**
+ * @brief 清零统计数据
+ */
+void spi_bus_arbiter_reset_stats(void);
+
+/**
+ * @brief 打印所有客户端的统计数据
+ */
+void spi_bus_arbiter_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPI_BUS_ARBITER_H */
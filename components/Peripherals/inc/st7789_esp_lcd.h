@@ -103,6 +103,16 @@ extern "C" {
 #define ST7789_CYAN             0x07FF
 #define ST7789_MAGENTA          0xF81F
 
+// ========================================
+// 数据结构定义
+// ========================================
+
+/**
+ * @brief 颜色数据DMA传输完成回调 (中断通知后在驱动的传输完成任务中调用，不应长时间阻塞)
+ * @param user_ctx 注册时传入的用户参数
+ */
+typedef void (*st7789_esp_lcd_trans_done_cb_t)(void *user_ctx);
+
 // ========================================
 // 函数声明
 // ========================================
@@ -206,6 +216,14 @@ esp_err_t st7789_esp_lcd_power_enable(bool enable);
  */
 esp_err_t st7789_esp_lcd_set_rotation(int rotation);
 
+/**
+ * @brief 注册颜色数据传输完成回调
+ * @note esp_lcd_panel_draw_bitmap() 只负责排队DMA事务，调用方需等待该回调后才能复用像素缓冲区
+ * @param cb 回调函数，传NULL取消注册
+ * @param user_ctx 回调用户参数
+ */
+void st7789_esp_lcd_register_trans_done_cb(st7789_esp_lcd_trans_done_cb_t cb, void *user_ctx);
+
 /**
  * @brief 获取LCD面板句柄 (供LVGL使用)
  * @return LCD面板句柄
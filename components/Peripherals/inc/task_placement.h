@@ -0,0 +1,167 @@
+/**
+ * @file task_placement.h
+ * @brief 任务布局表 - 按任务名集中配置核、优先级、栈大小和栈内存类型
+ * @author TidyCraze
+ * @date 2025-10-18
+ *
+ * 所有任务都通过 task_placement_create() 创建，不再在各处写死 xTaskCreatePinnedToCore 的参数。
+ * 布局分两套方案：
+ *  - control：默认方案，遥控输入、遥测和UI响应优先，图传流水线让路
+ *  - video：图传方案，接收和解码流水线优先，解码独占 Core 1 与 LVGL 分时
+ * 开机即创建的常驻任务在两套方案中核相同、只有优先级不同，因此切换方案时可以直接调整
+ * 正在运行任务的优先级；按需创建的任务（图传、遥测、串口等）下次创建时使用新方案的核。
+ * 两套方案的具体数值目前只是按设计意图给出的初始估计，还没有在硬件上测量过，
+ * 需用 task_placement_bench 和栈统计实测后再修改布局表。
+ *
+ * 栈大小调优：每个表内任务的栈历史最小剩余由 task_placement_note_stack() 汇总（task_profiler
+ * 每次采样时调用，接收端可用 task_placement_sample_stacks()），task_placement_log_stacks()
+ * 按实际用量加余量给出推荐栈大小，可直接粘贴回布局表。
+ *
+ * PSRAM栈：不使用DMA、不在栈上放ISR访问的数据、不执行Flash写操作（NVS等）的任务可以把栈放到PSRAM，
+ * 为DMA缓冲区腾出内部RAM。这类任务必须用 task_placement_delete() 删除（内部调用 vTaskDeleteWithCaps）。
+ */
+
+#ifndef TASK_PLACEMENT_H
+#define TASK_PLACEMENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TASK_PLACEMENT_ANY_CORE (-1) // 不绑定核
+
+// 是否允许任务栈放在PSRAM，关闭后布局表中的PSRAM栈全部退回内部RAM
+#ifndef TASK_PLACEMENT_PSRAM_STACKS
+#if CONFIG_SPIRAM && CONFIG_FREERTOS_TASK_CREATE_ALLOW_EXT_MEM
+#define TASK_PLACEMENT_PSRAM_STACKS 1
+#else
+#define TASK_PLACEMENT_PSRAM_STACKS 0
+#endif
+#endif
+
+#define TASK_PLACEMENT_STACK_MARGIN_PCT 25  // 推荐栈大小 = 实际用量 + 余量
+#define TASK_PLACEMENT_STACK_MIN_MARGIN 512 // 余量下限 (字节)
+#define TASK_PLACEMENT_STACK_ALIGN 256      // 推荐栈大小向上取整
+#define TASK_PLACEMENT_STACK_MIN 2048       // 推荐栈大小下限（含日志输出）
+
+// 布局方案
+typedef enum {
+    TASK_PROFILE_CONTROL = 0, // 控制优先（默认）
+    TASK_PROFILE_VIDEO,       // 图传优先
+    TASK_PROFILE_MAX
+} task_profile_t;
+
+// 单个任务的布局
+typedef struct {
+    int8_t core;         // 0/1 或 TASK_PLACEMENT_ANY_CORE
+    uint8_t priority;    // FreeRTOS 优先级
+    uint32_t stack_size; // 栈大小 (字节)
+    uint32_t stack_caps; // 栈内存能力，MALLOC_CAP_INTERNAL 或 MALLOC_CAP_SPIRAM
+} task_placement_t;
+
+/**
+ * @brief 从 NVS 读取上次选择的方案（需在 NVS 初始化之后调用，之前使用默认方案）
+ */
+void task_placement_load_profile(void);
+
+/**
+ * @brief 切换方案并保存到 NVS
+ * 正在运行的表内任务立即调整优先级；核的变化对之后创建的任务生效。
+ * @param profile 方案
+ * @return ESP_OK 成功
+ */
+esp_err_t task_placement_set_profile(task_profile_t profile);
+
+/**
+ * @brief 当前方案
+ */
+task_profile_t task_placement_get_profile(void);
+
+/**
+ * @brief 方案名称
+ */
+const char* task_placement_profile_name(task_profile_t profile);
+
+/**
+ * @brief 查询任务在当前方案下的布局，表中没有的任务返回默认布局
+ * @param name 任务名
+ */
+const task_placement_t* task_placement_get(const char* name);
+
+/**
+ * @brief 按布局表创建任务
+ * @param fn 任务函数
+ * @param name 任务名（同时作为布局表的键）
+ * @param arg 任务参数
+ * @param handle 输出任务句柄，可为NULL
+ * @return pdPASS 成功
+ */
+BaseType_t task_placement_create(TaskFunction_t fn, const char* name, void* arg, TaskHandle_t* handle);
+
+/**
+ * @brief 按布局表创建任务，允许调用者覆盖栈大小和优先级（对外接口带这两个参数的模块使用）
+ * @param stack_size 栈大小，0 表示使用布局表
+ * @param priority 优先级，0 表示使用布局表
+ */
+BaseType_t task_placement_create_ex(TaskFunction_t fn, const char* name, void* arg, uint32_t stack_size,
+                                    UBaseType_t priority, TaskHandle_t* handle);
+
+/**
+ * @brief 删除由 task_placement_create() 创建的任务，PSRAM栈的任务使用 vTaskDeleteWithCaps
+ * 删除前记录一次栈的历史最小剩余。
+ * @param handle 任务句柄，NULL 表示删除调用者自身
+ */
+void task_placement_delete(TaskHandle_t handle);
+
+/**
+ * @brief 打印当前方案的布局表
+ */
+void task_placement_log(void);
+
+// 单个任务的栈用量统计
+typedef struct {
+    const char* name;
+    uint32_t stack_size;  // 最近一次创建时的栈大小
+    uint32_t min_free;    // 历次运行中栈的最小剩余
+    uint32_t recommended; // 推荐栈大小
+    bool psram;           // 最近一次创建时栈是否在PSRAM
+} task_placement_stack_stat_t;
+
+/**
+ * @brief 记录任务栈的历史最小剩余，不在表中或未通过布局表创建的任务忽略
+ * @param name 任务名
+ * @param stack_free uxTaskGetStackHighWaterMark 的结果 (字节)
+ */
+void task_placement_note_stack(const char* name, uint32_t stack_free);
+
+/**
+ * @brief 遍历当前所有任务，记录栈的历史最小剩余（没有运行 task_profiler 时使用）
+ */
+void task_placement_sample_stacks(void);
+
+/**
+ * @brief 获取已观察到的任务栈用量
+ * @param out 输出数组
+ * @param max 数组容量
+ * @return 写入的条目数
+ */
+size_t task_placement_get_stack_stats(task_placement_stack_stat_t* out, size_t max);
+
+/**
+ * @brief 打印栈用量和推荐栈大小，以及按推荐值调整后可节省的内部RAM
+ */
+void task_placement_log_stacks(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TASK_PLACEMENT_H
@@ -100,6 +100,13 @@ esp_err_t xpt2046_deinit(void);
  */
 esp_err_t xpt2046_read_raw(xpt2046_data_t *data);
 
+/**
+ * @brief 单次快速采样（一次SPI传输读取X/Y/Z1/Z2，不滤波）
+ * @param data 输出的触摸数据，pressed由压力阈值判断
+ * @return ESP_OK 成功
+ */
+esp_err_t xpt2046_read_sample(xpt2046_data_t *data);
+
 /**
  * @brief 读取校准后的触摸坐标
  * @param x 输出X坐标 (屏幕像素坐标)
@@ -0,0 +1,486 @@
+/**
+ * @file heap_tracer.c
+ * @brief 轻量级堆分配跟踪和碎片化趋势记录实现
+ * @author TidyCraze
+ * @date 2025-10-18
+ *
+ * 钩子在分配器内调用，不能再分配内存也不能写日志；跟踪表在开启时一次性从内部RAM分配，
+ * 用线性探测哈希表按指针查找存活分配。调用位置通过回溯栈帧取得第一个位于 Flash 代码段的 PC，
+ * 分配器本身（heap_caps、newlib malloc）位于 IRAM，因此会被跳过。
+ */
+
+#include "heap_tracer.h"
+#include "esp_attr.h"
+#include "esp_debug_helpers.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_memory_utils.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "soc/soc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* TAG = "HEAP_TRACER";
+
+#define HEAP_TRACER_WALK_DEPTH 12 // 查找调用位置时最多回溯的栈帧数
+#define SITE_NONE 0xFF
+
+// 一个存活的分配
+typedef struct {
+    uintptr_t ptr; // 0 表示空槽
+    uint32_t size;
+    uint32_t time_ms;
+    uint8_t site; // s_state->sites 下标，SITE_NONE 表示调用位置表已满
+    uint8_t mem;
+} live_entry_t;
+
+// 跟踪状态，开启时从内部RAM分配
+typedef struct {
+    live_entry_t live[HEAP_TRACER_MAX_LIVE];
+    heap_tracer_site_t sites[HEAP_TRACER_MAX_SITES];
+    uint32_t site_count;
+    uint32_t lifetimes[HEAP_TRACER_MEM_MAX][HEAP_TRACER_LIFE_MAX];
+    uint32_t live_count;
+    uint32_t live_bytes[HEAP_TRACER_MEM_MAX];
+    uint32_t traced;    // 已记录的分配次数
+    uint32_t untracked; // 存活表已满而未记录的分配次数
+    uint32_t no_site;   // 调用位置表已满的分配次数
+    uint32_t start_ms;
+} tracer_state_t;
+
+static tracer_state_t* s_state = NULL;
+static volatile bool s_enabled = false;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// 碎片化趋势（PSRAM）
+static heap_tracer_trend_t* s_trend[HEAP_TRACER_MEM_MAX] = {NULL};
+static uint32_t s_trend_head = 0;
+static uint32_t s_trend_count = 0;
+static esp_timer_handle_t s_trend_timer = NULL;
+
+static const char* const s_mem_names[HEAP_TRACER_MEM_MAX] = {"internal", "psram"};
+static const char* const s_life_names[HEAP_TRACER_LIFE_MAX] = {"<10ms", "<100ms", "<1s", "<10s", "<60s", ">=60s"};
+
+static inline uint32_t IRAM_ATTR hash_ptr(uintptr_t ptr) {
+    return (uint32_t)((ptr >> 3) ^ (ptr >> 13)) & (HEAP_TRACER_MAX_LIVE - 1);
+}
+
+// 栈上保存的返回地址高两位是窗口大小，还原为指向调用指令的地址
+static inline uintptr_t IRAM_ATTR frame_pc(uint32_t pc) {
+    if (pc & 0x80000000) {
+        pc = (pc & 0x3fffffff) | 0x40000000;
+    }
+    return pc - 3;
+}
+
+static inline bool IRAM_ATTR pc_in_flash(uintptr_t pc) { return pc >= SOC_IROM_LOW && pc < SOC_IROM_HIGH; }
+
+// 回溯到第一个 Flash 中的调用者作为调用位置
+static void IRAM_ATTR find_call_site(uintptr_t* site, uintptr_t* parent) {
+    *site = 0;
+    *parent = 0;
+    esp_backtrace_frame_t frame = {0};
+    esp_backtrace_get_start(&frame.pc, &frame.sp, &frame.next_pc);
+
+    for (int depth = 0; depth < HEAP_TRACER_WALK_DEPTH && esp_backtrace_get_next_frame(&frame); depth++) {
+        uintptr_t pc = frame_pc(frame.pc);
+        if (*site == 0) {
+            if (pc_in_flash(pc)) {
+                *site = pc;
+            }
+        } else {
+            *parent = pc;
+            return;
+        }
+        if (frame.next_pc == 0) {
+            return;
+        }
+    }
+}
+
+static uint8_t IRAM_ATTR find_or_add_site(uintptr_t site, uintptr_t parent, uint8_t mem) {
+    for (uint32_t i = 0; i < s_state->site_count; i++) {
+        heap_tracer_site_t* s = &s_state->sites[i];
+        if (s->site == site && s->parent == parent && s->mem == mem) {
+            return (uint8_t)i;
+        }
+    }
+    if (s_state->site_count >= HEAP_TRACER_MAX_SITES) {
+        return SITE_NONE;
+    }
+    heap_tracer_site_t* s = &s_state->sites[s_state->site_count];
+    memset(s, 0, sizeof(*s));
+    s->site = site;
+    s->parent = parent;
+    s->mem = (heap_tracer_mem_t)mem;
+    return (uint8_t)s_state->site_count++;
+}
+
+static heap_tracer_life_t IRAM_ATTR life_bucket(uint32_t ms) {
+    if (ms < 10) {
+        return HEAP_TRACER_LIFE_10MS;
+    } else if (ms < 100) {
+        return HEAP_TRACER_LIFE_100MS;
+    } else if (ms < 1000) {
+        return HEAP_TRACER_LIFE_1S;
+    } else if (ms < 10000) {
+        return HEAP_TRACER_LIFE_10S;
+    } else if (ms < 60000) {
+        return HEAP_TRACER_LIFE_60S;
+    }
+    return HEAP_TRACER_LIFE_LONG;
+}
+
+#if CONFIG_HEAP_USE_HOOKS
+
+// IDF 堆钩子：每次分配成功后调用
+void IRAM_ATTR esp_heap_trace_alloc_hook(void* ptr, size_t size, uint32_t caps) {
+    (void)caps;
+    if (!s_enabled || ptr == NULL) {
+        return;
+    }
+
+    uintptr_t site, parent;
+    find_call_site(&site, &parent);
+    uint8_t mem = esp_ptr_external_ram(ptr) ? HEAP_TRACER_MEM_PSRAM : HEAP_TRACER_MEM_INTERNAL;
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+
+    portENTER_CRITICAL_SAFE(&s_lock);
+    if (s_state == NULL) {
+        portEXIT_CRITICAL_SAFE(&s_lock);
+        return;
+    }
+    s_state->traced++;
+    if (s_state->live_count >= HEAP_TRACER_MAX_LIVE * 3 / 4) {
+        // 保持哈希表负载，超出的分配不跟踪
+        s_state->untracked++;
+        portEXIT_CRITICAL_SAFE(&s_lock);
+        return;
+    }
+
+    uint8_t site_index = find_or_add_site(site, parent, mem);
+    if (site_index == SITE_NONE) {
+        s_state->no_site++;
+    } else {
+        heap_tracer_site_t* s = &s_state->sites[site_index];
+        s->allocs++;
+        s->total_bytes += size;
+        s->live_bytes += size;
+        if (s->live_bytes > s->peak_live_bytes) {
+            s->peak_live_bytes = s->live_bytes;
+        }
+        if (size > s->max_size) {
+            s->max_size = size;
+        }
+    }
+
+    uint32_t i = hash_ptr((uintptr_t)ptr);
+    while (s_state->live[i].ptr != 0) {
+        i = (i + 1) & (HEAP_TRACER_MAX_LIVE - 1);
+    }
+    s_state->live[i] = (live_entry_t){
+        .ptr = (uintptr_t)ptr,
+        .size = size,
+        .time_ms = now_ms,
+        .site = site_index,
+        .mem = mem,
+    };
+    s_state->live_count++;
+    s_state->live_bytes[mem] += size;
+    portEXIT_CRITICAL_SAFE(&s_lock);
+}
+
+// IDF 堆钩子：每次释放前调用
+void IRAM_ATTR esp_heap_trace_free_hook(void* ptr) {
+    if (!s_enabled || ptr == NULL) {
+        return;
+    }
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+
+    portENTER_CRITICAL_SAFE(&s_lock);
+    if (s_state == NULL) {
+        portEXIT_CRITICAL_SAFE(&s_lock);
+        return;
+    }
+
+    uint32_t i = hash_ptr((uintptr_t)ptr);
+    while (s_state->live[i].ptr != 0 && s_state->live[i].ptr != (uintptr_t)ptr) {
+        i = (i + 1) & (HEAP_TRACER_MAX_LIVE - 1);
+    }
+    if (s_state->live[i].ptr == 0) {
+        // 跟踪开始前的分配
+        portEXIT_CRITICAL_SAFE(&s_lock);
+        return;
+    }
+
+    live_entry_t* e = &s_state->live[i];
+    s_state->lifetimes[e->mem][life_bucket(now_ms - e->time_ms)]++;
+    s_state->live_bytes[e->mem] -= e->size;
+    s_state->live_count--;
+    if (e->site != SITE_NONE) {
+        heap_tracer_site_t* s = &s_state->sites[e->site];
+        s->frees++;
+        s->live_bytes -= e->size;
+    }
+
+    // 线性探测的删除：把后面同一探测链上的条目前移，保持查找不中断
+    uint32_t hole = i;
+    uint32_t j = i;
+    while (true) {
+        j = (j + 1) & (HEAP_TRACER_MAX_LIVE - 1);
+        if (s_state->live[j].ptr == 0) {
+            break;
+        }
+        uint32_t home = hash_ptr(s_state->live[j].ptr);
+        // home 不在 (hole, j] 循环区间内时才能前移
+        bool in_range = (hole <= j) ? (home > hole && home <= j) : (home > hole || home <= j);
+        if (!in_range) {
+            s_state->live[hole] = s_state->live[j];
+            hole = j;
+        }
+    }
+    s_state->live[hole].ptr = 0;
+    portEXIT_CRITICAL_SAFE(&s_lock);
+}
+
+#endif // CONFIG_HEAP_USE_HOOKS
+
+static void trend_sample(void* arg) {
+    (void)arg;
+    const uint32_t caps[HEAP_TRACER_MEM_MAX] = {MALLOC_CAP_INTERNAL, MALLOC_CAP_SPIRAM};
+    heap_tracer_trend_t point[HEAP_TRACER_MEM_MAX];
+    uint32_t now_s = (uint32_t)(esp_timer_get_time() / 1000000);
+
+    for (int m = 0; m < HEAP_TRACER_MEM_MAX; m++) {
+        multi_heap_info_t info;
+        heap_caps_get_info(&info, caps[m]);
+        point[m] = (heap_tracer_trend_t){
+            .timestamp_s = now_s,
+            .free_bytes = info.total_free_bytes,
+            .largest_block = info.largest_free_block,
+            .min_free = info.minimum_free_bytes,
+        };
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    for (int m = 0; m < HEAP_TRACER_MEM_MAX; m++) {
+        s_trend[m][s_trend_head] = point[m];
+    }
+    s_trend_head = (s_trend_head + 1) % HEAP_TRACER_TREND_SAMPLES;
+    if (s_trend_count < HEAP_TRACER_TREND_SAMPLES) {
+        s_trend_count++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+esp_err_t heap_tracer_init(void) {
+    if (s_trend_timer != NULL) {
+        return ESP_OK;
+    }
+
+    for (int m = 0; m < HEAP_TRACER_MEM_MAX; m++) {
+        s_trend[m] = heap_caps_calloc(HEAP_TRACER_TREND_SAMPLES, sizeof(heap_tracer_trend_t), MALLOC_CAP_SPIRAM);
+        if (s_trend[m] == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate trend buffer");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = trend_sample,
+        .name = "heap_trend",
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &s_trend_timer);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    trend_sample(NULL);
+    ret = esp_timer_start_periodic(s_trend_timer, (uint64_t)HEAP_TRACER_TREND_PERIOD_MS * 1000);
+    ESP_LOGI(TAG, "Heap trend sampling every %d s", HEAP_TRACER_TREND_PERIOD_MS / 1000);
+    return ret;
+}
+
+esp_err_t heap_tracer_start(void) {
+#if CONFIG_HEAP_USE_HOOKS
+    if (s_enabled) {
+        return ESP_OK;
+    }
+
+    // 先分配再开启，自身的分配不会被记录
+    tracer_state_t* state = s_state;
+    if (state == NULL) {
+        state = heap_caps_malloc(sizeof(tracer_state_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (state == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate trace table (%u bytes)", (unsigned)sizeof(tracer_state_t));
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    memset(state, 0, sizeof(*state));
+    state->start_ms = (uint32_t)(esp_timer_get_time() / 1000);
+
+    portENTER_CRITICAL(&s_lock);
+    s_state = state;
+    s_enabled = true;
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "Allocation tracing started (%u bytes internal RAM)", (unsigned)sizeof(tracer_state_t));
+    return ESP_OK;
+#else
+    ESP_LOGW(TAG, "Allocation tracing needs CONFIG_HEAP_USE_HOOKS");
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void heap_tracer_stop(void) {
+    // 保留跟踪表，下次 start 时复用
+    s_enabled = false;
+    ESP_LOGI(TAG, "Allocation tracing stopped");
+}
+
+bool heap_tracer_is_running(void) { return s_enabled; }
+
+size_t heap_tracer_get_sites(heap_tracer_site_t* out, size_t max) {
+    if (out == NULL || s_state == NULL) {
+        return 0;
+    }
+
+    size_t n = 0;
+    portENTER_CRITICAL(&s_lock);
+    for (uint32_t i = 0; i < s_state->site_count && n < max; i++) {
+        out[n++] = s_state->sites[i];
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    // 按存活字节降序，其次按累计分配字节
+    for (size_t i = 1; i < n; i++) {
+        heap_tracer_site_t key = out[i];
+        size_t j = i;
+        while (j > 0 && (out[j - 1].live_bytes < key.live_bytes ||
+                         (out[j - 1].live_bytes == key.live_bytes && out[j - 1].total_bytes < key.total_bytes))) {
+            out[j] = out[j - 1];
+            j--;
+        }
+        out[j] = key;
+    }
+    return n;
+}
+
+void heap_tracer_get_lifetimes(heap_tracer_mem_t mem, uint32_t* out) {
+    if (out == NULL || mem >= HEAP_TRACER_MEM_MAX) {
+        return;
+    }
+    memset(out, 0, sizeof(uint32_t) * HEAP_TRACER_LIFE_MAX);
+    if (s_state == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    memcpy(out, s_state->lifetimes[mem], sizeof(uint32_t) * HEAP_TRACER_LIFE_MAX);
+    portEXIT_CRITICAL(&s_lock);
+}
+
+size_t heap_tracer_get_trend(heap_tracer_mem_t mem, heap_tracer_trend_t* out, size_t max) {
+    if (out == NULL || mem >= HEAP_TRACER_MEM_MAX || s_trend[mem] == NULL) {
+        return 0;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    size_t n = s_trend_count < max ? s_trend_count : max;
+    // 取最近的 n 个点，从旧到新
+    uint32_t start = (s_trend_head + HEAP_TRACER_TREND_SAMPLES - n) % HEAP_TRACER_TREND_SAMPLES;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = s_trend[mem][(start + i) % HEAP_TRACER_TREND_SAMPLES];
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return n;
+}
+
+static void out_line(heap_tracer_out_t out, void* ctx, const char* line) {
+    if (out) {
+        out(line, ctx);
+    } else {
+        ESP_LOGI(TAG, "%s", line);
+    }
+}
+
+void heap_tracer_dump(heap_tracer_out_t out, void* ctx, size_t max_sites) {
+    char line[128];
+    if (s_state == NULL) {
+        out_line(out, ctx, "Heap trace: never started");
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    uint32_t traced = s_state->traced;
+    uint32_t untracked = s_state->untracked;
+    uint32_t no_site = s_state->no_site;
+    uint32_t live_count = s_state->live_count;
+    uint32_t live_internal = s_state->live_bytes[HEAP_TRACER_MEM_INTERNAL];
+    uint32_t live_psram = s_state->live_bytes[HEAP_TRACER_MEM_PSRAM];
+    uint32_t start_ms = s_state->start_ms;
+    portEXIT_CRITICAL(&s_lock);
+
+    snprintf(line, sizeof(line), "Heap trace %s, %lu s: %lu allocs, %lu untracked, %lu without site",
+             s_enabled ? "running" : "stopped", (unsigned long)((esp_timer_get_time() / 1000 - start_ms) / 1000),
+             (unsigned long)traced, (unsigned long)untracked, (unsigned long)no_site);
+    out_line(out, ctx, line);
+    snprintf(line, sizeof(line), "Live: %lu blocks, internal %lu B, psram %lu B", (unsigned long)live_count,
+             (unsigned long)live_internal, (unsigned long)live_psram);
+    out_line(out, ctx, line);
+
+    heap_tracer_site_t* sites = heap_caps_malloc(sizeof(heap_tracer_site_t) * HEAP_TRACER_MAX_SITES, MALLOC_CAP_SPIRAM);
+    if (sites != NULL) {
+        size_t n = heap_tracer_get_sites(sites, HEAP_TRACER_MAX_SITES);
+        out_line(out, ctx, "site:parent            mem      allocs   frees   live_B   peak_B    max_B");
+        for (size_t i = 0; i < n && i < max_sites; i++) {
+            const heap_tracer_site_t* s = &sites[i];
+            snprintf(line, sizeof(line), "0x%08lx:0x%08lx %-8s %7lu %7lu %8lu %8lu %8lu", (unsigned long)s->site,
+                     (unsigned long)s->parent, s_mem_names[s->mem], (unsigned long)s->allocs,
+                     (unsigned long)s->frees, (unsigned long)s->live_bytes, (unsigned long)s->peak_live_bytes,
+                     (unsigned long)s->max_size);
+            out_line(out, ctx, line);
+        }
+        free(sites);
+    }
+
+    for (int m = 0; m < HEAP_TRACER_MEM_MAX; m++) {
+        uint32_t life[HEAP_TRACER_LIFE_MAX];
+        heap_tracer_get_lifetimes((heap_tracer_mem_t)m, life);
+        int len = snprintf(line, sizeof(line), "Lifetime %s:", s_mem_names[m]);
+        for (int b = 0; b < HEAP_TRACER_LIFE_MAX && len < (int)sizeof(line); b++) {
+            len += snprintf(line + len, sizeof(line) - len, " %s %lu", s_life_names[b], (unsigned long)life[b]);
+        }
+        out_line(out, ctx, line);
+    }
+}
+
+void heap_tracer_dump_trend(heap_tracer_out_t out, void* ctx, size_t max_points) {
+    char line[96];
+    heap_tracer_trend_t* points = heap_caps_malloc(sizeof(heap_tracer_trend_t) * HEAP_TRACER_TREND_SAMPLES,
+                                                   MALLOC_CAP_SPIRAM);
+    if (points == NULL) {
+        return;
+    }
+    if (max_points > HEAP_TRACER_TREND_SAMPLES) {
+        max_points = HEAP_TRACER_TREND_SAMPLES;
+    }
+
+    for (int m = 0; m < HEAP_TRACER_MEM_MAX; m++) {
+        size_t n = heap_tracer_get_trend((heap_tracer_mem_t)m, points, max_points);
+        snprintf(line, sizeof(line), "Heap trend %s (%u points):", s_mem_names[m], (unsigned)n);
+        out_line(out, ctx, line);
+        out_line(out, ctx, "    t_s     free  largest frag%  min_free");
+        for (size_t i = 0; i < n; i++) {
+            const heap_tracer_trend_t* p = &points[i];
+            // 碎片率：空闲内存中不能作为最大块使用的比例
+            uint32_t frag = p->free_bytes ? 100 - (uint32_t)((uint64_t)p->largest_block * 100 / p->free_bytes) : 0;
+            snprintf(line, sizeof(line), "%7lu %8lu %8lu %5lu %9lu", (unsigned long)p->timestamp_s,
+                     (unsigned long)p->free_bytes, (unsigned long)p->largest_block, (unsigned long)frag,
+                     (unsigned long)p->min_free);
+            out_line(out, ctx, line);
+        }
+    }
+    free(points);
+}
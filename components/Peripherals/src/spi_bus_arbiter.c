@@ -0,0 +1,236 @@
+/**
+ * @file spi_bus_arbiter.c
+ * @brief SPI2 总线仲裁实现
+ * @author Your Name
+ * @date 2024
+ */
+
+#include "spi_bus_arbiter.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char *TAG = "SPI_ARBITER";
+
+#define SPI_BUS_OWNER_NONE SPI_BUS_CLIENT_MAX
+
+// ========================================
+// 私有变量
+// ========================================
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t s_grant_sem[SPI_BUS_CLIENT_MAX];   // 交接总线时通知等待者
+static volatile spi_bus_client_t s_owner = SPI_BUS_OWNER_NONE;
+static volatile uint32_t s_pending = 0;                     // 等待中的客户端位图
+static int64_t s_wait_start_us[SPI_BUS_CLIENT_MAX];
+static int64_t s_hold_start_us[SPI_BUS_CLIENT_MAX];
+static spi_bus_arbiter_stats_t s_stats[SPI_BUS_CLIENT_MAX];
+static bool s_initialized = false;
+
+static const char *const s_client_names[SPI_BUS_CLIENT_MAX] = {
+    [SPI_BUS_CLIENT_TOUCH] = "touch",
+    [SPI_BUS_CLIENT_DISPLAY] = "display",
+};
+
+// ========================================
+// 私有函数
+// ========================================
+
+/* 在临界区内记录一次获得总线 */
+static void record_grant(spi_bus_client_t client, int64_t wait_start_us, int64_t now_us)
+{
+    spi_bus_arbiter_stats_t *st = &s_stats[client];
+    uint32_t wait_us = (uint32_t)(now_us - wait_start_us);
+    st->acquires++;
+    st->total_wait_us += wait_us;
+    if (wait_us > st->max_wait_us) {
+        st->max_wait_us = wait_us;
+    }
+    s_hold_start_us[client] = now_us;
+}
+
+// ========================================
+// 公共函数实现
+// ========================================
+
+esp_err_t spi_bus_arbiter_init(void)
+{
+    if (s_initialized) {
+        return ESP_OK;
+    }
+
+    for (int i = 0; i < SPI_BUS_CLIENT_MAX; i++) {
+        s_grant_sem[i] = xSemaphoreCreateBinary();
+        if (s_grant_sem[i] == NULL) {
+            ESP_LOGE(TAG, "Failed to create grant semaphore");
+            for (int j = 0; j < i; j++) {
+                vSemaphoreDelete(s_grant_sem[j]);
+                s_grant_sem[j] = NULL;
+            }
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    s_owner = SPI_BUS_OWNER_NONE;
+    s_pending = 0;
+    memset(s_stats, 0, sizeof(s_stats));
+    s_initialized = true;
+
+    ESP_LOGI(TAG, "SPI bus arbiter initialized");
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_arbiter_acquire(spi_bus_client_t client, TickType_t timeout)
+{
+    if (!s_initialized || client >= SPI_BUS_CLIENT_MAX) {
+        return ESP_OK; // 未启用仲裁时不限制访问，由SPI驱动自身的总线锁保证正确性
+    }
+
+    int64_t start_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_owner == SPI_BUS_OWNER_NONE) {
+        s_owner = client;
+        record_grant(client, start_us, start_us);
+        portEXIT_CRITICAL(&s_lock);
+        return ESP_OK;
+    }
+    s_pending |= (1UL << client);
+    s_wait_start_us[client] = start_us;
+    s_stats[client].contended++;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (xSemaphoreTake(s_grant_sem[client], timeout) == pdTRUE) {
+        return ESP_OK; // 释放者已把总线交给本客户端并记录统计
+    }
+
+    // 超时：若恰好在超时后被交接，则仍视为成功
+    portENTER_CRITICAL(&s_lock);
+    bool granted = (s_owner == client);
+    if (!granted) {
+        s_pending &= ~(1UL << client);
+        s_stats[client].timeouts++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (granted) {
+        // 释放者在临界区内改了 s_owner，信号量在退出临界区后才给出，可能还没到；
+        // 必须等它到达并取走，否则会残留一个令牌让下次等待立即误判为已获得总线
+        xSemaphoreTake(s_grant_sem[client], portMAX_DELAY);
+        return ESP_OK;
+    }
+    return ESP_ERR_TIMEOUT;
+}
+
+void spi_bus_arbiter_release(spi_bus_client_t client)
+{
+    if (!s_initialized || client >= SPI_BUS_CLIENT_MAX) {
+        return;
+    }
+
+    bool in_isr = xPortInIsrContext();
+    int64_t now_us = esp_timer_get_time();
+    spi_bus_client_t next = SPI_BUS_OWNER_NONE;
+
+    if (in_isr) {
+        portENTER_CRITICAL_ISR(&s_lock);
+    } else {
+        portENTER_CRITICAL(&s_lock);
+    }
+
+    if (s_owner == client) {
+        spi_bus_arbiter_stats_t *st = &s_stats[client];
+        uint32_t hold_us = (uint32_t)(now_us - s_hold_start_us[client]);
+        st->total_hold_us += hold_us;
+        if (hold_us > st->max_hold_us) {
+            st->max_hold_us = hold_us;
+        }
+
+        // 直接交给优先级最高的等待者，避免被释放者立即重新抢占
+        for (int i = 0; i < SPI_BUS_CLIENT_MAX; i++) {
+            if (s_pending & (1UL << i)) {
+                next = (spi_bus_client_t)i;
+                break;
+            }
+        }
+        if (next != SPI_BUS_OWNER_NONE) {
+            s_pending &= ~(1UL << next);
+            s_owner = next;
+            record_grant(next, s_wait_start_us[next], now_us);
+        } else {
+            s_owner = SPI_BUS_OWNER_NONE;
+        }
+    }
+
+    if (in_isr) {
+        portEXIT_CRITICAL_ISR(&s_lock);
+    } else {
+        portEXIT_CRITICAL(&s_lock);
+    }
+
+    if (next != SPI_BUS_OWNER_NONE) {
+        if (in_isr) {
+            BaseType_t need_yield = pdFALSE;
+            xSemaphoreGiveFromISR(s_grant_sem[next], &need_yield);
+            if (need_yield) {
+                portYIELD_FROM_ISR();
+            }
+        } else {
+            xSemaphoreGive(s_grant_sem[next]);
+        }
+    }
+}
+
+bool spi_bus_arbiter_should_yield(spi_bus_client_t client)
+{
+    if (!s_initialized || client >= SPI_BUS_CLIENT_MAX) {
+        return false;
+    }
+    return (s_pending & ~(1UL << client)) != 0;
+}
+
+void spi_bus_arbiter_yield(spi_bus_client_t client)
+{
+    if (!s_initialized || client >= SPI_BUS_CLIENT_MAX) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_stats[client].yields++;
+    portEXIT_CRITICAL(&s_lock);
+
+    spi_bus_arbiter_release(client);
+    spi_bus_arbiter_acquire(client, portMAX_DELAY);
+}
+
+void spi_bus_arbiter_get_stats(spi_bus_client_t client, spi_bus_arbiter_stats_t *stats)
+{
+    if (stats == NULL || client >= SPI_BUS_CLIENT_MAX) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_stats[client];
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void spi_bus_arbiter_reset_stats(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    memset(s_stats, 0, sizeof(s_stats));
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void spi_bus_arbiter_log_stats(void)
+{
+    for (int i = 0; i < SPI_BUS_CLIENT_MAX; i++) {
+        spi_bus_arbiter_stats_t st;
+        spi_bus_arbiter_get_stats((spi_bus_client_t)i, &st);
+        uint32_t avg_wait = st.acquires ? (uint32_t)(st.total_wait_us / st.acquires) : 0;
+        uint32_t avg_hold = st.acquires ? (uint32_t)(st.total_hold_us / st.acquires) : 0;
+        ESP_LOGI(TAG, "%-7s acq=%lu contended=%lu timeout=%lu yield=%lu wait avg/max=%lu/%lu us hold avg/max=%lu/%lu us",
+                 s_client_names[i], (unsigned long)st.acquires, (unsigned long)st.contended,
+                 (unsigned long)st.timeouts, (unsigned long)st.yields, (unsigned long)avg_wait,
+                 (unsigned long)st.max_wait_us, (unsigned long)avg_hold, (unsigned long)st.max_hold_us);
+    }
+}
@@ -6,6 +6,7 @@
  */
 
 #include "st7789.h"
+#include "spi_bus_arbiter.h"
 #include "esp_log.h"
 #include "esp_err.h"
 #include "freertos/FreeRTOS.h"
@@ -58,9 +59,11 @@ static esp_err_t st7789_spi_init(void)
         .max_transfer_sz = ST7789_WIDTH * ST7789_HEIGHT * 2,  // 整屏大小
     };
     
-    // 初始化SPI总线
+    // 初始化SPI总线 (总线可能已由ESP-LCD驱动初始化，切换驱动时直接复用)
     ret = spi_bus_initialize(ST7789_SPI_HOST, &bus_config, SPI_DMA_CH_AUTO);
-    if (ret != ESP_OK) {
+    if (ret == ESP_ERR_INVALID_STATE) {
+        ESP_LOGI(TAG, "SPI bus already initialized, reusing it");
+    } else if (ret != ESP_OK) {
         ESP_LOGE(TAG, "SPI bus initialize failed: %s", esp_err_to_name(ret));
         return ret;
     }
@@ -82,6 +85,9 @@ static esp_err_t st7789_spi_init(void)
         spi_bus_free(ST7789_SPI_HOST);
         return ret;
     }
+
+    // 与XPT2046共用总线，像素流在分块边界让出总线给触摸
+    spi_bus_arbiter_init();
     
     ESP_LOGI(TAG, "SPI initialized successfully");
     return ESP_OK;
@@ -216,6 +222,18 @@ static void st7789_write_data_buf(const uint8_t *data, size_t length)
 #define ST7789_DMA_QUEUE_DEPTH 4      // 队列深度4（四缓冲流水线）
 static uint8_t *s_dma_buf[ST7789_DMA_QUEUE_DEPTH] = {0};
 
+/* 取回所有在途事务 */
+static void st7789_drain_trans(bool *in_use, int *queued)
+{
+    while (*queued > 0) {
+        spi_transaction_t *ret_trans;
+        spi_device_get_trans_result(g_st7789_handle.spi_handle, &ret_trans, portMAX_DELAY);
+        int freed = (int)(uintptr_t)ret_trans->user;
+        if (freed >= 0 && freed < ST7789_DMA_QUEUE_DEPTH) in_use[freed] = false;
+        (*queued)--;
+    }
+}
+
 static void st7789_write_bytes_async(const uint8_t *data, size_t size)
 {
     if (size == 0) return;
@@ -254,6 +272,14 @@ static void st7789_write_bytes_async(const uint8_t *data, size_t size)
             queued--;
         }
 
+        // 分块边界 (刚空出一个slot)：触摸在等待总线时排空在途事务并让出，
+        // 触摸等待时间不超过一个流水线 (队列深度 x 分块) 的传输时间
+        if (spi_bus_arbiter_should_yield(SPI_BUS_CLIENT_DISPLAY)) {
+            st7789_drain_trans(in_use, &queued);
+            spi_bus_arbiter_yield(SPI_BUS_CLIENT_DISPLAY);
+            gpio_set_level(ST7789_PIN_DC, 1);
+        }
+
         // 找到一个空闲slot
         int slot = -1;
         for (int i = 0; i < ST7789_DMA_QUEUE_DEPTH; i++) {
@@ -303,13 +329,7 @@ static void st7789_write_bytes_async(const uint8_t *data, size_t size)
     }
 
     // 取回所有剩余事务
-    while (queued > 0) {
-        spi_transaction_t *ret_trans;
-        spi_device_get_trans_result(g_st7789_handle.spi_handle, &ret_trans, portMAX_DELAY);
-        int freed = (int)(uintptr_t)ret_trans->user;
-        if (freed >= 0 && freed < ST7789_DMA_QUEUE_DEPTH) in_use[freed] = false;
-        queued--;
-    }
+    st7789_drain_trans(in_use, &queued);
 }
 
 /**
@@ -480,7 +500,7 @@ esp_err_t st7789_deinit(void)
     st7789_set_backlight(0);
     st7789_power_enable(false);  // 关闭电源
     
-    // 释放SPI设备
+    // 释放SPI设备 (XPT2046仍挂在总线上时spi_bus_free会失败，此时保留总线)
     spi_bus_remove_device(g_st7789_handle.spi_handle);
     spi_bus_free(ST7789_SPI_HOST);
     
@@ -527,8 +547,10 @@ void st7789_write_pixels(const uint16_t *data, size_t length)
     if (data == NULL || length == 0) {
         return;
     }
-    // 零转换路径 + 异步DMA流水线
+    // 零转换路径 + 异步DMA流水线，整个像素流期间持有总线
+    spi_bus_arbiter_acquire(SPI_BUS_CLIENT_DISPLAY, portMAX_DELAY);
     st7789_write_bytes_async((const uint8_t *)data, length * 2);
+    spi_bus_arbiter_release(SPI_BUS_CLIENT_DISPLAY);
 }
 
 /**
@@ -6,6 +6,10 @@
  */
 
 #include "st7789_esp_lcd.h"
+#include "spi_bus_arbiter.h"
+#include "task_placement.h"
+#include "xpt2046.h"
+#include "esp_attr.h"
 #include "esp_err.h"
 #include "esp_heap_caps.h"
 #include "esp_log.h"
@@ -24,6 +28,12 @@ static esp_lcd_panel_handle_t panel_handle = NULL;
 static esp_lcd_panel_io_handle_t io_handle = NULL;
 static bool is_initialized = false;
 
+// 颜色数据传输完成回调：中断里只通知完成任务，回调在任务上下文中执行
+// (回调链路上的 lv_disp_flush_ready、总线仲裁等都在Flash中，不能在IRAM中断里调用)
+static st7789_esp_lcd_trans_done_cb_t s_trans_done_cb = NULL;
+static void* s_trans_done_ctx = NULL;
+static TaskHandle_t s_trans_done_task = NULL;
+
 // ========================================
 // 私有函数声明
 // ========================================
@@ -31,6 +41,8 @@ static esp_err_t st7789_esp_lcd_gpio_init(void);
 static esp_err_t st7789_esp_lcd_spi_init(void);
 static void st7789_esp_lcd_hardware_reset(void);
 static esp_err_t st7789_esp_lcd_init_sequence(void);
+static bool st7789_esp_lcd_on_color_trans_done(esp_lcd_panel_io_handle_t panel_io,
+                                               esp_lcd_panel_io_event_data_t* edata, void* user_ctx);
 
 // ========================================
 // ST7789初始化序列数据
@@ -132,6 +144,30 @@ static esp_err_t st7789_esp_lcd_gpio_init(void) {
     return ESP_OK;
 }
 
+// ========================================
+// DMA传输完成中断回调
+// ========================================
+static bool IRAM_ATTR st7789_esp_lcd_on_color_trans_done(esp_lcd_panel_io_handle_t panel_io,
+                                                         esp_lcd_panel_io_event_data_t* edata, void* user_ctx) {
+    BaseType_t need_yield = pdFALSE;
+    if (s_trans_done_task) {
+        vTaskNotifyGiveFromISR(s_trans_done_task, &need_yield);
+    }
+    return need_yield == pdTRUE;
+}
+
+// 传输完成任务：每次中断通知执行一次回调。常驻，切换驱动时不删除
+static void st7789_esp_lcd_trans_done_task(void* arg) {
+    (void)arg;
+    while (1) {
+        ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+        st7789_esp_lcd_trans_done_cb_t cb = s_trans_done_cb;
+        if (cb) {
+            cb(s_trans_done_ctx);
+        }
+    }
+}
+
 // ========================================
 // SPI初始化
 // ========================================
@@ -141,16 +177,18 @@ static esp_err_t st7789_esp_lcd_spi_init(void) {
     // SPI总线配置 - 使用PSRAM
     spi_bus_config_t bus_config = {
         .mosi_io_num = ST7789_PIN_MOSI,
-        .miso_io_num = -1, // ST7789不需要MISO
+        .miso_io_num = XPT2046_PIN_MISO, // ST7789不需要MISO，但XPT2046共享此总线
         .sclk_io_num = ST7789_PIN_CLK,
         .quadwp_io_num = -1,
         .quadhd_io_num = -1,
         .max_transfer_sz = ST7789_WIDTH * 40 * 2, // 减小传输大小，避免内存不足
     };
 
-    // 初始化SPI总线
+    // 初始化SPI总线 (总线可能已由原始驱动初始化，切换驱动时直接复用)
     ret = spi_bus_initialize(ST7789_SPI_HOST, &bus_config, SPI_DMA_CH_AUTO);
-    if (ret != ESP_OK) {
+    if (ret == ESP_ERR_INVALID_STATE) {
+        ESP_LOGI(TAG, "SPI bus already initialized, reusing it");
+    } else if (ret != ESP_OK) {
         ESP_LOGE(TAG, "SPI bus initialize failed: %s", esp_err_to_name(ret));
         return ret;
     }
@@ -164,7 +202,7 @@ static esp_err_t st7789_esp_lcd_spi_init(void) {
         .lcd_param_bits = 8,
         .spi_mode = 0,
         .trans_queue_depth = 5, // 减小队列深度，节省内存
-        .on_color_trans_done = NULL,
+        .on_color_trans_done = st7789_esp_lcd_on_color_trans_done, // 整块颜色数据发送完成后通知上层
         .user_ctx = NULL,
     };
 
@@ -174,6 +212,9 @@ static esp_err_t st7789_esp_lcd_spi_init(void) {
         return ret;
     }
 
+    // 与XPT2046共用总线，由上层在整块颜色数据传输期间持有总线
+    spi_bus_arbiter_init();
+
     // LCD面板配置
     esp_lcd_panel_dev_config_t panel_config = {
         .reset_gpio_num = ST7789_PIN_RST,
@@ -238,6 +279,13 @@ esp_err_t st7789_esp_lcd_init(void) {
 
     ESP_LOGI(TAG, "Initializing ST7789 with ESP-LCD component");
 
+    // 传输完成回调在此任务中执行，需在第一次传输前创建
+    if (s_trans_done_task == NULL &&
+        task_placement_create(st7789_esp_lcd_trans_done_task, "lcd_trans_done", NULL, &s_trans_done_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create transfer done task");
+        return ESP_ERR_NO_MEM;
+    }
+
     // 初始化GPIO
     ret = st7789_esp_lcd_gpio_init();
     if (ret != ESP_OK) {
@@ -332,7 +380,7 @@ esp_err_t st7789_esp_lcd_deinit(void) {
         io_handle = NULL;
     }
 
-    // 释放SPI总线
+    // 释放SPI总线 (XPT2046仍挂在总线上时会失败，此时保留总线)
     spi_bus_free(ST7789_SPI_HOST);
 
     is_initialized = false;
@@ -487,6 +535,11 @@ esp_err_t st7789_esp_lcd_set_rotation(int rotation) {
     return ret;
 }
 
+void st7789_esp_lcd_register_trans_done_cb(st7789_esp_lcd_trans_done_cb_t cb, void* user_ctx) {
+    s_trans_done_ctx = user_ctx;
+    s_trans_done_cb = cb;
+}
+
 esp_lcd_panel_handle_t st7789_esp_lcd_get_panel_handle(void) { return panel_handle; }
 
 esp_lcd_panel_io_handle_t st7789_esp_lcd_get_panel_io_handle(void) { return io_handle; }
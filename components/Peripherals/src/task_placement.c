@@ -0,0 +1,337 @@
+/**
+ * @file task_placement.c
+ * @brief 任务布局表实现
+ * @author TidyCraze
+ * @date 2025-10-18
+ */
+
+#include "task_placement.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_memory_utils.h"
+#include "nvs.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* TAG = "TASK_PLACEMENT";
+
+#define TASK_PLACEMENT_NVS_NAMESPACE "task_plan"
+#define TASK_PLACEMENT_NVS_KEY "profile"
+
+// 内部RAM栈的布局
+#define PLACE(core, prio, stack) {(core), (prio), (stack), MALLOC_CAP_INTERNAL}
+// PSRAM栈的布局，仅用于不碰DMA、ISR和Flash写操作的任务
+#define PLACE_EXT(core, prio, stack) {(core), (prio), (stack), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT}
+#define ANY TASK_PLACEMENT_ANY_CORE
+
+// 布局表的一行：任务名和它在每个方案下的布局
+typedef struct {
+    const char* name;
+    task_placement_t profile[TASK_PROFILE_MAX];
+} task_placement_row_t;
+
+// ==================== 布局表 ====================
+// WiFi驱动任务固定在 Core 0（优先级23），lwIP 任务不绑定（优先级18），esp_timer 在 Core 0。
+// 常驻任务两套方案核相同；图传和遥测等按需任务在 video 方案中重新分核。
+// 注意：下表的核、优先级和栈大小是按任务职责估计的初始值，尚未在硬件上测量验证，不是调好的方案。
+// 调整时在测试页运行布局对比测试（task_placement_bench）比较两套方案的解码和界面帧率，
+// 栈大小按 task_placement_log_stacks() 的推荐值修改，并在提交中附上测得的数据。
+static const task_placement_row_t s_table[] = {
+    //  任务名              control                    video
+    // --- 界面和输入（常驻）---
+    {"LVGL_Main",        {PLACE(1, 8, 12288),      PLACE(1, 7, 12288)}},
+    {"Touch_Sampler",    {PLACE(0, 6, 3072),       PLACE(0, 6, 3072)}},
+    {"lcd_trans_done",   {PLACE(1, 9, 2048),       PLACE(1, 8, 2048)}}, // 高于LVGL，尽快释放总线和刷新缓冲
+    {"Joystick_ADC",     {PLACE(0, 5, 4096),       PLACE(0, 4, 4096)}},
+    {"Power_Mgmt",       {PLACE(0, 2, 4096),       PLACE(0, 2, 4096)}},
+    {"Sys_Monitor",      {PLACE(0, 2, 2048),       PLACE(0, 2, 2048)}},
+    {"WiFi_Manager",     {PLACE(0, 5, 4096),       PLACE(0, 4, 4096)}},
+    {"Battery_Monitor",  {PLACE(0, 2, 4096),       PLACE(0, 2, 4096)}},
+    {"Background_Mgr",   {PLACE(0, 2, 4096),       PLACE(0, 2, 4096)}},
+    {"Svc_Lifecycle",    {PLACE(0, 2, 4096),       PLACE(0, 2, 4096)}},
+    {"task_profiler",    {PLACE_EXT(0, 2, 4096),   PLACE_EXT(0, 2, 4096)}},
+    {"Boot_Init",        {PLACE(1, 1, 4096),       PLACE(1, 1, 4096)}},
+    // --- 按需服务 ---
+    {"lsm6ds3_control",  {PLACE(0, 5, 4096),       PLACE(0, 4, 4096)}},
+    {"audio_server",     {PLACE_EXT(1, 5, 4096),   PLACE_EXT(1, 3, 4096)}},
+    {"audio_receive",    {PLACE(0, 5, 4096),       PLACE(0, 3, 4096)}},
+    {"i2s_playback",     {PLACE(1, 5, 4096),       PLACE(1, 3, 4096)}},
+    {"mic_capture",      {PLACE(1, 5, 4096),       PLACE(1, 3, 4096)}},
+    {"serial_task",      {PLACE(1, 4, 4096),       PLACE(1, 3, 4096)}},
+    {"serial_server",    {PLACE_EXT(1, 4, 4096),   PLACE_EXT(1, 3, 4096)}},
+    {"ui_display_task",  {PLACE(ANY, 3, 4096),     PLACE(ANY, 3, 4096)}},
+    {"telemetry_server", {PLACE_EXT(0, 5, 4096),   PLACE_EXT(0, 4, 4096)}},
+    {"telemetry_data",   {PLACE_EXT(0, 6, 4096),   PLACE_EXT(0, 5, 4096)}},
+    {"test_task",        {PLACE(ANY, 5, 4096),     PLACE(ANY, 5, 4096)}},
+    // --- 图传接收和解码（遥控器端）---
+    {"udp_rx",           {PLACE_EXT(0, 4, 8192),   PLACE_EXT(0, 8, 8192)}},
+    {"udp_tx",           {PLACE_EXT(0, 4, 4096),   PLACE_EXT(0, 4, 4096)}},
+    {"tcp_recv",         {PLACE_EXT(0, 4, 8192),   PLACE_EXT(0, 8, 8192)}},
+    {"jpeg_decode",      {PLACE(0, 4, 8192),       PLACE(1, 8, 8192)}},
+    // --- 接收端采集和编码 ---
+    {"spi_rx",           {PLACE(1, 5, 4096),       PLACE(1, 10, 4096)}},
+    {"usb_rx",           {PLACE(1, 4, 4096),       PLACE(1, 8, 4096)}},
+    {"jpeg_feed",        {PLACE(1, 5, 8192),       PLACE(1, 9, 8192)}},
+    {"jpeg_enc",         {PLACE(0, 5, 8192),       PLACE(0, 9, 8192)}}, // 与 jpeg_feed 分核，编码和拼帧并行
+    {"jpeg_hfm",         {PLACE(1, 6, 0),          PLACE(1, 10, 0)}}, // esp_new_jpeg 内部哈夫曼任务，栈由编码器决定
+    {"vout_udp",         {PLACE_EXT(0, 5, 4096),   PLACE_EXT(0, 8, 4096)}},
+    {"vout_tcp",         {PLACE_EXT(0, 5, 4096),   PLACE_EXT(0, 8, 4096)}},
+    {"vout_usb",         {PLACE(0, 4, 4096),       PLACE(0, 7, 4096)}},
+    {"tcp_task",         {PLACE(0, 6, 8192),       PLACE(0, 5, 8192)}},
+    {"tcp_hb",           {PLACE_EXT(0, 6, 4096),   PLACE_EXT(0, 5, 4096)}},
+    {"tcp_telemetry",    {PLACE_EXT(0, 6, 4096),   PLACE_EXT(0, 5, 4096)}},
+    {"wifi_scan",        {PLACE(ANY, 3, 4096),     PLACE(ANY, 3, 4096)}},
+    {"led_manager",      {PLACE(ANY, 2, 2048),     PLACE(ANY, 2, 2048)}},
+};
+
+#define TABLE_SIZE (sizeof(s_table) / sizeof(s_table[0]))
+
+static const task_placement_t s_default_placement = PLACE(ANY, 5, 4096);
+static const char* const s_profile_names[TASK_PROFILE_MAX] = {"control", "video"};
+
+static task_profile_t s_profile = TASK_PROFILE_CONTROL;
+
+// 每行的运行时统计
+typedef struct {
+    uint32_t stack_size; // 最近一次创建时的栈大小，0 表示还没有通过布局表创建过
+    uint32_t min_free;   // 历次运行中栈的最小剩余
+    bool psram;
+} task_stack_track_t;
+
+static task_stack_track_t s_track[TABLE_SIZE];
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static int find_row_index(const char* name) {
+    if (name == NULL) {
+        return -1;
+    }
+    for (size_t i = 0; i < TABLE_SIZE; i++) {
+        if (strcmp(s_table[i].name, name) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static const task_placement_row_t* find_row(const char* name) {
+    int index = find_row_index(name);
+    return index >= 0 ? &s_table[index] : NULL;
+}
+
+static uint32_t recommend_stack(uint32_t used) {
+    uint32_t margin = used * TASK_PLACEMENT_STACK_MARGIN_PCT / 100;
+    if (margin < TASK_PLACEMENT_STACK_MIN_MARGIN) {
+        margin = TASK_PLACEMENT_STACK_MIN_MARGIN;
+    }
+    uint32_t size = (used + margin + TASK_PLACEMENT_STACK_ALIGN - 1) / TASK_PLACEMENT_STACK_ALIGN * TASK_PLACEMENT_STACK_ALIGN;
+    return size < TASK_PLACEMENT_STACK_MIN ? TASK_PLACEMENT_STACK_MIN : size;
+}
+
+void task_placement_load_profile(void) {
+    nvs_handle_t nvs;
+    if (nvs_open(TASK_PLACEMENT_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        ESP_LOGI(TAG, "Using default task profile: %s", s_profile_names[s_profile]);
+        return;
+    }
+
+    uint8_t value = 0;
+    if (nvs_get_u8(nvs, TASK_PLACEMENT_NVS_KEY, &value) == ESP_OK && value < TASK_PROFILE_MAX) {
+        s_profile = (task_profile_t)value;
+    }
+    nvs_close(nvs);
+    ESP_LOGI(TAG, "Task profile: %s", s_profile_names[s_profile]);
+}
+
+esp_err_t task_placement_set_profile(task_profile_t profile) {
+    if (profile >= TASK_PROFILE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_profile = profile;
+
+    // 正在运行的任务立即调整优先级（核在创建后无法更改）
+    for (size_t i = 0; i < TABLE_SIZE; i++) {
+        if (strlen(s_table[i].name) >= configMAX_TASK_NAME_LEN) {
+            continue;
+        }
+        TaskHandle_t handle = xTaskGetHandle(s_table[i].name);
+        if (handle != NULL) {
+            vTaskPrioritySet(handle, s_table[i].profile[profile].priority);
+        }
+    }
+
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(TASK_PLACEMENT_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret == ESP_OK) {
+        ret = nvs_set_u8(nvs, TASK_PLACEMENT_NVS_KEY, (uint8_t)profile);
+        if (ret == ESP_OK) {
+            ret = nvs_commit(nvs);
+        }
+        nvs_close(nvs);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to save task profile: %s", esp_err_to_name(ret));
+    }
+
+    ESP_LOGI(TAG, "Switched to task profile: %s", s_profile_names[profile]);
+    return ESP_OK;
+}
+
+task_profile_t task_placement_get_profile(void) { return s_profile; }
+
+const char* task_placement_profile_name(task_profile_t profile) {
+    return profile < TASK_PROFILE_MAX ? s_profile_names[profile] : "unknown";
+}
+
+const task_placement_t* task_placement_get(const char* name) {
+    const task_placement_row_t* row = find_row(name);
+    if (row == NULL) {
+        ESP_LOGW(TAG, "Task %s not in placement table, using defaults", name ? name : "(null)");
+        return &s_default_placement;
+    }
+    return &row->profile[s_profile];
+}
+
+BaseType_t task_placement_create_ex(TaskFunction_t fn, const char* name, void* arg, uint32_t stack_size,
+                                    UBaseType_t priority, TaskHandle_t* handle) {
+    const task_placement_t* placement = task_placement_get(name);
+    uint32_t stack = stack_size > 0 ? stack_size : placement->stack_size;
+    UBaseType_t prio = priority > 0 ? priority : placement->priority;
+    BaseType_t core = placement->core == TASK_PLACEMENT_ANY_CORE ? tskNO_AFFINITY : placement->core;
+
+    BaseType_t result = pdFAIL;
+    bool psram = false;
+    TaskHandle_t created = NULL;
+#if TASK_PLACEMENT_PSRAM_STACKS
+    if (placement->stack_caps & MALLOC_CAP_SPIRAM) {
+        result = xTaskCreatePinnedToCoreWithCaps(fn, name, stack, arg, prio, &created, core, placement->stack_caps);
+        psram = (result == pdPASS);
+        if (!psram) {
+            ESP_LOGW(TAG, "PSRAM stack unavailable for %s, using internal RAM", name);
+        }
+    }
+#endif
+    if (result != pdPASS) {
+        result = xTaskCreatePinnedToCore(fn, name, stack, arg, prio, &created, core);
+    }
+
+    if (result != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create task %s (stack %lu, prio %u, core %d)", name, (unsigned long)stack,
+                 (unsigned)prio, placement->core);
+        return result;
+    }
+
+    if (handle) {
+        *handle = created;
+    }
+    int index = find_row_index(name);
+    if (index >= 0) {
+        taskENTER_CRITICAL(&s_lock);
+        // 栈大小改变后之前的最小剩余不再可比
+        if (s_track[index].stack_size != stack) {
+            s_track[index].min_free = UINT32_MAX;
+        }
+        s_track[index].stack_size = stack;
+        s_track[index].psram = psram;
+        taskEXIT_CRITICAL(&s_lock);
+    }
+    ESP_LOGD(TAG, "Created %s: stack %lu (%s), prio %u, core %d", name, (unsigned long)stack,
+             psram ? "psram" : "internal", (unsigned)prio, placement->core);
+    return result;
+}
+
+BaseType_t task_placement_create(TaskFunction_t fn, const char* name, void* arg, TaskHandle_t* handle) {
+    return task_placement_create_ex(fn, name, arg, 0, 0, handle);
+}
+
+void task_placement_delete(TaskHandle_t handle) {
+    if (handle == NULL) {
+        handle = xTaskGetCurrentTaskHandle();
+    }
+    task_placement_note_stack(pcTaskGetName(handle), uxTaskGetStackHighWaterMark(handle));
+
+#if TASK_PLACEMENT_PSRAM_STACKS
+    // 栈在PSRAM说明是用 xTaskCreatePinnedToCoreWithCaps 创建的；删除自身时由辅助任务完成释放
+    if (esp_ptr_external_ram(pxTaskGetStackStart(handle))) {
+        vTaskDeleteWithCaps(handle);
+        return;
+    }
+#endif
+    vTaskDelete(handle);
+}
+
+void task_placement_note_stack(const char* name, uint32_t stack_free) {
+    int index = find_row_index(name);
+    if (index < 0) {
+        return;
+    }
+    taskENTER_CRITICAL(&s_lock);
+    if (s_track[index].stack_size > 0 && stack_free < s_track[index].min_free) {
+        s_track[index].min_free = stack_free;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void task_placement_sample_stacks(void) {
+    UBaseType_t capacity = uxTaskGetNumberOfTasks() + 4;
+    TaskStatus_t* status = heap_caps_malloc(capacity * sizeof(TaskStatus_t), MALLOC_CAP_SPIRAM);
+    if (status == NULL) {
+        return;
+    }
+    UBaseType_t count = uxTaskGetSystemState(status, capacity, NULL);
+    for (UBaseType_t i = 0; i < count; i++) {
+        task_placement_note_stack(status[i].pcTaskName, status[i].usStackHighWaterMark); // 字节
+    }
+    free(status);
+}
+
+size_t task_placement_get_stack_stats(task_placement_stack_stat_t* out, size_t max) {
+    size_t n = 0;
+    for (size_t i = 0; i < TABLE_SIZE && n < max; i++) {
+        taskENTER_CRITICAL(&s_lock);
+        task_stack_track_t track = s_track[i];
+        taskEXIT_CRITICAL(&s_lock);
+        if (track.stack_size == 0 || track.min_free == UINT32_MAX) {
+            continue;
+        }
+        uint32_t used = track.stack_size > track.min_free ? track.stack_size - track.min_free : 0;
+        out[n++] = (task_placement_stack_stat_t){
+            .name = s_table[i].name,
+            .stack_size = track.stack_size,
+            .min_free = track.min_free,
+            .recommended = recommend_stack(used),
+            .psram = track.psram,
+        };
+    }
+    return n;
+}
+
+void task_placement_log_stacks(void) {
+    task_placement_stack_stat_t stats[TABLE_SIZE];
+    size_t n = task_placement_get_stack_stats(stats, TABLE_SIZE);
+    int32_t internal_saving = 0;
+
+    ESP_LOGI(TAG, "=== Task stacks (%u observed) ===", (unsigned)n);
+    ESP_LOGI(TAG, "%-16s %6s %6s %6s %6s %s", "task", "stack", "used", "free", "recom", "mem");
+    for (size_t i = 0; i < n; i++) {
+        const task_placement_stack_stat_t* s = &stats[i];
+        ESP_LOGI(TAG, "%-16s %6lu %6lu %6lu %6lu %s", s->name, (unsigned long)s->stack_size,
+                 (unsigned long)(s->stack_size - s->min_free), (unsigned long)s->min_free,
+                 (unsigned long)s->recommended, s->psram ? "psram" : "internal");
+        if (!s->psram) {
+            internal_saving += (int32_t)s->stack_size - (int32_t)s->recommended;
+        }
+    }
+    // 只有运行过所有典型场景（图传、遥测、串口等）后推荐值才可靠
+    ESP_LOGI(TAG, "Internal RAM saved with recommended sizes: %ld bytes", (long)internal_saving);
+}
+
+void task_placement_log(void) {
+    ESP_LOGI(TAG, "=== Task placement (%s, initial estimates, not measured) ===", s_profile_names[s_profile]);
+    ESP_LOGI(TAG, "%-16s %4s %4s %6s %s", "task", "core", "prio", "stack", "mem");
+    for (size_t i = 0; i < TABLE_SIZE; i++) {
+        const task_placement_t* p = &s_table[i].profile[s_profile];
+        ESP_LOGI(TAG, "%-16s %4d %4u %6lu %s", s_table[i].name, p->core, p->priority, (unsigned long)p->stack_size,
+                 (p->stack_caps & MALLOC_CAP_SPIRAM) ? "psram" : "internal");
+    }
+}
@@ -6,6 +6,7 @@
  */
 
 #include "xpt2046.h"
+#include "spi_bus_arbiter.h"
 #include "esp_err.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -35,6 +36,7 @@ static xpt2046_handle_t g_xpt2046_handle = {0};
 #define ERR_RANGE 50          // 误差范围
 #define PRESSURE_THRESHOLD_MIN 10    // 压力阈值最小值
 #define PRESSURE_THRESHOLD_MAX 4000  // 压力阈值最大值
+#define BUS_WAIT_TIMEOUT_MS 20       // 等待显示让出SPI总线的最长时间
 
 // ========================================
 // 私有函数声明
@@ -77,6 +79,9 @@ static esp_err_t xpt2046_spi_init(void)
         ESP_LOGE(TAG, "SPI device add failed: %s", esp_err_to_name(ret));
         return ret;
     }
+
+    // 通过仲裁器与显示的DMA像素流交替使用总线
+    spi_bus_arbiter_init();
     
     /* added to shared bus */
     return ESP_OK;
@@ -116,7 +121,11 @@ static uint16_t xpt2046_read_channel(uint8_t command)
     trans.tx_buffer = tx_data;
     trans.rx_buffer = rx_data;
     
+    if (spi_bus_arbiter_acquire(SPI_BUS_CLIENT_TOUCH, pdMS_TO_TICKS(BUS_WAIT_TIMEOUT_MS)) != ESP_OK) {
+        return 0;
+    }
     ret = spi_device_polling_transmit(g_xpt2046_handle.spi_handle, &trans);
+    spi_bus_arbiter_release(SPI_BUS_CLIENT_TOUCH);
     if (ret != ESP_OK) {
         /* spi transmit failed */
         return 0;
@@ -395,6 +404,51 @@ esp_err_t xpt2046_read_raw(xpt2046_data_t *data)
     return ESP_OK;
 }
 
+/**
+ * @brief 单次采样X/Y/Z1/Z2
+ *
+ * 四条命令在一次SPI传输中重叠发送 (每条命令的12位结果跨在后两个字节上)，
+ * 只占用一次总线，不做延时和排序，滤波由调用者完成。
+ * 最后一条命令PD=00，转换结束后重新打开PENIRQ。
+ */
+esp_err_t xpt2046_read_sample(xpt2046_data_t *data)
+{
+    if (!g_xpt2046_handle.is_initialized || !data) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t tx_data[9] = {XPT2046_CMD_X_POS, 0, XPT2046_CMD_Y_POS, 0, XPT2046_CMD_Z1_POS, 0,
+                          XPT2046_CMD_Z2_POS, 0, 0};
+    uint8_t rx_data[9] = {0};
+    spi_transaction_t trans = {
+        .length = sizeof(tx_data) * 8,
+        .tx_buffer = tx_data,
+        .rx_buffer = rx_data,
+    };
+
+    esp_err_t ret = spi_bus_arbiter_acquire(SPI_BUS_CLIENT_TOUCH, pdMS_TO_TICKS(BUS_WAIT_TIMEOUT_MS));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = spi_device_polling_transmit(g_xpt2046_handle.spi_handle, &trans);
+    spi_bus_arbiter_release(SPI_BUS_CLIENT_TOUCH);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    int16_t x = (((uint16_t)rx_data[1] << 8) | rx_data[2]) >> 3;
+    int16_t y = (((uint16_t)rx_data[3] << 8) | rx_data[4]) >> 3;
+    int16_t z1 = (((uint16_t)rx_data[5] << 8) | rx_data[6]) >> 3;
+    int16_t z2 = (((uint16_t)rx_data[7] << 8) | rx_data[8]) >> 3;
+
+    data->z = (z1 > 0) ? (int16_t)(((int32_t)x * (z2 - z1)) / z1) : 0;
+    data->pressed = (data->z > PRESSURE_THRESHOLD_MIN) && (data->z < PRESSURE_THRESHOLD_MAX);
+    data->x = data->pressed ? x : 0;
+    data->y = data->pressed ? y : 0;
+
+    return ESP_OK;
+}
+
 /**
  * @brief 读取校准后的触摸坐标
  */
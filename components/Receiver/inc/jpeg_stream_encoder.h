@@ -16,6 +16,8 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include "pixel_stream_protocol.h"
+#include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
 
@@ -23,15 +25,52 @@
 #define JPEG_ENC_WIDTH 240
 #define JPEG_ENC_HEIGHT 188
 #define JPEG_ENC_QUALITY 70
+// SPI 线上的输入像素格式（PIXEL_FORMAT_*）：RGB565 和 YUV422 每像素2字节，同样 SCLK 下帧率是 RGBA 的两倍
+#define JPEG_ENC_INPUT_FORMAT PIXEL_FORMAT_RGB565
+#if JPEG_ENC_INPUT_FORMAT == PIXEL_FORMAT_RGBA8888
+#define JPEG_ENC_INPUT_BPP 4
 #define JPEG_ENC_SRC_TYPE JPEG_PIXEL_FORMAT_RGBA
+#else
+// RGB565 在编码前原地转换为 YUYV，两者每像素字节数相同
+#define JPEG_ENC_INPUT_BPP 2
+#define JPEG_ENC_SRC_TYPE JPEG_PIXEL_FORMAT_YCbYCr
+#endif
 #define JPEG_ENC_SUBSAMPLE JPEG_SUBSAMPLE_422
+// 1: 按 MCU 行条带边收边编码，输入缓冲只需一个条带，帧尾到JPEG输出只差一个条带的编码时间
+// 0: 整帧缓冲后再编码
+#define JPEG_ENC_STREAM_MODE 1
+// 乒乓输入缓冲个数（条带或整帧）：拼帧任务填一个的同时，另一核上的编码任务编码另一个
+#define JPEG_ENC_INPUT_BUFFERS 2
+
+// 数据块释放回调：编码任务用完数据块后调用，所有权交还给数据提供者
+typedef void (*jpeg_chunk_release_t)(uint8_t* data, void* ctx);
 
 // JPEG数据块消息结构
 typedef struct {
     uint8_t* data;
     size_t len;
+    jpeg_chunk_release_t release; // NULL 表示 data 由 malloc 分配，用完后 free
+    void* release_ctx;
+    bool framed; // true 表示 data 是分块像素流（见 pixel_stream_protocol.h）
 } jpeg_chunk_msg_t;
 
+// 分块像素流统计
+typedef struct {
+    uint32_t frames_encoded;
+    uint32_t frames_dropped; // 缺块、乱序、CRC错误而放弃的帧
+    uint32_t crc_errors;     // CRC错误或截断的块
+    uint32_t blocks_skipped; // 等待 SOF 期间丢弃的块
+    uint32_t format_mismatch; // 像素格式与 JPEG_ENC_INPUT_FORMAT 不一致的帧
+} jpeg_stream_stats_t;
+
+// 编码流水线各阶段在统计窗口内的占用率（%）
+typedef struct {
+    float feed_busy_pct;   // 拼帧任务：CRC校验、拼帧、复制到输入缓冲
+    float feed_stall_pct;  // 拼帧任务等待空闲输入缓冲，持续偏高说明编码是瓶颈
+    float encode_busy_pct; // 编码任务：格式转换、编码和输出回调
+    uint32_t window_ms;    // 统计窗口长度
+} jpeg_pipeline_util_t;
+
 // JPEG编码器回调函数类型
 typedef void (*jpeg_output_callback_t)(const uint8_t* jpeg_data, size_t jpeg_len);
 
@@ -61,6 +100,40 @@ void jpeg_stream_encoder_stop(void);
  */
 esp_err_t jpeg_stream_encoder_feed_data(const uint8_t* data, size_t len);
 
+/**
+ * @brief 把数据块的所有权交给JPEG编码器，不复制数据
+ * 编码任务把数据拼入帧缓冲后立即调用 release 归还数据块（例如重新挂回 SPI DMA 事务），
+ * 停止编码器时未处理的数据块也会被归还。
+ * @param data 数据指针，在 release 被调用前提供者不得改写
+ * @param len 数据长度
+ * @param release 归还回调，不能为NULL
+ * @param release_ctx 回调参数
+ * @param wait 队列满时的等待时间
+ * @return ESP_OK 已接管，之后一定会调用 release；其他值表示未接管，所有权仍在调用者
+ */
+esp_err_t jpeg_stream_encoder_feed_buffer(uint8_t* data, size_t len, jpeg_chunk_release_t release, void* release_ctx,
+                                          TickType_t wait);
+
+/**
+ * @brief 把一个分块像素事务的所有权交给JPEG编码器，所有权约定同 jpeg_stream_encoder_feed_buffer
+ * 编码任务校验每块的CRC并按帧号和位置拼帧，丢块或出错时放弃当前帧，从下一个 SOF 块重新同步。
+ * @param data 以 pixel_block_header_t 开头的事务数据
+ * @param len 事务长度
+ */
+esp_err_t jpeg_stream_encoder_feed_blocks(uint8_t* data, size_t len, jpeg_chunk_release_t release, void* release_ctx,
+                                          TickType_t wait);
+
+/**
+ * @brief 获取分块像素流统计
+ */
+void jpeg_stream_encoder_get_stats(jpeg_stream_stats_t* out);
+
+/**
+ * @brief 获取自上次调用以来各阶段的占用率，并开始新的统计窗口
+ * @param out 结果，NULL 时只重置统计窗口
+ */
+void jpeg_stream_encoder_get_pipeline_util(jpeg_pipeline_util_t* out);
+
 /**
  * @brief 获取JPEG编码器队列句柄
  * @return 队列句柄，如果未初始化则返回NULL
@@ -54,14 +54,14 @@ typedef struct {
 // LED管理器配置
 typedef struct {
     uint16_t led_count;       // LED数量
-    uint8_t task_priority;    // 任务优先级
-    uint32_t task_stack_size; // 任务栈大小
+    uint8_t task_priority;    // 任务优先级，0 表示使用任务布局表
+    uint32_t task_stack_size; // 任务栈大小，0 表示使用任务布局表
     uint8_t queue_size;       // 请求队列大小
 } led_manager_config_t;
 
 // 默认配置
 #define LED_MANAGER_DEFAULT_CONFIG()                                                               \
-    {.led_count = 1, .task_priority = 2, .task_stack_size = 2048, .queue_size = 8}
+    {.led_count = 1, .task_priority = 0, .task_stack_size = 0, .queue_size = 8}
 
 /**
  * @brief 初始化LED状态管理器
@@ -0,0 +1,58 @@
+/**
+ * @file pixel_stream_protocol.h
+ * @brief SPI 从机像素流分块协议定义
+ * @author TidyCraze
+ * @date 2025-10-18
+ *
+ * 像素数据按块发送，每块带帧号和在帧内的位置，接收端据此拼帧并在丢块后于下一帧重新同步。
+ * 像素事务与命令事务分开：以块魔数开头的 SPI 事务是像素事务，可以连续包含多个块，
+ * 块不跨事务，块后剩余部分视为填充；其他事务按 AA55 命令帧解析。
+ *
+ * 块格式: [魔数:2B][CRC:2B][标志:1B][像素格式:1B][帧号:2B][起始行:2B][行内偏移:2B][长度:2B][负载:NB]
+ * CRC 为 CRC16 Modbus，覆盖标志字段到负载结束，多字节字段均为小端。
+ * 一帧的块必须按顺序发送：第一块带 SOF 且从 (0,0) 开始，最后一块带 EOF。
+ */
+
+#ifndef PIXEL_STREAM_PROTOCOL_H
+#define PIXEL_STREAM_PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ----------------- 协议常量 -----------------
+#define PIXEL_BLOCK_MAGIC_1 0xA5 // 块魔数1
+#define PIXEL_BLOCK_MAGIC_2 0x5A // 块魔数2
+
+#define PIXEL_BLOCK_FLAG_SOF 0x01 // 帧的第一块
+#define PIXEL_BLOCK_FLAG_EOF 0x02 // 帧的最后一块
+
+// 像素格式，一帧内各块一致
+#define PIXEL_FORMAT_RGBA8888 0 // 每像素4字节 R G B A
+#define PIXEL_FORMAT_RGB565 1   // 每像素2字节，小端 RGB565
+#define PIXEL_FORMAT_YUV422 2   // 每两像素4字节，打包 Y0 U Y1 V（YUYV）
+
+// ----------------- 块头结构 -----------------
+typedef struct __attribute__((packed)) {
+    uint8_t magic1;    // 0xA5
+    uint8_t magic2;    // 0x5A
+    uint16_t crc;      // 从 flags 到负载结束的 CRC16
+    uint8_t flags;     // PIXEL_BLOCK_FLAG_*
+    uint8_t format;    // PIXEL_FORMAT_*
+    uint16_t frame_id; // 帧号，每帧加1
+    uint16_t line;     // 块起始行
+    uint16_t offset;   // 块在起始行内的字节偏移
+    uint16_t length;   // 负载字节数，可以跨行
+} pixel_block_header_t;
+
+// CRC 覆盖范围的起点
+#define PIXEL_BLOCK_CRC_START offsetof(pixel_block_header_t, flags)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PIXEL_STREAM_PROTOCOL_H
@@ -2,6 +2,7 @@
 #define SPI_SLAVE_RECEIVER_H
 
 #include "esp_err.h"
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -14,15 +15,46 @@ extern "C" {
 #define SPI_SLAVE_PIN_SCLK 42
 #define SPI_SLAVE_PIN_CS 39
 
-// 事务与缓冲配置
-#define SPI_RX_QUEUE_SIZE 2
-#define SPI_RX_TRANSACTION_SZ 512 // 单次事务最大接收字节数
-#define SPI_RX_BUFFER_SZ 1024     // 累积解析缓冲
+// 事务与缓冲配置，可在 CMake 中用 -DSPI_RX_QUEUE_SIZE= / -DSPI_RX_TRANSACTION_SZ= 覆盖
+// 每个排队事务一块内部RAM DMA缓冲，总占用 SPI_RX_QUEUE_SIZE x SPI_RX_TRANSACTION_SZ
+#ifndef SPI_RX_QUEUE_SIZE
+#define SPI_RX_QUEUE_SIZE 4
+#endif
+#ifndef SPI_RX_TRANSACTION_SZ
+#define SPI_RX_TRANSACTION_SZ (16 * 1024) // 单次事务最大接收字节数
+#endif
+#define SPI_RX_BUFFER_SZ 1024 // 跨事务命令帧的续接缓冲
+
+#if SPI_RX_QUEUE_SIZE < 2 || SPI_RX_QUEUE_SIZE > 16
+#error "SPI_RX_QUEUE_SIZE must be 2..16"
+#endif
+#if SPI_RX_TRANSACTION_SZ < 4096 || SPI_RX_TRANSACTION_SZ > 32768 || (SPI_RX_TRANSACTION_SZ % 4) != 0
+#error "SPI_RX_TRANSACTION_SZ must be 4KB..32KB and a multiple of 4"
+#endif
+
+// 接收统计
+typedef struct {
+    uint32_t transactions;       // 完成的事务数
+    uint64_t bytes;              // 收到的有效字节数
+    uint32_t pixel_transactions;
+    uint32_t command_transactions;
+    uint32_t queue_empty_events; // 事务完成时驱动中已没有排队的事务；只有主机在重新排队前发送才会丢数据，
+                                 // 从机无法区分，所以这是丢失的上限而不是丢失数
+    uint32_t truncated;          // 主机一次发送超过 SPI_RX_TRANSACTION_SZ，超出部分被丢弃
+    uint32_t underruns;          // 片选结束时没有收到可用数据（空事务或不足一个块头的像素事务）
+    uint32_t feed_drops;         // 编码器队列满而丢弃的像素事务
+    uint32_t min_queued;         // 驱动中排队事务数的历史最小值
+} spi_rx_stats_t;
 
 esp_err_t spi_receiver_init(void);
 void spi_receiver_start(void);
 void spi_receiver_stop(void);
 
+/**
+ * @brief 获取 SPI 从机接收统计
+ */
+void spi_receiver_get_stats(spi_rx_stats_t* out);
+
 #ifdef __cplusplus
 }
 #endif
@@ -2,6 +2,10 @@
 #define USB_DEVICE_RECEIVER_H
 
 #include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -11,14 +15,50 @@ extern "C" {
 #define USB_DP_PIN 20
 #define USB_DM_PIN 19
 
-// CDC 接收缓冲
-#define USB_RX_CHUNK_SIZE 256
-#define USB_RX_BUFFER_SIZE 4096
+// CDC 接收缓冲：像素块按 pixel_stream_protocol.h 分块发送，可与文本命令/AA55帧交替，
+// 但一次发送中不要把命令紧跟在像素块之前（命令之后的数据按命令解析直到换行）
+#define USB_RX_CHUNK_SIZE (16 * 1024) // 单次读取和交给编码器的最大字节数，也是像素块大小上限
+#define USB_RX_POOL_SIZE 4            // 接收缓冲个数（PSRAM），编码器持有的缓冲用完后归还
+#define USB_RX_BUFFER_SIZE 4096       // 命令解析缓冲
+
+// USB 接收统计
+typedef struct {
+    uint64_t bytes;       // CDC 收到的总字节数
+    uint64_t pixel_bytes; // 交给编码器的像素块字节数
+    uint32_t blocks;      // 完整像素块数
+    uint32_t chunks_fed;  // 交给编码器的缓冲数
+    uint32_t feed_drops;  // 编码器队列满而丢弃的缓冲
+    uint32_t resyncs;     // 块长度非法而重新寻找魔数的次数
+} usb_rx_stats_t;
 
 esp_err_t usb_receiver_init(void);
 void usb_receiver_start(void);
+
+/**
+ * @brief 停止接收任务并释放接收缓冲
+ * @note 需先调用 jpeg_stream_encoder_stop()，等编码器交还所有接收缓冲后才会释放；超时则保留缓冲
+ */
 void usb_receiver_stop(void);
 
+/**
+ * @brief 获取 USB 接收统计
+ */
+void usb_receiver_get_stats(usb_rx_stats_t* out);
+
+/**
+ * @brief 主机是否已打开 CDC 端口（DTR/RTS 有效）
+ */
+bool usb_receiver_is_connected(void);
+
+/**
+ * @brief 通过 CDC 发送一段带前缀的二进制数据，与命令终端输出互斥，保证不被文本打断
+ * @param prefix 前缀（例如帧头），可为NULL
+ * @param timeout 整段数据的发送超时
+ * @return ESP_OK 全部发出；ESP_ERR_TIMEOUT 主机读取太慢；ESP_ERR_INVALID_STATE 未连接
+ */
+esp_err_t usb_receiver_write_frame(const uint8_t* prefix, size_t prefix_len, const uint8_t* data, size_t len,
+                                   TickType_t timeout);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,116 @@
+/**
+ * @file video_output.h
+ * @brief 接收端JPEG帧输出：P2P UDP、TCP 长度前缀、USB CDC
+ * @author TidyCraze
+ * @date 2025-10-18
+ *
+ * 编码完成的帧复制到帧池后分发给各个已启用的输出，提交方不阻塞。每个输出有独立的发送任务和
+ * 在途帧上限（排队 + 正在发送），超出上限或帧池用完时直接丢帧，慢的输出不会拖慢编码和其他输出。
+ *
+ * 各输出的线上格式：
+ *  - UDP：与遥控器端 p2p_udp_image_transfer 相同的 p2p_udp_packet_header_t 分包，默认广播到 P2P_UDP_PORT
+ *  - TCP：[长度:4B 大端][JPEG数据]
+ *  - USB：[魔数 "VOUT":4B][长度:4B 大端][JPEG数据]，与命令终端文本共用 CDC 端口，主机按魔数分离
+ */
+
+#ifndef VIDEO_OUTPUT_H
+#define VIDEO_OUTPUT_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VIDEO_OUTPUT_POOL_SIZE 4                  // 帧池大小
+#define VIDEO_OUTPUT_MAX_FRAME_SIZE (100 * 1024)  // 单帧最大字节数，与编码器输出缓冲一致
+#define VIDEO_OUTPUT_MAX_IN_FLIGHT 2              // 每个输出的在途帧上限
+#define VIDEO_OUTPUT_TCP_DEFAULT_PORT 6790
+
+// P2P UDP 分包参数，与 main/app/inc/p2p_udp_image_transfer.h 保持一致
+#define P2P_UDP_PORT 6789
+#define P2P_UDP_MAX_PACKET_SIZE 1400
+#define P2P_UDP_MAGIC_NUMBER 0x50325055 // "P2PU"
+#define P2P_UDP_PACKET_TYPE_FRAME_DATA 0x02
+
+// P2P UDP 包头，与 main/app/inc/p2p_udp_image_transfer.h 保持一致
+typedef struct __attribute__((packed)) {
+    uint32_t magic;         // 魔数标识: 0x50325055 ("P2PU")
+    uint8_t packet_type;    // 包类型
+    uint8_t version;        // 协议版本
+    uint16_t sequence_num;  // 序列号
+    uint32_t frame_id;      // 帧ID
+    uint16_t packet_id;     // 当前包在帧中的ID
+    uint16_t total_packets; // 该帧总包数
+    uint32_t frame_size;    // 帧总大小
+    uint16_t data_size;     // 当前包数据大小
+    uint16_t checksum;      // 数据校验和
+    uint32_t timestamp;     // 时间戳
+    uint8_t reserved[4];    // 保留字段
+} p2p_udp_packet_header_t;
+
+// 输出类型
+typedef enum {
+    VIDEO_SINK_UDP = 0,
+    VIDEO_SINK_TCP,
+    VIDEO_SINK_USB,
+    VIDEO_SINK_MAX
+} video_sink_type_t;
+
+// 单个输出的统计
+typedef struct {
+    bool enabled;
+    uint32_t frames_sent;
+    uint32_t frames_dropped; // 在途超限、帧池用完或输出未就绪而丢弃
+    uint32_t send_errors;
+    uint32_t in_flight;
+    uint64_t bytes_sent;
+    uint32_t kbps; // 最近一个统计窗口的吞吐
+    float fps;
+} video_sink_stats_t;
+
+/**
+ * @brief 初始化帧池，启用默认输出（UDP 广播和 USB）
+ * @return ESP_OK 成功
+ */
+esp_err_t video_output_init(void);
+
+/**
+ * @brief 启用或停用一个输出，首次启用时创建发送任务
+ */
+esp_err_t video_output_enable(video_sink_type_t type, bool enable);
+
+/**
+ * @brief 设置 UDP 目标地址，NULL 表示广播
+ */
+esp_err_t video_output_set_udp_peer(const char* ip);
+
+/**
+ * @brief 设置 TCP 服务器地址，已连接时断开后按新地址重连
+ * @param port 0 表示 VIDEO_OUTPUT_TCP_DEFAULT_PORT
+ */
+esp_err_t video_output_set_tcp_server(const char* ip, uint16_t port);
+
+/**
+ * @brief 提交一帧JPEG，复制到帧池后立即返回，可以在编码回调中直接调用
+ */
+void video_output_submit(const uint8_t* jpeg, size_t len);
+
+/**
+ * @brief 获取输出统计
+ */
+void video_output_get_stats(video_sink_type_t type, video_sink_stats_t* out);
+
+/**
+ * @brief 输出名称（udp/tcp/usb）
+ */
+const char* video_output_sink_name(video_sink_type_t type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VIDEO_OUTPUT_H
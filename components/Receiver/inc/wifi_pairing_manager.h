@@ -33,8 +33,8 @@ typedef struct {
 // WiFi配对管理器配置
 typedef struct {
     uint32_t scan_interval_ms;      // 扫描间隔（毫秒）
-    uint8_t task_priority;          // 任务优先级
-    uint32_t task_stack_size;       // 任务栈大小
+    uint8_t task_priority;          // 任务优先级，0 表示使用任务布局表
+    uint32_t task_stack_size;       // 任务栈大小，0 表示使用任务布局表
     uint32_t connection_timeout_ms; // 连接超时时间（毫秒）
     char target_ssid_prefix[16];    // 目标SSID前缀
     char default_password[65];      // 默认密码
@@ -44,8 +44,8 @@ typedef struct {
 #define WIFI_PAIRING_DEFAULT_CONFIG() \
     { \
         .scan_interval_ms = 5000, \
-        .task_priority = 3, \
-        .task_stack_size = 4096, \
+        .task_priority = 0, \
+        .task_stack_size = 0, \
         .connection_timeout_ms = 10000, \
         .target_ssid_prefix = "ESP32_Terminal_", \
         .default_password = "12345678" \
@@ -12,7 +12,12 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "heap_tracer.h"
+#include "spi_slave_receiver.h"
+#include "task_placement.h"
+#include "usb_device_receiver.h"
 #include "tcp_common_protocol.h"
+#include "video_output.h"
 
 static const char* TAG = "cmd_terminal";
 
@@ -91,7 +96,7 @@ __attribute__((weak)) bool cmd_terminal_confirm_restart(void) {
 }
 
 static void respondf(const char* fmt, ...) {
-    char buf[512];  // 增加缓冲区大小以支持更长的help输出
+    char buf[1024];  // 增加缓冲区大小以支持更长的help输出
     va_list ap;
     va_start(ap, fmt);
     vsnprintf(buf, sizeof(buf), fmt, ap);
@@ -99,6 +104,12 @@ static void respondf(const char* fmt, ...) {
     cmd_terminal_write(buf);
 }
 
+// 分配跟踪输出逐行转发到终端
+static void heap_tracer_respond(const char* line, void* ctx) {
+    (void)ctx;
+    cmd_terminal_write(line);
+}
+
 static void str_tolower(char* s) {
     if (!s) return;
     for (; *s; ++s) {
@@ -188,6 +199,14 @@ static void handle_text_command(char* line) {
                  "  version             - 打印IDF版本\n"
                  "  echo <text>         - 回显文本\n"
                  "  jpegq <0-100>       - 设置JPEG质量\n"
+                 "  profile [name]      - 查看/切换任务布局(control/video)\n"
+                 "  stacks              - 任务栈用量和推荐大小\n"
+                 "  heaptrace <on|off|dump|trend> - 分配跟踪/碎片趋势\n"
+                 "  spirx               - SPI从机接收统计\n"
+                 "  usbrx               - USB像素流接收统计\n"
+                 "  vout [udp|tcp|usb on|off] - 图传输出统计/开关\n"
+                 "  vout peer <ip|bcast>     - UDP目标地址\n"
+                 "  vout server <ip> [port]  - TCP服务器地址\n"
                  "  wifi <ssid> <pwd>   - 配置WiFi并保存到NVS\n"
                  "  wifir <ssid> <pwd>  - 配置WiFi并立即重启\n"
                  "  restart             - 软件重启\n"
@@ -242,6 +261,123 @@ static void handle_text_command(char* line) {
         return;
     }
 
+    if (strcmp(cmd, "stacks") == 0) {
+        task_placement_sample_stacks();
+        task_placement_stack_stat_t stats[16];
+        size_t n = task_placement_get_stack_stats(stats, sizeof(stats) / sizeof(stats[0]));
+        respondf("%-16s %6s %6s %6s %s", "任务名", "栈", "已用", "推荐", "内存");
+        for (size_t i = 0; i < n; i++) {
+            respondf("%-16s %6lu %6lu %6lu %s", stats[i].name, (unsigned long)stats[i].stack_size,
+                     (unsigned long)(stats[i].stack_size - stats[i].min_free), (unsigned long)stats[i].recommended,
+                     stats[i].psram ? "psram" : "internal");
+        }
+        return;
+    }
+
+    if (strcmp(cmd, "heaptrace") == 0) {
+        char* sub = strtok_r(NULL, " \t", &saveptr);
+        if (sub && strcmp(sub, "on") == 0) {
+            esp_err_t err = heap_tracer_start();
+            respondf("分配跟踪: %s", err == ESP_OK ? "已开启" : esp_err_to_name(err));
+        } else if (sub && strcmp(sub, "off") == 0) {
+            heap_tracer_stop();
+            respondf("分配跟踪: 已停止，dump 查看结果");
+        } else if (sub && strcmp(sub, "dump") == 0) {
+            heap_tracer_dump(heap_tracer_respond, NULL, 16);
+        } else if (sub && strcmp(sub, "trend") == 0) {
+            // 每种内存最多输出最近 20 个点（默认周期下10分钟）
+            heap_tracer_dump_trend(heap_tracer_respond, NULL, 20);
+        } else {
+            respondf("用法: heaptrace <on|off|dump|trend>，当前%s", heap_tracer_is_running() ? "开启" : "关闭");
+        }
+        return;
+    }
+
+    if (strcmp(cmd, "spirx") == 0) {
+        spi_rx_stats_t st;
+        spi_receiver_get_stats(&st);
+        respondf("SPI接收: %d x %d 字节事务, 排队最少 %lu", SPI_RX_QUEUE_SIZE, SPI_RX_TRANSACTION_SZ,
+                 (unsigned long)st.min_queued);
+        respondf("事务 %lu (像素 %lu, 命令 %lu), %llu 字节", (unsigned long)st.transactions,
+                 (unsigned long)st.pixel_transactions, (unsigned long)st.command_transactions,
+                 (unsigned long long)st.bytes);
+        respondf("队列空 %lu, 截断 %lu, 欠载 %lu, 编码丢弃 %lu", (unsigned long)st.queue_empty_events,
+                 (unsigned long)st.truncated, (unsigned long)st.underruns, (unsigned long)st.feed_drops);
+        return;
+    }
+
+    if (strcmp(cmd, "usbrx") == 0) {
+        usb_rx_stats_t st;
+        usb_receiver_get_stats(&st);
+        respondf("USB接收: %llu 字节, 像素 %llu 字节, %lu 块", (unsigned long long)st.bytes,
+                 (unsigned long long)st.pixel_bytes, (unsigned long)st.blocks);
+        respondf("交给编码器 %lu, 编码丢弃 %lu, 重新同步 %lu", (unsigned long)st.chunks_fed,
+                 (unsigned long)st.feed_drops, (unsigned long)st.resyncs);
+        return;
+    }
+
+    if (strcmp(cmd, "vout") == 0) {
+        char* arg1 = strtok_r(NULL, " \t", &saveptr);
+        char* arg2 = strtok_r(NULL, " \t", &saveptr);
+        char* arg3 = strtok_r(NULL, " \t", &saveptr);
+        if (!arg1) {
+            respondf("%-4s %-3s %7s %7s %6s %4s %7s %6s", "输出", "开", "已发", "丢弃", "错误", "在途", "kbps", "fps");
+            for (int i = 0; i < VIDEO_SINK_MAX; i++) {
+                video_sink_stats_t st;
+                video_output_get_stats((video_sink_type_t)i, &st);
+                respondf("%-4s %-3s %7lu %7lu %6lu %4lu %7lu %6.1f", video_output_sink_name((video_sink_type_t)i),
+                         st.enabled ? "on" : "off", (unsigned long)st.frames_sent, (unsigned long)st.frames_dropped,
+                         (unsigned long)st.send_errors, (unsigned long)st.in_flight, (unsigned long)st.kbps, st.fps);
+            }
+            return;
+        }
+        if (strcmp(arg1, "peer") == 0 && arg2) {
+            // IP 地址不受大小写影响，直接使用小写副本
+            esp_err_t err = video_output_set_udp_peer(strcmp(arg2, "bcast") == 0 ? NULL : arg2);
+            respondf("UDP目标: %s, %s", arg2, err == ESP_OK ? "成功" : "地址无效");
+            return;
+        }
+        if (strcmp(arg1, "server") == 0 && arg2) {
+            uint16_t port = arg3 ? (uint16_t)atoi(arg3) : 0;
+            esp_err_t err = video_output_set_tcp_server(arg2, port);
+            if (err == ESP_OK) {
+                video_output_enable(VIDEO_SINK_TCP, true);
+            }
+            respondf("TCP服务器: %s:%u, %s", arg2, port ? port : VIDEO_OUTPUT_TCP_DEFAULT_PORT,
+                     err == ESP_OK ? "已启用" : "地址无效");
+            return;
+        }
+        for (int i = 0; i < VIDEO_SINK_MAX; i++) {
+            if (strcmp(arg1, video_output_sink_name((video_sink_type_t)i)) == 0 && arg2 &&
+                (strcmp(arg2, "on") == 0 || strcmp(arg2, "off") == 0)) {
+                esp_err_t err = video_output_enable((video_sink_type_t)i, strcmp(arg2, "on") == 0);
+                respondf("输出 %s: %s", arg1, err == ESP_OK ? arg2 : esp_err_to_name(err));
+                return;
+            }
+        }
+        respondf("用法: vout [udp|tcp|usb on|off] | vout peer <ip|bcast> | vout server <ip> [port]");
+        return;
+    }
+
+    if (strcmp(cmd, "profile") == 0) {
+        char* name = strtok_r(NULL, " \t", &saveptr);
+        if (!name) {
+            respondf("当前任务布局: %s", task_placement_profile_name(task_placement_get_profile()));
+            task_placement_log();
+            return;
+        }
+        for (int i = 0; i < TASK_PROFILE_MAX; i++) {
+            if (strcmp(name, task_placement_profile_name((task_profile_t)i)) == 0) {
+                task_placement_set_profile((task_profile_t)i);
+                // 已创建任务的核在重启后才会改变
+                respondf("任务布局已切换为 %s，优先级已生效，核分配重启后生效", name);
+                return;
+            }
+        }
+        respondf("用法: profile [control|video]");
+        return;
+    }
+
     if (strcmp(cmd, "wifi") == 0 || strcmp(cmd, "wifir") == 0) {
         bool reboot_after = (strcmp(cmd, "wifir") == 0);
         
@@ -1,32 +1,395 @@
 #include "jpeg_stream_encoder.h"
 #include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/event_groups.h"
 #include "settings_manager.h"
+#include "pixel_stream_protocol.h"
+#include "task_placement.h"
+#include "tcp_common_protocol.h"
 #include <string.h>
 #include <stdlib.h>
 
 static const char* TAG = "jpeg_encoder";
 
+#define JPEG_ENC_FRAME_STRIDE (JPEG_ENC_WIDTH * JPEG_ENC_INPUT_BPP)
+#define JPEG_ENC_FRAME_SIZE (JPEG_ENC_FRAME_STRIDE * JPEG_ENC_HEIGHT)
+#define JPEG_STOP_TIMEOUT_MS 2000 // 等待退出信号入队和两个任务退出的上限
+
+// 任务退出标志，停止时等两个任务都置位后才释放队列和缓冲
+#define JPEG_FEED_EXITED_BIT BIT0
+#define JPEG_ENC_EXITED_BIT BIT1
+
+// 编码任务的工作项：填满的输入缓冲，或放弃当前帧/退出信号
+typedef enum {
+    JPEG_JOB_ENCODE = 0,
+    JPEG_JOB_ABORT,
+    JPEG_JOB_QUIT,
+} jpeg_job_type_t;
+
+typedef struct {
+    jpeg_job_type_t type;
+    uint8_t* buf;
+} jpeg_job_t;
+
 // JPEG编码器全局变量
 static jpeg_enc_handle_t s_jpeg_enc = NULL;
 static QueueHandle_t s_jpeg_queue = NULL;
 static TaskHandle_t s_jpeg_task = NULL;
+static TaskHandle_t s_encode_task = NULL;
+static EventGroupHandle_t s_task_events = NULL;
 static jpeg_output_callback_t s_output_callback = NULL;
 
+// 乒乓输入缓冲：拼帧任务填一个，编码任务编码另一个。空闲缓冲和待编码缓冲各用一个队列传递
+static uint8_t* s_jpeg_input_buffers[JPEG_ENC_INPUT_BUFFERS] = {NULL};
+static QueueHandle_t s_free_queue = NULL;
+static QueueHandle_t s_job_queue = NULL;
+static uint8_t* s_fill_buffer = NULL; // 拼帧任务正在填的缓冲，NULL 表示需要取一个空闲缓冲
+
 // JPEG编码缓冲区
-static uint8_t* s_jpeg_input_buffer = NULL;
 static uint8_t* s_jpeg_output_buffer = NULL;
 static size_t s_jpeg_input_buffer_size = 0;
 static size_t s_jpeg_output_buffer_size = 0;
 static size_t s_jpeg_data_len = 0;
 static uint8_t s_jpeg_quality = JPEG_ENC_QUALITY;
 
+// 流式编码状态：当前帧已编码的条带数和已输出的JPEG字节数
+static jpeg_enc_config_t s_jpeg_cfg;
+static size_t s_stripes_per_frame = 0;
+static size_t s_stripes_done = 0;
+static size_t s_jpeg_out_len = 0;
+static bool s_stripe_error = false;
+
+// 分块像素流的拼帧状态
+static bool s_frame_active = false; // 已收到 SOF，正在拼帧
+static uint16_t s_frame_id = 0;
+static jpeg_stream_stats_t s_stats = {0};
+
+// 各阶段忙碌时间，读取统计时清零
+static portMUX_TYPE s_util_lock = portMUX_INITIALIZER_UNLOCKED;
+static int64_t s_util_window_start = 0;
+static int64_t s_feed_busy_us = 0;
+static int64_t s_feed_stall_us = 0;
+static int64_t s_encode_busy_us = 0;
+
 // 前向声明
 static void jpeg_encode_feed_task(void* arg);
+static void jpeg_encode_task(void* arg);
 static esp_err_t init_jpeg_encoder_internal(void);
 static void cleanup_jpeg_encoder_internal(void);
 static void on_jpeg_quality_changed(setting_type_t type, const setting_value_t* new_value);
 
+// 归还数据块：外部缓冲交回提供者，复制的数据块直接释放
+static void jpeg_chunk_release(const jpeg_chunk_msg_t* msg) {
+    if (msg->data == NULL) {
+        return;
+    }
+    if (msg->release) {
+        msg->release(msg->data, msg->release_ctx);
+    } else {
+        free(msg->data);
+    }
+}
+
+static inline void jpeg_util_add(int64_t* acc, int64_t since) {
+    int64_t d = esp_timer_get_time() - since;
+    portENTER_CRITICAL(&s_util_lock);
+    *acc += d;
+    portEXIT_CRITICAL(&s_util_lock);
+}
+
+#if JPEG_ENC_INPUT_FORMAT == PIXEL_FORMAT_RGB565
+static inline uint8_t clamp_u8(int v) { return v < 0 ? 0 : (v > 255 ? 255 : (uint8_t)v); }
+
+// 小端 RGB565 原地转换为 YUYV（BT.601 全范围，与JFIF一致）：每两个像素 4 字节转换为 Y0 U Y1 V，
+// 色度取两像素平均。输入输出大小相同，条带拼完后转换即可，块和事务边界不必按像素对齐。
+static void rgb565_to_yuyv_inplace(uint8_t* buf, size_t len) {
+    for (size_t i = 0; i + 4 <= len; i += 4) {
+        uint16_t p0 = buf[i] | (buf[i + 1] << 8);
+        uint16_t p1 = buf[i + 2] | (buf[i + 3] << 8);
+
+        int r0 = ((p0 >> 8) & 0xF8) | (p0 >> 13);
+        int g0 = ((p0 >> 3) & 0xFC) | ((p0 >> 9) & 0x03);
+        int b0 = ((p0 << 3) & 0xF8) | ((p0 >> 2) & 0x07);
+        int r1 = ((p1 >> 8) & 0xF8) | (p1 >> 13);
+        int g1 = ((p1 >> 3) & 0xFC) | ((p1 >> 9) & 0x03);
+        int b1 = ((p1 << 3) & 0xF8) | ((p1 >> 2) & 0x07);
+
+        int r = r0 + r1;
+        int g = g0 + g1;
+        int b = b0 + b1;
+
+        buf[i] = (uint8_t)((77 * r0 + 150 * g0 + 29 * b0 + 128) >> 8);
+        buf[i + 1] = clamp_u8((-43 * r - 85 * g + 128 * b + (128 << 9) + 256) >> 9);
+        buf[i + 2] = (uint8_t)((77 * r1 + 150 * g1 + 29 * b1 + 128) >> 8);
+        buf[i + 3] = clamp_u8((128 * r - 107 * g - 21 * b + (128 << 9) + 256) >> 9);
+    }
+}
+#endif
+
+// 把输入格式转换为编码器格式，RGBA 和 YUV422 编码器直接支持
+static inline void jpeg_convert_input(uint8_t* buf, size_t len) {
+#if JPEG_ENC_INPUT_FORMAT == PIXEL_FORMAT_RGB565
+    rgb565_to_yuyv_inplace(buf, len);
+#else
+    (void)buf;
+    (void)len;
+#endif
+}
+
+// 输出一帧编码结果
+static void jpeg_output_frame(int out_len) {
+    s_stats.frames_encoded++;
+    ESP_LOGD(TAG, "JPEG encoded: %d bytes -> %d bytes", JPEG_ENC_FRAME_SIZE, out_len);
+    // 调用回调函数处理编码后的数据
+    if (s_output_callback) {
+        s_output_callback(s_jpeg_output_buffer, out_len);
+    }
+}
+
+// ==================== 编码任务 ====================
+
+// 编码一个填满的输入缓冲：流式模式下是一个条带，帧的最后一个条带完成后输出；否则是整帧
+static void jpeg_encode_buffer(uint8_t* buf) {
+#if JPEG_ENC_STREAM_MODE
+    jpeg_convert_input(buf, s_jpeg_input_buffer_size);
+    int out_len = 0;
+    jpeg_error_t ret = jpeg_enc_process_with_block(s_jpeg_enc, buf, s_jpeg_input_buffer_size,
+                                                   s_jpeg_output_buffer + s_jpeg_out_len,
+                                                   s_jpeg_output_buffer_size - s_jpeg_out_len, &out_len);
+    if (ret < JPEG_ERR_OK) {
+        ESP_LOGW(TAG, "JPEG stripe encode failed: %d", ret);
+        s_stripe_error = true;
+    } else if (out_len > 0) {
+        s_jpeg_out_len += out_len;
+    }
+    s_stripes_done++;
+
+    if (s_stripes_done == s_stripes_per_frame) {
+        if (!s_stripe_error && s_jpeg_out_len > 0) {
+            jpeg_output_frame(s_jpeg_out_len);
+        }
+        s_stripes_done = 0;
+        s_jpeg_out_len = 0;
+        s_stripe_error = false;
+    }
+#else
+    jpeg_convert_input(buf, JPEG_ENC_FRAME_SIZE);
+    int out_len = 0;
+    jpeg_error_t ret =
+        jpeg_enc_process(s_jpeg_enc, buf, JPEG_ENC_FRAME_SIZE, s_jpeg_output_buffer, s_jpeg_output_buffer_size, &out_len);
+    if (ret == JPEG_ERR_OK && out_len > 0) {
+        jpeg_output_frame(out_len);
+    } else {
+        ESP_LOGW(TAG, "JPEG encode failed: %d", ret);
+    }
+#endif
+}
+
+// 放弃编码了一半的帧；流式模式下编码器内部已有部分条带，需要重新打开
+static void jpeg_encode_abort(void) {
+#if JPEG_ENC_STREAM_MODE
+    if (s_stripes_done > 0) {
+        jpeg_enc_close(s_jpeg_enc);
+        s_jpeg_enc = NULL;
+        if (jpeg_enc_open(&s_jpeg_cfg, &s_jpeg_enc) != JPEG_ERR_OK) {
+            ESP_LOGE(TAG, "JPEG encoder reopen failed");
+            s_jpeg_enc = NULL;
+        }
+    }
+    s_stripes_done = 0;
+    s_jpeg_out_len = 0;
+    s_stripe_error = false;
+#endif
+}
+
+// 编码任务：与拼帧任务分核运行，编码一个缓冲的同时拼帧任务填另一个
+static void jpeg_encode_task(void* arg) {
+    ESP_LOGI(TAG, "JPEG encode task started");
+    jpeg_job_t job;
+
+    while (1) {
+        if (xQueueReceive(s_job_queue, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (job.type == JPEG_JOB_QUIT) {
+            break;
+        }
+
+        int64_t t0 = esp_timer_get_time();
+        if (job.type == JPEG_JOB_ABORT) {
+            jpeg_encode_abort();
+        } else {
+            if (s_jpeg_enc) {
+                jpeg_encode_buffer(job.buf);
+            }
+            xQueueSend(s_free_queue, &job.buf, portMAX_DELAY);
+        }
+        jpeg_util_add(&s_encode_busy_us, t0);
+    }
+    ESP_LOGI(TAG, "JPEG encode task stopped");
+    xEventGroupSetBits(s_task_events, JPEG_ENC_EXITED_BIT);
+    task_placement_delete(NULL);
+}
+
+// ==================== 拼帧任务 ====================
+
+// 取一个空闲输入缓冲，两个缓冲都在编码时阻塞等待，等待时间计为编码背压
+static bool jpeg_acquire_fill_buffer(void) {
+    if (s_fill_buffer) {
+        return true;
+    }
+    int64_t t0 = esp_timer_get_time();
+    bool ok = xQueueReceive(s_free_queue, &s_fill_buffer, portMAX_DELAY) == pdTRUE;
+    jpeg_util_add(&s_feed_stall_us, t0);
+    return ok;
+}
+
+// 把填满的缓冲交给编码任务
+static void jpeg_submit_fill_buffer(void) {
+    jpeg_job_t job = {.type = JPEG_JOB_ENCODE, .buf = s_fill_buffer};
+    xQueueSend(s_job_queue, &job, portMAX_DELAY);
+    s_fill_buffer = NULL;
+}
+
+// 按顺序写入当前帧的像素数据：流式模式下每填满一个条带提交编码，否则整帧填满后提交
+static void jpeg_frame_write(const uint8_t* data, size_t len) {
+    while (len > 0) {
+        if (!jpeg_acquire_fill_buffer()) {
+            return;
+        }
+        size_t fill = s_jpeg_data_len % s_jpeg_input_buffer_size;
+        size_t n = s_jpeg_input_buffer_size - fill;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(s_fill_buffer + fill, data, n);
+        s_jpeg_data_len += n;
+        data += n;
+        len -= n;
+
+        if (fill + n == s_jpeg_input_buffer_size) {
+            jpeg_submit_fill_buffer();
+        } else if (s_jpeg_data_len == JPEG_ENC_FRAME_SIZE) {
+            // 帧高不是条带高度的整数倍：最后一个条带用最后一行补齐
+            size_t stride = JPEG_ENC_FRAME_STRIDE;
+            for (size_t pos = fill + n; pos < s_jpeg_input_buffer_size; pos += stride) {
+                memcpy(s_fill_buffer + pos, s_fill_buffer + fill + n - stride, stride);
+            }
+            jpeg_submit_fill_buffer();
+        }
+    }
+    if (s_jpeg_data_len == JPEG_ENC_FRAME_SIZE) {
+        s_jpeg_data_len = 0;
+    }
+}
+
+// 丢弃写了一半的帧：填了一半的缓冲留着下一帧覆盖，已提交过条带时通知编码任务放弃
+static void jpeg_frame_reset(void) {
+    if (s_jpeg_data_len >= s_jpeg_input_buffer_size) {
+        jpeg_job_t job = {.type = JPEG_JOB_ABORT, .buf = NULL};
+        xQueueSend(s_job_queue, &job, portMAX_DELAY);
+    }
+    s_jpeg_data_len = 0;
+}
+
+// 放弃正在拼的帧，等待下一个 SOF 块重新同步
+static void jpeg_frame_abort(const char* reason) {
+    if (s_frame_active) {
+        s_stats.frames_dropped++;
+        ESP_LOGW(TAG, "Frame %u dropped: %s", s_frame_id, reason);
+    }
+    s_frame_active = false;
+    if (s_jpeg_data_len > 0) {
+        jpeg_frame_reset();
+    }
+}
+
+// 按块头把一个像素块放入帧缓冲
+static void jpeg_place_block(const pixel_block_header_t* hdr, const uint8_t* block) {
+    const size_t stride = JPEG_ENC_FRAME_STRIDE;
+
+    uint16_t crc = calculate_crc16_modbus(block + PIXEL_BLOCK_CRC_START,
+                                          sizeof(pixel_block_header_t) - PIXEL_BLOCK_CRC_START + hdr->length);
+    if (crc != hdr->crc) {
+        s_stats.crc_errors++;
+        jpeg_frame_abort("crc error");
+        return;
+    }
+
+    if (hdr->flags & PIXEL_BLOCK_FLAG_SOF) {
+        jpeg_frame_abort("no EOF before next SOF");
+        if (hdr->format != JPEG_ENC_INPUT_FORMAT) {
+            // 主机发送的格式与编码器配置不一致，整帧丢弃
+            s_stats.format_mismatch++;
+            return;
+        }
+        s_frame_active = true;
+        s_frame_id = hdr->frame_id;
+    } else if (!s_frame_active) {
+        // 等待帧头期间的块直接丢弃
+        s_stats.blocks_skipped++;
+        return;
+    } else if (hdr->frame_id != s_frame_id) {
+        jpeg_frame_abort("frame id changed");
+        s_stats.blocks_skipped++;
+        return;
+    }
+
+    // 块必须按顺序到达，位置不符说明中间丢了块
+    size_t at = (size_t)hdr->line * stride + hdr->offset;
+    if (hdr->offset >= stride || at != s_jpeg_data_len || at + hdr->length > JPEG_ENC_FRAME_SIZE) {
+        jpeg_frame_abort("block missing or out of order");
+        return;
+    }
+
+    bool completes = at + hdr->length == JPEG_ENC_FRAME_SIZE;
+    if ((hdr->flags & PIXEL_BLOCK_FLAG_EOF) && !completes) {
+        jpeg_frame_abort("EOF before frame complete");
+        return;
+    }
+
+    jpeg_frame_write(block + sizeof(pixel_block_header_t), hdr->length);
+    if (completes) {
+        s_frame_active = false;
+    }
+}
+
+// 处理一个像素事务：依次取出其中的块，块后的剩余部分是填充
+static void jpeg_feed_blocks(const uint8_t* data, size_t len) {
+    size_t pos = 0;
+    while (pos + sizeof(pixel_block_header_t) <= len) {
+        const uint8_t* block = &data[pos];
+        if (block[0] != PIXEL_BLOCK_MAGIC_1 || block[1] != PIXEL_BLOCK_MAGIC_2) {
+            break;
+        }
+        pixel_block_header_t hdr;
+        memcpy(&hdr, block, sizeof(hdr)); // DMA 缓冲中的块头不保证对齐
+        size_t block_size = sizeof(pixel_block_header_t) + hdr.length;
+        if (hdr.length == 0 || pos + block_size > len) {
+            s_stats.crc_errors++;
+            jpeg_frame_abort("truncated block");
+            break;
+        }
+        jpeg_place_block(&hdr, block);
+        pos += block_size;
+    }
+}
+
+// 无分块信息的数据：按字节数累积，凑满一帧即编码
+static void jpeg_feed_raw(const uint8_t* data, size_t len) {
+    while (len > 0) {
+        // 按帧边界切开，超出当前帧的部分属于下一帧
+        size_t n = JPEG_ENC_FRAME_SIZE - s_jpeg_data_len;
+        if (n > len) {
+            n = len;
+        }
+        jpeg_frame_write(data, n);
+        data += n;
+        len -= n;
+    }
+}
+
 // JPEG编码任务实现
 static void jpeg_encode_feed_task(void* arg) {
     ESP_LOGI(TAG, "JPEG feed task started");
@@ -39,84 +402,40 @@ static void jpeg_encode_feed_task(void* arg) {
                 break;
             }
             
-            if (msg.data && msg.len > 0 && s_jpeg_enc) {
-                // 累积数据到输入缓冲区
-                if (s_jpeg_data_len + msg.len <= s_jpeg_input_buffer_size) {
-                    memcpy(s_jpeg_input_buffer + s_jpeg_data_len, msg.data, msg.len);
-                    s_jpeg_data_len += msg.len;
-                    
-                    // 检查是否收集到足够的数据进行编码
-                    size_t expected_size = JPEG_ENC_WIDTH * JPEG_ENC_HEIGHT * 4; // RGBA格式
-                    if (s_jpeg_data_len >= expected_size) {
-                        // 执行JPEG编码
-                        int out_len = 0;
-                        jpeg_error_t ret = jpeg_enc_process(s_jpeg_enc, s_jpeg_input_buffer, 
-                                                          expected_size, s_jpeg_output_buffer, 
-                                                          s_jpeg_output_buffer_size, &out_len);
-                        if (ret == JPEG_ERR_OK && out_len > 0) {
-                            ESP_LOGI(TAG, "JPEG encoded: %d bytes -> %d bytes", expected_size, out_len);
-                            // 调用回调函数处理编码后的数据
-                            if (s_output_callback) {
-                                s_output_callback(s_jpeg_output_buffer, out_len);
-                            }
-                        } else {
-                            ESP_LOGW(TAG, "JPEG encode failed: %d", ret);
-                        }
-                        s_jpeg_data_len = 0; // 重置缓冲区
-                    }
+            // 忙碌时间包含等待空闲缓冲，统计时再扣除
+            int64_t t0 = esp_timer_get_time();
+            if (msg.data && msg.len > 0) {
+                // 复制到输入缓冲是数据块唯一的一次复制
+                if (msg.framed) {
+                    jpeg_feed_blocks(msg.data, msg.len);
                 } else {
-                    ESP_LOGW(TAG, "Input buffer overflow, dropping data");
-                    s_jpeg_data_len = 0; // 重置缓冲区
+                    jpeg_feed_raw(msg.data, msg.len);
                 }
             }
             
-            if (msg.data) free(msg.data);
+            jpeg_chunk_release(&msg);
+            jpeg_util_add(&s_feed_busy_us, t0);
         }
     }
+    // 编码任务处理完已提交的缓冲后退出
+    jpeg_job_t quit = {.type = JPEG_JOB_QUIT, .buf = NULL};
+    xQueueSend(s_job_queue, &quit, portMAX_DELAY);
     ESP_LOGI(TAG, "JPEG feed task stopped");
-    vTaskDelete(NULL);
+    xEventGroupSetBits(s_task_events, JPEG_FEED_EXITED_BIT);
+    task_placement_delete(NULL);
 }
 
 // 内部初始化函数
 static esp_err_t init_jpeg_encoder_internal(void) {
-    // 分配缓冲区
-    s_jpeg_input_buffer_size = JPEG_ENC_WIDTH * JPEG_ENC_HEIGHT * 4; // RGBA
     s_jpeg_output_buffer_size = 100 * 1024; // 100KB
 
-    ESP_LOGI(TAG, "Available SPIRAM before malloc: %u bytes", (unsigned long)esp_get_free_heap_size());
-    ESP_LOGI(TAG, "Available internal memory: %u bytes", (unsigned long)heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
-    ESP_LOGI(TAG, "Available SPIRAM memory: %u bytes", (unsigned long)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
-    
-    // 添加更长延迟确保SPIRAM完全初始化，并尝试小块分配测试
-    vTaskDelay(pdMS_TO_TICKS(1000));
-    
-    // 先尝试小块SPIRAM分配测试
-    void* test_ptr = heap_caps_malloc(1024, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    if (test_ptr == NULL) {
-        ESP_LOGE(TAG, "SPIRAM test allocation failed! SPIRAM may not be ready.");
-        return ESP_ERR_NO_MEM;
-    }
-    heap_caps_free(test_ptr);
-    ESP_LOGI(TAG, "SPIRAM test allocation successful");
-    
-    ESP_LOGI(TAG, "Attempting to allocate %d bytes for input buffer from SPIRAM...", s_jpeg_input_buffer_size);
-    
-    // 分配输入缓冲区 - 强制使用SPIRAM
-    s_jpeg_input_buffer = (uint8_t*)heap_caps_malloc(s_jpeg_input_buffer_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    if (s_jpeg_input_buffer == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate input buffer from SPIRAM!");
-        return ESP_ERR_NO_MEM;
-    }
-    ESP_LOGI(TAG, "JPEG encoder input buffer allocated from SPIRAM: %d bytes", s_jpeg_input_buffer_size);
+    ESP_LOGI(TAG, "Available internal memory: %u bytes", (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    ESP_LOGI(TAG, "Available SPIRAM memory: %u bytes", (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
 
-    ESP_LOGI(TAG, "Attempting to allocate %d bytes for output buffer from SPIRAM...", s_jpeg_output_buffer_size);
-    
     // 分配输出缓冲区 - 强制使用SPIRAM
     s_jpeg_output_buffer = (uint8_t*)heap_caps_malloc(s_jpeg_output_buffer_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
     if (s_jpeg_output_buffer == NULL) {
         ESP_LOGE(TAG, "Failed to allocate output buffer from SPIRAM!");
-        heap_caps_free(s_jpeg_input_buffer);
-        s_jpeg_input_buffer = NULL;
         return ESP_ERR_NO_MEM;
     }
     ESP_LOGI(TAG, "JPEG encoder output buffer allocated from SPIRAM: %d bytes", s_jpeg_output_buffer_size);
@@ -130,8 +449,11 @@ static esp_err_t init_jpeg_encoder_internal(void) {
     jpeg_cfg.quality = s_jpeg_quality;
     jpeg_cfg.rotate = JPEG_ROTATE_0D;
     jpeg_cfg.task_enable = true;
-    jpeg_cfg.hfm_task_core = 1;
-    jpeg_cfg.hfm_task_priority = 10;
+    // 编码器内部的哈夫曼任务由 esp_new_jpeg 创建，核和优先级取自任务布局表
+    const task_placement_t* hfm = task_placement_get("jpeg_hfm");
+    jpeg_cfg.hfm_task_core = hfm->core == TASK_PLACEMENT_ANY_CORE ? 1 : hfm->core;
+    jpeg_cfg.hfm_task_priority = hfm->priority;
+    s_jpeg_cfg = jpeg_cfg; // 流式模式丢帧时按同一配置重新打开
 
     ESP_LOGI(TAG, "JPEG encoder config: %d %d %d %d", jpeg_cfg.width, jpeg_cfg.height, jpeg_cfg.src_type, jpeg_cfg.quality);
     
@@ -142,6 +464,44 @@ static esp_err_t init_jpeg_encoder_internal(void) {
         return ESP_FAIL;
     }
     ESP_LOGI(TAG, "jpeg_enc_open success");
+
+#if JPEG_ENC_STREAM_MODE
+    // 输入缓冲只需一个 MCU 行条带（422 为 8 行），放在内部RAM，要求16字节对齐
+    int block_size = jpeg_enc_get_block_size(s_jpeg_enc);
+    if (block_size <= 0 || block_size % JPEG_ENC_FRAME_STRIDE != 0) {
+        ESP_LOGE(TAG, "Unexpected JPEG block size: %d", block_size);
+        cleanup_jpeg_encoder_internal();
+        return ESP_FAIL;
+    }
+    s_jpeg_input_buffer_size = block_size;
+    size_t stripe_lines = s_jpeg_input_buffer_size / JPEG_ENC_FRAME_STRIDE;
+    s_stripes_per_frame = (JPEG_ENC_HEIGHT + stripe_lines - 1) / stripe_lines;
+    ESP_LOGI(TAG, "Stripe encode: %u lines per stripe, %u stripes per frame", (unsigned)stripe_lines,
+             (unsigned)s_stripes_per_frame);
+#else
+    // 整帧输入缓冲 - 强制使用SPIRAM
+    s_jpeg_input_buffer_size = JPEG_ENC_FRAME_SIZE;
+#endif
+    for (int i = 0; i < JPEG_ENC_INPUT_BUFFERS; i++) {
+#if JPEG_ENC_STREAM_MODE
+        s_jpeg_input_buffers[i] = (uint8_t*)heap_caps_aligned_alloc(16, s_jpeg_input_buffer_size,
+                                                                    MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (s_jpeg_input_buffers[i] == NULL) {
+            s_jpeg_input_buffers[i] = (uint8_t*)heap_caps_aligned_alloc(16, s_jpeg_input_buffer_size,
+                                                                        MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        }
+#else
+        s_jpeg_input_buffers[i] =
+            (uint8_t*)heap_caps_malloc(s_jpeg_input_buffer_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#endif
+        if (s_jpeg_input_buffers[i] == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate input buffer (%d bytes)!", s_jpeg_input_buffer_size);
+            cleanup_jpeg_encoder_internal();
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    ESP_LOGI(TAG, "JPEG encoder input buffers allocated: %d x %d bytes", JPEG_ENC_INPUT_BUFFERS,
+             s_jpeg_input_buffer_size);
     
     // 缓冲区分配成功，初始化数据长度
     s_jpeg_data_len = 0;
@@ -159,10 +519,13 @@ static void cleanup_jpeg_encoder_internal(void) {
         s_jpeg_enc = NULL;
     }
     
-    if (s_jpeg_input_buffer) {
-        heap_caps_free(s_jpeg_input_buffer);
-        s_jpeg_input_buffer = NULL;
+    for (int i = 0; i < JPEG_ENC_INPUT_BUFFERS; i++) {
+        if (s_jpeg_input_buffers[i]) {
+            heap_caps_free(s_jpeg_input_buffers[i]);
+            s_jpeg_input_buffers[i] = NULL;
+        }
     }
+    s_fill_buffer = NULL;
     
     if (s_jpeg_output_buffer) {
         heap_caps_free(s_jpeg_output_buffer);
@@ -172,6 +535,10 @@ static void cleanup_jpeg_encoder_internal(void) {
     s_jpeg_input_buffer_size = 0;
     s_jpeg_output_buffer_size = 0;
     s_jpeg_data_len = 0;
+    s_frame_active = false;
+    s_stripes_done = 0;
+    s_jpeg_out_len = 0;
+    s_stripe_error = false;
 }
 
 // JPEG质量变化回调
@@ -182,6 +549,27 @@ static void on_jpeg_quality_changed(setting_type_t type, const setting_value_t*
     }
 }
 
+// 等待指定任务退出标志全部置位
+static bool jpeg_wait_tasks_exited(EventBits_t bits) {
+    EventBits_t got = xEventGroupWaitBits(s_task_events, bits, pdFALSE, pdTRUE, pdMS_TO_TICKS(JPEG_STOP_TIMEOUT_MS));
+    return (got & bits) == bits;
+}
+
+static void jpeg_delete_queues(void) {
+    if (s_jpeg_queue) {
+        vQueueDelete(s_jpeg_queue);
+        s_jpeg_queue = NULL;
+    }
+    if (s_job_queue) {
+        vQueueDelete(s_job_queue);
+        s_job_queue = NULL;
+    }
+    if (s_free_queue) {
+        vQueueDelete(s_free_queue);
+        s_free_queue = NULL;
+    }
+}
+
 // 公共API实现
 esp_err_t jpeg_stream_encoder_init(jpeg_output_callback_t output_callback) {
     if (s_jpeg_enc != NULL) {
@@ -209,23 +597,51 @@ esp_err_t jpeg_stream_encoder_start(void) {
         return ESP_ERR_INVALID_STATE;
     }
     
-    if (s_jpeg_queue != NULL || s_jpeg_task != NULL) {
+    if (s_jpeg_queue != NULL || s_jpeg_task != NULL || s_encode_task != NULL) {
         ESP_LOGW(TAG, "JPEG encoder already started");
         return ESP_OK;
     }
     
     // 创建编码消息队列
     s_jpeg_queue = xQueueCreate(16, sizeof(jpeg_chunk_msg_t));
-    if (!s_jpeg_queue) {
+    // 待编码队列除了所有输入缓冲，还要容纳放弃和退出信号
+    s_job_queue = xQueueCreate(JPEG_ENC_INPUT_BUFFERS + 2, sizeof(jpeg_job_t));
+    s_free_queue = xQueueCreate(JPEG_ENC_INPUT_BUFFERS, sizeof(uint8_t*));
+    // 退出标志只创建一次不释放：任务置位后还会读一次事件组，停止时删掉会被访问到已释放内存
+    if (!s_task_events) {
+        s_task_events = xEventGroupCreate();
+    }
+    if (!s_jpeg_queue || !s_job_queue || !s_free_queue || !s_task_events) {
         ESP_LOGE(TAG, "Failed to create JPEG queue");
+        jpeg_delete_queues();
         return ESP_ERR_NO_MEM;
     }
-    
-    // 创建编码任务
-    if (xTaskCreatePinnedToCore(jpeg_encode_feed_task, "jpeg_feed", 8192, NULL, 9, &s_jpeg_task, tskNO_AFFINITY) != pdPASS) {
+    for (int i = 0; i < JPEG_ENC_INPUT_BUFFERS; i++) {
+        xQueueSend(s_free_queue, &s_jpeg_input_buffers[i], 0);
+    }
+    s_fill_buffer = NULL;
+    s_jpeg_data_len = 0;
+    jpeg_stream_encoder_get_pipeline_util(NULL); // 从启动时开始统计
+
+    // 编码任务和拼帧任务分核，由任务布局表决定
+    xEventGroupClearBits(s_task_events, JPEG_FEED_EXITED_BIT | JPEG_ENC_EXITED_BIT);
+    if (task_placement_create(jpeg_encode_task, "jpeg_enc", NULL, &s_encode_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create JPEG encode task");
+        jpeg_delete_queues();
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (task_placement_create(jpeg_encode_feed_task, "jpeg_feed", NULL, &s_jpeg_task) != pdPASS) {
         ESP_LOGE(TAG, "Failed to create JPEG feed task");
-        vQueueDelete(s_jpeg_queue);
-        s_jpeg_queue = NULL;
+        jpeg_job_t quit = {.type = JPEG_JOB_QUIT, .buf = NULL};
+        xQueueSend(s_job_queue, &quit, portMAX_DELAY);
+        if (!jpeg_wait_tasks_exited(JPEG_ENC_EXITED_BIT)) {
+            // 编码任务仍在运行，队列不能释放
+            ESP_LOGE(TAG, "JPEG encode task did not exit");
+            return ESP_ERR_NO_MEM;
+        }
+        s_encode_task = NULL;
+        jpeg_delete_queues();
         return ESP_ERR_NO_MEM;
     }
     
@@ -234,28 +650,29 @@ esp_err_t jpeg_stream_encoder_start(void) {
 }
 
 void jpeg_stream_encoder_stop(void) {
-    // 停止JPEG编码任务
+    // 停止JPEG编码任务：拼帧任务收到退出信号后通知编码任务退出，两个任务都退出后才能释放资源
     if (s_jpeg_task) {
-        // 发送退出信号
+        // 背压时队列通常是满的，退出信号要阻塞等待入队
         jpeg_chunk_msg_t quit = {.data = NULL, .len = 0};
-        if (s_jpeg_queue) {
-            xQueueSend(s_jpeg_queue, &quit, 0);
+        if (xQueueSend(s_jpeg_queue, &quit, pdMS_TO_TICKS(JPEG_STOP_TIMEOUT_MS)) != pdTRUE ||
+            !jpeg_wait_tasks_exited(JPEG_FEED_EXITED_BIT | JPEG_ENC_EXITED_BIT)) {
+            // 任务仍可能访问队列和缓冲，宁可泄漏也不释放
+            ESP_LOGE(TAG, "JPEG tasks did not exit, resources left allocated");
+            return;
         }
-        // 等待任务自行退出
-        vTaskDelay(pdMS_TO_TICKS(100));
         s_jpeg_task = NULL;
+        s_encode_task = NULL;
     }
     
     // 清理队列
     if (s_jpeg_queue) {
-        // 清空残留消息并释放内存
+        // 清空残留消息，数据块归还给提供者
         jpeg_chunk_msg_t m;
         while (xQueueReceive(s_jpeg_queue, &m, 0) == pdTRUE) {
-            if (m.data) free(m.data);
+            jpeg_chunk_release(&m);
         }
-        vQueueDelete(s_jpeg_queue);
-        s_jpeg_queue = NULL;
     }
+    jpeg_delete_queues();
     
     // 清理编码器资源
     cleanup_jpeg_encoder_internal();
@@ -284,7 +701,10 @@ esp_err_t jpeg_stream_encoder_feed_data(const uint8_t* data, size_t len) {
     
     jpeg_chunk_msg_t msg = {
         .data = data_copy,
-        .len = len
+        .len = len,
+        .release = NULL,
+        .release_ctx = NULL,
+        .framed = false
     };
     
     if (xQueueSend(s_jpeg_queue, &msg, pdMS_TO_TICKS(100)) != pdTRUE) {
@@ -296,6 +716,74 @@ esp_err_t jpeg_stream_encoder_feed_data(const uint8_t* data, size_t len) {
     return ESP_OK;
 }
 
+static esp_err_t jpeg_enqueue_buffer(uint8_t* data, size_t len, bool framed, jpeg_chunk_release_t release,
+                                     void* release_ctx, TickType_t wait) {
+    if (!s_jpeg_queue || !data || len == 0 || !release) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    jpeg_chunk_msg_t msg = {
+        .data = data,
+        .len = len,
+        .release = release,
+        .release_ctx = release_ctx,
+        .framed = framed
+    };
+
+    if (xQueueSend(s_jpeg_queue, &msg, wait) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t jpeg_stream_encoder_feed_buffer(uint8_t* data, size_t len, jpeg_chunk_release_t release, void* release_ctx,
+                                          TickType_t wait) {
+    return jpeg_enqueue_buffer(data, len, false, release, release_ctx, wait);
+}
+
+esp_err_t jpeg_stream_encoder_feed_blocks(uint8_t* data, size_t len, jpeg_chunk_release_t release, void* release_ctx,
+                                          TickType_t wait) {
+    return jpeg_enqueue_buffer(data, len, true, release, release_ctx, wait);
+}
+
+void jpeg_stream_encoder_get_stats(jpeg_stream_stats_t* out) {
+    if (out) {
+        *out = s_stats;
+    }
+}
+
+void jpeg_stream_encoder_get_pipeline_util(jpeg_pipeline_util_t* out) {
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_util_lock);
+    int64_t window = now - s_util_window_start;
+    int64_t feed_busy = s_feed_busy_us;
+    int64_t feed_stall = s_feed_stall_us;
+    int64_t encode_busy = s_encode_busy_us;
+    s_feed_busy_us = 0;
+    s_feed_stall_us = 0;
+    s_encode_busy_us = 0;
+    s_util_window_start = now;
+    portEXIT_CRITICAL(&s_util_lock);
+
+    if (out == NULL) {
+        return;
+    }
+    // 等待空闲缓冲发生在处理数据块期间，不算拼帧任务自身的工作
+    feed_busy -= feed_stall;
+    if (feed_busy < 0) {
+        feed_busy = 0;
+    }
+    out->window_ms = (uint32_t)(window / 1000);
+    if (window <= 0) {
+        out->feed_busy_pct = out->feed_stall_pct = out->encode_busy_pct = 0.0f;
+        return;
+    }
+    out->feed_busy_pct = 100.0f * feed_busy / window;
+    out->feed_stall_pct = 100.0f * feed_stall / window;
+    out->encode_busy_pct = 100.0f * encode_busy / window;
+}
+
 QueueHandle_t jpeg_stream_encoder_get_queue(void) {
     return s_jpeg_queue;
 }
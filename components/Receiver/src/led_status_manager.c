@@ -7,6 +7,7 @@
 #include "freertos/queue.h"
 #include "freertos/task.h"
 #include "freertos/timers.h"
+#include "task_placement.h"
 
 #include "led_status_manager.h"
 
@@ -116,9 +117,8 @@ esp_err_t led_status_manager_init(const led_manager_config_t* config) {
     s_initialized = true;
 
     // 创建LED管理任务
-    ESP_LOGI(TAG, "创建LED管理任务，栈大小: %d 字节", s_config->task_stack_size);
-    BaseType_t task_ret = xTaskCreate(led_manager_task, "led_manager", s_config->task_stack_size,
-                                      NULL, s_config->task_priority, &s_led_task_handle);
+    BaseType_t task_ret = task_placement_create_ex(led_manager_task, "led_manager", NULL, s_config->task_stack_size,
+                                                   s_config->task_priority, &s_led_task_handle);
     if (task_ret != pdPASS) {
         ESP_LOGE(TAG, "创建LED管理任务失败");
         s_initialized = false;
@@ -9,10 +9,14 @@
 #include "freertos/semphr.h"
 #include "freertos/task.h"
 #include "jpeg_stream_encoder.h"
+#include "pixel_stream_protocol.h"
 #include "settings_manager.h"
+#include "task_placement.h"
 #include "tcp_common_protocol.h"
+#include "video_output.h"
 #include "cmd_terminal.h"
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -27,16 +31,31 @@ static TaskHandle_t s_task = NULL;
 static SemaphoreHandle_t s_spi_trans_done_sem = NULL;
 static spi_slave_transaction_t s_trans[SPI_RX_QUEUE_SIZE];
 
-// JPEG输出回调函数
+// 接收统计，s_queued 是驱动中尚未完成的事务数，中断里递减
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static spi_rx_stats_t s_stats = {.min_queued = SPI_RX_QUEUE_SIZE};
+static uint32_t s_queued = 0;
+
+// JPEG输出回调函数：复制到输出帧池后立即返回，由各输出任务发送
 static void jpeg_output_callback(const uint8_t* data, size_t len) {
-    // 这里可以将编码后的JPEG数据发送到其他地方
-    ESP_LOGI(TAG, "JPEG output received: %d bytes", len);
-    // TODO: 实现具体的输出处理逻辑
+    video_output_submit(data, len);
 }
 
 // 当SPI传输完成时，在中断上下文中调用此回调
 static void IRAM_ATTR spi_post_trans_callback(spi_slave_transaction_t* trans) {
     BaseType_t task_woken = pdFALSE;
+    portENTER_CRITICAL_ISR(&s_stats_lock);
+    if (s_queued > 0) {
+        s_queued--;
+    }
+    if (s_queued < s_stats.min_queued) {
+        s_stats.min_queued = s_queued;
+    }
+    if (s_queued == 0) {
+        // 所有缓冲都在等待处理或编码；只有主机在重新排队前又开始发送才会真正丢数据
+        s_stats.queue_empty_events++;
+    }
+    portEXIT_CRITICAL_ISR(&s_stats_lock);
     if (s_spi_trans_done_sem) {
         xSemaphoreGiveFromISR(s_spi_trans_done_sem, &task_woken);
     }
@@ -45,66 +64,167 @@ static void IRAM_ATTR spi_post_trans_callback(spi_slave_transaction_t* trans) {
     }
 }
 
-// 解析并回调
+// 命令帧总长度：帧头2 + 长度1 + length（已包含类型字节）+ CRC2，与 validate_frame 一致
+static inline size_t command_frame_size(const protocol_header_t* header) {
+    return offsetof(protocol_header_t, frame_type) + header->length + sizeof(uint16_t);
+}
+
+// 分发一个完整的命令帧
+static void spi_dispatch_frame(const uint8_t* frame, size_t frame_size) {
+    const protocol_header_t* header = (const protocol_header_t*)frame;
+    if (!validate_frame(frame, frame_size)) {
+        ESP_LOGW(TAG, "Frame validation failed");
+        return;
+    }
+
+    switch (header->frame_type) {
+    case FRAME_TYPE_COMMAND:
+        // 处理命令帧（如遥控数据）
+        ESP_LOGI(TAG, "Received command frame");
+        break;
+    case FRAME_TYPE_HEARTBEAT:
+        // 处理心跳帧
+        ESP_LOGI(TAG, "Received heartbeat frame");
+        break;
+    case FRAME_TYPE_EXTENDED:
+        // 处理扩展帧
+        ESP_LOGI(TAG, "Received extended frame");
+        if (header->length >= sizeof(extended_cmd_payload_t)) {
+            handle_extended_command((const extended_cmd_payload_t*)&frame[sizeof(protocol_header_t)]);
+        }
+        break;
+    default:
+        ESP_LOGW(TAG, "Unknown frame type: 0x%02X", header->frame_type);
+        break;
+    }
+}
+
+// 续接上个事务末尾不完整的命令帧，返回从 data 中消耗的字节数
+static size_t spi_parse_carry(const uint8_t* data, size_t len) {
+    size_t take = 0;
+    if (s_parse_len < sizeof(protocol_header_t)) {
+        take = sizeof(protocol_header_t) - s_parse_len;
+        if (take > len) {
+            take = len;
+        }
+        memcpy(&s_parse_buf[s_parse_len], data, take);
+        s_parse_len += take;
+        if (s_parse_len < sizeof(protocol_header_t)) {
+            return take;
+        }
+    }
+
+    const protocol_header_t* header = (const protocol_header_t*)s_parse_buf;
+    if (header->header1 != FRAME_HEADER_1 || header->header2 != FRAME_HEADER_2) {
+        // 末尾只是恰好出现了 0xAA，不是帧头，新数据从头重新扫描
+        s_parse_len = 0;
+        return 0;
+    }
+
+    size_t frame_size = command_frame_size(header);
+    size_t more = frame_size - s_parse_len;
+    if (more > len - take) {
+        more = len - take;
+    }
+    memcpy(&s_parse_buf[s_parse_len], &data[take], more);
+    s_parse_len += more;
+    take += more;
+
+    if (s_parse_len == frame_size) {
+        spi_dispatch_frame(s_parse_buf, frame_size);
+        s_parse_len = 0;
+    }
+    return take;
+}
+
+// 直接在 DMA 缓冲上解析命令帧，只有跨事务的不完整帧才复制到解析缓冲
 static void spi_parse_and_dispatch(const uint8_t* data, size_t len) {
-    if (!data || !s_parse_buf || len < MIN_FRAME_SIZE)
+    if (!data || !s_parse_buf || len == 0)
         return;
 
     size_t pos = 0;
-    while (pos + MIN_FRAME_SIZE <= len) {
-        if (pos + sizeof(protocol_header_t) > len)
-            break;
-        
+    if (s_parse_len > 0) {
+        pos = spi_parse_carry(data, len);
+        if (s_parse_len > 0) {
+            // 新数据已全部用于续接
+            return;
+        }
+    }
+
+    while (pos < len) {
         // 检查帧头
-        if (data[pos] != FRAME_HEADER_1 || data[pos + 1] != FRAME_HEADER_2) {
+        if (data[pos] != FRAME_HEADER_1 || (pos + 1 < len && data[pos + 1] != FRAME_HEADER_2)) {
             pos++;
             continue;
         }
 
-        // 获取协议头信息
-        protocol_header_t* header = (protocol_header_t*)&data[pos];
-        size_t frame_size = sizeof(protocol_header_t) + header->length + sizeof(uint16_t);
-        
+        if (pos + sizeof(protocol_header_t) > len)
+            break;
+
+        const protocol_header_t* header = (const protocol_header_t*)&data[pos];
+        size_t frame_size = command_frame_size(header);
         if (pos + frame_size > len)
             break;
 
-        // 验证帧
-        if (validate_frame(&data[pos], frame_size)) {
-            switch (header->frame_type) {
-            case FRAME_TYPE_COMMAND:
-                // 处理命令帧（如遥控数据）
-                ESP_LOGI(TAG, "Received command frame");
-                break;
-            case FRAME_TYPE_HEARTBEAT:
-                // 处理心跳帧
-                ESP_LOGI(TAG, "Received heartbeat frame");
-                break;
-            case FRAME_TYPE_EXTENDED:
-                // 处理扩展帧
-                ESP_LOGI(TAG, "Received extended frame");
-                if (header->length >= sizeof(extended_cmd_payload_t)) {
-                    handle_extended_command((const extended_cmd_payload_t*)&data[pos + sizeof(protocol_header_t)]);
-                }
-                break;
-            default:
-                ESP_LOGW(TAG, "Unknown frame type: 0x%02X", header->frame_type);
-                break;
-            }
-        } else {
-            ESP_LOGW(TAG, "Frame validation failed");
-        }
+        spi_dispatch_frame(&data[pos], frame_size);
         pos += frame_size;
     }
 
+    // 保存末尾不完整的帧（命令帧最长 sizeof(protocol_header_t) + 255 + 2，不会超过解析缓冲）
     if (pos < len) {
-        size_t remain = len - pos;
-        if (remain > SPI_RX_BUFFER_SZ)
-            remain = SPI_RX_BUFFER_SZ; // clamp
-        memmove(s_parse_buf, &data[pos], remain);
-        s_parse_len = remain;
+        s_parse_len = len - pos;
+        memcpy(s_parse_buf, &data[pos], s_parse_len);
+    }
+}
+
+// 把事务挂到 SPI 驱动，先计数再排队，避免事务立即完成时中断里计数不足
+static esp_err_t spi_rx_queue_trans(spi_slave_transaction_t* trans) {
+    portENTER_CRITICAL(&s_stats_lock);
+    s_queued++;
+    portEXIT_CRITICAL(&s_stats_lock);
+    esp_err_t ret = spi_slave_queue_trans(SPI_RX_HOST, trans, portMAX_DELAY);
+    if (ret != ESP_OK) {
+        portENTER_CRITICAL(&s_stats_lock);
+        s_queued--;
+        portEXIT_CRITICAL(&s_stats_lock);
+    }
+    return ret;
+}
+
+// 编码任务用完 DMA 缓冲后调用：把事务重新挂回 SPI 驱动
+static void spi_rx_release(uint8_t* data, void* ctx) {
+    (void)data;
+    spi_slave_transaction_t* trans = (spi_slave_transaction_t*)ctx;
+    esp_err_t ret = spi_rx_queue_trans(trans);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "re-queue err: %s", esp_err_to_name(ret));
+    }
+}
+
+// 按事务内容分类计数，返回可用字节数（主机发送超过缓冲时截断到缓冲大小）
+static size_t spi_rx_account(const spi_slave_transaction_t* trans, bool* is_pixel) {
+    size_t bytes = trans->trans_len / 8;
+    const uint8_t* rxp = (const uint8_t*)trans->rx_buffer;
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.transactions++;
+    if (bytes > SPI_RX_TRANSACTION_SZ) {
+        s_stats.truncated++;
+        bytes = SPI_RX_TRANSACTION_SZ;
+    }
+    s_stats.bytes += bytes;
+    *is_pixel = bytes >= 2 && rxp[0] == PIXEL_BLOCK_MAGIC_1 && rxp[1] == PIXEL_BLOCK_MAGIC_2;
+    if (bytes == 0 || (*is_pixel && bytes < sizeof(pixel_block_header_t))) {
+        s_stats.underruns++;
+        *is_pixel = false;
+        bytes = 0;
+    } else if (*is_pixel) {
+        s_stats.pixel_transactions++;
     } else {
-        s_parse_len = 0;
+        s_stats.command_transactions++;
     }
+    portEXIT_CRITICAL(&s_stats_lock);
+    return bytes;
 }
 
 // SPI接收任务，现在由事件驱动
@@ -120,65 +240,54 @@ static void spi_rx_task(void* arg) {
     // 延迟一小段时间，确保其他初始化可以继续进行，避免潜在的启动死锁
     vTaskDelay(pdMS_TO_TICKS(10));
 
-    // 预先将所有事务排入队列
+    // 预先将所有事务排入队列，多个大缓冲轮流接收，主机可以连续发送而不必等待处理
     for (int i = 0; i < SPI_RX_QUEUE_SIZE; i++) {
         memset(&s_trans[i], 0, sizeof(spi_slave_transaction_t));
         s_trans[i].length = SPI_RX_TRANSACTION_SZ * 8;
         s_trans[i].rx_buffer = s_rx_dma_bufs[i];
 
-        esp_err_t ret = spi_slave_queue_trans(SPI_RX_HOST, &s_trans[i], portMAX_DELAY);
+        esp_err_t ret = spi_rx_queue_trans(&s_trans[i]);
         if (ret != ESP_OK) {
             ESP_LOGE(TAG, "Initial queue_trans err for trans #%d: %s", i, esp_err_to_name(ret));
         }
     }
 
-    ESP_LOGI(TAG, "SPI transactions queued, waiting for incoming data...");
+    ESP_LOGI(TAG, "SPI transactions queued (%d x %d bytes), waiting for incoming data...", SPI_RX_QUEUE_SIZE,
+             SPI_RX_TRANSACTION_SZ);
 
     while (1) {
-        // 等待来自ISR的回调信号，表示一个事务已完成
-        if (xSemaphoreTake(s_spi_trans_done_sem, portMAX_DELAY) == pdTRUE) {
-            spi_slave_transaction_t* ret_trans = NULL;
-            // 获取已完成的事务，超时设为0，因为它应该已经准备好了
-            esp_err_t ret = spi_slave_get_trans_result(SPI_RX_HOST, &ret_trans, 0);
-            if (ret != ESP_OK) {
-                ESP_LOGE(TAG, "get_trans_result err: %s", esp_err_to_name(ret));
-                continue;
-            }
-
-            size_t bytes = ret_trans->trans_len / 8;
-            if (bytes > 0) {
-                uint8_t* rxp = (uint8_t*)ret_trans->rx_buffer;
-
-                if (s_parse_len + bytes > SPI_RX_BUFFER_SZ) {
-                    size_t to_copy = SPI_RX_BUFFER_SZ;
-                    if (bytes < SPI_RX_BUFFER_SZ) {
-                        memmove(s_parse_buf, &s_parse_buf[s_parse_len + bytes - SPI_RX_BUFFER_SZ],
-                                SPI_RX_BUFFER_SZ - bytes);
-                        memcpy(&s_parse_buf[SPI_RX_BUFFER_SZ - bytes], rxp, bytes);
-                    } else {
-                        memcpy(s_parse_buf, &rxp[bytes - SPI_RX_BUFFER_SZ], SPI_RX_BUFFER_SZ);
-                    }
-                    s_parse_len = to_copy;
-                } else {
-                    memcpy(&s_parse_buf[s_parse_len], rxp, bytes);
-                    s_parse_len += bytes;
-                }
+        // 等待来自ISR的回调信号，表示至少一个事务已完成
+        if (xSemaphoreTake(s_spi_trans_done_sem, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
 
-                spi_parse_and_dispatch(s_parse_buf, s_parse_len);
-                // 异步通过JPEG编码器处理数据，避免在SPI线程内执行编码
-                if (bytes > 0) {
-                    esp_err_t ret_jpeg = jpeg_stream_encoder_feed_data(ret_trans->rx_buffer, bytes);
-                    if (ret_jpeg != ESP_OK) {
-                        ESP_LOGW(TAG, "JPEG encoder feed failed: %s, drop %d bytes",
-                                 esp_err_to_name(ret_jpeg), bytes);
-                    }
+        // 二值信号量可能合并多次完成，取空所有已完成的事务
+        spi_slave_transaction_t* ret_trans = NULL;
+        while (spi_slave_get_trans_result(SPI_RX_HOST, &ret_trans, 0) == ESP_OK) {
+            bool is_pixel = false;
+            size_t bytes = spi_rx_account(ret_trans, &is_pixel);
+            uint8_t* rxp = (uint8_t*)ret_trans->rx_buffer;
+
+            if (is_pixel) {
+                // 像素事务：DMA 缓冲直接交给编码任务，编码任务用完后由 spi_rx_release 重新挂回驱动；
+                // 队列满时阻塞在这里，SPI 事务不再补充，主机端自然被限速
+                s_parse_len = 0; // 命令帧不会跨到像素事务中
+                esp_err_t ret_jpeg =
+                    jpeg_stream_encoder_feed_blocks(rxp, bytes, spi_rx_release, ret_trans, pdMS_TO_TICKS(100));
+                if (ret_jpeg == ESP_OK) {
+                    continue;
                 }
+                portENTER_CRITICAL(&s_stats_lock);
+                uint32_t drops = ++s_stats.feed_drops;
+                portEXIT_CRITICAL(&s_stats_lock);
+                ESP_LOGW(TAG, "JPEG encoder feed failed: %s, drop %d bytes (total drops %lu)",
+                         esp_err_to_name(ret_jpeg), bytes, (unsigned long)drops);
+            } else if (bytes > 0) {
+                // 命令事务：只解析 AA55 命令帧，不进入像素缓冲
+                spi_parse_and_dispatch(rxp, bytes);
             }
-            // 将刚刚处理完的事务重新排入队列，以备下次使用
-            ret = spi_slave_queue_trans(SPI_RX_HOST, ret_trans, portMAX_DELAY);
-            if (ret != ESP_OK) {
-                ESP_LOGE(TAG, "re-queue err: %s", esp_err_to_name(ret));
-            }
+            // 未交给编码器的事务立即重新排入队列
+            spi_rx_release(rxp, ret_trans);
         }
     }
 }
@@ -256,8 +365,9 @@ esp_err_t spi_receiver_init(void) {
         s_spi_trans_done_sem = NULL;
         return ret;
     }
-    ESP_LOGI(TAG, "SPI 从机初始化完成: host=%d, MOSI=%d MISO=%d SCLK=%d CS=%d", SPI_RX_HOST,
-             SPI_SLAVE_PIN_MOSI, SPI_SLAVE_PIN_MISO, SPI_SLAVE_PIN_SCLK, SPI_SLAVE_PIN_CS);
+    ESP_LOGI(TAG, "SPI 从机初始化完成: host=%d, MOSI=%d MISO=%d SCLK=%d CS=%d, %d x %d 字节事务", SPI_RX_HOST,
+             SPI_SLAVE_PIN_MOSI, SPI_SLAVE_PIN_MISO, SPI_SLAVE_PIN_SCLK, SPI_SLAVE_PIN_CS, SPI_RX_QUEUE_SIZE,
+             SPI_RX_TRANSACTION_SZ);
 
     return ESP_OK;
 }
@@ -265,19 +375,19 @@ esp_err_t spi_receiver_init(void) {
 void spi_receiver_start(void) {
     if (s_task)
         return;
-    xTaskCreatePinnedToCore(spi_rx_task, "spi_rx", 4096, NULL, 5, &s_task, 1);
+    task_placement_create(spi_rx_task, "spi_rx", NULL, &s_task);
 }
 
 void spi_receiver_stop(void) {
+    // 先停止JPEG编码器，尚在编码队列中的 DMA 缓冲归还给驱动后再释放
+    jpeg_stream_encoder_stop();
+
     if (s_task) {
         vTaskDelete(s_task);
         s_task = NULL;
     }
     spi_slave_free(SPI_RX_HOST);
 
-    // 停止JPEG编码器
-    jpeg_stream_encoder_stop();
-
     // 释放信号量
     if (s_spi_trans_done_sem) {
         vSemaphoreDelete(s_spi_trans_done_sem);
@@ -296,4 +406,14 @@ void spi_receiver_stop(void) {
         free(s_parse_buf);
         s_parse_buf = NULL;
     }
+    s_queued = 0;
+}
+
+void spi_receiver_get_stats(spi_rx_stats_t* out) {
+    if (!out) {
+        return;
+    }
+    portENTER_CRITICAL(&s_stats_lock);
+    *out = s_stats;
+    portEXIT_CRITICAL(&s_stats_lock);
 }
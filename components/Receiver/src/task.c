@@ -11,6 +11,7 @@
 #include "task.h"
 #include "tcp_client_hb.h"
 #include "tcp_client_telemetry.h"
+#include "task_placement.h"
 #include "esp_log.h"
 #include "esp_event.h"
 #include "esp_task_wdt.h"
@@ -80,14 +81,7 @@ esp_err_t tcp_task_manager_start(void) {
     ESP_LOGI(TAG, "启动TCP任务管理器...");
     
     // 创建TCP任务
-    BaseType_t ret = xTaskCreate(
-        tcp_task_function,
-        "tcp_task",
-        8192,  // 增大栈大小
-        NULL,
-        5,
-        &s_tcp_task_handle
-    );
+    BaseType_t ret = task_placement_create(tcp_task_function, "tcp_task", NULL, &s_tcp_task_handle);
     
     if (ret != pdPASS) {
         ESP_LOGE(TAG, "创建TCP任务失败");
@@ -339,13 +333,13 @@ static esp_err_t start_tcp_modules(void) {
     }
     
     // 启动心跳模块
-    if (!tcp_client_hb_start("tcp_hb_task", 4096, 5)) {
+    if (!tcp_client_hb_start(NULL, 0, 0)) {
         ESP_LOGE(TAG, "心跳模块启动失败");
         return ESP_FAIL;
     }
     
     // 启动遥测模块
-    if (!tcp_client_telemetry_start("tcp_telemetry_task", 4096, 5)) {
+    if (!tcp_client_telemetry_start(NULL, 0, 0)) {
         ESP_LOGE(TAG, "遥测模块启动失败");
         return ESP_FAIL;
     }
@@ -390,13 +384,13 @@ void tcp_task(void) {
     ESP_LOGI(TAG, "TCP模块初始化完成，服务器IP: %s", server_ip);
     
     // 启动心跳模块
-    if (!tcp_client_hb_start("tcp_hb_task", 4096, 5)) {
+    if (!tcp_client_hb_start(NULL, 0, 0)) {
         ESP_LOGE(TAG, "心跳模块启动失败");
         return;
     }
     
     // 启动遥测模块
-    if (!tcp_client_telemetry_start("tcp_telemetry_task", 4096, 5)) {
+    if (!tcp_client_telemetry_start(NULL, 0, 0)) {
         ESP_LOGE(TAG, "遥测模块启动失败");
         return;
     }
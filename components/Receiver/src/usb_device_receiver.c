@@ -8,18 +8,35 @@
 #include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
+#include "jpeg_stream_encoder.h"
+#include "pixel_stream_protocol.h"
+#include "task_placement.h"
 #include "tcp_common_protocol.h"
 #include "cmd_terminal.h"
+#include <stddef.h>
 #include <string.h>
 
 static const char* TAG = "usb_rx";
 
+#define USB_RX_STOP_TIMEOUT_MS 2000 // 停止时等待接收任务退出和缓冲全部归还的上限
+
 static TaskHandle_t s_usb_task = NULL;
-static uint8_t s_rx_chunk[USB_RX_CHUNK_SIZE];
+static volatile bool s_usb_stopping = false;
+static volatile bool s_usb_task_running = false;
 static uint8_t* s_parse_buf = NULL;
 static size_t s_parse_len = 0;
 static bool s_usb_connected = false;
+static SemaphoreHandle_t s_tx_mutex = NULL; // 命令终端文本和视频帧共用 CDC 发送
+
+// 接收缓冲池：CDC FIFO 直接读入池中的缓冲，凑成完整像素块后整块交给编码任务，编码任务用完后归还
+static uint8_t* s_chunk_bufs[USB_RX_POOL_SIZE] = {NULL};
+static QueueHandle_t s_chunk_pool = NULL;
+static uint8_t* s_chunk = NULL; // 正在读入的缓冲
+static size_t s_chunk_len = 0;
+static usb_rx_stats_t s_stats = {0};
 
 // USB CDC 连接状态回调
 static void usb_line_state_changed_callback(int itf, cdcacm_event_t* event) {
@@ -32,6 +49,15 @@ static void usb_line_state_changed_callback(int itf, cdcacm_event_t* event) {
     }
 }
 
+// CDC 收到数据：唤醒接收任务读 FIFO（在 TinyUSB 任务中调用）
+static void usb_rx_callback(int itf, cdcacm_event_t* event) {
+    (void)itf;
+    (void)event;
+    if (s_usb_task) {
+        xTaskNotifyGive(s_usb_task);
+    }
+}
+
 static void parse_and_dispatch(const uint8_t* data, size_t len) {
     if (!data || !s_parse_buf || len == 0)
         return;
@@ -52,7 +78,8 @@ static void parse_and_dispatch(const uint8_t* data, size_t len) {
             
             // 获取协议头信息
             protocol_header_t* header = (protocol_header_t*)&data[pos];
-            size_t frame_size = sizeof(protocol_header_t) + header->length + sizeof(uint16_t);
+            // length 已包含类型字节，与 validate_frame 一致
+            size_t frame_size = offsetof(protocol_header_t, frame_type) + header->length + sizeof(uint16_t);
             
             if (pos + frame_size > len)
                 break; // 帧不完整，等待更多数据
@@ -138,58 +165,204 @@ static void parse_and_dispatch(const uint8_t* data, size_t len) {
     }
 }
 
+// 命令数据（文本行或 AA55 帧）：累积到解析缓冲后解析
+static void usb_feed_commands(const uint8_t* data, size_t n) {
+    if (s_parse_len + n > USB_RX_BUFFER_SIZE) {
+        // 解析缓冲放不下时只保留最新的数据
+        if (n < USB_RX_BUFFER_SIZE) {
+            memmove(s_parse_buf, &s_parse_buf[s_parse_len + n - USB_RX_BUFFER_SIZE], USB_RX_BUFFER_SIZE - n);
+            memcpy(&s_parse_buf[USB_RX_BUFFER_SIZE - n], data, n);
+        } else {
+            memcpy(s_parse_buf, &data[n - USB_RX_BUFFER_SIZE], USB_RX_BUFFER_SIZE);
+        }
+        s_parse_len = USB_RX_BUFFER_SIZE;
+    } else {
+        memcpy(&s_parse_buf[s_parse_len], data, n);
+        s_parse_len += n;
+    }
+    parse_and_dispatch(s_parse_buf, s_parse_len);
+}
+
+// 编码任务用完像素块后归还接收缓冲
+static void usb_chunk_release(uint8_t* data, void* ctx) {
+    (void)ctx;
+    xQueueSend(s_chunk_pool, &data, portMAX_DELAY);
+}
+
+// 从 pos 开始找下一个块魔数，找不到时返回末尾（末字节是魔数1时保留它）
+static size_t usb_find_block_magic(const uint8_t* data, size_t pos, size_t len) {
+    for (; pos + 1 < len; pos++) {
+        if (data[pos] == PIXEL_BLOCK_MAGIC_1 && data[pos + 1] == PIXEL_BLOCK_MAGIC_2) {
+            return pos;
+        }
+    }
+    return (pos < len && data[pos] == PIXEL_BLOCK_MAGIC_1) ? pos : len;
+}
+
+// 处理当前缓冲：开头连续的完整像素块交给编码任务，不完整的块搬到新缓冲开头等待后续数据，
+// 块之后不是魔数的部分按命令解析。CRC 由编码任务校验。
+static void usb_process_chunk(void) {
+    const uint8_t* data = s_chunk;
+    size_t len = s_chunk_len;
+
+    // 上次留下半行命令且新数据不是像素块时，整段按命令续接
+    bool starts_pixel = len >= 1 && data[0] == PIXEL_BLOCK_MAGIC_1 && (len < 2 || data[1] == PIXEL_BLOCK_MAGIC_2);
+    if (s_parse_len > 0 && !starts_pixel) {
+        usb_feed_commands(data, len);
+        s_chunk_len = 0;
+        return;
+    }
+
+    size_t pos = 0;
+    while (pos < len) {
+        if (data[pos] != PIXEL_BLOCK_MAGIC_1 || (pos + 1 < len && data[pos + 1] != PIXEL_BLOCK_MAGIC_2)) {
+            break;
+        }
+        if (pos + sizeof(pixel_block_header_t) > len) {
+            break; // 块头不完整
+        }
+        pixel_block_header_t hdr;
+        memcpy(&hdr, &data[pos], sizeof(hdr));
+        size_t block_size = sizeof(pixel_block_header_t) + hdr.length;
+        if (hdr.length == 0 || block_size > USB_RX_CHUNK_SIZE) {
+            // 长度不可能是合法块，跳到下一个魔数重新同步
+            s_stats.resyncs++;
+            size_t next = usb_find_block_magic(data, pos + 1, len);
+            memmove(s_chunk + pos, s_chunk + next, len - next);
+            len -= next - pos;
+            continue;
+        }
+        if (pos + block_size > len) {
+            break; // 块不完整
+        }
+        pos += block_size;
+        s_stats.blocks++;
+    }
+
+    // 块之后的数据：以魔数开头的是下一个不完整的块，其余按命令解析
+    size_t tail = len - pos;
+    bool partial_block = tail > 0 && data[pos] == PIXEL_BLOCK_MAGIC_1 &&
+                         (tail == 1 || data[pos + 1] == PIXEL_BLOCK_MAGIC_2);
+    if (tail > 0 && !partial_block) {
+        usb_feed_commands(&data[pos], tail);
+        tail = 0;
+    }
+
+    if (pos == 0) {
+        s_chunk_len = tail;
+        return;
+    }
+
+    // 完整块所在的缓冲整体交给编码器，不完整的块复制到新缓冲开头
+    uint8_t* full = s_chunk;
+    uint8_t* next = NULL;
+    xQueueReceive(s_chunk_pool, &next, portMAX_DELAY);
+    memcpy(next, full + pos, tail);
+    s_chunk = next;
+    s_chunk_len = tail;
+
+    s_stats.pixel_bytes += pos;
+    if (jpeg_stream_encoder_feed_blocks(full, pos, usb_chunk_release, NULL, pdMS_TO_TICKS(1000)) != ESP_OK) {
+        s_stats.feed_drops++;
+        usb_chunk_release(full, NULL);
+    } else {
+        s_stats.chunks_fed++;
+    }
+}
+
 static void usb_rx_task(void* arg) {
     ESP_LOGI(TAG, "USB CDC 接收任务启动");
 
-    if (!s_parse_buf) {
+    if (!s_parse_buf || !s_chunk_pool) {
         ESP_LOGE(TAG, "Parse buffer not initialized");
-        vTaskDelete(NULL);
+        s_usb_task_running = false;
+        task_placement_delete(NULL);
         return;
     }
 
     // 等待USB连接建立
-    while (!tusb_cdc_acm_initialized(TINYUSB_CDC_ACM_0)) {
+    while (!tusb_cdc_acm_initialized(TINYUSB_CDC_ACM_0) && !s_usb_stopping) {
         ESP_LOGI(TAG, "等待USB CDC初始化完成...");
         vTaskDelay(pdMS_TO_TICKS(500));
     }
 
     ESP_LOGI(TAG, "USB CDC已初始化，开始接收数据");
 
-    while (1) {
+    if (!s_chunk) {
+        xQueueReceive(s_chunk_pool, &s_chunk, portMAX_DELAY);
+        s_chunk_len = 0;
+    }
+
+    while (!s_usb_stopping) {
+        // 直接读入接收缓冲的剩余空间，一次可读空 CDC FIFO
         size_t n = 0;
-        esp_err_t ret = tinyusb_cdcacm_read(TINYUSB_CDC_ACM_0, s_rx_chunk, sizeof(s_rx_chunk), &n);
-        if (ret == ESP_OK && n > 0) {
-            // 接收到USB数据
-            if (s_parse_len + (size_t)n > USB_RX_BUFFER_SIZE) {
-                size_t to_copy = USB_RX_BUFFER_SIZE;
-                if ((size_t)n < USB_RX_BUFFER_SIZE) {
-                    memmove(s_parse_buf, &s_parse_buf[s_parse_len + n - USB_RX_BUFFER_SIZE],
-                            USB_RX_BUFFER_SIZE - (size_t)n);
-                    memcpy(&s_parse_buf[USB_RX_BUFFER_SIZE - (size_t)n], s_rx_chunk, (size_t)n);
-                } else {
-                    memcpy(s_parse_buf, &s_rx_chunk[n - USB_RX_BUFFER_SIZE], USB_RX_BUFFER_SIZE);
-                }
-                s_parse_len = to_copy;
-            } else {
-                memcpy(&s_parse_buf[s_parse_len], s_rx_chunk, (size_t)n);
-                s_parse_len += (size_t)n;
-            }
-            parse_and_dispatch(s_parse_buf, s_parse_len);
-        } else {
-            vTaskDelay(pdMS_TO_TICKS(5));
+        esp_err_t ret = tinyusb_cdcacm_read(TINYUSB_CDC_ACM_0, s_chunk + s_chunk_len, USB_RX_CHUNK_SIZE - s_chunk_len,
+                                            &n);
+        if (ret != ESP_OK || n == 0) {
+            // FIFO 已读空，等接收回调唤醒；超时兜底防止漏掉通知
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+            continue;
         }
-        // 无论是否有数据，适当让出 CPU，防止长期占用导致 WDT 触发
-        vTaskDelay(1);
+        s_stats.bytes += n;
+        s_chunk_len += n;
+        usb_process_chunk();
     }
+
+    // 正在读入的缓冲归还缓冲池，未凑完整的数据丢弃
+    xQueueSend(s_chunk_pool, &s_chunk, 0);
+    s_chunk = NULL;
+    s_chunk_len = 0;
+    ESP_LOGI(TAG, "USB CDC 接收任务退出");
+    s_usb_task_running = false;
+    task_placement_delete(NULL);
+}
+
+static void usb_free_buffers(void) {
+    if (s_parse_buf) {
+        free(s_parse_buf);
+        s_parse_buf = NULL;
+    }
+    for (int i = 0; i < USB_RX_POOL_SIZE; i++) {
+        if (s_chunk_bufs[i]) {
+            heap_caps_free(s_chunk_bufs[i]);
+            s_chunk_bufs[i] = NULL;
+        }
+    }
+    if (s_chunk_pool) {
+        vQueueDelete(s_chunk_pool);
+        s_chunk_pool = NULL;
+    }
+    s_chunk = NULL;
+    s_chunk_len = 0;
 }
 
 esp_err_t usb_receiver_init(void) {
+    s_tx_mutex = xSemaphoreCreateMutex();
+    if (!s_tx_mutex) {
+        return ESP_ERR_NO_MEM;
+    }
+
     // Allocate parse buffer from PSRAM to save internal RAM
     s_parse_buf = (uint8_t*)heap_caps_malloc(USB_RX_BUFFER_SIZE, MALLOC_CAP_SPIRAM);
     if (!s_parse_buf) {
         ESP_LOGE(TAG, "Failed to allocate parse buffer from PSRAM");
         return ESP_ERR_NO_MEM;
     }
+
+    // 像素接收缓冲池放在PSRAM，USB全速带宽远低于PSRAM带宽
+    s_chunk_pool = xQueueCreate(USB_RX_POOL_SIZE, sizeof(uint8_t*));
+    for (int i = 0; s_chunk_pool && i < USB_RX_POOL_SIZE; i++) {
+        s_chunk_bufs[i] = (uint8_t*)heap_caps_malloc(USB_RX_CHUNK_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!s_chunk_bufs[i]) {
+            break;
+        }
+        xQueueSend(s_chunk_pool, &s_chunk_bufs[i], 0);
+    }
+    if (!s_chunk_pool || !s_chunk_bufs[USB_RX_POOL_SIZE - 1]) {
+        ESP_LOGE(TAG, "Failed to allocate USB rx chunk pool");
+        usb_free_buffers();
+        return ESP_ERR_NO_MEM;
+    }
     // ESP32-S3内置USB接口，不需要外部PHY
     const tinyusb_config_t tusb_cfg = {
         .device_descriptor = NULL,        // 使用默认设备描述符
@@ -202,8 +375,7 @@ esp_err_t usb_receiver_init(void) {
     esp_err_t ret = tinyusb_driver_install(&tusb_cfg);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "tinyusb_driver_install 失败: %s", esp_err_to_name(ret));
-        free(s_parse_buf);
-        s_parse_buf = NULL;
+        usb_free_buffers();
         return ret;
     }
 
@@ -211,7 +383,7 @@ esp_err_t usb_receiver_init(void) {
         .usb_dev = TINYUSB_USBDEV_0,
         .cdc_port = TINYUSB_CDC_ACM_0,
         .rx_unread_buf_sz = 2048, // 扩大内部未读缓冲
-        .callback_rx = NULL,
+        .callback_rx = usb_rx_callback,
         .callback_rx_wanted_char = NULL,
         .callback_line_state_changed = usb_line_state_changed_callback,
         .callback_line_coding_changed = NULL,
@@ -219,45 +391,114 @@ esp_err_t usb_receiver_init(void) {
     ret = tusb_cdc_acm_init(&acm_cfg);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "tinyusb_cdcacm_init 失败: %s", esp_err_to_name(ret));
-        free(s_parse_buf);
-        s_parse_buf = NULL;
+        usb_free_buffers();
         return ret;
     }
 
+    // 枚举由TinyUSB任务在后台完成，接收任务在主机打开端口后才会收到数据，这里不需要等待
     ESP_LOGI(TAG, "USB CDC 初始化完成");
-
-    // 等待USB连接建立
-    ESP_LOGI(TAG, "等待USB设备连接...");
-
-    // 给USB设备一些时间来枚举
-    vTaskDelay(pdMS_TO_TICKS(1000));
     return ESP_OK;
 }
 
 void usb_receiver_start(void) {
     if (s_usb_task)
         return;
-    // 降低任务优先级并固定到 CPU1，减少对 CPU0 空闲任务的影响
-    xTaskCreatePinnedToCore(usb_rx_task, "usb_rx", 4096, NULL, 4, &s_usb_task, 1);
+    // 固定到 CPU1，减少对 CPU0 空闲任务的影响（见任务布局表）
+    s_usb_stopping = false;
+    s_usb_task_running = true;
+    if (task_placement_create(usb_rx_task, "usb_rx", NULL, &s_usb_task) != pdPASS) {
+        s_usb_task_running = false;
+        s_usb_task = NULL;
+    }
+}
+
+// 等待接收任务退出并且所有缓冲回到缓冲池，超时返回 false
+static bool usb_wait_pool_idle(void) {
+    TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(USB_RX_STOP_TIMEOUT_MS);
+    while (s_usb_task_running || (s_chunk_pool && uxQueueMessagesWaiting(s_chunk_pool) < USB_RX_POOL_SIZE)) {
+        if ((int32_t)(xTaskGetTickCount() - deadline) >= 0) {
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return true;
 }
 
 void usb_receiver_stop(void) {
+    // 接收任务自行退出：处理完当前缓冲后把它还回缓冲池，不在持有缓冲时被强行删除
     if (s_usb_task) {
-        vTaskDelete(s_usb_task);
-        s_usb_task = NULL;
+        s_usb_stopping = true;
+        xTaskNotifyGive(s_usb_task);
     }
-    // tinyusb_driver_uninstall 函数在当前版本中不可用 (IDF-1474)
-    // 由于没有卸载函数，直接返回
-    if (s_parse_buf) {
-        free(s_parse_buf);
-        s_parse_buf = NULL;
+
+    // 交给编码器的缓冲在编码器用完或停止时经 usb_chunk_release 归还；
+    // 调用者应先停止编码器（jpeg_stream_encoder_stop 会等编码任务退出并归还排队中的缓冲），
+    // 缓冲全部回到池中后才能释放，否则归还时会访问已删除的队列
+    if (!usb_wait_pool_idle()) {
+        ESP_LOGE(TAG, "USB rx buffers still in use (%u/%d returned), not freeing",
+                 s_chunk_pool ? (unsigned)uxQueueMessagesWaiting(s_chunk_pool) : 0, USB_RX_POOL_SIZE);
+        return;
     }
+    s_usb_task = NULL;
+
+    // tinyusb_driver_uninstall 函数在当前版本中不可用 (IDF-1474)，驱动保持安装，只释放缓冲
+    usb_free_buffers();
+}
+
+void usb_receiver_get_stats(usb_rx_stats_t* out) {
+    if (out) {
+        *out = s_stats;
+    }
+}
+
+bool usb_receiver_is_connected(void) { return s_usb_connected; }
+
+// 写入 CDC 发送 FIFO，FIFO 满时 flush 等待主机读取
+static esp_err_t usb_write_all(const uint8_t* data, size_t len, TickType_t deadline) {
+    while (len > 0) {
+        size_t n = tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_0, data, len);
+        data += n;
+        len -= n;
+        if (len == 0) {
+            break;
+        }
+        TickType_t now = xTaskGetTickCount();
+        if (!s_usb_connected || (int32_t)(deadline - now) <= 0) {
+            return s_usb_connected ? ESP_ERR_TIMEOUT : ESP_ERR_INVALID_STATE;
+        }
+        tinyusb_cdcacm_write_flush(TINYUSB_CDC_ACM_0, 1);
+    }
+    return ESP_OK;
+}
+
+esp_err_t usb_receiver_write_frame(const uint8_t* prefix, size_t prefix_len, const uint8_t* data, size_t len,
+                                   TickType_t timeout) {
+    if (!s_usb_connected || !s_tx_mutex) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    TickType_t deadline = xTaskGetTickCount() + timeout;
+    if (xSemaphoreTake(s_tx_mutex, timeout) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    esp_err_t ret = ESP_OK;
+    if (prefix && prefix_len > 0) {
+        ret = usb_write_all(prefix, prefix_len, deadline);
+    }
+    if (ret == ESP_OK) {
+        ret = usb_write_all(data, len, deadline);
+    }
+    tinyusb_cdcacm_write_flush(TINYUSB_CDC_ACM_0, 0);
+    xSemaphoreGive(s_tx_mutex);
+    return ret;
 }
 
 // 供命令终端使用的输出函数：通过USB CDC回传到主机
 void cmd_terminal_write(const char* s) {
     if (!s || !s_usb_connected)
         return;
+    // 视频帧发送中时等它发完，避免文本插入帧数据中间
+    if (s_tx_mutex && xSemaphoreTake(s_tx_mutex, pdMS_TO_TICKS(1000)) != pdTRUE)
+        return;
     size_t len = strlen(s);
     // 将整段字符串写入CDC队列并flush
     tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_0, (const uint8_t*)s, len);
@@ -266,4 +507,6 @@ void cmd_terminal_write(const char* s) {
     const char crlf[] = "\r\n";
     tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_0, (const uint8_t*)crlf, sizeof(crlf) - 1);
     tinyusb_cdcacm_write_flush(TINYUSB_CDC_ACM_0, 0);
+    if (s_tx_mutex)
+        xSemaphoreGive(s_tx_mutex);
 }
@@ -0,0 +1,459 @@
+/**
+ * @file video_output.c
+ * @brief 接收端JPEG帧输出实现
+ * @author TidyCraze
+ * @date 2025-10-18
+ */
+
+#include "video_output.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "lwip/inet.h"
+#include "lwip/sockets.h"
+#include "task_placement.h"
+#include "usb_device_receiver.h"
+#include <errno.h>
+#include <string.h>
+
+static const char* TAG = "video_out";
+
+#define STATS_WINDOW_US 1000000      // 吞吐统计窗口
+#define TCP_RECONNECT_INTERVAL_MS 2000
+#define SINK_SEND_TIMEOUT_MS 1000
+#define UDP_SEND_RETRIES 3            // lwIP 缓冲不足时的重试次数
+
+_Static_assert(sizeof(p2p_udp_packet_header_t) == 32, "p2p_udp_packet_header_t must match the display side");
+
+// 帧池中的一帧，refs 为持有该帧的输出数
+typedef struct {
+    uint8_t* data;
+    size_t len;
+    uint32_t frame_id;
+    int refs;
+} video_frame_t;
+
+typedef struct video_sink video_sink_t;
+
+struct video_sink {
+    const char* name;      // 输出名称
+    const char* task_name; // 发送任务名（任务布局表）
+    esp_err_t (*send)(video_sink_t* sink, const video_frame_t* frame);
+    void (*close)(video_sink_t* sink);
+    volatile bool enabled;
+    QueueHandle_t queue; // video_frame_t*，长度为在途上限
+    TaskHandle_t task;
+    int sock;
+    uint32_t in_flight;
+    video_sink_stats_t stats;
+    int64_t window_start_us;
+    uint64_t window_bytes;
+    uint32_t window_frames;
+};
+
+static esp_err_t udp_send_frame(video_sink_t* sink, const video_frame_t* frame);
+static esp_err_t tcp_send_frame(video_sink_t* sink, const video_frame_t* frame);
+static esp_err_t usb_send_frame(video_sink_t* sink, const video_frame_t* frame);
+static void socket_close(video_sink_t* sink);
+
+static video_sink_t s_sinks[VIDEO_SINK_MAX] = {
+    [VIDEO_SINK_UDP] = {.name = "udp", .task_name = "vout_udp", .send = udp_send_frame, .close = socket_close, .sock = -1},
+    [VIDEO_SINK_TCP] = {.name = "tcp", .task_name = "vout_tcp", .send = tcp_send_frame, .close = socket_close, .sock = -1},
+    [VIDEO_SINK_USB] = {.name = "usb", .task_name = "vout_usb", .send = usb_send_frame, .close = NULL, .sock = -1},
+};
+
+static video_frame_t s_frames[VIDEO_OUTPUT_POOL_SIZE];
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool s_initialized = false;
+static uint32_t s_frame_id = 0;
+
+// 目标地址
+static struct sockaddr_in s_udp_peer;
+static struct sockaddr_in s_tcp_server;
+static volatile bool s_tcp_server_set = false;
+static volatile bool s_tcp_server_changed = false;
+static int64_t s_tcp_last_attempt_us = 0;
+static uint16_t s_udp_sequence = 0;
+
+static void frame_release(video_frame_t* frame) {
+    portENTER_CRITICAL(&s_lock);
+    frame->refs--;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+// ==================== UDP ====================
+
+static uint16_t p2p_checksum(const uint8_t* data, uint16_t len) {
+    uint32_t sum = 0;
+    for (uint16_t i = 0; i < len; i++) {
+        sum += data[i];
+    }
+    return (uint16_t)(sum & 0xFFFF);
+}
+
+static esp_err_t udp_open(video_sink_t* sink) {
+    sink->sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (sink->sock < 0) {
+        ESP_LOGE(TAG, "UDP socket create failed: errno %d", errno);
+        return ESP_FAIL;
+    }
+    int broadcast = 1;
+    setsockopt(sink->sock, SOL_SOCKET, SO_BROADCAST, &broadcast, sizeof(broadcast));
+    return ESP_OK;
+}
+
+// 按 p2p_udp_packet_header_t 分包发送，包头和负载用 sendmsg 组合，不复制负载
+static esp_err_t udp_send_frame(video_sink_t* sink, const video_frame_t* frame) {
+    if (sink->sock < 0 && udp_open(sink) != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    const uint32_t payload_size = P2P_UDP_MAX_PACKET_SIZE - sizeof(p2p_udp_packet_header_t);
+    const uint16_t total_packets = (frame->len + payload_size - 1) / payload_size;
+    const uint32_t timestamp = (uint32_t)(esp_timer_get_time() / 1000);
+    p2p_udp_packet_header_t header;
+
+    for (uint16_t packet_id = 0; packet_id < total_packets; packet_id++) {
+        uint32_t offset = packet_id * payload_size;
+        uint16_t data_size = (offset + payload_size > frame->len) ? (frame->len - offset) : payload_size;
+
+        memset(&header, 0, sizeof(header));
+        header.magic = P2P_UDP_MAGIC_NUMBER;
+        header.packet_type = P2P_UDP_PACKET_TYPE_FRAME_DATA;
+        header.version = 1;
+        header.sequence_num = s_udp_sequence++;
+        header.frame_id = frame->frame_id;
+        header.packet_id = packet_id;
+        header.total_packets = total_packets;
+        header.frame_size = frame->len;
+        header.data_size = data_size;
+        header.checksum = p2p_checksum(frame->data + offset, data_size);
+        header.timestamp = timestamp;
+
+        struct iovec iov[2] = {
+            {.iov_base = &header, .iov_len = sizeof(header)},
+            {.iov_base = (void*)(frame->data + offset), .iov_len = data_size},
+        };
+        struct msghdr msg = {
+            .msg_name = &s_udp_peer,
+            .msg_namelen = sizeof(s_udp_peer),
+            .msg_iov = iov,
+            .msg_iovlen = 2,
+        };
+
+        int retries = 0;
+        while (sendmsg(sink->sock, &msg, 0) < 0) {
+            // lwIP 发送缓冲不足时稍等再发，其他错误放弃这一帧
+            if ((errno != ENOMEM && errno != ENOBUFS) || ++retries > UDP_SEND_RETRIES) {
+                return ESP_FAIL;
+            }
+            vTaskDelay(1);
+        }
+    }
+    return ESP_OK;
+}
+
+// ==================== TCP ====================
+
+static esp_err_t tcp_connect(video_sink_t* sink) {
+    int64_t now = esp_timer_get_time();
+    if (now - s_tcp_last_attempt_us < (int64_t)TCP_RECONNECT_INTERVAL_MS * 1000) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_tcp_last_attempt_us = now;
+    s_tcp_server_changed = false;
+
+    sink->sock = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    if (sink->sock < 0) {
+        ESP_LOGE(TAG, "TCP socket create failed: errno %d", errno);
+        return ESP_FAIL;
+    }
+    struct timeval timeout = {.tv_sec = SINK_SEND_TIMEOUT_MS / 1000, .tv_usec = 0};
+    setsockopt(sink->sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    int nodelay = 1;
+    setsockopt(sink->sock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    if (connect(sink->sock, (struct sockaddr*)&s_tcp_server, sizeof(s_tcp_server)) != 0) {
+        ESP_LOGW(TAG, "TCP connect to %s:%d failed: errno %d", inet_ntoa(s_tcp_server.sin_addr),
+                 ntohs(s_tcp_server.sin_port), errno);
+        socket_close(sink);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "TCP output connected to %s:%d", inet_ntoa(s_tcp_server.sin_addr), ntohs(s_tcp_server.sin_port));
+    return ESP_OK;
+}
+
+static esp_err_t tcp_send_all(int sock, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        int n = send(sock, data, len, 0);
+        if (n <= 0) {
+            return ESP_FAIL;
+        }
+        data += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t tcp_send_frame(video_sink_t* sink, const video_frame_t* frame) {
+    if (!s_tcp_server_set) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_tcp_server_changed) {
+        socket_close(sink);
+        s_tcp_last_attempt_us = 0;
+    }
+    if (sink->sock < 0 && tcp_connect(sink) != ESP_OK) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint8_t prefix[4] = {(uint8_t)(frame->len >> 24), (uint8_t)(frame->len >> 16), (uint8_t)(frame->len >> 8),
+                         (uint8_t)frame->len};
+    if (tcp_send_all(sink->sock, prefix, sizeof(prefix)) != ESP_OK ||
+        tcp_send_all(sink->sock, frame->data, frame->len) != ESP_OK) {
+        // 发送中断后流已错位，断开重连
+        ESP_LOGW(TAG, "TCP output send failed: errno %d, reconnecting", errno);
+        socket_close(sink);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+// ==================== USB ====================
+
+static esp_err_t usb_send_frame(video_sink_t* sink, const video_frame_t* frame) {
+    (void)sink;
+    if (!usb_receiver_is_connected()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint8_t prefix[8] = {'V', 'O', 'U', 'T', (uint8_t)(frame->len >> 24), (uint8_t)(frame->len >> 16),
+                         (uint8_t)(frame->len >> 8), (uint8_t)frame->len};
+    return usb_receiver_write_frame(prefix, sizeof(prefix), frame->data, frame->len,
+                                    pdMS_TO_TICKS(SINK_SEND_TIMEOUT_MS));
+}
+
+// ==================== 发送任务 ====================
+
+static void socket_close(video_sink_t* sink) {
+    if (sink->sock >= 0) {
+        close(sink->sock);
+        sink->sock = -1;
+    }
+}
+
+static void sink_update_window(video_sink_t* sink, size_t bytes) {
+    int64_t now = esp_timer_get_time();
+    sink->window_bytes += bytes;
+    sink->window_frames++;
+    int64_t elapsed = now - sink->window_start_us;
+    if (elapsed >= STATS_WINDOW_US) {
+        sink->stats.kbps = (uint32_t)(sink->window_bytes * 8 * 1000 / elapsed);
+        sink->stats.fps = sink->window_frames * 1000000.0f / elapsed;
+        sink->window_bytes = 0;
+        sink->window_frames = 0;
+        sink->window_start_us = now;
+    }
+}
+
+static void video_sink_task(void* arg) {
+    video_sink_t* sink = (video_sink_t*)arg;
+    video_frame_t* frame = NULL;
+    sink->window_start_us = esp_timer_get_time();
+
+    while (1) {
+        if (xQueueReceive(sink->queue, &frame, pdMS_TO_TICKS(1000)) != pdTRUE) {
+            // 停用后释放连接
+            if (!sink->enabled && sink->close) {
+                sink->close(sink);
+            }
+            // 空闲时窗口吞吐归零
+            if (esp_timer_get_time() - sink->window_start_us >= STATS_WINDOW_US && sink->window_frames == 0) {
+                sink->stats.kbps = 0;
+                sink->stats.fps = 0;
+                sink->window_start_us = esp_timer_get_time();
+            }
+            continue;
+        }
+
+        esp_err_t ret = sink->enabled ? sink->send(sink, frame) : ESP_ERR_INVALID_STATE;
+        if (ret == ESP_OK) {
+            sink->stats.frames_sent++;
+            sink->stats.bytes_sent += frame->len;
+            sink_update_window(sink, frame->len);
+        } else if (ret == ESP_ERR_INVALID_STATE) {
+            // 输出未就绪（未连接、未配置）
+            sink->stats.frames_dropped++;
+        } else {
+            sink->stats.send_errors++;
+        }
+
+        frame_release(frame);
+        portENTER_CRITICAL(&s_lock);
+        sink->in_flight--;
+        portEXIT_CRITICAL(&s_lock);
+    }
+}
+
+// ==================== 公共接口 ====================
+
+esp_err_t video_output_init(void) {
+    if (s_initialized) {
+        return ESP_OK;
+    }
+
+    for (int i = 0; i < VIDEO_OUTPUT_POOL_SIZE; i++) {
+        s_frames[i].data = heap_caps_malloc(VIDEO_OUTPUT_MAX_FRAME_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (s_frames[i].data == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate frame pool");
+            for (int j = 0; j < i; j++) {
+                heap_caps_free(s_frames[j].data);
+                s_frames[j].data = NULL;
+            }
+            return ESP_ERR_NO_MEM;
+        }
+        s_frames[i].refs = 0;
+    }
+
+    for (int i = 0; i < VIDEO_SINK_MAX; i++) {
+        s_sinks[i].queue = xQueueCreate(VIDEO_OUTPUT_MAX_IN_FLIGHT, sizeof(video_frame_t*));
+        if (s_sinks[i].queue == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    video_output_set_udp_peer(NULL);
+    s_initialized = true;
+
+    // UDP 广播给遥控器端的 P2P 接收，USB 在主机打开端口后才发送
+    video_output_enable(VIDEO_SINK_UDP, true);
+    video_output_enable(VIDEO_SINK_USB, true);
+    ESP_LOGI(TAG, "Video output initialized: pool %d x %d KB", VIDEO_OUTPUT_POOL_SIZE,
+             VIDEO_OUTPUT_MAX_FRAME_SIZE / 1024);
+    return ESP_OK;
+}
+
+esp_err_t video_output_enable(video_sink_type_t type, bool enable) {
+    if (!s_initialized || type >= VIDEO_SINK_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    video_sink_t* sink = &s_sinks[type];
+    if (enable && sink->task == NULL) {
+        if (task_placement_create(video_sink_task, sink->task_name, sink, &sink->task) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create %s output task", sink->name);
+            sink->task = NULL;
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    sink->enabled = enable;
+    ESP_LOGI(TAG, "Output %s %s", sink->name, enable ? "enabled" : "disabled");
+    return ESP_OK;
+}
+
+esp_err_t video_output_set_udp_peer(const char* ip) {
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(P2P_UDP_PORT);
+    if (ip == NULL) {
+        addr.sin_addr.s_addr = htonl(INADDR_BROADCAST);
+    } else if (inet_pton(AF_INET, ip, &addr.sin_addr) != 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_udp_peer = addr;
+    return ESP_OK;
+}
+
+esp_err_t video_output_set_tcp_server(const char* ip, uint16_t port) {
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port ? port : VIDEO_OUTPUT_TCP_DEFAULT_PORT);
+    if (ip == NULL || inet_pton(AF_INET, ip, &addr.sin_addr) != 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_tcp_server = addr;
+    s_tcp_server_set = true;
+    s_tcp_server_changed = true;
+    return ESP_OK;
+}
+
+void video_output_submit(const uint8_t* jpeg, size_t len) {
+    if (!s_initialized || jpeg == NULL || len == 0) {
+        return;
+    }
+
+    bool any_enabled = false;
+    for (int i = 0; i < VIDEO_SINK_MAX; i++) {
+        any_enabled |= s_sinks[i].enabled;
+    }
+    if (!any_enabled) {
+        return;
+    }
+
+    // 找一个空闲的帧池槽位，提交方先持有一个引用，分发完再释放
+    video_frame_t* frame = NULL;
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < VIDEO_OUTPUT_POOL_SIZE; i++) {
+        if (s_frames[i].refs == 0) {
+            frame = &s_frames[i];
+            frame->refs = 1;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (frame == NULL || len > VIDEO_OUTPUT_MAX_FRAME_SIZE) {
+        for (int i = 0; i < VIDEO_SINK_MAX; i++) {
+            if (s_sinks[i].enabled) {
+                s_sinks[i].stats.frames_dropped++;
+            }
+        }
+        if (frame) {
+            frame_release(frame);
+        }
+        return;
+    }
+
+    memcpy(frame->data, jpeg, len);
+    frame->len = len;
+    frame->frame_id = ++s_frame_id;
+
+    for (int i = 0; i < VIDEO_SINK_MAX; i++) {
+        video_sink_t* sink = &s_sinks[i];
+        if (!sink->enabled || sink->task == NULL) {
+            continue;
+        }
+        // 在途帧达到上限说明这个输出跟不上，丢帧不等待
+        portENTER_CRITICAL(&s_lock);
+        bool accept = sink->in_flight < VIDEO_OUTPUT_MAX_IN_FLIGHT;
+        if (accept) {
+            frame->refs++;
+            sink->in_flight++;
+        }
+        portEXIT_CRITICAL(&s_lock);
+        if (!accept) {
+            sink->stats.frames_dropped++;
+        } else if (xQueueSend(sink->queue, &frame, 0) != pdTRUE) {
+            portENTER_CRITICAL(&s_lock);
+            frame->refs--;
+            sink->in_flight--;
+            portEXIT_CRITICAL(&s_lock);
+            sink->stats.frames_dropped++;
+        }
+    }
+    frame_release(frame);
+}
+
+void video_output_get_stats(video_sink_type_t type, video_sink_stats_t* out) {
+    if (out == NULL || type >= VIDEO_SINK_MAX) {
+        return;
+    }
+    *out = s_sinks[type].stats;
+    out->enabled = s_sinks[type].enabled;
+    out->in_flight = s_sinks[type].in_flight;
+}
+
+const char* video_output_sink_name(video_sink_type_t type) {
+    return type < VIDEO_SINK_MAX ? s_sinks[type].name : "unknown";
+}
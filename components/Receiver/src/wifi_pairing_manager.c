@@ -11,6 +11,7 @@
 #include "freertos/timers.h"
 #include "nvs.h"
 #include "nvs_flash.h"
+#include "task_placement.h"
 
 #include "led_status_manager.h"
 #include "wifi_pairing_manager.h"
@@ -351,8 +352,8 @@ esp_err_t wifi_pairing_trigger_scan(void) {
 
     // 创建扫描任务
     if (s_scan_task_handle == NULL) {
-        BaseType_t ret = xTaskCreate(wifi_scan_task, "wifi_scan", s_config.task_stack_size, NULL,
-                                     s_config.task_priority, &s_scan_task_handle);
+        BaseType_t ret = task_placement_create_ex(wifi_scan_task, "wifi_scan", NULL, s_config.task_stack_size,
+                                                  s_config.task_priority, &s_scan_task_handle);
         if (ret != pdPASS) {
             ESP_LOGE(TAG, "创建WiFi扫描任务失败");
             return ESP_ERR_NO_MEM;
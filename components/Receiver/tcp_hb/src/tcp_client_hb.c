@@ -26,6 +26,7 @@
 
 #include "tcp_client_hb.h"
 #include "tcp_common_protocol.h"
+#include "task_placement.h"
 
 static const char *TAG = "TCP_CLIENT_HB";
 
@@ -354,7 +355,7 @@ static void tcp_client_hb_task_function(void *pvParameters) {
     }
     
     ESP_LOGI(TAG, "心跳任务结束");
-    vTaskDelete(NULL);
+    task_placement_delete(NULL);
 }
 
 // ----------------- 公共接口实现 -----------------
@@ -425,18 +426,16 @@ bool tcp_client_hb_start(const char *task_name, uint32_t stack_size, UBaseType_t
         return true;
     }
 
-    // 设置默认参数
-    const char *name = task_name ? task_name : "tcp_hb_task";
-    uint32_t stack = (stack_size > 0) ? stack_size : 4096;
-    UBaseType_t priority = task_priority;
+    // 未指定的参数使用任务布局表中 "tcp_hb" 的配置
+    const char *name = task_name ? task_name : "tcp_hb";
 
     // 创建任务
-    BaseType_t result = xTaskCreate(
+    BaseType_t result = task_placement_create_ex(
         tcp_client_hb_task_function,
         name,
-        stack,
         NULL,
-        priority,
+        stack_size,
+        task_priority,
         &g_hb_client.heartbeat_task_handle
     );
 
@@ -80,9 +80,9 @@ bool tcp_client_telemetry_init(const char *server_ip, uint16_t server_port);
 
 /**
  * @brief 启动TCP遥测客户端任务
- * @param task_name 任务名称
- * @param stack_size 任务栈大小
- * @param task_priority 任务优先级
+ * @param task_name 任务名称，NULL 时为 "tcp_telemetry"（任务布局表的键）
+ * @param stack_size 任务栈大小，0 表示使用任务布局表
+ * @param task_priority 任务优先级，0 表示使用任务布局表
  * @return true 启动成功，false 启动失败
  */
 bool tcp_client_telemetry_start(const char *task_name, uint32_t stack_size, UBaseType_t task_priority);
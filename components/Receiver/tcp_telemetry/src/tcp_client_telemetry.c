@@ -23,6 +23,7 @@
 #include "lwip/sockets.h"
 #include "lwip/sys.h"
 #include "lwip/netdb.h"
+#include "task_placement.h"
 
 static const char *TAG = "TCP_CLIENT_TELEMETRY";
 
@@ -306,7 +307,7 @@ static void tcp_client_telemetry_task_function(void *pvParameters) {
     }
     
     ESP_LOGI(TAG, "遥测任务结束");
-    vTaskDelete(NULL);
+    task_placement_delete(NULL);
 }
 
 // ----------------- 公共接口实现 -----------------
@@ -353,18 +354,16 @@ bool tcp_client_telemetry_start(const char *task_name, uint32_t stack_size, UBas
         return true;
     }
 
-    // 设置默认参数
-    const char *name = task_name ? task_name : "tcp_telemetry_task";
-    uint32_t stack = (stack_size > 0) ? stack_size : 4096;
-    UBaseType_t priority = task_priority;
+    // 未指定的参数使用任务布局表中 "tcp_telemetry" 的配置
+    const char *name = task_name ? task_name : "tcp_telemetry";
 
     // 创建任务
-    BaseType_t result = xTaskCreate(
+    BaseType_t result = task_placement_create_ex(
         tcp_client_telemetry_task_function,
         name,
-        stack,
         NULL,
-        priority,
+        stack_size,
+        task_priority,
         &g_telemetry_client.telemetry_task_handle
     );
 
@@ -10,18 +10,13 @@
  *********************/
 #include "lv_port_disp.h"
 #include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include <stdbool.h>
 
-// ========================================
-// 驱动选择宏定义开关
-// ========================================
-#define USE_ESP_LCD_DRIVER 0 // 0=使用原始驱动, 1=使用ESP-LCD驱动
-
-#if USE_ESP_LCD_DRIVER
+#include "st7789.h"         // 原始驱动
 #include "st7789_esp_lcd.h" // ESP-LCD驱动
-#else
-#include "st7789.h" // 原始驱动
-#endif
+#include "spi_bus_arbiter.h" // 与触摸共用SPI2
 
 /*********************
  *      DEFINES
@@ -34,12 +29,29 @@ static const char* TAG = "lv_port_disp";
 /**********************
  *      TYPEDEFS
  **********************/
+/* 显示后端接口：flush 只负责启动传输，像素全部发出后由后端调用 disp_transfer_done() */
+typedef struct {
+    const char* name;
+    esp_err_t (*init)(void);
+    esp_err_t (*deinit)(void);
+    esp_err_t (*flush)(const lv_area_t* area, const lv_color_t* color_p);
+    void (*set_backlight)(uint8_t brightness);
+} disp_backend_ops_t;
 
 /**********************
  *  STATIC PROTOTYPES
  **********************/
 static void disp_init(void);
 static void disp_flush(lv_disp_drv_t* disp_drv, const lv_area_t* area, lv_color_t* color_p);
+static void disp_transfer_done(void* user_ctx);
+static void esp_lcd_backend_transfer_done(void* user_ctx);
+
+static esp_err_t raw_backend_init(void);
+static esp_err_t raw_backend_flush(const lv_area_t* area, const lv_color_t* color_p);
+static esp_err_t esp_lcd_backend_init(void);
+static esp_err_t esp_lcd_backend_deinit(void);
+static esp_err_t esp_lcd_backend_flush(const lv_area_t* area, const lv_color_t* color_p);
+static void esp_lcd_backend_set_backlight(uint8_t brightness);
 
 /**********************
  *  STATIC VARIABLES
@@ -50,6 +62,33 @@ static bool disp_flush_enabled = true;
 static lv_color_t* disp_buf_1 = NULL;
 static lv_color_t* disp_buf_2 = NULL;
 
+static const disp_backend_ops_t s_backends[LV_PORT_DISP_BACKEND_MAX] = {
+    [LV_PORT_DISP_BACKEND_ST7789] =
+        {
+            .name = "st7789",
+            .init = raw_backend_init,
+            .deinit = st7789_deinit,
+            .flush = raw_backend_flush,
+            .set_backlight = st7789_set_backlight,
+        },
+    [LV_PORT_DISP_BACKEND_ESP_LCD] =
+        {
+            .name = "esp_lcd",
+            .init = esp_lcd_backend_init,
+            .deinit = esp_lcd_backend_deinit,
+            .flush = esp_lcd_backend_flush,
+            .set_backlight = esp_lcd_backend_set_backlight,
+        },
+};
+
+static lv_port_disp_backend_t s_backend = LV_PORT_DISP_DEFAULT_BACKEND;
+static bool s_hw_ready = false;
+static uint8_t s_backlight = 100;
+
+/* 当前传输的发起者：非NULL表示LVGL刷新，NULL表示阻塞刷新 (性能测试) */
+static lv_disp_drv_t* volatile s_flushing_drv = NULL;
+static SemaphoreHandle_t s_blocking_done_sem = NULL;
+
 /**********************
  *      MACROS
  **********************/
@@ -89,73 +128,149 @@ void lv_port_disp_init(void) {
     /*Finally register the driver*/
     lv_disp_drv_register(&disp_drv);
 
-    ESP_LOGI(TAG, "Display port initialized successfully (buf lines=%d)", (int)lines);
+    ESP_LOGI(TAG, "Display port initialized successfully (backend=%s, buf lines=%d)", s_backends[s_backend].name,
+             (int)lines);
 }
 
 void disp_enable_update(void) { disp_flush_enabled = true; }
 
 void disp_disable_update(void) { disp_flush_enabled = false; }
 
+esp_err_t lv_port_disp_set_backend(lv_port_disp_backend_t backend) {
+    if (backend >= LV_PORT_DISP_BACKEND_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_hw_ready) {
+        // 尚未初始化，只记录选择
+        s_backend = backend;
+        return ESP_OK;
+    }
+    if (backend == s_backend) {
+        return ESP_OK;
+    }
+
+    // 等待LVGL正在进行的刷新完成，避免切换时DMA仍在读取缓冲区
+    lv_disp_t* disp = lv_disp_get_default();
+    if (disp && disp->driver->draw_buf) {
+        while (disp->driver->draw_buf->flushing) {
+            vTaskDelay(1);
+        }
+    }
+
+    ESP_LOGI(TAG, "Switching display backend: %s -> %s", s_backends[s_backend].name, s_backends[backend].name);
+    s_backends[s_backend].deinit();
+    s_hw_ready = false;
+
+    esp_err_t ret = s_backends[backend].init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Backend %s init failed: %s, falling back to %s", s_backends[backend].name,
+                 esp_err_to_name(ret), s_backends[s_backend].name);
+        if (s_backends[s_backend].init() == ESP_OK) {
+            s_hw_ready = true;
+            s_backends[s_backend].set_backlight(s_backlight);
+        }
+        return ret;
+    }
+
+    s_backend = backend;
+    s_hw_ready = true;
+    s_backends[s_backend].set_backlight(s_backlight);
+
+    // 新驱动初始化时清过屏，让LVGL重绘整屏
+    if (disp) {
+        lv_obj_invalidate(lv_disp_get_scr_act(disp));
+    }
+    return ESP_OK;
+}
+
+lv_port_disp_backend_t lv_port_disp_get_backend(void) { return s_backend; }
+
+const char* lv_port_disp_backend_name(lv_port_disp_backend_t backend) {
+    if (backend >= LV_PORT_DISP_BACKEND_MAX) {
+        return "unknown";
+    }
+    return s_backends[backend].name;
+}
+
+void lv_port_disp_set_backlight(uint8_t brightness) {
+    s_backlight = brightness;
+    if (s_hw_ready) {
+        s_backends[s_backend].set_backlight(brightness);
+    }
+}
+
+esp_err_t lv_port_disp_flush_blocking(const lv_area_t* area, const lv_color_t* color_p, uint32_t timeout_ms) {
+    if (!s_hw_ready || area == NULL || color_p == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_blocking_done_sem == NULL) {
+        s_blocking_done_sem = xSemaphoreCreateBinary();
+        if (s_blocking_done_sem == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    s_flushing_drv = NULL;
+    esp_err_t ret = s_backends[s_backend].flush(area, color_p);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (xSemaphoreTake(s_blocking_done_sem, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
 /**********************
  *   STATIC FUNCTIONS
  **********************/
 
 /*Initialize your display and the required peripherals.*/
 static void disp_init(void) {
-    /*You code here*/
-#if USE_ESP_LCD_DRIVER
-    ESP_LOGI(TAG, "Display hardware initialization with ESP-LCD driver");
-    esp_err_t ret = st7789_esp_lcd_init();
+    ESP_LOGI(TAG, "Display hardware initialization with %s driver", s_backends[s_backend].name);
+    esp_err_t ret = s_backends[s_backend].init();
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize ST7789 with ESP-LCD: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Failed to initialize display backend %s: %s", s_backends[s_backend].name,
+                 esp_err_to_name(ret));
+        return;
     }
-#else
-    ESP_LOGI(TAG, "Display hardware initialization with original driver");
-    st7789_init();
-#endif
+    s_hw_ready = true;
 }
 
-volatile bool disp_flush_ready = false;
+/*
+ * 传输完成通知，两个后端共用。
+ * ESP-LCD 后端在驱动的传输完成任务中调用（SPI中断只做通知），原始驱动在流水线取回全部事务后调用。
+ */
+static void disp_transfer_done(void* user_ctx) {
+    (void)user_ctx;
+    lv_disp_drv_t* drv = s_flushing_drv;
+    if (drv) {
+        s_flushing_drv = NULL;
+        lv_disp_flush_ready(drv);
+    } else if (s_blocking_done_sem) {
+        BaseType_t need_yield = pdFALSE;
+        if (xPortInIsrContext()) {
+            xSemaphoreGiveFromISR(s_blocking_done_sem, &need_yield);
+            if (need_yield) {
+                portYIELD_FROM_ISR();
+            }
+        } else {
+            xSemaphoreGive(s_blocking_done_sem);
+        }
+    }
+}
 
 /*Flush the content of the internal buffer the specific area on the display
  *You can use DMA or any hardware acceleration to do this operation in the background but
  *'lv_disp_flush_ready()' has to be called when finished.*/
 static void disp_flush(lv_disp_drv_t* disp_drv, const lv_area_t* area, lv_color_t* color_p) {
-    if (disp_flush_enabled) {
-#if USE_ESP_LCD_DRIVER
-        // ESP-LCD驱动实现
-        esp_lcd_panel_handle_t panel_handle = st7789_esp_lcd_get_panel_handle();
-        if (panel_handle) {
-            uint16_t width = area->x2 - area->x1 + 1;
-            uint16_t height = area->y2 - area->y1 + 1;
-
-            // 检查区域是否有效
-            if (width > 0 && height > 0 && area->x1 >= 0 && area->y1 >= 0 && area->x2 < MY_DISP_HOR_RES &&
-                area->y2 < MY_DISP_VER_RES) {
-
-                // 分块绘制，避免内存不足
-                const uint16_t block_height = 20; // 每次绘制20行
-                for (uint16_t y = area->y1; y <= area->y2; y += block_height) {
-                    uint16_t current_height = (y + block_height - 1 <= area->y2) ? block_height : (area->y2 - y + 1);
-                    const lv_color_t* block_data = color_p + (y - area->y1) * width;
-
-                    esp_err_t ret =
-                        esp_lcd_panel_draw_bitmap(panel_handle, area->x1, y, width, current_height, block_data);
-                    if (ret != ESP_OK) {
-                        ESP_LOGE(TAG, "Failed to draw bitmap block: %s", esp_err_to_name(ret));
-                        break;
-                    }
-                }
-            }
-        } else {
-            ESP_LOGE(TAG, "Panel handle is NULL");
+    if (disp_flush_enabled && s_hw_ready) {
+        s_flushing_drv = disp_drv;
+        if (s_backends[s_backend].flush(area, color_p) == ESP_OK) {
+            // 后端会在DMA完成后调用 lv_disp_flush_ready()
+            return;
         }
-#else
-        // 原始驱动实现
-        st7789_set_window(area->x1, area->y1, area->x2, area->y2);
-        size_t pixel_count = lv_area_get_size(area);
-        st7789_write_pixels((uint16_t*)color_p, pixel_count);
-#endif
+        s_flushing_drv = NULL;
     }
 
     /*IMPORTANT!!!
@@ -163,4 +278,65 @@ static void disp_flush(lv_disp_drv_t* disp_drv, const lv_area_t* area, lv_color_
     lv_disp_flush_ready(disp_drv);
 }
 
-#endif
\ No newline at end of file
+/*------------------
+ * 原始驱动后端
+ * -----------------*/
+static esp_err_t raw_backend_init(void) { return st7789_init(); }
+
+static esp_err_t raw_backend_flush(const lv_area_t* area, const lv_color_t* color_p) {
+    st7789_set_window(area->x1, area->y1, area->x2, area->y2);
+    size_t pixel_count = lv_area_get_size(area);
+    // 内部是8KB分块的DMA流水线，返回时所有事务均已取回
+    st7789_write_pixels((const uint16_t*)color_p, pixel_count);
+    disp_transfer_done(NULL);
+    return ESP_OK;
+}
+
+/*------------------
+ * ESP-LCD驱动后端
+ * -----------------*/
+static esp_err_t esp_lcd_backend_init(void) {
+    esp_err_t ret = st7789_esp_lcd_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    st7789_esp_lcd_register_trans_done_cb(esp_lcd_backend_transfer_done, NULL);
+    return ESP_OK;
+}
+
+static esp_err_t esp_lcd_backend_deinit(void) {
+    st7789_esp_lcd_register_trans_done_cb(NULL, NULL);
+    return st7789_esp_lcd_deinit();
+}
+
+static esp_err_t esp_lcd_backend_flush(const lv_area_t* area, const lv_color_t* color_p) {
+    esp_lcd_panel_handle_t panel_handle = st7789_esp_lcd_get_panel_handle();
+    if (panel_handle == NULL) {
+        ESP_LOGE(TAG, "Panel handle is NULL");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (area->x1 < 0 || area->y1 < 0 || area->x2 >= MY_DISP_HOR_RES || area->y2 >= MY_DISP_VER_RES ||
+        area->x2 < area->x1 || area->y2 < area->y1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // esp_lcd 按总线 max_transfer_sz 自动分块并排队DMA，整块发送完成后触发 disp_transfer_done
+    // esp_lcd 内部无法插入让出点，整块传输期间持有总线，完成回调中释放
+    spi_bus_arbiter_acquire(SPI_BUS_CLIENT_DISPLAY, portMAX_DELAY);
+    esp_err_t ret = esp_lcd_panel_draw_bitmap(panel_handle, area->x1, area->y1, area->x2 + 1, area->y2 + 1, color_p);
+    if (ret != ESP_OK) {
+        spi_bus_arbiter_release(SPI_BUS_CLIENT_DISPLAY);
+        ESP_LOGE(TAG, "Failed to draw bitmap: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+static void esp_lcd_backend_transfer_done(void* user_ctx) {
+    spi_bus_arbiter_release(SPI_BUS_CLIENT_DISPLAY);
+    disp_transfer_done(user_ctx);
+}
+
+static void esp_lcd_backend_set_backlight(uint8_t brightness) { st7789_esp_lcd_backlight_enable(brightness > 0); }
+
+#endif
@@ -15,13 +15,26 @@ extern "C" {
  *********************/
 #include "lvgl.h"
 
+#include "esp_err.h"
+#include <stdint.h>
+
 /*********************
  *      DEFINES
  *********************/
+/* 默认显示后端，可在 lv_port_disp_init() 之前通过 lv_port_disp_set_backend() 覆盖 */
+#ifndef LV_PORT_DISP_DEFAULT_BACKEND
+#define LV_PORT_DISP_DEFAULT_BACKEND LV_PORT_DISP_BACKEND_ST7789
+#endif
 
 /**********************
  *      TYPEDEFS
  **********************/
+/* 显示后端类型：两个驱动共用 SPI2 和同一块屏幕，同一时刻只能启用一个 */
+typedef enum {
+    LV_PORT_DISP_BACKEND_ST7789 = 0, /* 原始驱动 (st7789.c)，8KB 分块 DMA 流水线 */
+    LV_PORT_DISP_BACKEND_ESP_LCD,    /* ESP-LCD 驱动 (st7789_esp_lcd.c)，DMA 完成中断通知 */
+    LV_PORT_DISP_BACKEND_MAX,
+} lv_port_disp_backend_t;
 
 /**********************
  * GLOBAL PROTOTYPES
@@ -29,6 +42,28 @@ extern "C" {
 /* Initialize low level display driver */
 void lv_port_disp_init(void);
 
+/**
+ * 选择显示后端。
+ * 在 lv_port_disp_init() 之前调用只记录选择；之后调用会反初始化当前驱动并初始化新驱动，
+ * 必须在 LVGL 任务上下文中调用。
+ */
+esp_err_t lv_port_disp_set_backend(lv_port_disp_backend_t backend);
+
+/* 获取当前显示后端 */
+lv_port_disp_backend_t lv_port_disp_get_backend(void);
+
+/* 获取显示后端名称 */
+const char* lv_port_disp_backend_name(lv_port_disp_backend_t backend);
+
+/* 设置背光亮度 (0-100)，由当前后端实现；ESP-LCD 后端只支持开/关 */
+void lv_port_disp_set_backlight(uint8_t brightness);
+
+/**
+ * 绕过 LVGL 直接把像素刷到屏幕，并等待 DMA 完成 (供性能测试使用)。
+ * 调用前需确保 LVGL 没有正在进行的刷新。
+ */
+esp_err_t lv_port_disp_flush_blocking(const lv_area_t* area, const lv_color_t* color_p, uint32_t timeout_ms);
+
 /* Enable updating the screen (the flushing process) when disp_flush() is called by LVGL */
 void disp_enable_update(void);
 
@@ -0,0 +1,312 @@
+/**
+ * @file lv_port_disp_bench.c
+ * Display backend benchmark (st7789 raw driver vs esp_lcd driver)
+ *
+ * 直接通过 lv_port_disp_flush_blocking() 向屏幕刷像素，绕过 LVGL 渲染，
+ * 只比较两个驱动的传输路径 (窗口设置 + DMA 分块 + 完成通知)。
+ */
+#if(EN_RECEIVER_MODE)
+
+#else
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_port_disp_bench.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "spi_bus_arbiter.h"
+#include "st7789.h"
+#include <stdio.h>
+#include <string.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define BENCH_HOR_RES ST7789_WIDTH
+#define BENCH_VER_RES ST7789_HEIGHT
+
+#define BENCH_SCROLL_STEP 4   // 每帧滚动的行数
+#define BENCH_IMAGE_SIZE 100  // 贴图边长
+#define BENCH_GLYPH_W 8       // 字符单元宽
+#define BENCH_GLYPH_H 16      // 字符单元高
+#define BENCH_TEXT_COLS 30    // 每帧刷新的字符列数
+#define BENCH_TEXT_ROWS 4     // 每帧刷新的字符行数
+#define BENCH_FLUSH_TIMEOUT_MS 500
+
+static const char* TAG = "lv_port_disp_bench";
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void bench_wait_lvgl_idle(void);
+static esp_err_t bench_fill(lv_color_t* fb, uint32_t frame);
+static esp_err_t bench_scroll(lv_color_t* fb, uint32_t frame);
+static esp_err_t bench_image(lv_color_t* img, uint32_t frame);
+static esp_err_t bench_text(lv_color_t* cell, uint32_t frame);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static const char* const s_case_names[LV_PORT_DISP_BENCH_COUNT] = {
+    [LV_PORT_DISP_BENCH_FILL] = "fill",
+    [LV_PORT_DISP_BENCH_SCROLL] = "scroll",
+    [LV_PORT_DISP_BENCH_IMAGE] = "image",
+    [LV_PORT_DISP_BENCH_TEXT] = "text",
+};
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+const char* lv_port_disp_bench_case_name(lv_port_disp_bench_case_t test_case) {
+    if (test_case >= LV_PORT_DISP_BENCH_COUNT) {
+        return "unknown";
+    }
+    return s_case_names[test_case];
+}
+
+esp_err_t lv_port_disp_bench_run(lv_port_disp_bench_result_t* result) {
+    if (result == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(result, 0, sizeof(*result));
+    result->backend = lv_port_disp_get_backend();
+
+    const size_t fb_pixels = (size_t)BENCH_HOR_RES * BENCH_VER_RES;
+    lv_color_t* fb = heap_caps_malloc(fb_pixels * sizeof(lv_color_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    lv_color_t* img =
+        heap_caps_malloc(BENCH_IMAGE_SIZE * BENCH_IMAGE_SIZE * sizeof(lv_color_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    lv_color_t* cell = heap_caps_malloc(BENCH_GLYPH_W * BENCH_GLYPH_H * sizeof(lv_color_t), MALLOC_CAP_DMA);
+    if (fb == NULL || img == NULL || cell == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate benchmark buffers");
+        heap_caps_free(fb);
+        heap_caps_free(img);
+        heap_caps_free(cell);
+        result->status = ESP_ERR_NO_MEM;
+        return ESP_ERR_NO_MEM;
+    }
+
+    // 预先生成滚动底图和贴图内容，不计入耗时
+    for (int y = 0; y < BENCH_VER_RES; y++) {
+        lv_color_t c = lv_color_make((uint8_t)(y * 255 / BENCH_VER_RES), 0x40, (uint8_t)(255 - y * 255 / BENCH_VER_RES));
+        for (int x = 0; x < BENCH_HOR_RES; x++) {
+            fb[y * BENCH_HOR_RES + x] = c;
+        }
+    }
+    for (int y = 0; y < BENCH_IMAGE_SIZE; y++) {
+        for (int x = 0; x < BENCH_IMAGE_SIZE; x++) {
+            img[y * BENCH_IMAGE_SIZE + x] = lv_color_make((uint8_t)(x * 255 / BENCH_IMAGE_SIZE),
+                                                          (uint8_t)(y * 255 / BENCH_IMAGE_SIZE), 0x80);
+        }
+    }
+
+    bench_wait_lvgl_idle();
+    ESP_LOGI(TAG, "Running display benchmark on backend %s (%d frames per case)",
+             lv_port_disp_backend_name(result->backend), LV_PORT_DISP_BENCH_FRAMES);
+
+    esp_err_t ret = ESP_OK;
+    for (int c = 0; c < LV_PORT_DISP_BENCH_COUNT && ret == ESP_OK; c++) {
+        uint32_t frames = 0;
+        int64_t start = esp_timer_get_time();
+        for (uint32_t f = 0; f < LV_PORT_DISP_BENCH_FRAMES; f++) {
+            switch (c) {
+            case LV_PORT_DISP_BENCH_FILL:
+                ret = bench_fill(fb, f);
+                break;
+            case LV_PORT_DISP_BENCH_SCROLL:
+                ret = bench_scroll(fb, f);
+                break;
+            case LV_PORT_DISP_BENCH_IMAGE:
+                ret = bench_image(img, f);
+                break;
+            default:
+                ret = bench_text(cell, f);
+                break;
+            }
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "Case %s failed at frame %lu: %s", s_case_names[c], (unsigned long)f,
+                         esp_err_to_name(ret));
+                break;
+            }
+            frames++;
+        }
+        int64_t elapsed_us = esp_timer_get_time() - start;
+
+        lv_port_disp_bench_item_t* item = &result->items[c];
+        item->frames = frames;
+        if (frames > 0 && elapsed_us > 0) {
+            item->us_per_frame = (uint32_t)(elapsed_us / frames);
+            item->fps = (float)frames * 1000000.0f / (float)elapsed_us;
+        }
+        ESP_LOGI(TAG, "[%s] %-6s: %3lu frames, %6lu us/frame, %6.1f fps", lv_port_disp_backend_name(result->backend),
+                 s_case_names[c], (unsigned long)item->frames, (unsigned long)item->us_per_frame, item->fps);
+
+        // 让出CPU，避免空闲任务看门狗超时
+        vTaskDelay(1);
+    }
+
+    heap_caps_free(fb);
+    heap_caps_free(img);
+    heap_caps_free(cell);
+
+    // 测试覆盖了屏幕内容，让LVGL整屏重绘
+    lv_obj_invalidate(lv_scr_act());
+
+    result->status = ret;
+    return ret;
+}
+
+esp_err_t lv_port_disp_bench_run_all(lv_port_disp_bench_result_t* results) {
+    if (results == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    lv_port_disp_backend_t original = lv_port_disp_get_backend();
+    esp_err_t first_err = ESP_OK;
+
+    for (int b = 0; b < LV_PORT_DISP_BACKEND_MAX; b++) {
+        memset(&results[b], 0, sizeof(results[b]));
+        results[b].backend = (lv_port_disp_backend_t)b;
+
+        esp_err_t ret = lv_port_disp_set_backend((lv_port_disp_backend_t)b);
+        if (ret == ESP_OK) {
+            ret = lv_port_disp_bench_run(&results[b]);
+        } else {
+            ESP_LOGE(TAG, "Cannot switch to backend %s: %s", lv_port_disp_backend_name(b), esp_err_to_name(ret));
+        }
+        results[b].status = ret;
+        if (ret != ESP_OK && first_err == ESP_OK) {
+            first_err = ret;
+        }
+    }
+
+    lv_port_disp_set_backend(original);
+
+    char summary[512];
+    lv_port_disp_bench_format(results, LV_PORT_DISP_BACKEND_MAX, summary, sizeof(summary));
+    ESP_LOGI(TAG, "Display benchmark summary:\n%s", summary);
+    spi_bus_arbiter_log_stats(); // 测试期间触摸与显示的总线等待情况
+    return first_err;
+}
+
+size_t lv_port_disp_bench_format(const lv_port_disp_bench_result_t* results, size_t count, char* buf,
+                                 size_t buf_size) {
+    if (results == NULL || buf == NULL || buf_size == 0) {
+        return 0;
+    }
+
+    size_t len = 0;
+    buf[0] = '\0';
+    for (size_t i = 0; i < count && len < buf_size; i++) {
+        const lv_port_disp_bench_result_t* r = &results[i];
+        int n = snprintf(buf + len, buf_size - len, "%s%s\n", lv_port_disp_backend_name(r->backend),
+                         r->status == ESP_OK ? "" : " (failed)");
+        if (n < 0) {
+            break;
+        }
+        len += (size_t)n;
+        for (int c = 0; c < LV_PORT_DISP_BENCH_COUNT && len < buf_size; c++) {
+            n = snprintf(buf + len, buf_size - len, "  %-6s %6lu us %5.1f fps\n", s_case_names[c],
+                         (unsigned long)r->items[c].us_per_frame, r->items[c].fps);
+            if (n < 0) {
+                break;
+            }
+            len += (size_t)n;
+        }
+    }
+    return len < buf_size ? len : buf_size - 1;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/* 等待LVGL当前的刷新结束，避免与测试传输交错 */
+static void bench_wait_lvgl_idle(void) {
+    lv_disp_t* disp = lv_disp_get_default();
+    if (disp == NULL || disp->driver->draw_buf == NULL) {
+        return;
+    }
+    while (disp->driver->draw_buf->flushing) {
+        vTaskDelay(1);
+    }
+}
+
+/* 整屏纯色填充，每帧换一种颜色 */
+static esp_err_t bench_fill(lv_color_t* fb, uint32_t frame) {
+    static const uint32_t colors[] = {0xFF0000, 0x00FF00, 0x0000FF, 0xFFFFFF};
+    lv_color_t c = lv_color_hex(colors[frame % (sizeof(colors) / sizeof(colors[0]))]);
+    const size_t pixels = (size_t)BENCH_HOR_RES * BENCH_VER_RES;
+    for (size_t i = 0; i < pixels; i++) {
+        fb[i] = c;
+    }
+
+    lv_area_t area = {0, 0, BENCH_HOR_RES - 1, BENCH_VER_RES - 1};
+    return lv_port_disp_flush_blocking(&area, fb, BENCH_FLUSH_TIMEOUT_MS);
+}
+
+/* 整屏内容上移 BENCH_SCROLL_STEP 行，底部补新行后整屏重刷 */
+static esp_err_t bench_scroll(lv_color_t* fb, uint32_t frame) {
+    const size_t row_pixels = BENCH_HOR_RES;
+    memmove(fb, fb + BENCH_SCROLL_STEP * row_pixels,
+            (BENCH_VER_RES - BENCH_SCROLL_STEP) * row_pixels * sizeof(lv_color_t));
+
+    lv_color_t c = lv_color_make((uint8_t)(frame * 37), (uint8_t)(frame * 11), (uint8_t)(255 - frame * 23));
+    lv_color_t* tail = fb + (BENCH_VER_RES - BENCH_SCROLL_STEP) * row_pixels;
+    for (size_t i = 0; i < BENCH_SCROLL_STEP * row_pixels; i++) {
+        tail[i] = c;
+    }
+
+    lv_area_t area = {0, 0, BENCH_HOR_RES - 1, BENCH_VER_RES - 1};
+    return lv_port_disp_flush_blocking(&area, fb, BENCH_FLUSH_TIMEOUT_MS);
+}
+
+/* 贴图沿对角线来回移动 */
+static esp_err_t bench_image(lv_color_t* img, uint32_t frame) {
+    const int range_x = BENCH_HOR_RES - BENCH_IMAGE_SIZE;
+    const int range_y = BENCH_VER_RES - BENCH_IMAGE_SIZE;
+    int step = (int)(frame * 7);
+    int x = step % (2 * range_x);
+    int y = step % (2 * range_y);
+    if (x > range_x) {
+        x = 2 * range_x - x;
+    }
+    if (y > range_y) {
+        y = 2 * range_y - y;
+    }
+
+    lv_area_t area = {x, y, x + BENCH_IMAGE_SIZE - 1, y + BENCH_IMAGE_SIZE - 1};
+    return lv_port_disp_flush_blocking(&area, img, BENCH_FLUSH_TIMEOUT_MS);
+}
+
+/* 模拟标签文字刷新：每帧逐个字符单元单独传输，主要测量每次传输的固定开销 */
+static esp_err_t bench_text(lv_color_t* cell, uint32_t frame) {
+    lv_color_t fg = lv_color_white();
+    lv_color_t bg = lv_color_black();
+
+    for (int row = 0; row < BENCH_TEXT_ROWS; row++) {
+        for (int col = 0; col < BENCH_TEXT_COLS; col++) {
+            // 用简单的位图案代替字形
+            uint8_t pattern = (uint8_t)(frame + row * BENCH_TEXT_COLS + col);
+            for (int y = 0; y < BENCH_GLYPH_H; y++) {
+                for (int x = 0; x < BENCH_GLYPH_W; x++) {
+                    cell[y * BENCH_GLYPH_W + x] = ((pattern >> x) ^ y) & 1 ? fg : bg;
+                }
+            }
+
+            lv_coord_t x1 = col * BENCH_GLYPH_W;
+            lv_coord_t y1 = 40 + row * BENCH_GLYPH_H;
+            lv_area_t area = {x1, y1, x1 + BENCH_GLYPH_W - 1, y1 + BENCH_GLYPH_H - 1};
+            esp_err_t ret = lv_port_disp_flush_blocking(&area, cell, BENCH_FLUSH_TIMEOUT_MS);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+#endif
@@ -0,0 +1,74 @@
+/**
+ * @file lv_port_disp_bench.h
+ * Display backend benchmark (st7789 raw driver vs esp_lcd driver)
+ */
+
+#ifndef LV_PORT_DISP_BENCH_H
+#define LV_PORT_DISP_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_port_disp.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define LV_PORT_DISP_BENCH_FRAMES 60 /* 每个测试项刷新的帧数 */
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef enum {
+    LV_PORT_DISP_BENCH_FILL = 0, /* 整屏纯色填充 */
+    LV_PORT_DISP_BENCH_SCROLL,   /* 整屏内容上移后重刷 */
+    LV_PORT_DISP_BENCH_IMAGE,    /* 100x100 图像在屏幕上移动贴图 */
+    LV_PORT_DISP_BENCH_TEXT,     /* 8x16 字符单元的大量小区域刷新 */
+    LV_PORT_DISP_BENCH_COUNT,
+} lv_port_disp_bench_case_t;
+
+typedef struct {
+    uint32_t frames;       /* 实际完成的帧数 */
+    uint32_t us_per_frame; /* 平均每帧耗时 (µs) */
+    float fps;             /* 帧率 */
+} lv_port_disp_bench_item_t;
+
+typedef struct {
+    lv_port_disp_backend_t backend;
+    esp_err_t status; /* ESP_OK 表示该后端测试完成 */
+    lv_port_disp_bench_item_t items[LV_PORT_DISP_BENCH_COUNT];
+} lv_port_disp_bench_result_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+/* 获取测试项名称 */
+const char* lv_port_disp_bench_case_name(lv_port_disp_bench_case_t test_case);
+
+/**
+ * 在当前显示后端上运行所有测试项并打印结果。
+ * 必须在 LVGL 任务上下文中调用 (例如按钮事件回调)，测试期间屏幕内容会被覆盖，结束后整屏重绘。
+ */
+esp_err_t lv_port_disp_bench_run(lv_port_disp_bench_result_t* result);
+
+/**
+ * 依次切换到每个显示后端运行测试，最后恢复原来的后端。
+ * @param results 至少 LV_PORT_DISP_BACKEND_MAX 个元素
+ */
+esp_err_t lv_port_disp_bench_run_all(lv_port_disp_bench_result_t* results);
+
+/* 把测试结果格式化为多行文本 (用于界面显示) */
+size_t lv_port_disp_bench_format(const lv_port_disp_bench_result_t* results, size_t count, char* buf,
+                                 size_t buf_size);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*LV_PORT_DISP_BENCH_H*/
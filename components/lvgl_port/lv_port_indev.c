@@ -7,7 +7,12 @@
  *      INCLUDES
  *********************/
 #include "lv_port_indev.h"
+#include "driver/gpio.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "task_placement.h"
 
 #if USE_FT6336G_TOUCH
 #include "ft6336g.h" // 使用 FT6336G 驱动
@@ -18,6 +23,22 @@
 /*********************
  *      DEFINES
  *********************/
+#if USE_FT6336G_TOUCH
+#define TOUCH_IRQ_PIN FT6336G_INT_PIN
+#else
+#define TOUCH_IRQ_PIN XPT2046_PIN_IRQ
+#endif
+
+#define TOUCH_SAMPLE_PERIOD_MS 10 /* 按下期间的采样周期 */
+#define TOUCH_RELEASE_SAMPLES 2   /* 连续多少次未按下判定为松开 */
+#define TOUCH_IIR_SHIFT 1         /* IIR 系数 1/2^n，越大越平滑、延迟越大 */
+
+/* 发布给 LVGL 的触摸状态打包成一个 32 位字，单次读写即可，无需加锁 */
+#define TOUCH_STATE_PRESSED (1UL << 31)
+#define TOUCH_STATE_X(s) ((lv_coord_t)((s) & 0x7FFF))
+#define TOUCH_STATE_Y(s) ((lv_coord_t)(((s) >> 15) & 0x7FFF))
+#define TOUCH_STATE_PACK(x, y, pressed)                                                                      \
+    (((uint32_t)(x) & 0x7FFF) | (((uint32_t)(y) & 0x7FFF) << 15) | ((pressed) ? TOUCH_STATE_PRESSED : 0))
 
 static const char* TAG = "lv_port_indev";
 
@@ -30,14 +51,18 @@ static const char* TAG = "lv_port_indev";
  **********************/
 static void touchpad_init(void);
 static void touchpad_read(lv_indev_drv_t* indev_drv, lv_indev_data_t* data);
+static bool touchpad_sample(lv_coord_t* x, lv_coord_t* y);
+static void touch_sampler_task(void* arg);
 #if !USE_FT6336G_TOUCH
-static void touchpad_get_xy(lv_coord_t* x, lv_coord_t* y);
+static void touchpad_map_xy(int16_t rx, int16_t ry, lv_coord_t* x, lv_coord_t* y);
 #endif
 
 /**********************
  *  STATIC VARIABLES
  **********************/
 static lv_indev_t* indev_touchpad;
+static TaskHandle_t s_sampler_task = NULL;
+static volatile uint32_t s_touch_state = 0; /* 由采样任务写入，LVGL 读取 */
 
 /**********************
  *      MACROS
@@ -85,6 +110,18 @@ void lv_port_indev_init(void) {
  * Touchpad
  * -----------------*/
 
+/* 触摸中断：关闭中断并唤醒采样任务，按下期间由任务轮询，松开后再打开中断 */
+static void IRAM_ATTR touch_irq_handler(void* arg) {
+    BaseType_t higher_prio_woken = pdFALSE;
+    gpio_intr_disable(TOUCH_IRQ_PIN);
+    if (s_sampler_task) {
+        vTaskNotifyGiveFromISR(s_sampler_task, &higher_prio_woken);
+    }
+    if (higher_prio_woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
 /*Initialize your touchpad*/
 static void touchpad_init(void) {
 #if USE_FT6336G_TOUCH
@@ -98,53 +135,143 @@ static void touchpad_init(void) {
     h->calibration.invert_x = false;
     h->calibration.invert_y = false;
 #endif
+
+    /* 布局见 task_placement.c：Core 0，优先级高于普通任务、低于LVGL */
+    BaseType_t result = task_placement_create(touch_sampler_task, "Touch_Sampler", NULL, &s_sampler_task);
+    if (result != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create touch sampler task");
+        return;
+    }
+
+    /* 触摸中断引脚：下降沿唤醒采样任务 */
+    esp_err_t ret = gpio_install_isr_service(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGW(TAG, "GPIO ISR service install failed: %s, touch sampler falls back to polling",
+                 esp_err_to_name(ret));
+        return;
+    }
+    gpio_set_intr_type(TOUCH_IRQ_PIN, GPIO_INTR_NEGEDGE);
+    gpio_isr_handler_add(TOUCH_IRQ_PIN, touch_irq_handler, NULL);
+    gpio_intr_enable(TOUCH_IRQ_PIN);
 }
 
-/*Will be called by the library to read the touchpad*/
-static void touchpad_read(lv_indev_drv_t* indev_drv, lv_indev_data_t* data) {
-    static lv_coord_t last_x = 0;
-    static lv_coord_t last_y = 0;
+/* 三值中值，去除单次毛刺 */
+static inline lv_coord_t median3(lv_coord_t a, lv_coord_t b, lv_coord_t c) {
+    if (a > b) {
+        lv_coord_t t = a;
+        a = b;
+        b = t;
+    }
+    if (b > c) {
+        b = c;
+    }
+    return a > b ? a : b;
+}
+
+/**
+ * 触摸采样任务：
+ * 平时阻塞等待触摸中断 (未装上中断服务时按采样周期轮询)，按下后按固定周期采样，
+ * 坐标经过三点中值和一阶 IIR 滤波后打包写入 s_touch_state。LVGL 读回调只读这个字，不访问 SPI。
+ */
+static void touch_sampler_task(void* arg) {
+    (void)arg;
+    lv_coord_t hist_x[3] = {0};
+    lv_coord_t hist_y[3] = {0};
+    int32_t filt_x = 0; /* 滤波值，放大 2^TOUCH_IIR_SHIFT 倍保存 */
+    int32_t filt_y = 0;
+
+    ESP_LOGI(TAG, "Touch sampler started on core %d", xPortGetCoreID());
+
+    while (1) {
+        /* 等待按下 */
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+
+        lv_coord_t x, y;
+        if (!touchpad_sample(&x, &y)) {
+            gpio_intr_enable(TOUCH_IRQ_PIN);
+            continue;
+        }
+
+        /* 刚按下：用第一次采样初始化滤波器 */
+        for (int i = 0; i < 3; i++) {
+            hist_x[i] = x;
+            hist_y[i] = y;
+        }
+        filt_x = (int32_t)x << TOUCH_IIR_SHIFT;
+        filt_y = (int32_t)y << TOUCH_IIR_SHIFT;
+        __atomic_store_n(&s_touch_state, TOUCH_STATE_PACK(x, y, true), __ATOMIC_RELEASE);
+
+        int released = 0;
+        int idx = 0;
+        TickType_t last_wake = xTaskGetTickCount();
+        while (released < TOUCH_RELEASE_SAMPLES) {
+            vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(TOUCH_SAMPLE_PERIOD_MS));
+
+            if (!touchpad_sample(&x, &y)) {
+                released++;
+                continue;
+            }
+            released = 0;
+
+            idx = (idx + 1) % 3;
+            hist_x[idx] = x;
+            hist_y[idx] = y;
+            lv_coord_t mx = median3(hist_x[0], hist_x[1], hist_x[2]);
+            lv_coord_t my = median3(hist_y[0], hist_y[1], hist_y[2]);
+            filt_x += mx - (filt_x >> TOUCH_IIR_SHIFT);
+            filt_y += my - (filt_y >> TOUCH_IIR_SHIFT);
+
+            __atomic_store_n(&s_touch_state,
+                             TOUCH_STATE_PACK(filt_x >> TOUCH_IIR_SHIFT, filt_y >> TOUCH_IIR_SHIFT, true),
+                             __ATOMIC_RELEASE);
+        }
+
+        /* 松开：保留最后坐标，清除按下标志 */
+        uint32_t state = __atomic_load_n(&s_touch_state, __ATOMIC_RELAXED);
+        __atomic_store_n(&s_touch_state, state & ~TOUCH_STATE_PRESSED, __ATOMIC_RELEASE);
 
+        /* 清掉按下期间积累的通知，重新打开中断等待下一次按下 */
+        ulTaskNotifyTake(pdTRUE, 0);
+        gpio_intr_enable(TOUCH_IRQ_PIN);
+    }
+}
+
+/* 采样一次，返回是否按下，按下时输出屏幕坐标 */
+static bool touchpad_sample(lv_coord_t* x, lv_coord_t* y) {
 #if USE_FT6336G_TOUCH
     uint8_t num_points;
     ft6336g_touch_point_t point;
 
     esp_err_t ret = ft6336g_read_touch_points(&point, &num_points);
-    if (ret == ESP_OK && num_points > 0) {
-        // 简单的屏幕旋转和镜像处理，需要根据实际情况调整
-        last_x = point.x;
-        last_y = point.y;
-        data->state = LV_INDEV_STATE_PR;
-        ESP_LOGD(TAG, "Touchpad read: x=%d, y=%d", last_x, last_y);
-    } else {
-        data->state = LV_INDEV_STATE_REL;
+    if (ret != ESP_OK || num_points == 0) {
+        return false;
     }
+    // 简单的屏幕旋转和镜像处理，需要根据实际情况调整
+    *x = point.x;
+    *y = point.y;
+    return true;
 #else
-    /* Use internal pressure-based pressed detection (IRQ may be broken) */
     xpt2046_data_t raw;
-    (void)xpt2046_read_raw(&raw);
-    if (raw.pressed) {
-        touchpad_get_xy(&last_x, &last_y);
-        data->state = LV_INDEV_STATE_PR;
-        ESP_LOGI(TAG, "Touchpad read: x=%d, y=%d", last_x, last_y);
-    } else {
-        data->state = LV_INDEV_STATE_REL;
+    if (xpt2046_read_sample(&raw) != ESP_OK || !raw.pressed) {
+        return false;
     }
+    touchpad_map_xy(raw.x, raw.y, x, y);
+    return true;
 #endif
-
-    data->point.x = last_x;
-    data->point.y = last_y;
 }
 
-#if !USE_FT6336G_TOUCH
-/*Get the x and y coordinates if the touchpad is pressed*/
-static void touchpad_get_xy(lv_coord_t* x, lv_coord_t* y) {
-    xpt2046_data_t raw;
-    (void)xpt2046_read_raw(&raw);
+/*Will be called by the library to read the touchpad*/
+static void touchpad_read(lv_indev_drv_t* indev_drv, lv_indev_data_t* data) {
+    uint32_t state = __atomic_load_n(&s_touch_state, __ATOMIC_ACQUIRE);
 
-    int16_t rx = raw.x;
-    int16_t ry = raw.y;
+    data->point.x = TOUCH_STATE_X(state);
+    data->point.y = TOUCH_STATE_Y(state);
+    data->state = (state & TOUCH_STATE_PRESSED) ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
+}
 
+#if !USE_FT6336G_TOUCH
+/*Map raw XPT2046 coordinates to screen coordinates*/
+static void touchpad_map_xy(int16_t rx, int16_t ry, lv_coord_t* x, lv_coord_t* y) {
     xpt2046_handle_t* h = xpt2046_get_handle();
     const xpt2046_calibration_t* cal = &h->calibration;
 
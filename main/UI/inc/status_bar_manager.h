@@ -116,6 +116,11 @@ int status_bar_manager_get_visible_icon_count(void);
  */
 bool status_bar_manager_is_icon_visible(status_icon_type_t icon_type);
 
+/**
+ * @brief 解除与状态栏容器的绑定，容器被删除前调用
+ */
+void status_bar_manager_detach(void);
+
 /**
  * @brief 释放状态栏管理器资源
  */
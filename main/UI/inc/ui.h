@@ -14,6 +14,7 @@ extern "C" {
 #include "lvgl.h"
 #include "theme_manager.h"
 #include "ui_state_manager.h"
+#include "ui_screen_cache.h"
 
 // --- LVGL 主任务 ---
 // 这个任务初始化并运行LVGL的主循环
@@ -39,6 +40,13 @@ void ui_start_animation_create(lv_obj_t* parent, ui_start_anim_finished_cb_t fin
  */
 void ui_main_menu_create(lv_obj_t* parent);
 
+/**
+ * @brief 主菜单的屏幕缓存钩子：恢复显示 / 切走 / 删除前清理
+ */
+void ui_main_menu_resume(void);
+void ui_main_menu_suspend(void);
+void ui_main_menu_destroy(void);
+
 /**
  * @brief 创建WiFi设置界面
  * @param parent 父对象，通常是 lv_scr_act()
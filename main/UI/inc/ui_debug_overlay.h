@@ -0,0 +1,39 @@
+/**
+ * @file ui_debug_overlay.h
+ * @brief 性能调试浮层 - 在顶层显示每个核的负载曲线和CPU占用最高的任务
+ * @author TidyCraze
+ * @date 2025-10-18
+ */
+
+#ifndef UI_DEBUG_OVERLAY_H
+#define UI_DEBUG_OVERLAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#define UI_DEBUG_OVERLAY_TOP_TASKS 5 // 浮层中列出的任务数
+
+/**
+ * @brief 显示浮层（位于 lv_layer_top，切换页面时保持显示，不拦截触摸）
+ * 需在 LVGL 任务中调用
+ */
+void ui_debug_overlay_show(void);
+
+/**
+ * @brief 隐藏并删除浮层
+ */
+void ui_debug_overlay_hide(void);
+
+/**
+ * @brief 浮层是否显示中
+ */
+bool ui_debug_overlay_is_visible(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UI_DEBUG_OVERLAY_H
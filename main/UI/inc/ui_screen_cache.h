@@ -0,0 +1,87 @@
+/**
+ * @file ui_screen_cache.h
+ * @brief 页面屏幕缓存 - 最近使用的页面保留在独立的 lv_obj 屏幕上，切换时直接 lv_scr_load
+ * @author TidyCraze
+ * @date 2025-10-18
+ */
+
+#ifndef UI_SCREEN_CACHE_H
+#define UI_SCREEN_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp_err.h"
+#include "lvgl.h"
+#include "ui_state_manager.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// 缓存页面占用的 PSRAM 预算（LVGL 对象全部分配在 PSRAM 中），超出后按 LRU 淘汰
+#define UI_SCREEN_CACHE_BUDGET_BYTES (256 * 1024)
+
+// 页面回调类型
+typedef void (*ui_screen_create_fn_t)(lv_obj_t* parent);
+typedef void (*ui_screen_hook_fn_t)(void);
+
+// 页面描述
+typedef struct {
+    ui_screen_create_fn_t create;   // 在给定屏幕上构建页面
+    ui_screen_hook_fn_t on_show;    // 从缓存重新显示时调用，可为NULL
+    ui_screen_hook_fn_t on_hide;    // 切换到其他页面前调用，可为NULL
+    ui_screen_hook_fn_t on_destroy; // 页面屏幕被删除前调用，可为NULL
+    bool cacheable;                 // 离开后是否保留页面对象
+    bool pinned;                    // 常驻，不参与LRU淘汰（仍可被失效）
+} ui_screen_desc_t;
+
+// 缓存统计
+typedef struct {
+    uint32_t hits;          // 直接从缓存切换的次数
+    uint32_t misses;        // 需要重新创建页面的次数
+    uint32_t evictions;     // LRU淘汰次数
+    uint32_t invalidations; // 因语言/主题等变化失效的次数
+    size_t bytes_cached;    // 当前缓存页面估算占用 (字节)
+    size_t budget;          // 预算 (字节)
+    uint32_t last_switch_us; // 最近一次切换耗时
+} ui_screen_cache_stats_t;
+
+/**
+ * @brief 切换到指定页面
+ * 缓存命中时直接加载已有屏幕；否则新建屏幕并调用页面的 create 函数。
+ * 旧页面按其描述保留或删除（删除为异步，可在旧页面自己的事件回调中调用）。
+ * @param type 页面类型
+ * @return ESP_OK 成功
+ */
+esp_err_t ui_screen_cache_show(ui_screen_type_t type);
+
+/**
+ * @brief 使某个页面的缓存失效，下次显示时重建
+ * 如果该页面正在显示，则在离开时删除
+ * @param type 页面类型
+ */
+void ui_screen_cache_invalidate(ui_screen_type_t type);
+
+/**
+ * @brief 使所有页面缓存失效（语言、主题切换后调用）
+ */
+void ui_screen_cache_invalidate_all(void);
+
+/**
+ * @brief 获取当前显示的页面类型
+ * @return 页面类型，尚未通过缓存显示任何页面时返回 UI_SCREEN_MAX
+ */
+ui_screen_type_t ui_screen_cache_get_active(void);
+
+/**
+ * @brief 获取缓存统计
+ * @param stats 输出统计
+ */
+void ui_screen_cache_get_stats(ui_screen_cache_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UI_SCREEN_CACHE_H
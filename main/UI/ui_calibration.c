@@ -18,6 +18,7 @@
 #include "joystick_adc.h"
 #include "lsm6ds3.h"
 #include "my_font.h"
+#include "task_placement.h"
 #include "theme_manager.h"
 #include "ui.h"
 
@@ -113,11 +114,7 @@ static void calibration_back_btn_callback(lv_event_t* e) {
 
     if (g_current_state == CALIBRATION_STATE_MAIN_MENU) {
         // 返回主菜单
-        lv_obj_t* screen = lv_scr_act();
-        if (screen) {
-            lv_obj_clean(screen);
-            ui_main_menu_create(screen);
-        }
+        ui_screen_cache_show(UI_SCREEN_MAIN_MENU);
     } else {
         // 返回校准主菜单
         g_current_state = CALIBRATION_STATE_MAIN_MENU;
@@ -179,7 +176,7 @@ static void test_btn_event_cb(lv_event_t* e) {
 
         // 启动测试任务
         if (g_test_task_handle == NULL) {
-            BaseType_t ret = xTaskCreate(test_task, "test_task", 4096, NULL, 5, &g_test_task_handle);
+            BaseType_t ret = task_placement_create(test_task, "test_task", NULL, &g_test_task_handle);
             if (ret != pdPASS) {
                 ESP_LOGE(TAG, "Failed to create test task");
                 g_test_running = false;
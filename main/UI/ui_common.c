@@ -20,11 +20,7 @@ static void common_settings_btn_callback(lv_event_t* e);
 
 // 统一的返回按钮回调函数 - 返回到主菜单
 static void back_button_callback(lv_event_t* e) {
-    lv_obj_t* screen = lv_scr_act();
-    if (screen) {
-        lv_obj_clean(screen);
-        ui_main_menu_create(screen);
-    }
+    ui_screen_cache_show(UI_SCREEN_MAIN_MENU);
 }
 
 // 返回到游戏菜单的回调函数
@@ -258,6 +254,7 @@ static void tcp_checkbox_callback(lv_event_t* e) {
             lv_obj_clear_state(udp_checkbox, LV_STATE_CHECKED);
             settings_set_transfer_mode(IMAGE_TRANSFER_MODE_TCP);
             lv_event_send(lv_scr_act(), UI_EVENT_SETTINGS_CHANGED, NULL);
+            ui_screen_cache_invalidate(UI_SCREEN_SETTINGS); // 设置页面中的传输模式选项已过期
         } else {
             // Prevent unchecking both
             if (!lv_obj_has_state(udp_checkbox, LV_STATE_CHECKED)) {
@@ -277,6 +274,7 @@ static void udp_checkbox_callback(lv_event_t* e) {
             lv_obj_clear_state(tcp_checkbox, LV_STATE_CHECKED);
             settings_set_transfer_mode(IMAGE_TRANSFER_MODE_UDP);
             lv_event_send(lv_scr_act(), UI_EVENT_SETTINGS_CHANGED, NULL);
+            ui_screen_cache_invalidate(UI_SCREEN_SETTINGS); // 设置页面中的传输模式选项已过期
         } else {
             // Prevent unchecking both
             if (!lv_obj_has_state(tcp_checkbox, LV_STATE_CHECKED)) {
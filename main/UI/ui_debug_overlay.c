@@ -0,0 +1,155 @@
+/**
+ * @file ui_debug_overlay.c
+ * @brief 性能调试浮层实现
+ * @author TidyCraze
+ * @date 2025-10-18
+ *
+ * 数据来自 task_profiler 的环形缓冲区，浮层只在有新采样时刷新。
+ */
+
+#include "ui_debug_overlay.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "lvgl.h"
+#include "task_profiler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* TAG = "UI_DEBUG_OVERLAY";
+
+#define OVERLAY_WIDTH 150
+#define OVERLAY_CHART_HEIGHT 40
+#define OVERLAY_REFRESH_MS 500
+
+static lv_obj_t* s_panel = NULL;
+static lv_obj_t* s_chart = NULL;
+static lv_chart_series_t* s_core_series[2] = {NULL, NULL};
+static lv_obj_t* s_label = NULL;
+static lv_timer_t* s_timer = NULL;
+static task_profiler_sample_t* s_sample = NULL; // PSRAM，避免占用 LVGL 任务栈
+static uint32_t s_shown_seq = 0;
+
+static void refresh_chart(void) {
+    uint16_t history[TASK_PROFILER_HISTORY];
+    for (int core = 0; core < portNUM_PROCESSORS && core < 2; core++) {
+        size_t n = task_profiler_get_core_history(core, history, TASK_PROFILER_HISTORY);
+        // 右对齐：最新的点在最右侧
+        lv_chart_set_all_value(s_chart, s_core_series[core], LV_CHART_POINT_NONE);
+        for (size_t i = 0; i < n; i++) {
+            s_core_series[core]->y_points[TASK_PROFILER_HISTORY - n + i] = history[i] / 10;
+        }
+    }
+    lv_chart_refresh(s_chart);
+}
+
+static void refresh_label(void) {
+    char text[64 + UI_DEBUG_OVERLAY_TOP_TASKS * 32];
+    int len = snprintf(text, sizeof(text), "C0 %u%%  C1 %u%%\nint %luK  ps %luK", s_sample->core_load_permille[0] / 10,
+                       portNUM_PROCESSORS > 1 ? s_sample->core_load_permille[portNUM_PROCESSORS - 1] / 10 : 0,
+                       (unsigned long)(s_sample->free_internal / 1024), (unsigned long)(s_sample->free_psram / 1024));
+
+    int shown = 0;
+    for (int i = 0; i < s_sample->entry_count && shown < UI_DEBUG_OVERLAY_TOP_TASKS && len < (int)sizeof(text); i++) {
+        const task_profiler_task_t* t = &s_sample->tasks[i];
+        // 空闲任务的占用已体现在核负载中
+        if (strncmp(t->name, "IDLE", 4) == 0) {
+            continue;
+        }
+        len += snprintf(text + len, sizeof(text) - len, "\n%-.10s %u.%u%% %luB", t->name, t->cpu_permille / 10,
+                        t->cpu_permille % 10, (unsigned long)t->stack_free);
+        shown++;
+    }
+    lv_label_set_text(s_label, text);
+}
+
+static void overlay_timer_cb(lv_timer_t* timer) {
+    (void)timer;
+    uint32_t seq = task_profiler_get_seq();
+    if (seq == s_shown_seq || task_profiler_get_latest(s_sample) != ESP_OK) {
+        return;
+    }
+    s_shown_seq = seq;
+    refresh_chart();
+    refresh_label();
+}
+
+void ui_debug_overlay_show(void) {
+    if (s_panel != NULL) {
+        return;
+    }
+
+    if (!task_profiler_is_running() && task_profiler_start(TASK_PROFILER_DEFAULT_PERIOD_MS) != ESP_OK) {
+        ESP_LOGE(TAG, "Task profiler not available");
+        return;
+    }
+
+    s_sample = heap_caps_malloc(sizeof(task_profiler_sample_t), MALLOC_CAP_SPIRAM);
+    if (s_sample == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate overlay sample buffer");
+        return;
+    }
+
+    s_panel = lv_obj_create(lv_layer_top());
+    lv_obj_set_width(s_panel, OVERLAY_WIDTH);
+    lv_obj_set_height(s_panel, LV_SIZE_CONTENT);
+    lv_obj_align(s_panel, LV_ALIGN_BOTTOM_RIGHT, -4, -4);
+    lv_obj_set_style_bg_color(s_panel, lv_color_black(), 0);
+    lv_obj_set_style_bg_opa(s_panel, LV_OPA_70, 0);
+    lv_obj_set_style_border_width(s_panel, 0, 0);
+    lv_obj_set_style_radius(s_panel, 6, 0);
+    lv_obj_set_style_pad_all(s_panel, 4, 0);
+    lv_obj_set_style_pad_gap(s_panel, 2, 0);
+    lv_obj_set_flex_flow(s_panel, LV_FLEX_FLOW_COLUMN);
+    // 不拦截触摸，下面的页面照常操作
+    lv_obj_clear_flag(s_panel, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+
+    s_chart = lv_chart_create(s_panel);
+    lv_obj_set_size(s_chart, lv_pct(100), OVERLAY_CHART_HEIGHT);
+    lv_chart_set_type(s_chart, LV_CHART_TYPE_LINE);
+    lv_chart_set_range(s_chart, LV_CHART_AXIS_PRIMARY_Y, 0, 100);
+    lv_chart_set_point_count(s_chart, TASK_PROFILER_HISTORY);
+    lv_chart_set_div_line_count(s_chart, 3, 0);
+    lv_obj_set_style_size(s_chart, 0, LV_PART_INDICATOR); // 不画数据点
+    lv_obj_set_style_line_width(s_chart, 1, LV_PART_ITEMS);
+    lv_obj_set_style_bg_opa(s_chart, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_width(s_chart, 0, 0);
+    lv_obj_set_style_pad_all(s_chart, 0, 0);
+    lv_obj_clear_flag(s_chart, LV_OBJ_FLAG_CLICKABLE);
+    s_core_series[0] = lv_chart_add_series(s_chart, lv_palette_main(LV_PALETTE_GREEN), LV_CHART_AXIS_PRIMARY_Y);
+    s_core_series[1] = lv_chart_add_series(s_chart, lv_palette_main(LV_PALETTE_ORANGE), LV_CHART_AXIS_PRIMARY_Y);
+    lv_chart_set_all_value(s_chart, s_core_series[0], LV_CHART_POINT_NONE);
+    lv_chart_set_all_value(s_chart, s_core_series[1], LV_CHART_POINT_NONE);
+
+    s_label = lv_label_create(s_panel);
+    lv_obj_set_width(s_label, lv_pct(100));
+    lv_obj_set_style_text_font(s_label, &lv_font_montserrat_12, 0);
+    lv_obj_set_style_text_color(s_label, lv_color_white(), 0);
+    lv_label_set_text(s_label, "Sampling...");
+
+    s_shown_seq = 0;
+    s_timer = lv_timer_create(overlay_timer_cb, OVERLAY_REFRESH_MS, NULL);
+    overlay_timer_cb(s_timer);
+
+    ESP_LOGI(TAG, "Debug overlay shown");
+}
+
+void ui_debug_overlay_hide(void) {
+    if (s_timer) {
+        lv_timer_del(s_timer);
+        s_timer = NULL;
+    }
+    if (s_panel) {
+        lv_obj_del(s_panel);
+        s_panel = NULL;
+    }
+    s_chart = NULL;
+    s_core_series[0] = NULL;
+    s_core_series[1] = NULL;
+    s_label = NULL;
+    free(s_sample);
+    s_sample = NULL;
+    ESP_LOGI(TAG, "Debug overlay hidden");
+}
+
+bool ui_debug_overlay_is_visible(void) { return s_panel != NULL; }
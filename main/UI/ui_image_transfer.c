@@ -295,8 +295,7 @@ static void stop_transfer_service(void) {
 static void on_back_clicked(lv_event_t* e) {
     ESP_LOGI(TAG, "Back button clicked");
     ui_image_transfer_destroy();
-    lv_obj_clean(lv_scr_act());
-    ui_main_menu_create(lv_scr_act());
+    ui_screen_cache_show(UI_SCREEN_MAIN_MENU);
 }
 
 static void on_mode_toggle_clicked(lv_event_t* e) {
@@ -20,6 +20,7 @@
 #include "ui_test.h"
 #include "ui_telemetry.h" // 添加遥测UI头文件
 #include "ui_state_manager.h" // 添加状态管理器头文件
+#include "ui_screen_cache.h"
 #include "wifi_image_transfer.h"
 #include "wifi_manager.h"
 // audio receiver is declared in ui.h (ui_audio_receiver_create)
@@ -33,6 +34,9 @@ static lv_obj_t* g_wifi_label = NULL;
 static lv_obj_t* g_menu_container = NULL;
 static int g_current_selected_index = 0;
 
+// 时间更新定时器
+static lv_timer_t* g_time_timer = NULL;
+
 // 函数声明
 
 // 时间更新定时器回调函数
@@ -103,209 +107,54 @@ void ui_main_update_battery_display(void) {
     }
 }
 
-// 菜单项回调函数类型
-typedef void (*menu_item_cb_t)(void);
+// 立即刷新时间和电量标签（创建页面或从缓存恢复时调用）
+static void refresh_status_labels(void) {
+    char time_str[32];
+    char battery_str[32];
+    background_battery_info_t battery_info;
 
-// 示例回调函数（后续扩展时实现）
-static void settings_cb(void) {
-    // 保存主菜单状态
-    if (g_menu_container) {
-        int scroll_pos = lv_obj_get_scroll_y(g_menu_container);
-        ui_state_manager_save_main_menu(g_menu_container, g_current_selected_index, scroll_pos);
-        ui_state_manager_save_current_screen(UI_SCREEN_SETTINGS);
+    if (background_manager_get_time_str(time_str, sizeof(time_str)) == ESP_OK) {
+        lv_label_set_text(g_time_label, time_str);
     }
+    if (background_manager_get_battery_str(battery_str, sizeof(battery_str)) == ESP_OK &&
+        background_manager_get_battery(&battery_info) == ESP_OK) {
+        lv_label_set_text(g_battery_label, battery_str);
 
-    lv_obj_t* screen = lv_scr_act();
-    if (screen) {
-        // 先停止时间更新定时器，避免访问已删除的UI元素
-        static lv_timer_t* timer = NULL;
-        if (timer) {
-            lv_timer_del(timer);
-            timer = NULL;
-            ESP_LOGI("UI_MAIN", "Time update timer stopped");
+        // 根据电量设置初始颜色
+        if (battery_info.percentage <= 30) {
+            lv_obj_set_style_text_color(g_battery_label, lv_color_hex(0xFF0000), 0);
+        } else {
+            lv_obj_set_style_text_color(g_battery_label, lv_color_hex(0x000000), 0);
         }
-
-        // 反初始化状态栏管理器
-        status_bar_manager_deinit();
-
-        // 重置全局UI指针
-        g_time_label = NULL;
-        g_battery_label = NULL;
-        g_wifi_label = NULL;
-        g_menu_container = NULL;
-
-        lv_obj_clean(screen);       // 清空当前屏幕
-        ui_settings_create(screen); // 加载系统设置界面
-    }
-}
-
-static void game_cb(void) {
-    // 保存主菜单状态
-    if (g_menu_container) {
-        int scroll_pos = lv_obj_get_scroll_y(g_menu_container);
-        ui_state_manager_save_main_menu(g_menu_container, g_current_selected_index, scroll_pos);
-        ui_state_manager_save_current_screen(UI_SCREEN_GAME);
-    }
-
-    lv_obj_t* screen = lv_scr_act();
-    if (screen) {
-        // 反初始化状态栏管理器
-        status_bar_manager_deinit();
-
-        // 重置全局UI指针
-        g_time_label = NULL;
-        g_battery_label = NULL;
-        g_wifi_label = NULL;
-        g_menu_container = NULL;
-
-        lv_obj_clean(screen);        // 清空当前屏幕
-        ui_game_menu_create(screen); // 加载游戏子菜单界面
     }
 }
 
-static void image_transfer_cb(void) {
-    // 保存主菜单状态
-    if (g_menu_container) {
-        int scroll_pos = lv_obj_get_scroll_y(g_menu_container);
-        ui_state_manager_save_main_menu(g_menu_container, g_current_selected_index, scroll_pos);
-        ui_state_manager_save_current_screen(UI_SCREEN_IMAGE_TRANSFER);
-    }
-
-    lv_obj_t* screen = lv_scr_act();
-    if (screen) {
-        // 反初始化状态栏管理器
-        status_bar_manager_deinit();
-
-        // 重置全局UI指针
-        g_time_label = NULL;
-        g_battery_label = NULL;
-        g_wifi_label = NULL;
-        g_menu_container = NULL;
-
-        lv_obj_clean(screen);             // 清空当前屏幕
-        ui_image_transfer_create(screen); // 加载图传界面
-    }
-}
-
-static void serial_display_cb(void) {
-    // 保存主菜单状态
-    if (g_menu_container) {
-        int scroll_pos = lv_obj_get_scroll_y(g_menu_container);
-        ui_state_manager_save_main_menu(g_menu_container, g_current_selected_index, scroll_pos);
-        ui_state_manager_save_current_screen(UI_SCREEN_SERIAL_DISPLAY);
-    }
-
-    lv_obj_t* screen = lv_scr_act();
-    if (screen) {
-        // 先停止时间更新定时器，避免访问已删除的UI元素
-        static lv_timer_t* timer = NULL;
-        if (timer) {
-            lv_timer_del(timer);
-            timer = NULL;
-            ESP_LOGI("UI_MAIN", "Time update timer stopped");
-        }
-
-        // 反初始化状态栏管理器
-        status_bar_manager_deinit();
-
-        // 重置全局UI指针
-        g_time_label = NULL;
-        g_battery_label = NULL;
-        g_wifi_label = NULL;
-        g_menu_container = NULL;
-
-        lv_obj_clean(screen);             // 清空当前屏幕
-        ui_serial_display_create(screen); // 加载串口显示界面
-    }
-}
+// 菜单项回调函数类型
+typedef void (*menu_item_cb_t)(void);
 
-static void calibration_cb(void) {
-    // 保存主菜单状态
+// 保存主菜单状态并切换到目标页面，主菜单本身保留在屏幕缓存中
+static void open_page(ui_screen_type_t screen_type) {
     if (g_menu_container) {
         int scroll_pos = lv_obj_get_scroll_y(g_menu_container);
         ui_state_manager_save_main_menu(g_menu_container, g_current_selected_index, scroll_pos);
-        ui_state_manager_save_current_screen(UI_SCREEN_CALIBRATION);
     }
 
-    lv_obj_t* screen = lv_scr_act();
-    if (screen) {
-        // 反初始化状态栏管理器
-        status_bar_manager_deinit();
-
-        // 重置全局UI指针
-        g_time_label = NULL;
-        g_battery_label = NULL;
-        g_wifi_label = NULL;
-        g_menu_container = NULL;
-
-        lv_obj_clean(screen);          // 清空当前屏幕
-        ui_calibration_create(screen); // 加载校准界面
-    }
+    ui_screen_cache_show(screen_type);
 }
 
-static void test_cb(void) {
-    // 保存主菜单状态
-    if (g_menu_container) {
-        int scroll_pos = lv_obj_get_scroll_y(g_menu_container);
-        ui_state_manager_save_main_menu(g_menu_container, g_current_selected_index, scroll_pos);
-        ui_state_manager_save_current_screen(UI_SCREEN_TEST);
-    }
+static void settings_cb(void) { open_page(UI_SCREEN_SETTINGS); }
 
-    lv_obj_t* screen = lv_scr_act();
-    if (screen) {
-        // 先停止时间更新定时器，避免访问已删除的UI元素
-        static lv_timer_t* timer = NULL;
-        if (timer) {
-            lv_timer_del(timer);
-            timer = NULL;
-            ESP_LOGI("UI_MAIN", "Time update timer stopped");
-        }
+static void game_cb(void) { open_page(UI_SCREEN_GAME); }
 
-        // 反初始化状态栏管理器
-        status_bar_manager_deinit();
+static void image_transfer_cb(void) { open_page(UI_SCREEN_IMAGE_TRANSFER); }
 
-        // 重置全局UI指针
-        g_time_label = NULL;
-        g_battery_label = NULL;
-        g_wifi_label = NULL;
-        g_menu_container = NULL;
+static void serial_display_cb(void) { open_page(UI_SCREEN_SERIAL_DISPLAY); }
 
-        lv_obj_clean(screen);   // 清空当前屏幕
-        ui_test_create(screen); // 加载测试界面
-    }
-}
+static void calibration_cb(void) { open_page(UI_SCREEN_CALIBRATION); }
 
-static void telemetry_cb(void) {
-    // 保存主菜单状态
-    if (g_menu_container) {
-        int scroll_pos = lv_obj_get_scroll_y(g_menu_container);
-        ui_state_manager_save_main_menu(g_menu_container, g_current_selected_index, scroll_pos);
-        ui_state_manager_save_current_screen(UI_SCREEN_TELEMETRY);
-    }
-
-    lv_obj_t* screen = lv_scr_act();
-    if (screen) {
-        // 先停止时间更新定时器，避免访问已删除的UI元素
-        static lv_timer_t* timer = NULL;
-        if (timer) {
-            lv_timer_del(timer);
-            timer = NULL;
-            ESP_LOGI("UI_MAIN", "Time update timer stopped");
-        }
-
-        // 反初始化状态栏管理器
-        status_bar_manager_deinit();
+static void test_cb(void) { open_page(UI_SCREEN_TEST); }
 
-        // 重置全局UI指针
-        g_time_label = NULL;
-        g_battery_label = NULL;
-        g_wifi_label = NULL;
-        g_menu_container = NULL;
-
-        lv_obj_clean(screen);               // 清空当前屏幕
-        ui_telemetry_create(screen); // 加载遥测界面
-    }
-}
+static void telemetry_cb(void) { open_page(UI_SCREEN_TELEMETRY); }
 
 // 可扩展的菜单项结构
 typedef struct {
@@ -473,36 +322,18 @@ void ui_main_menu_create(lv_obj_t* parent) {
     }
 
     // 创建时间更新定时器（每分钟检查一次后台更新）
-    static lv_timer_t* timer = NULL;
-    if (timer == NULL) {
-        timer = lv_timer_create(time_update_timer_cb, 60000, NULL); // 1分钟检查一次
+    if (g_time_timer == NULL) {
+        g_time_timer = lv_timer_create(time_update_timer_cb, 60000, NULL); // 1分钟检查一次
         ESP_LOGI("UI_MAIN", "Time update timer created (1min interval)");
     } else {
         // 如果定时器已存在，先删除再创建新的
-        lv_timer_del(timer);
-        timer = lv_timer_create(time_update_timer_cb, 60000, NULL);
+        lv_timer_del(g_time_timer);
+        g_time_timer = lv_timer_create(time_update_timer_cb, 60000, NULL);
         ESP_LOGI("UI_MAIN", "Time update timer recreated (1min interval)");
     }
 
     // 初始化显示
-    char time_str[32];
-    char battery_str[32];
-    background_battery_info_t battery_info;
-
-    if (background_manager_get_time_str(time_str, sizeof(time_str)) == ESP_OK) {
-        lv_label_set_text(g_time_label, time_str);
-    }
-    if (background_manager_get_battery_str(battery_str, sizeof(battery_str)) == ESP_OK &&
-        background_manager_get_battery(&battery_info) == ESP_OK) {
-        lv_label_set_text(g_battery_label, battery_str);
-
-        // 根据电量设置初始颜色
-        if (battery_info.percentage <= 30) {
-            lv_obj_set_style_text_color(g_battery_label, lv_color_hex(0xFF0000), 0);
-        } else {
-            lv_obj_set_style_text_color(g_battery_label, lv_color_hex(0x000000), 0);
-        }
-    }
+    refresh_status_labels();
 
     // 设置状态栏管理器的容器和UI组件
     esp_err_t ret = status_bar_manager_set_container(status_bar, NULL);
@@ -543,4 +374,41 @@ void ui_main_menu_create(lv_obj_t* parent) {
     ESP_LOGI("UI_MAIN", "Main menu created with background manager support");
 
     // 扩展提示：要添加新选项，在 menu_items 数组中添加新项，并实现对应的回调函数
-}
\ No newline at end of file
+}
+
+// 从屏幕缓存恢复主菜单：刷新状态栏并重新启动更新定时器
+void ui_main_menu_resume(void) {
+    if (g_time_label == NULL || g_battery_label == NULL) {
+        return;
+    }
+
+    ui_state_manager_save_current_screen(UI_SCREEN_MAIN_MENU);
+    refresh_status_labels();
+    if (g_time_timer) {
+        lv_timer_resume(g_time_timer);
+    }
+    status_bar_manager_start();
+}
+
+// 主菜单被切走但保留在缓存中：暂停定时器，不再更新隐藏的状态栏
+void ui_main_menu_suspend(void) {
+    if (g_time_timer) {
+        lv_timer_pause(g_time_timer);
+    }
+    status_bar_manager_stop();
+}
+
+// 主菜单屏幕即将被删除：释放定时器并解除状态栏管理器对其标签的引用
+void ui_main_menu_destroy(void) {
+    if (g_time_timer) {
+        lv_timer_del(g_time_timer);
+        g_time_timer = NULL;
+    }
+    status_bar_manager_detach();
+
+    // 重置全局UI指针
+    g_time_label = NULL;
+    g_battery_label = NULL;
+    g_wifi_label = NULL;
+    g_menu_container = NULL;
+}
@@ -0,0 +1,205 @@
+/**
+ * @file ui_screen_cache.c
+ * @brief 页面屏幕缓存 - 避免每次导航都 lv_obj_clean 后重建整个页面
+ * @author TidyCraze
+ * @date 2025-10-18
+ *
+ * 每个页面建在自己的屏幕对象 (lv_obj_create(NULL)) 上，离开时如果页面可缓存就只切走不删除，
+ * 未激活的屏幕不参与绘制和输入，再次进入时 lv_scr_load 即可。
+ * 页面占用按创建前后 PSRAM 空闲量之差估算（LVGL 内存全部来自 PSRAM），总量超出预算时按 LRU 淘汰。
+ * 带后台任务、网络服务或游戏定时器的页面不缓存，离开时照旧销毁。
+ */
+
+#include "ui_screen_cache.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "game.h"
+#include "service_lifecycle.h"
+#include "ui.h"
+#include "ui_calibration.h"
+#include "ui_image_transfer.h"
+#include "ui_serial_display.h"
+#include "ui_telemetry.h"
+#include "ui_test.h"
+
+static const char* TAG = "UI_SCREEN_CACHE";
+
+// 缓存条目
+typedef struct {
+    lv_obj_t* screen;   // 页面所在屏幕，NULL表示未缓存
+    size_t bytes;       // 创建时估算的占用
+    uint32_t last_used; // LRU时间戳
+    bool stale;         // 已失效，离开时删除
+} screen_cache_entry_t;
+
+// 页面描述表
+static const ui_screen_desc_t s_screen_descs[UI_SCREEN_MAX] = {
+    [UI_SCREEN_MAIN_MENU] = {.create = ui_main_menu_create,
+                             .on_show = ui_main_menu_resume,
+                             .on_hide = ui_main_menu_suspend,
+                             .on_destroy = ui_main_menu_destroy,
+                             .cacheable = true,
+                             .pinned = true},
+    [UI_SCREEN_SETTINGS] = {.create = ui_settings_create, .cacheable = true},
+    [UI_SCREEN_TEST] = {.create = ui_test_create, .cacheable = true},
+    // 以下页面持有任务/定时器/网络服务，离开即销毁
+    [UI_SCREEN_WIFI_SETTINGS] = {.create = ui_wifi_settings_create},
+    [UI_SCREEN_GAME] = {.create = ui_game_menu_create},
+    [UI_SCREEN_IMAGE_TRANSFER] = {.create = ui_image_transfer_create},
+    [UI_SCREEN_SERIAL_DISPLAY] = {.create = ui_serial_display_create},
+    [UI_SCREEN_CALIBRATION] = {.create = ui_calibration_create},
+    [UI_SCREEN_TELEMETRY] = {.create = ui_telemetry_create, .on_destroy = ui_telemetry_cleanup},
+};
+
+static screen_cache_entry_t s_entries[UI_SCREEN_MAX];
+static ui_screen_type_t s_active = UI_SCREEN_MAX;
+static uint32_t s_lru_clock = 0;
+static ui_screen_cache_stats_t s_stats = {.budget = UI_SCREEN_CACHE_BUDGET_BYTES};
+
+// 删除页面屏幕。总是异步删除：调用方可能正处于该屏幕上某个按钮的事件回调中
+static void screen_cache_drop(ui_screen_type_t type) {
+    screen_cache_entry_t* entry = &s_entries[type];
+    if (entry->screen == NULL) {
+        return;
+    }
+
+    if (s_screen_descs[type].on_destroy) {
+        s_screen_descs[type].on_destroy();
+    }
+    if (lv_obj_is_valid(entry->screen)) {
+        lv_obj_del_async(entry->screen);
+    }
+
+    s_stats.bytes_cached -= entry->bytes;
+    entry->screen = NULL;
+    entry->bytes = 0;
+    entry->stale = false;
+}
+
+// 超出预算时淘汰最久未使用的非常驻页面
+static void screen_cache_trim(void) {
+    while (s_stats.bytes_cached > s_stats.budget) {
+        int victim = -1;
+        for (int i = 0; i < UI_SCREEN_MAX; i++) {
+            if (i == s_active || s_entries[i].screen == NULL || s_screen_descs[i].pinned) {
+                continue;
+            }
+            if (victim < 0 || s_entries[i].last_used < s_entries[victim].last_used) {
+                victim = i;
+            }
+        }
+        if (victim < 0) {
+            break; // 只剩当前页面和常驻页面
+        }
+
+        ESP_LOGI(TAG, "Evict screen %d (%u bytes, cached %u/%u)", victim, (unsigned)s_entries[victim].bytes,
+                 (unsigned)s_stats.bytes_cached, (unsigned)s_stats.budget);
+        screen_cache_drop((ui_screen_type_t)victim);
+        s_stats.evictions++;
+    }
+}
+
+esp_err_t ui_screen_cache_show(ui_screen_type_t type) {
+    if (type >= UI_SCREEN_MAX || s_screen_descs[type].create == NULL) {
+        ESP_LOGE(TAG, "Invalid screen type: %d", type);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    ui_screen_type_t prev = s_active;
+    lv_obj_t* old_screen = lv_scr_act();
+    screen_cache_entry_t* entry = &s_entries[type];
+
+    if (prev == type && entry->screen == old_screen) {
+        return ESP_OK;
+    }
+
+    // 先启动新页面依赖的后台服务，页面创建时即可使用；服务挂起迟迟不结束时留在当前页面
+    esp_err_t ret = service_lifecycle_on_screen(type);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Screen %d not shown: services not ready (%s)", type, esp_err_to_name(ret));
+        return ret;
+    }
+
+    if (prev < UI_SCREEN_MAX && s_screen_descs[prev].on_hide) {
+        s_screen_descs[prev].on_hide();
+    }
+
+    bool hit = (entry->screen != NULL && lv_obj_is_valid(entry->screen));
+    if (hit) {
+        s_stats.hits++;
+        lv_scr_load(entry->screen);
+        if (s_screen_descs[type].on_show) {
+            s_screen_descs[type].on_show();
+        }
+    } else {
+        s_stats.misses++;
+        size_t free_before = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+
+        lv_obj_t* screen = lv_obj_create(NULL);
+        if (screen == NULL) {
+            ESP_LOGE(TAG, "Failed to create screen %d", type);
+            return ESP_ERR_NO_MEM;
+        }
+        entry->screen = screen;
+        entry->stale = false;
+        s_active = type; // 页面创建过程中可能查询当前页面
+        s_screen_descs[type].create(screen);
+        lv_scr_load(screen);
+
+        size_t free_after = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+        entry->bytes = free_before > free_after ? free_before - free_after : 0;
+        s_stats.bytes_cached += entry->bytes;
+    }
+
+    entry->last_used = ++s_lru_clock;
+    s_active = type;
+    ui_state_manager_save_current_screen(type);
+
+    // 处理旧屏幕：不可缓存或已失效的页面删除；不属于缓存的屏幕（开机动画所用的默认屏幕）直接删除
+    if (old_screen != NULL && old_screen != entry->screen) {
+        if (prev < UI_SCREEN_MAX && s_entries[prev].screen == old_screen) {
+            if (!s_screen_descs[prev].cacheable || s_entries[prev].stale) {
+                screen_cache_drop(prev);
+            }
+        } else {
+            lv_obj_del_async(old_screen);
+        }
+    }
+
+    screen_cache_trim();
+
+    s_stats.last_switch_us = (uint32_t)(esp_timer_get_time() - start_us);
+    ESP_LOGI(TAG, "Screen %d -> %d %s in %lu us (cached %u/%u bytes)", prev, type, hit ? "hit" : "built",
+             s_stats.last_switch_us, (unsigned)s_stats.bytes_cached, (unsigned)s_stats.budget);
+    return ESP_OK;
+}
+
+void ui_screen_cache_invalidate(ui_screen_type_t type) {
+    if (type >= UI_SCREEN_MAX || s_entries[type].screen == NULL) {
+        return;
+    }
+
+    s_stats.invalidations++;
+    if (type == s_active) {
+        s_entries[type].stale = true; // 正在显示，离开时再删除
+    } else {
+        screen_cache_drop(type);
+    }
+}
+
+void ui_screen_cache_invalidate_all(void) {
+    for (int i = 0; i < UI_SCREEN_MAX; i++) {
+        ui_screen_cache_invalidate((ui_screen_type_t)i);
+    }
+    ESP_LOGI(TAG, "All cached screens invalidated");
+}
+
+ui_screen_type_t ui_screen_cache_get_active(void) { return s_active; }
+
+void ui_screen_cache_get_stats(ui_screen_cache_stats_t* stats) {
+    if (stats) {
+        *stats = s_stats;
+    }
+}
@@ -8,6 +8,7 @@
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 #include "lvgl.h"
 #include <stdio.h>
@@ -17,6 +18,7 @@
 
 #include "my_font.h"
 #include "serial_display.h"
+#include "task_placement.h"
 #include "ui.h"
 
 static const char* TAG = "UI_SERIAL_DISPLAY";
@@ -26,6 +28,13 @@ static const char* TAG = "UI_SERIAL_DISPLAY";
 #define MAX_LINE_LENGTH 256  // 增加长度以避免截断
 #define DISPLAY_QUEUE_LEN 16
 
+// 虚拟行视图：固定高度的行对象循环复用，只给新进入视图的行设置文本
+#define VIEW_WIDTH 240
+#define VIEW_HEIGHT 290
+#define MAX_VIEW_ROWS 24
+#define ROW_SEQ_NONE UINT32_MAX             // 空行
+#define ROW_SEQ_PLACEHOLDER (UINT32_MAX - 1) // 显示等待提示的行
+
 // 消息类型
 typedef struct {
     char line[MAX_LINE_LENGTH - 20];  // 为时间戳预留空间
@@ -34,19 +43,30 @@ typedef struct {
 
 // 全局变量
 static lv_obj_t* g_serial_display_screen = NULL;
-static lv_obj_t* g_label = NULL;
+static lv_obj_t* g_line_view = NULL;
 static lv_obj_t* g_status_label = NULL;
 static lv_obj_t* g_back_btn = NULL;
 static lv_obj_t* g_clear_btn = NULL;
 
 // 循环缓冲区 - 使用PSRAM动态分配
+// 行序号从0开始递增，序号为seq的行存放在 display_buffer[seq % MAX_DISPLAY_LINES]
 static char (*display_buffer)[MAX_LINE_LENGTH] = NULL;
-static int display_start = 0;
-static int display_count = 0;
+static uint32_t display_total = 0; // 累计写入的行数（下一行的序号）
+static int display_count = 0;      // 缓冲区中有效行数
+static SemaphoreHandle_t g_buffer_mutex = NULL;
 static volatile bool g_ui_needs_update = false;
 static lv_timer_t* g_ui_update_timer = NULL;
 static bool g_buffer_initialized = false;
 
+// 行视图状态（仅在LVGL任务中访问）
+static lv_obj_t* g_rows[MAX_VIEW_ROWS];
+static uint32_t g_row_seq[MAX_VIEW_ROWS]; // 每个行对象当前显示的行序号
+static int g_row_count = 0;
+static lv_coord_t g_row_height = 16;
+static uint32_t g_view_first = 0; // 视图第一行的行序号
+static bool g_follow_tail = true; // 是否自动跟随最新行
+static lv_coord_t g_drag_accum = 0;
+
 // 消息队列
 static QueueHandle_t g_display_queue = NULL;
 static TaskHandle_t g_display_task_handle = NULL;
@@ -68,9 +88,16 @@ static esp_err_t init_display_buffer(void) {
         return ESP_ERR_NO_MEM;
     }
 
+    g_buffer_mutex = xSemaphoreCreateMutex();
+    if (g_buffer_mutex == NULL) {
+        heap_caps_free(display_buffer);
+        display_buffer = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
     // 初始化缓冲区
     memset(display_buffer, 0, MAX_DISPLAY_LINES * MAX_LINE_LENGTH);
-    display_start = 0;
+    display_total = 0;
     display_count = 0;
     g_buffer_initialized = true;
 
@@ -85,8 +112,12 @@ static void cleanup_display_buffer(void) {
         heap_caps_free(display_buffer);
         display_buffer = NULL;
     }
+    if (g_buffer_mutex != NULL) {
+        vSemaphoreDelete(g_buffer_mutex);
+        g_buffer_mutex = NULL;
+    }
     g_buffer_initialized = false;
-    display_start = 0;
+    display_total = 0;
     display_count = 0;
 }
 
@@ -97,15 +128,16 @@ static void add_line(const char* line) {
         return;
     }
 
-    int idx = (display_start + display_count) % MAX_DISPLAY_LINES;
+    xSemaphoreTake(g_buffer_mutex, portMAX_DELAY);
+    int idx = display_total % MAX_DISPLAY_LINES;
     strncpy(display_buffer[idx], line, MAX_LINE_LENGTH - 1);
     display_buffer[idx][MAX_LINE_LENGTH - 1] = '\0';
 
+    display_total++;
     if (display_count < MAX_DISPLAY_LINES) {
         display_count++;
-    } else {
-        display_start = (display_start + 1) % MAX_DISPLAY_LINES;
     }
+    xSemaphoreGive(g_buffer_mutex);
 
     g_ui_needs_update = true;
 }
@@ -116,48 +148,70 @@ static void clear_display(void) {
         return;
     }
     
-    display_start = 0;
+    // 只丢弃有效行，行序号继续递增，已显示的行对象会在下次刷新时被清空
+    xSemaphoreTake(g_buffer_mutex, portMAX_DELAY);
     display_count = 0;
-    memset(display_buffer, 0, MAX_DISPLAY_LINES * MAX_LINE_LENGTH);
+    xSemaphoreGive(g_buffer_mutex);
+    g_follow_tail = true;
     g_ui_needs_update = true;
 }
 
+// 设置行对象内容，只有显示的行发生变化时才重新排版文本
+static void row_set_line(int slot, uint32_t seq, const char* text) {
+    if (g_row_seq[slot] == seq) {
+        return;
+    }
+    lv_label_set_text(g_rows[slot], text);
+    g_row_seq[slot] = seq;
+}
+
 // UI更新定时器回调
 static void ui_update_timer_cb(lv_timer_t* timer) {
-    if (!g_ui_needs_update || g_label == NULL || !g_buffer_initialized || display_buffer == NULL) {
+    if (!g_ui_needs_update || g_line_view == NULL || !g_buffer_initialized || display_buffer == NULL) {
         return;
     }
     g_ui_needs_update = false;
 
     // 检查LVGL对象是否有效
-    if (!lv_obj_is_valid(g_label)) {
-        ESP_LOGW(TAG, "Label object is not valid");
+    if (!lv_obj_is_valid(g_line_view)) {
+        ESP_LOGW(TAG, "Line view object is not valid");
         return;
     }
 
-    // 使用PSRAM分配临时缓冲区
-    static char* buf = NULL;
-    if (buf == NULL) {
-        buf = (char*)heap_caps_malloc(MAX_DISPLAY_LINES * MAX_LINE_LENGTH, MALLOC_CAP_SPIRAM);
-        if (buf == NULL) {
-            ESP_LOGE(TAG, "Failed to allocate PSRAM buffer for UI update");
-            return;
-        }
+    xSemaphoreTake(g_buffer_mutex, portMAX_DELAY);
+
+    uint32_t total = display_total;
+    uint32_t oldest = total - (uint32_t)display_count;
+    uint32_t last_first = total > (uint32_t)g_row_count ? total - (uint32_t)g_row_count : 0;
+    if (last_first < oldest) {
+        last_first = oldest;
     }
 
-    char* p = buf;
-    int rem = MAX_DISPLAY_LINES * MAX_LINE_LENGTH;
+    // 确定视图第一行：跟随模式贴住最新行，否则限制在缓冲区有效范围内
+    if (g_follow_tail || g_view_first > last_first) {
+        g_view_first = last_first;
+        g_follow_tail = true;
+    } else if (g_view_first < oldest) {
+        g_view_first = oldest;
+    }
 
-    for (int i = 0; i < display_count; i++) {
-        int idx = (display_start + i) % MAX_DISPLAY_LINES;
-        int n = snprintf(p, rem, "%s\n", display_buffer[idx]);
-        if (n < 0 || n >= rem) break;
-        p += n;
-        rem -= n;
+    // 行序号seq固定由 g_rows[seq % g_row_count] 显示；滚动时行对象只移动位置，
+    // 只有新进入视图的行才需要设置文本
+    for (int i = 0; i < g_row_count; i++) {
+        uint32_t seq = g_view_first + (uint32_t)i;
+        int slot = (int)(seq % (uint32_t)g_row_count);
+
+        if (seq < total) {
+            row_set_line(slot, seq, display_buffer[seq % MAX_DISPLAY_LINES]);
+        } else if (i == 0 && display_count == 0) {
+            row_set_line(slot, ROW_SEQ_PLACEHOLDER, "Waiting for data...");
+        } else {
+            row_set_line(slot, ROW_SEQ_NONE, "");
+        }
+        lv_obj_set_y(g_rows[slot], (lv_coord_t)(i * g_row_height));
     }
 
-    lv_label_set_text_static(g_label, buf);
-    lv_obj_scroll_to_y(g_label, LV_COORD_MAX, LV_ANIM_OFF);
+    xSemaphoreGive(g_buffer_mutex);
 
     // 更新状态信息
     if (g_status_label && lv_obj_is_valid(g_status_label)) {
@@ -240,17 +294,13 @@ static void back_btn_event_cb(lv_event_t* e) {
         cleanup_display_buffer();
 
         g_serial_display_screen = NULL;
-        g_label = NULL;
+        g_line_view = NULL;
+        g_row_count = 0;
         g_status_label = NULL;
         g_back_btn = NULL;
         g_clear_btn = NULL;
 
-        // 停止TCP服务器 - 移到最后执行
-        serial_display_stop();
-        ESP_LOGI(TAG, "Serial display TCP server stopped on back button");
-
-        lv_obj_clean(screen);
-        ui_main_menu_create(screen);
+        ui_screen_cache_show(UI_SCREEN_MAIN_MENU);
     }
 }
 
@@ -258,9 +308,44 @@ static void clear_btn_event_cb(lv_event_t* e) {
     clear_display();
 }
 
-// 滚动事件回调
-static void scroll_event_cb(lv_event_t* e) {
-    // 简化滚动事件处理，保持自动滚动行为
+// 拖动滚动回调：按行高累计拖动距离，整行滚动；滚回底部后恢复自动跟随
+static void line_view_drag_cb(lv_event_t* e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code == LV_EVENT_RELEASED || code == LV_EVENT_PRESS_LOST) {
+        g_drag_accum = 0;
+        return;
+    }
+
+    lv_indev_t* indev = lv_indev_get_act();
+    if (indev == NULL || g_row_height <= 0) {
+        return;
+    }
+    lv_point_t vect;
+    lv_indev_get_vect(indev, &vect);
+    g_drag_accum += vect.y;
+
+    bool moved = false;
+    while (g_drag_accum >= g_row_height) { // 向下拖动，查看更早的行
+        if (g_view_first > 0) {
+            g_view_first--;
+        }
+        g_follow_tail = false;
+        g_drag_accum -= g_row_height;
+        moved = true;
+    }
+    while (g_drag_accum <= -g_row_height) { // 向上拖动，查看更新的行
+        g_view_first++;
+        g_drag_accum += g_row_height;
+        moved = true;
+    }
+
+    if (moved) {
+        uint32_t total = display_total;
+        if (total <= (uint32_t)g_row_count || g_view_first >= total - (uint32_t)g_row_count) {
+            g_follow_tail = true;
+        }
+        g_ui_needs_update = true;
+    }
 }
 
 // 公共API：添加新数据
@@ -312,26 +397,15 @@ void ui_serial_display_create(lv_obj_t* parent) {
         ui_serial_display_destroy();
     }
 
-    // 初始化串口显示模块
-    esp_err_t ret = serial_display_init();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize serial display module");
-        return;
+    // 串口模块和TCP服务器由 service_lifecycle 在进入本界面前启动
+    if (!serial_display_is_running()) {
+        ESP_LOGW(TAG, "Serial display TCP server is not running");
     }
 
-    // 启动TCP服务器，监听端口8080
-    if (!serial_display_start(8080)) {
-        ESP_LOGE(TAG, "Failed to start serial display TCP server");
-        return;
-    }
-
-    ESP_LOGI(TAG, "Serial display TCP server started on port 8080");
-
     // 初始化PSRAM缓冲区
-    ret = init_display_buffer();
+    esp_err_t ret = init_display_buffer();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize PSRAM display buffer");
-        serial_display_stop();
         return;
     }
 
@@ -362,25 +436,46 @@ void ui_serial_display_create(lv_obj_t* parent) {
     lv_obj_t* content_container;
     ui_create_page_content_area(page_parent_container, &content_container);
 
-    // 创建标签 - 直接占满整个内容区域
-    g_label = lv_label_create(content_container);
-    lv_obj_set_size(g_label, 240, 290);
-    lv_obj_align(g_label, LV_ALIGN_CENTER, 0, 10);
-    lv_label_set_long_mode(g_label, LV_LABEL_LONG_WRAP);
-    lv_label_set_text(g_label, "Waiting for data...");
-    lv_obj_set_style_text_color(g_label, theme_get_color(theme_get_current_theme()->colors.text_primary), 0);
-    lv_obj_set_style_bg_color(g_label, theme_get_color(theme_get_current_theme()->colors.surface), 0);
+    // 创建行视图容器 - 直接占满整个内容区域，行对象由容器继承字体和颜色
+    g_line_view = lv_obj_create(content_container);
+    lv_obj_set_size(g_line_view, VIEW_WIDTH, VIEW_HEIGHT);
+    lv_obj_align(g_line_view, LV_ALIGN_CENTER, 0, 10);
+    lv_obj_clear_flag(g_line_view, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_style_pad_all(g_line_view, 0, 0);
+    lv_obj_set_style_border_width(g_line_view, 0, 0);
+    lv_obj_set_style_radius(g_line_view, 0, 0);
+    lv_obj_set_style_text_color(g_line_view, theme_get_color(theme_get_current_theme()->colors.text_primary), 0);
+    lv_obj_set_style_bg_color(g_line_view, theme_get_color(theme_get_current_theme()->colors.surface), 0);
 
     // 检查并应用中文字体
-    if (is_font_loaded()) {
-        lv_obj_set_style_text_font(g_label, get_loaded_font(), 0);
-    } else {
-        // Fallback to default font if custom font is not loaded
-        lv_obj_set_style_text_font(g_label, &lv_font_montserrat_14, 0);
+    const lv_font_t* font = is_font_loaded() ? get_loaded_font() : &lv_font_montserrat_14;
+    lv_obj_set_style_text_font(g_line_view, font, 0);
+
+    // 按字体行高创建固定数量的单行行对象
+    g_row_height = lv_font_get_line_height(font);
+    if (g_row_height <= 0) {
+        g_row_height = 16;
+    }
+    g_row_count = VIEW_HEIGHT / g_row_height;
+    if (g_row_count > MAX_VIEW_ROWS) {
+        g_row_count = MAX_VIEW_ROWS;
     }
+    for (int i = 0; i < g_row_count; i++) {
+        g_rows[i] = lv_label_create(g_line_view);
+        lv_obj_set_size(g_rows[i], VIEW_WIDTH, g_row_height);
+        lv_label_set_long_mode(g_rows[i], LV_LABEL_LONG_CLIP);
+        lv_label_set_text_static(g_rows[i], "");
+        lv_obj_set_pos(g_rows[i], 0, (lv_coord_t)(i * g_row_height));
+        g_row_seq[i] = ROW_SEQ_NONE;
+    }
+    g_view_first = 0;
+    g_follow_tail = true;
+    g_drag_accum = 0;
 
-    // 添加滚动事件
-    lv_obj_add_event_cb(g_label, scroll_event_cb, LV_EVENT_SCROLL, NULL);
+    // 添加拖动滚动事件
+    lv_obj_add_event_cb(g_line_view, line_view_drag_cb, LV_EVENT_PRESSING, NULL);
+    lv_obj_add_event_cb(g_line_view, line_view_drag_cb, LV_EVENT_RELEASED, NULL);
+    lv_obj_add_event_cb(g_line_view, line_view_drag_cb, LV_EVENT_PRESS_LOST, NULL);
 
     // 5. 创建清空按钮 - 直接放在内容区域右下角
     g_clear_btn = lv_btn_create(content_container);
@@ -413,12 +508,11 @@ void ui_serial_display_create(lv_obj_t* parent) {
 
     // 启动显示任务
     g_display_running = true;
-    if (xTaskCreate(display_task, "ui_display_task", 4096, NULL, 3, &g_display_task_handle) != pdPASS) {
+    if (task_placement_create(display_task, "ui_display_task", NULL, &g_display_task_handle) != pdPASS) {
         ESP_LOGE(TAG, "Failed to create display task");
         g_display_running = false;
         vQueueDelete(g_display_queue);
         g_display_queue = NULL;
-        serial_display_stop();
         return;
     }
 
@@ -427,10 +521,6 @@ void ui_serial_display_create(lv_obj_t* parent) {
 
 // 销毁串口显示界面
 void ui_serial_display_destroy(void) {
-    // 停止TCP服务器
-    serial_display_stop();
-    ESP_LOGI(TAG, "Serial display TCP server stopped");
-
     // 停止显示任务
     g_display_running = false;
     if (g_display_task_handle) {
@@ -460,7 +550,8 @@ void ui_serial_display_destroy(void) {
 
     // 清空全局变量
     g_serial_display_screen = NULL;
-    g_label = NULL;
+    g_line_view = NULL;
+    g_row_count = 0;
     g_status_label = NULL;
     g_back_btn = NULL;
     g_clear_btn = NULL;
@@ -11,7 +11,8 @@
 #include "settings_manager.h" // For transfer mode settings
 #include "theme_manager.h"
 #include "ui.h"
-#include "st7789.h" // For backlight control
+#include "ui_debug_overlay.h"
+#include "lv_port_disp.h" // For backlight control
 
 static const char* TAG = "UI_SETTINGS";
 
@@ -35,6 +36,7 @@ typedef struct {
     const char* language_changed;
     const char* wifi_settings_label; // 新增WiFi设置标签
     const char* backlight_label;     // 新增背光标签
+    const char* debug_overlay_label; // 性能浮层开关
 } ui_text_t;
 
 // 英文文本
@@ -50,7 +52,8 @@ static const ui_text_t english_text = {.settings_title = "SETTINGS",
                                        .version_info = "ESP32-S3 Demo v1.0.0",
                                        .language_changed = "Language Changed!",
                                        .wifi_settings_label = "WiFi Settings",
-                                       .backlight_label = "Backlight:"};
+                                       .backlight_label = "Backlight:",
+                                       .debug_overlay_label = "Perf Overlay:"};
 
 // 中文文本（需要中文字体支持）
 static const ui_text_t chinese_text = {.settings_title = "设置",
@@ -65,7 +68,8 @@ static const ui_text_t chinese_text = {.settings_title = "设置",
                                        .version_info = "ESP32-S3 演示 v1.0.0",
                                        .language_changed = "语言已切换!",
                                        .wifi_settings_label = "无线网络设置",
-                                       .backlight_label = "背光:"};
+                                       .backlight_label = "背光:",
+                                       .debug_overlay_label = "性能浮层:"};
 
 // 获取当前语言文本
 static const ui_text_t* get_current_text(void) {
@@ -119,6 +123,9 @@ static void language_switch_cb(lv_event_t* e) {
     g_current_language = is_chinese ? LANG_CHINESE : LANG_ENGLISH;
     save_language_setting(g_current_language);
 
+    // 其他缓存页面的文字已过期，下次进入时重建
+    ui_screen_cache_invalidate_all();
+
     // 显示切换提示
     lv_obj_t* screen = lv_scr_act();
     lv_obj_t* msgbox = lv_msgbox_create(screen, "Info", get_current_text()->language_changed, NULL, true);
@@ -128,14 +135,19 @@ static void language_switch_cb(lv_event_t* e) {
 }
 
 // WiFi设置按钮回调
-static void wifi_settings_btn_cb(lv_event_t* e) {
-    lv_obj_t* screen = lv_scr_act();
-    if (screen) {
-        lv_obj_clean(screen);
-        ui_wifi_settings_create(screen); // 跳转到WiFi设置页面
+static void debug_overlay_switch_cb(lv_event_t* e) {
+    lv_obj_t* sw = lv_event_get_target(e);
+    if (lv_obj_has_state(sw, LV_STATE_CHECKED)) {
+        ui_debug_overlay_show();
+    } else {
+        ui_debug_overlay_hide();
     }
 }
 
+static void wifi_settings_btn_cb(lv_event_t* e) {
+    ui_screen_cache_show(UI_SCREEN_WIFI_SETTINGS); // 跳转到WiFi设置页面，设置页面保留在缓存中
+}
+
 // 关于信息回调
 static void about_btn_cb(lv_event_t* e) {
     lv_obj_t* screen = lv_scr_act();
@@ -188,6 +200,9 @@ static void theme_dropdown_cb(lv_event_t* e) {
     lv_obj_t* screen = lv_scr_act();
     theme_apply_to_screen(screen);
 
+    // 其他缓存页面仍是旧主题，下次进入时重建
+    ui_screen_cache_invalidate_all();
+
     // 显示切换提示
     const theme_t* theme = theme_get_current_theme();
     lv_obj_t* msgbox = lv_msgbox_create(screen, "Theme Changed", theme->name, NULL, true);
@@ -205,7 +220,7 @@ static void backlight_slider_cb(lv_event_t* e) {
     lv_label_set_text_fmt(label, "%ld%%", brightness);
     
     // Set and save backlight
-    st7789_set_backlight((uint8_t)brightness);
+    lv_port_disp_set_backlight((uint8_t)brightness);
     settings_set_backlight((uint8_t)brightness);
 }
 
@@ -389,6 +404,27 @@ void ui_settings_create(lv_obj_t* parent) {
     lv_obj_add_event_cb(tcp_checkbox, transfer_mode_tcp_cb, LV_EVENT_VALUE_CHANGED, udp_checkbox);
     lv_obj_add_event_cb(udp_checkbox, transfer_mode_udp_cb, LV_EVENT_VALUE_CHANGED, tcp_checkbox);
 
+    // --- 性能浮层 ---
+    lv_obj_t* overlay_row = lv_obj_create(content_container);
+    lv_obj_set_width(overlay_row, lv_pct(100));
+    lv_obj_set_height(overlay_row, LV_SIZE_CONTENT);
+    lv_obj_set_flex_flow(overlay_row, LV_FLEX_FLOW_ROW);
+    lv_obj_set_flex_align(overlay_row, LV_FLEX_ALIGN_SPACE_BETWEEN, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+    lv_obj_set_style_bg_opa(overlay_row, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_width(overlay_row, 0, 0);
+    lv_obj_set_style_pad_all(overlay_row, 0, 0);
+
+    lv_obj_t* overlay_label = lv_label_create(overlay_row);
+    lv_label_set_text(overlay_label, text->debug_overlay_label);
+    theme_apply_to_label(overlay_label, false);
+
+    lv_obj_t* overlay_switch = lv_switch_create(overlay_row);
+    theme_apply_to_switch(overlay_switch);
+    if (ui_debug_overlay_is_visible()) {
+        lv_obj_add_state(overlay_switch, LV_STATE_CHECKED);
+    }
+    lv_obj_add_event_cb(overlay_switch, debug_overlay_switch_cb, LV_EVENT_VALUE_CHANGED, NULL);
+
     // --- WiFi设置 ---
     lv_obj_t* wifi_btn = lv_btn_create(content_container);
     lv_obj_set_width(wifi_btn, lv_pct(100));
@@ -455,4 +491,5 @@ ui_language_t ui_get_current_language(void) { return g_current_language; }
 void ui_set_language(ui_language_t lang) {
     g_current_language = lang;
     save_language_setting(lang);
+    ui_screen_cache_invalidate_all();
 }
\ No newline at end of file
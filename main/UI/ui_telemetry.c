@@ -38,10 +38,7 @@ static void local_ui_update_task(lv_timer_t* timer);
 void ui_telemetry_create(lv_obj_t* parent) {
     theme_apply_to_screen(parent);
 
-    // 初始化遥测服务
-    if (telemetry_service_init() != 0) {
-        LV_LOG_ERROR("Failed to initialize telemetry service");
-    }
+    // 遥测服务由 service_lifecycle 在进入本界面前初始化，这里只负责启动/停止
 
     // 获取中文字体
     lv_font_t* font_cn = get_loaded_font();
@@ -439,8 +436,7 @@ void ui_telemetry_cleanup(void) {
         telemetry_service_active = false;
     }
 
-    // 反初始化遥测服务
-    telemetry_service_deinit();
+    // 反初始化由 service_lifecycle 在离开界面后完成
 
     LV_LOG_USER("Telemetry UI cleanup completed");
 }
@@ -5,8 +5,11 @@
  * @date 2024
  */
 #include "esp_log.h"
+#include "heap_tracer.h"
 #include "joystick_adc.h"
+#include "lv_port_disp_bench.h"
 #include "misc/lv_color.h"
+#include "task_placement_bench.h"
 #include "theme_manager.h"
 #include "ui.h"
 
@@ -16,11 +19,58 @@ static const char* TAG = "UI_TEST";
 
 // 自定义返回按钮回调 - 处理测试界面的特殊逻辑
 static void test_back_btn_callback(lv_event_t* e) {
-    lv_obj_t* screen = lv_scr_act();
-    if (screen) {
-        lv_obj_clean(screen);
-        ui_main_menu_create(screen);
+    ui_screen_cache_show(UI_SCREEN_MAIN_MENU);
+}
+
+// 显示后端性能测试按钮回调：依次测试两个显示驱动，结果显示在标签中
+static void disp_bench_btn_callback(lv_event_t* e) {
+    lv_obj_t* result_label = (lv_obj_t*)lv_event_get_user_data(e);
+
+    static lv_port_disp_bench_result_t results[LV_PORT_DISP_BACKEND_MAX];
+    esp_err_t ret = lv_port_disp_bench_run_all(results);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Display benchmark finished with error: %s", esp_err_to_name(ret));
+    }
+
+    static char text[512];
+    lv_port_disp_bench_format(results, LV_PORT_DISP_BACKEND_MAX, text, sizeof(text));
+    lv_label_set_text(result_label, text);
+}
+
+// 布局方案测试完成回调：结果显示在标签中
+static void placement_bench_done(const task_placement_bench_result_t* results, size_t count, void* user_data) {
+    lv_obj_t* result_label = (lv_obj_t*)user_data;
+
+    static char text[256];
+    task_placement_bench_format(results, count, text, sizeof(text));
+    lv_label_set_text(result_label, text);
+}
+
+// 布局方案测试按钮回调：依次在 control/video 方案下测量解码帧率和界面帧率
+static void placement_bench_btn_callback(lv_event_t* e) {
+    lv_obj_t* result_label = (lv_obj_t*)lv_event_get_user_data(e);
+
+    esp_err_t ret = task_placement_bench_start(placement_bench_done, result_label);
+    if (ret != ESP_OK) {
+        lv_label_set_text_fmt(result_label, "Placement bench: %s", esp_err_to_name(ret));
+        return;
     }
+    lv_label_set_text(result_label, "Running placement bench...");
+}
+
+// 分配跟踪开关：停止时把调用位置和碎片化趋势写到日志
+static void heap_trace_btn_callback(lv_event_t* e) {
+    lv_obj_t* result_label = (lv_obj_t*)lv_event_get_user_data(e);
+
+    if (heap_tracer_is_running()) {
+        heap_tracer_stop();
+        heap_tracer_dump(NULL, NULL, 16);
+        heap_tracer_dump_trend(NULL, NULL, 20);
+        lv_label_set_text(result_label, "Heap trace stopped, see log");
+        return;
+    }
+    esp_err_t ret = heap_tracer_start();
+    lv_label_set_text_fmt(result_label, "Heap trace: %s", ret == ESP_OK ? "running" : esp_err_to_name(ret));
 }
 
 // 创建测试界面
@@ -68,5 +118,38 @@ void ui_test_create(lv_obj_t* parent) {
 
     lv_obj_center(label);
 
+    // 显示后端性能测试
+    lv_obj_t* bench_btn = lv_btn_create(cont);
+    lv_obj_t* bench_btn_label = lv_label_create(bench_btn);
+    lv_label_set_text(bench_btn_label, "Display Benchmark");
+    lv_obj_center(bench_btn_label);
+
+    lv_obj_t* bench_result_label = lv_label_create(cont);
+    lv_obj_set_style_text_color(bench_result_label, lv_color_black(), LV_PART_MAIN);
+    lv_label_set_text(bench_result_label, "");
+    lv_obj_add_event_cb(bench_btn, disp_bench_btn_callback, LV_EVENT_CLICKED, bench_result_label);
+
+    // 任务布局方案测试
+    lv_obj_t* placement_btn = lv_btn_create(cont);
+    lv_obj_t* placement_btn_label = lv_label_create(placement_btn);
+    lv_label_set_text(placement_btn_label, "Placement Benchmark");
+    lv_obj_center(placement_btn_label);
+
+    lv_obj_t* placement_result_label = lv_label_create(cont);
+    lv_obj_set_style_text_color(placement_result_label, lv_color_black(), LV_PART_MAIN);
+    lv_label_set_text(placement_result_label, "");
+    lv_obj_add_event_cb(placement_btn, placement_bench_btn_callback, LV_EVENT_CLICKED, placement_result_label);
+
+    // 分配跟踪
+    lv_obj_t* heap_trace_btn = lv_btn_create(cont);
+    lv_obj_t* heap_trace_btn_label = lv_label_create(heap_trace_btn);
+    lv_label_set_text(heap_trace_btn_label, "Heap Trace");
+    lv_obj_center(heap_trace_btn_label);
+
+    lv_obj_t* heap_trace_label = lv_label_create(cont);
+    lv_obj_set_style_text_color(heap_trace_label, lv_color_black(), LV_PART_MAIN);
+    lv_label_set_text(heap_trace_label, heap_tracer_is_running() ? "Heap trace: running" : "");
+    lv_obj_add_event_cb(heap_trace_btn, heap_trace_btn_callback, LV_EVENT_CLICKED, heap_trace_label);
+
     ESP_LOGI(TAG, "Test UI created successfully");
 }
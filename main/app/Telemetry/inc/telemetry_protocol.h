@@ -8,12 +8,19 @@
 #define FRAME_HEADER_1 0xAA
 #define FRAME_HEADER_2 0x55
 
+// 长度字段为1字节（类型+负载），负载最多254字节
+#define TELEMETRY_MAX_PAYLOAD 254
+#define TELEMETRY_TASK_NAME_LEN 10
+#define TELEMETRY_TASK_STATS_MAX_ENTRIES \
+    ((TELEMETRY_MAX_PAYLOAD - sizeof(task_stats_payload_t)) / sizeof(task_stats_entry_t))
+
 // 帧类型
 typedef enum {
     FRAME_TYPE_RC = 0x01,
     FRAME_TYPE_TELEMETRY = 0x02,
     FRAME_TYPE_HEARTBEAT = 0x03,
     FRAME_TYPE_EXT_CMD = 0x04,
+    FRAME_TYPE_TASK_STATS = 0x05,
 } frame_type_t;
 
 // 扩展命令ID
@@ -63,6 +70,26 @@ typedef struct {
     uint8_t params[];
 } ext_command_payload_t;
 
+// 任务统计负载 (ESP32 -> 地面站)，后跟 entry_count 个 task_stats_entry_t
+typedef struct {
+    uint32_t seq;          // 采样序号
+    uint32_t timestamp_ms; // 采样时刻（自启动）
+    uint16_t period_ms;    // 采样间隔
+    uint16_t core_load[2]; // 每个核的负载，千分比
+    uint32_t free_internal;
+    uint32_t free_psram;
+    uint8_t task_count;  // 系统任务总数
+    uint8_t entry_count; // 本帧携带的任务条目数，按CPU占用降序
+} task_stats_payload_t;
+
+// 任务统计条目
+typedef struct {
+    char name[TELEMETRY_TASK_NAME_LEN]; // 任务名，不足补0，可能没有结尾0
+    uint16_t cpu_permille;              // 占用单个核的千分比
+    uint16_t stack_free;                // 栈历史最小剩余 (字节)，超过65535记为65535
+    uint8_t core_prio;                  // 高2位：核 (3 表示未绑定)，低6位：优先级
+} task_stats_entry_t;
+
 #pragma pack(pop)
 
 // 结构体用于存放解析后的帧数据
@@ -108,6 +135,18 @@ size_t telemetry_protocol_create_heartbeat_frame(uint8_t* buffer, size_t buffer_
 size_t telemetry_protocol_create_ext_command(uint8_t* buffer, size_t buffer_size, uint8_t cmd_id, const uint8_t* params,
                                              uint8_t param_len);
 
+/**
+ * @brief 编码任务统计帧
+ *
+ * @param buffer 用于存储编码后数据的缓冲区
+ * @param buffer_size 缓冲区大小
+ * @param stats 统计头，entry_count 会被截断到 TELEMETRY_TASK_STATS_MAX_ENTRIES
+ * @param entries 任务条目
+ * @return 编码后的帧长度, 失败返回0
+ */
+size_t telemetry_protocol_create_task_stats_frame(uint8_t* buffer, size_t buffer_size, const task_stats_payload_t* stats,
+                                                  const task_stats_entry_t* entries);
+
 /**
  * @brief 解析收到的数据帧
  *
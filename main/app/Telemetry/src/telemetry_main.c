@@ -6,6 +6,7 @@
 #include "freertos/semphr.h"
 #include "freertos/task.h"
 #include "lwip/sockets.h"
+#include "task_placement.h"
 #include "telemetry_data_converter.h" // 添加缺失的头文件
 #include "telemetry_receiver.h"
 #include "telemetry_sender.h"
@@ -101,7 +102,7 @@ int telemetry_service_start(telemetry_data_callback_t callback) {
     }
 
     // 启动服务器任务
-    if (xTaskCreate(telemetry_server_task, "telemetry_server", 4096, NULL, 5, &server_task_handle) != pdPASS) {
+    if (task_placement_create(telemetry_server_task, "telemetry_server", NULL, &server_task_handle) != pdPASS) {
         ESP_LOGE(TAG, "Failed to create server task");
         telemetry_receiver_stop();
         service_status = TELEMETRY_STATUS_ERROR;
@@ -109,10 +110,10 @@ int telemetry_service_start(telemetry_data_callback_t callback) {
     }
 
     // 启动数据处理任务
-    if (xTaskCreate(telemetry_data_task, "telemetry_data", 4096, NULL, 4, &telemetry_task_handle) != pdPASS) {
+    if (task_placement_create(telemetry_data_task, "telemetry_data", NULL, &telemetry_task_handle) != pdPASS) {
         ESP_LOGE(TAG, "Failed to create data task");
         if (server_task_handle) {
-            vTaskDelete(server_task_handle);
+            task_placement_delete(server_task_handle);
             server_task_handle = NULL;
         }
         telemetry_receiver_stop();
@@ -151,12 +152,12 @@ int telemetry_service_stop(void) {
 
     // 如果任务仍然存在，强制删除
     if (server_task_handle != NULL && eTaskGetState(server_task_handle) != eDeleted) {
-        vTaskDelete(server_task_handle);
+        task_placement_delete(server_task_handle);
         server_task_handle = NULL;
     }
 
     if (telemetry_task_handle != NULL && eTaskGetState(telemetry_task_handle) != eDeleted) {
-        vTaskDelete(telemetry_task_handle);
+        task_placement_delete(telemetry_task_handle);
         telemetry_task_handle = NULL;
     }
 
@@ -288,7 +289,7 @@ static void telemetry_server_task(void* pvParameters) {
 
     ESP_LOGI(TAG, "Server task ended");
     server_task_handle = NULL;
-    vTaskDelete(NULL);
+    task_placement_delete(NULL);
 }
 
 /**
@@ -325,5 +326,5 @@ static void telemetry_data_task(void* pvParameters) {
 
     ESP_LOGI(TAG, "Data task ended");
     telemetry_task_handle = NULL;
-    vTaskDelete(NULL);
+    task_placement_delete(NULL);
 }
\ No newline at end of file
@@ -157,6 +157,42 @@ size_t telemetry_protocol_create_ext_command(uint8_t* buffer, size_t buffer_size
     return finalize_frame(buffer, FRAME_TYPE_EXT_CMD, payload, payload_len);
 }
 
+/**
+ * @brief 创建任务统计帧
+ *
+ * @param buffer 帧缓冲区
+ * @param buffer_size 帧缓冲区大小
+ * @param stats 统计头
+ * @param entries 任务条目数组
+ * @return 整个帧的总长度
+ */
+size_t telemetry_protocol_create_task_stats_frame(uint8_t* buffer, size_t buffer_size, const task_stats_payload_t* stats,
+                                                  const task_stats_entry_t* entries) {
+    if (stats == NULL || (stats->entry_count > 0 && entries == NULL)) {
+        return 0;
+    }
+
+    uint8_t payload[TELEMETRY_MAX_PAYLOAD];
+    task_stats_payload_t header = *stats;
+    if (header.entry_count > TELEMETRY_TASK_STATS_MAX_ENTRIES) {
+        header.entry_count = TELEMETRY_TASK_STATS_MAX_ENTRIES;
+    }
+    size_t entries_len = header.entry_count * sizeof(task_stats_entry_t);
+    size_t payload_len = sizeof(header) + entries_len;
+
+    memcpy(payload, &header, sizeof(header));
+    if (entries_len > 0) {
+        memcpy(&payload[sizeof(header)], entries, entries_len);
+    }
+
+    size_t frame_len = 2 + 1 + 1 + payload_len + 2; // Header + Len + Type + Payload + CRC
+    if (buffer_size < frame_len) {
+        return 0;
+    }
+
+    return finalize_frame(buffer, FRAME_TYPE_TASK_STATS, payload, payload_len);
+}
+
 /**
  * @brief 解析帧
  *
@@ -17,7 +17,11 @@
 #include "telemetry_data_converter.h"
 #include "telemetry_main.h"
 #include "telemetry_protocol.h"
+#include "task_profiler.h"
+#include "esp_heap_caps.h"
+#include <stdlib.h>
 #include <string.h>
+#include <sys/param.h>
 
 static const char* TAG = "telemetry_sender";
 
@@ -26,9 +30,11 @@ static int g_client_sock = -1;
 static bool g_sender_active = false;
 static uint32_t g_last_heartbeat = 0;
 static uint32_t g_last_data_send = 0;
+static uint32_t g_last_stats_seq = 0; // 最近发送的任务统计采样序号
 
 // 内部函数声明
 static int send_frame(const uint8_t* frame, size_t len);
+static void send_task_stats(void);
 
 /**
  * @brief 初始化发送器
@@ -41,6 +47,7 @@ int telemetry_sender_init(void) {
     g_sender_active = false;
     g_last_heartbeat = 0;
     g_last_data_send = 0;
+    g_last_stats_seq = 0;
     return 0;
 }
 
@@ -123,6 +130,58 @@ void telemetry_sender_process(void) {
         }
         g_last_data_send = current_time;
     }
+
+    // 有新的任务统计采样时发送
+    send_task_stats();
+}
+
+/**
+ * @brief 发送最近一次任务统计采样（CPU占用最高的若干任务）
+ */
+static void send_task_stats(void) {
+    if (task_profiler_get_seq() == g_last_stats_seq) {
+        return;
+    }
+
+    task_profiler_sample_t* sample = heap_caps_malloc(sizeof(task_profiler_sample_t), MALLOC_CAP_SPIRAM);
+    if (sample == NULL) {
+        return;
+    }
+    if (task_profiler_get_latest(sample) != ESP_OK || sample->seq == g_last_stats_seq) {
+        free(sample);
+        return;
+    }
+
+    task_stats_payload_t stats = {
+        .seq = sample->seq,
+        .timestamp_ms = sample->timestamp_ms,
+        .period_ms = (uint16_t)MIN(sample->period_ms, UINT16_MAX),
+        .free_internal = sample->free_internal,
+        .free_psram = sample->free_psram,
+        .task_count = sample->task_count,
+        .entry_count = (uint8_t)MIN(sample->entry_count, TELEMETRY_TASK_STATS_MAX_ENTRIES),
+    };
+    for (int core = 0; core < portNUM_PROCESSORS && core < 2; core++) {
+        stats.core_load[core] = sample->core_load_permille[core];
+    }
+
+    task_stats_entry_t entries[TELEMETRY_TASK_STATS_MAX_ENTRIES];
+    for (int i = 0; i < stats.entry_count; i++) {
+        const task_profiler_task_t* task = &sample->tasks[i];
+        memset(entries[i].name, 0, sizeof(entries[i].name));
+        strncpy(entries[i].name, task->name, sizeof(entries[i].name));
+        entries[i].cpu_permille = task->cpu_permille;
+        entries[i].stack_free = (uint16_t)MIN(task->stack_free, UINT16_MAX);
+        uint8_t core = (task->core < 0) ? 3 : (uint8_t)task->core;
+        entries[i].core_prio = (uint8_t)((core << 6) | MIN(task->priority, 0x3F));
+    }
+    free(sample);
+
+    uint8_t frame_buffer[2 + 1 + 1 + TELEMETRY_MAX_PAYLOAD + 2];
+    size_t frame_len = telemetry_protocol_create_task_stats_frame(frame_buffer, sizeof(frame_buffer), &stats, entries);
+    if (frame_len > 0 && send_frame(frame_buffer, frame_len) > 0) {
+        g_last_stats_seq = stats.seq;
+    }
 }
 
 void telemetry_sender_deactivate(void) {
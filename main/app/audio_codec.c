@@ -0,0 +1,109 @@
+/**
+ * @file audio_codec.c
+ * @brief IMA-ADPCM编解码实现
+ * @author TidyCraze
+ * @date 2025-10-18
+ */
+
+#include "audio_codec.h"
+
+static const int16_t s_step_table[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,    23,    25,    28,
+    31,    34,    37,    41,    45,    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,   337,   371,   408,   449,   494,
+    544,   598,   658,   724,   796,   876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,  5894,  6484,  7132,  7845,  8630,
+    9493,  10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+static const int8_t s_index_table[16] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+
+// 解码一个4位样本，更新预测值和步长索引
+static inline int16_t adpcm_decode_nibble(uint8_t nibble, int32_t* predictor, int32_t* index) {
+    int32_t step = s_step_table[*index];
+    int32_t diff = step >> 3;
+    if (nibble & 4) {
+        diff += step;
+    }
+    if (nibble & 2) {
+        diff += step >> 1;
+    }
+    if (nibble & 1) {
+        diff += step >> 2;
+    }
+    *predictor += (nibble & 8) ? -diff : diff;
+    if (*predictor > 32767) {
+        *predictor = 32767;
+    } else if (*predictor < -32768) {
+        *predictor = -32768;
+    }
+
+    *index += s_index_table[nibble];
+    if (*index < 0) {
+        *index = 0;
+    } else if (*index > 88) {
+        *index = 88;
+    }
+    return (int16_t)*predictor;
+}
+
+size_t audio_adpcm_decode_block(const uint8_t* in, size_t block_bytes, int16_t* out) {
+    if (block_bytes < AUDIO_ADPCM_MIN_BLOCK_BYTES) {
+        return 0;
+    }
+
+    int32_t predictor = (int16_t)(in[0] | (in[1] << 8));
+    int32_t index = in[2] > 88 ? 88 : in[2];
+    size_t n = 0;
+
+    out[n++] = (int16_t)predictor;
+    for (size_t i = AUDIO_ADPCM_HEADER_BYTES; i < block_bytes; i++) {
+        out[n++] = adpcm_decode_nibble(in[i] & 0x0F, &predictor, &index);
+        out[n++] = adpcm_decode_nibble(in[i] >> 4, &predictor, &index);
+    }
+    return n;
+}
+
+// 编码一个样本：按当前步长量化差值，并用与解码相同的方式更新预测值
+static inline uint8_t adpcm_encode_sample(int16_t sample, int32_t* predictor, int32_t* index) {
+    int32_t step = s_step_table[*index];
+    int32_t diff = sample - *predictor;
+    uint8_t nibble = 0;
+
+    if (diff < 0) {
+        nibble = 8;
+        diff = -diff;
+    }
+    if (diff >= step) {
+        nibble |= 4;
+        diff -= step;
+    }
+    if (diff >= (step >> 1)) {
+        nibble |= 2;
+        diff -= step >> 1;
+    }
+    if (diff >= (step >> 2)) {
+        nibble |= 1;
+    }
+    adpcm_decode_nibble(nibble, predictor, index);
+    return nibble;
+}
+
+size_t audio_adpcm_encode_block(const int16_t* in, size_t block_bytes, uint8_t* out, int32_t* index) {
+    if (block_bytes < AUDIO_ADPCM_MIN_BLOCK_BYTES) {
+        return 0;
+    }
+
+    int32_t predictor = in[0];
+    out[0] = (uint8_t)(predictor & 0xFF);
+    out[1] = (uint8_t)((predictor >> 8) & 0xFF);
+    out[2] = (uint8_t)*index;
+    out[3] = 0;
+
+    const int16_t* src = in + 1;
+    for (size_t i = AUDIO_ADPCM_HEADER_BYTES; i < block_bytes; i++) {
+        uint8_t lo = adpcm_encode_sample(*src++, &predictor, index);
+        uint8_t hi = adpcm_encode_sample(*src++, &predictor, index);
+        out[i] = (uint8_t)(lo | (hi << 4));
+    }
+    return block_bytes;
+}
@@ -0,0 +1,379 @@
+/**
+ * @file audio_jitter_buffer.c
+ * @brief TCP音频抖动缓冲实现
+ * @author TidyCraze
+ * @date 2025-10-18
+ */
+
+#include "audio_jitter_buffer.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* TAG = "AUDIO_JB";
+
+#define JB_MS_TO_SAMPLES(ms) ((uint32_t)(ms) * AUDIO_JB_SAMPLE_RATE / 1000)
+#define JB_CAPACITY_SAMPLES JB_MS_TO_SAMPLES(AUDIO_JB_CAPACITY_MS)
+
+#define JB_DEPTH_AVG_SHIFT 6         // 深度均值 EMA 系数 1/64，约0.37秒
+#define JB_DRIFT_DEADBAND_MS 5       // 均值偏离目标在此范围内不校正
+#define JB_DRIFT_PPM_PER_MS 100      // 超出死区后每1ms偏差对应的校正速率
+#define JB_DRIFT_MAX_PPM 5000        // 校正速率上限0.5%，约8音分
+#define JB_PLC_FADE_FRAMES 4         // 欠载后重复上一帧并淡出的帧数，约23ms
+#define JB_TARGET_STEP_UP_MS 20      // 每次欠载提高的目标延迟
+#define JB_TARGET_STEP_DOWN_MS 5     // 稳定后每次降低的目标延迟
+#define JB_STABLE_MS 20000           // 连续这么久无欠载才降低目标延迟
+#define JB_STABLE_FRAMES (JB_MS_TO_SAMPLES(JB_STABLE_MS) / AUDIO_JB_FRAME_SAMPLES)
+
+_Static_assert(2 * AUDIO_JB_MAX_TARGET_MS < AUDIO_JB_CAPACITY_MS, "high water mark must fit in the buffer");
+
+// ==================== 共享状态（s_lock 保护） ====================
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static int16_t* s_ring = NULL;
+static uint32_t s_read_pos = 0;
+static uint32_t s_write_pos = 0;
+static uint32_t s_count = 0;
+static bool s_reset_pending = false;      // 写入侧已清空缓冲，播放侧下一帧重置自身状态
+static uint32_t s_base_target_ms = AUDIO_JB_DEFAULT_TARGET_MS;
+static uint32_t s_target_ms = AUDIO_JB_DEFAULT_TARGET_MS;
+
+// ==================== 写入侧状态 ====================
+static uint8_t s_carry = 0;               // 上次写入剩下的半个样本
+static bool s_has_carry = false;
+static uint32_t s_dropped_bytes = 0;      // 写入侧统计，s_lock 保护，播放侧重置时不清零
+
+// ==================== 播放侧状态 ====================
+static bool s_playing = false;
+static bool s_fade_in = false;
+static int32_t s_depth_avg = 0;           // 深度均值，放大 2^JB_DEPTH_AVG_SHIFT 倍
+static int64_t s_drift_acc = 0;           // 累计校正量，单位百万分之一样本
+static uint32_t s_stable_frames = 0;
+static uint32_t s_plc_pos = 0;            // 补偿已输出的样本数
+static int16_t s_last_frame[AUDIO_JB_FRAME_SAMPLES];
+static int16_t s_scratch[AUDIO_JB_FRAME_SAMPLES + 1];
+static audio_jb_stats_t s_stats;
+
+static uint32_t clamp_target(uint32_t target_ms) {
+    if (target_ms < AUDIO_JB_MIN_TARGET_MS) {
+        return AUDIO_JB_MIN_TARGET_MS;
+    }
+    if (target_ms > AUDIO_JB_MAX_TARGET_MS) {
+        return AUDIO_JB_MAX_TARGET_MS;
+    }
+    return target_ms;
+}
+
+// 调用方持有 s_lock
+static uint32_t jb_free_samples_locked(void) {
+    uint32_t high = 2 * JB_MS_TO_SAMPLES(s_target_ms);
+    return s_count < high ? high - s_count : 0;
+}
+
+// 播放侧重置，由 audio_jb_read_frame 在看到 s_reset_pending 后调用
+static void jb_reset_playout(void) {
+    s_playing = false;
+    s_fade_in = false;
+    s_depth_avg = 0;
+    s_drift_acc = 0;
+    s_stable_frames = 0;
+    s_plc_pos = JB_PLC_FADE_FRAMES * AUDIO_JB_FRAME_SAMPLES;
+    memset(s_last_frame, 0, sizeof(s_last_frame));
+    memset(&s_stats, 0, sizeof(s_stats));
+}
+
+esp_err_t audio_jb_init(uint32_t target_ms) {
+    if (s_ring == NULL) {
+        s_ring = heap_caps_malloc(JB_CAPACITY_SAMPLES * sizeof(int16_t), MALLOC_CAP_SPIRAM);
+        if (s_ring == NULL) {
+            s_ring = malloc(JB_CAPACITY_SAMPLES * sizeof(int16_t));
+            if (s_ring == NULL) {
+                ESP_LOGE(TAG, "Failed to allocate jitter buffer");
+                return ESP_ERR_NO_MEM;
+            }
+        }
+    }
+
+    target_ms = clamp_target(target_ms);
+    portENTER_CRITICAL(&s_lock);
+    s_base_target_ms = target_ms;
+    s_target_ms = target_ms;
+    portEXIT_CRITICAL(&s_lock);
+    audio_jb_reset();
+
+    ESP_LOGI(TAG, "Jitter buffer ready: target %lums, capacity %dms", (unsigned long)target_ms, AUDIO_JB_CAPACITY_MS);
+    return ESP_OK;
+}
+
+void audio_jb_deinit(void) {
+    if (s_ring != NULL) {
+        free(s_ring);
+        s_ring = NULL;
+    }
+}
+
+void audio_jb_reset(void) {
+    portENTER_CRITICAL(&s_lock);
+    s_read_pos = s_write_pos;
+    s_count = 0;
+    s_target_ms = s_base_target_ms;
+    s_reset_pending = true;
+    s_dropped_bytes = 0;
+    portEXIT_CRITICAL(&s_lock);
+    s_has_carry = false;
+}
+
+void audio_jb_set_target_ms(uint32_t target_ms) {
+    target_ms = clamp_target(target_ms);
+    portENTER_CRITICAL(&s_lock);
+    s_base_target_ms = target_ms;
+    s_target_ms = target_ms;
+    portEXIT_CRITICAL(&s_lock);
+    ESP_LOGI(TAG, "Target latency set to %lums", (unsigned long)target_ms);
+}
+
+size_t audio_jb_writable(void) {
+    if (s_ring == NULL) {
+        return 0;
+    }
+    portENTER_CRITICAL(&s_lock);
+    uint32_t free_samples = jb_free_samples_locked();
+    portEXIT_CRITICAL(&s_lock);
+    return free_samples * sizeof(int16_t);
+}
+
+// ==================== 写入侧 ====================
+
+size_t audio_jb_write(const uint8_t* data, size_t len) {
+    if (s_ring == NULL || data == NULL || len == 0) {
+        return 0;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    uint32_t space = jb_free_samples_locked();
+    portEXIT_CRITICAL(&s_lock);
+
+    // 只有写入侧修改 s_write_pos，读出后在锁外拷贝
+    uint32_t wpos = s_write_pos;
+    uint32_t written = 0;
+    size_t used = 0;
+
+    if (s_has_carry && space > 0) {
+        s_ring[wpos] = (int16_t)(s_carry | ((uint16_t)data[0] << 8));
+        wpos = (wpos + 1) % JB_CAPACITY_SAMPLES;
+        s_has_carry = false;
+        used = 1;
+        written = 1;
+    }
+
+    uint32_t n = (len - used) / sizeof(int16_t);
+    if (n > space - written) {
+        n = space - written;
+    }
+    uint32_t first = JB_CAPACITY_SAMPLES - wpos;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(&s_ring[wpos], data + used, first * sizeof(int16_t));
+    memcpy(&s_ring[0], data + used + first * sizeof(int16_t), (n - first) * sizeof(int16_t));
+    wpos = (wpos + n) % JB_CAPACITY_SAMPLES;
+    used += n * sizeof(int16_t);
+    written += n;
+
+    if (len - used == 1 && !s_has_carry) {
+        s_carry = data[used];
+        s_has_carry = true;
+        used++;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_write_pos = wpos;
+    s_count += written;
+    s_dropped_bytes += len - used;
+    portEXIT_CRITICAL(&s_lock);
+    return used;
+}
+
+// ==================== 播放侧 ====================
+
+// 从 rpos 拷贝 n 个样本，期间缓冲被重置时不推进读指针
+static void jb_take(int16_t* dst, uint32_t rpos, uint32_t n) {
+    uint32_t first = JB_CAPACITY_SAMPLES - rpos;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(dst, &s_ring[rpos], first * sizeof(int16_t));
+    memcpy(dst + first, &s_ring[0], (n - first) * sizeof(int16_t));
+
+    portENTER_CRITICAL(&s_lock);
+    if (!s_reset_pending) {
+        s_read_pos = (rpos + n) % JB_CAPACITY_SAMPLES;
+        s_count -= n;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+// 从 from 开始用上一帧重复并线性淡出补齐，淡出结束后补静音
+static void jb_conceal(int16_t* out, uint32_t from) {
+    const uint32_t total = JB_PLC_FADE_FRAMES * AUDIO_JB_FRAME_SAMPLES;
+    bool concealed = false;
+
+    for (uint32_t i = from; i < AUDIO_JB_FRAME_SAMPLES; i++) {
+        if (s_plc_pos < total) {
+            out[i] = (int16_t)((int32_t)s_last_frame[i] * (int32_t)(total - s_plc_pos) / (int32_t)total);
+            s_plc_pos++;
+            concealed = true;
+        } else {
+            out[i] = 0;
+        }
+    }
+    if (concealed) {
+        s_stats.plc_frames++;
+    } else {
+        s_stats.silence_frames++;
+    }
+}
+
+// 把 in_len 个样本线性插值成一帧
+static void jb_resample(const int16_t* in, uint32_t in_len, int16_t* out) {
+    uint32_t step = ((in_len - 1) << 16) / (AUDIO_JB_FRAME_SAMPLES - 1);
+    uint32_t pos = 0;
+
+    for (uint32_t i = 0; i < AUDIO_JB_FRAME_SAMPLES; i++, pos += step) {
+        uint32_t idx = pos >> 16;
+        int32_t a = in[idx];
+        int32_t b = (idx + 1 < in_len) ? in[idx + 1] : a;
+        out[i] = (int16_t)(a + (int32_t)(((int64_t)(b - a) * (pos & 0xFFFF)) >> 16));
+    }
+}
+
+// 按深度均值与目标的偏差累计校正量，返回本帧多取(+1)、少取(-1)或不变(0)
+static int jb_drift_step(uint32_t depth, uint32_t target_ms) {
+    s_depth_avg += (int32_t)depth - (s_depth_avg >> JB_DEPTH_AVG_SHIFT);
+    int32_t avg = s_depth_avg >> JB_DEPTH_AVG_SHIFT;
+    int32_t error_ms = (avg - (int32_t)JB_MS_TO_SAMPLES(target_ms)) * 1000 / AUDIO_JB_SAMPLE_RATE;
+
+    int32_t ppm = 0;
+    if (error_ms > JB_DRIFT_DEADBAND_MS) {
+        ppm = (error_ms - JB_DRIFT_DEADBAND_MS) * JB_DRIFT_PPM_PER_MS;
+    } else if (error_ms < -JB_DRIFT_DEADBAND_MS) {
+        ppm = (error_ms + JB_DRIFT_DEADBAND_MS) * JB_DRIFT_PPM_PER_MS;
+    }
+    if (ppm > JB_DRIFT_MAX_PPM) {
+        ppm = JB_DRIFT_MAX_PPM;
+    } else if (ppm < -JB_DRIFT_MAX_PPM) {
+        ppm = -JB_DRIFT_MAX_PPM;
+    }
+    s_stats.drift_ppm = ppm;
+
+    s_drift_acc += (int64_t)ppm * AUDIO_JB_FRAME_SAMPLES;
+    if (s_drift_acc >= 1000000) {
+        s_drift_acc -= 1000000;
+        return 1;
+    }
+    if (s_drift_acc <= -1000000) {
+        s_drift_acc += 1000000;
+        return -1;
+    }
+    return 0;
+}
+
+static void jb_set_target(uint32_t target_ms) {
+    portENTER_CRITICAL(&s_lock);
+    s_target_ms = target_ms;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void audio_jb_read_frame(int16_t* out) {
+    if (s_ring == NULL) {
+        memset(out, 0, AUDIO_JB_FRAME_SAMPLES * sizeof(int16_t));
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    bool reset = s_reset_pending;
+    s_reset_pending = false;
+    uint32_t depth = s_count;
+    uint32_t rpos = s_read_pos;
+    uint32_t target_ms = s_target_ms;
+    uint32_t base_ms = s_base_target_ms;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (reset) {
+        jb_reset_playout();
+    }
+
+    // 预缓冲：深度达到目标前输出静音（或上一段的补偿尾巴）
+    if (!s_playing) {
+        if (depth < JB_MS_TO_SAMPLES(target_ms)) {
+            jb_conceal(out, 0);
+            return;
+        }
+        s_playing = true;
+        s_fade_in = true;
+        s_depth_avg = (int32_t)depth << JB_DEPTH_AVG_SHIFT;
+        s_drift_acc = 0;
+    }
+
+    int adjust = jb_drift_step(depth, target_ms);
+    uint32_t need = AUDIO_JB_FRAME_SAMPLES + adjust;
+
+    if (depth < need) {
+        // 欠载：先放完剩下的样本，其余补偿，然后重新预缓冲并提高目标延迟
+        jb_take(out, rpos, depth);
+        s_plc_pos = 0;
+        jb_conceal(out, depth);
+        s_playing = false;
+        s_stable_frames = 0;
+        s_stats.underruns++;
+        if (target_ms < AUDIO_JB_MAX_TARGET_MS) {
+            uint32_t raised = target_ms + JB_TARGET_STEP_UP_MS;
+            jb_set_target(raised > AUDIO_JB_MAX_TARGET_MS ? AUDIO_JB_MAX_TARGET_MS : raised);
+        }
+        ESP_LOGW(TAG, "Underrun #%lu, target %lums", (unsigned long)s_stats.underruns, (unsigned long)target_ms);
+        return;
+    }
+
+    if (adjust == 0) {
+        jb_take(out, rpos, need);
+    } else {
+        jb_take(s_scratch, rpos, need);
+        jb_resample(s_scratch, need, out);
+        if (adjust > 0) {
+            s_stats.removed_samples++;
+        } else {
+            s_stats.inserted_samples++;
+        }
+    }
+
+    if (s_fade_in) {
+        for (uint32_t i = 0; i < AUDIO_JB_FRAME_SAMPLES; i++) {
+            out[i] = (int16_t)((int32_t)out[i] * (int32_t)i / AUDIO_JB_FRAME_SAMPLES);
+        }
+        s_fade_in = false;
+    }
+    memcpy(s_last_frame, out, sizeof(s_last_frame));
+
+    // 长时间无欠载，逐步降回配置的目标延迟
+    if (++s_stable_frames >= JB_STABLE_FRAMES && target_ms > base_ms) {
+        s_stable_frames = 0;
+        uint32_t lowered = target_ms > base_ms + JB_TARGET_STEP_DOWN_MS ? target_ms - JB_TARGET_STEP_DOWN_MS : base_ms;
+        jb_set_target(lowered);
+        ESP_LOGI(TAG, "Stable, target lowered to %lums", (unsigned long)lowered);
+    }
+}
+
+void audio_jb_get_stats(audio_jb_stats_t* out) {
+    if (out == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    *out = s_stats;
+    out->depth_ms = s_count * 1000 / AUDIO_JB_SAMPLE_RATE;
+    out->target_ms = s_target_ms;
+    out->base_target_ms = s_base_target_ms;
+    out->dropped_bytes = s_dropped_bytes;
+    portEXIT_CRITICAL(&s_lock);
+    out->playing = s_playing;
+}
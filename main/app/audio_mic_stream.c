@@ -0,0 +1,297 @@
+/**
+ * @file audio_mic_stream.c
+ * @brief 麦克风采集和UDP上行实现
+ * @author TidyCraze
+ * @date 2025-10-18
+ */
+
+#include "audio_mic_stream.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "i2s_tdm.h"
+#include "lwip/sockets.h"
+#include "task_placement.h"
+#include <errno.h>
+#include <string.h>
+
+static const char* TAG = "AUDIO_MIC";
+
+#define MIC_SAMPLES_TO_US(n) ((int64_t)(n) * 1000000 / I2S_TDM_SAMPLE_RATE)
+#define MIC_CLICK_SAMPLES 88         // 咔嗒声长度，约2ms
+#define MIC_CLICK_HALF_PERIOD 8      // 方波半周期，约2.8kHz，落在小喇叭和麦克风都灵敏的频段
+#define MIC_CLICK_AMPLITUDE 24000
+#define MIC_DETECT_MIN_LEVEL 4000    // 检测阈值下限
+#define MIC_DETECT_NOISE_FACTOR 4    // 检测阈值不低于底噪峰值的这么多倍
+
+typedef enum {
+    LOOPBACK_IDLE,   // 等待下一次测量
+    LOOPBACK_ARMED,  // 已请求插入，等播放任务写入咔嗒声
+    LOOPBACK_WAIT,   // 咔嗒声已写入，等待采集到
+} loopback_state_t;
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool s_running = false;
+static TaskHandle_t s_task = NULL;
+static int s_sock = -1;
+static struct sockaddr_in s_dest;
+static audio_codec_t s_codec = AUDIO_CODEC_PCM16;
+static bool s_loopback = false;
+static audio_mic_stats_t s_stats;
+
+// 回环测量（s_lock 保护）：采集任务 IDLE->ARMED、WAIT->IDLE，播放任务 ARMED->WAIT
+static loopback_state_t s_lb_state = LOOPBACK_IDLE;
+static int64_t s_lb_play_us = 0;     // 咔嗒声开始播放的时刻
+static int64_t s_lb_next_us = 0;     // 下一次测量的时刻
+static int32_t s_lb_noise = 0;       // 底噪峰值，只由采集任务更新
+
+static int16_t s_pcm[AUDIO_MIC_FRAME_SAMPLES];
+static uint8_t s_packet[sizeof(mic_packet_header_t) + AUDIO_MIC_FRAME_SAMPLES * sizeof(int16_t)];
+
+// ==================== 回环测量 ====================
+
+void audio_mic_stream_on_playback(int16_t* frame, size_t samples, int64_t play_us) {
+    if (!s_running || !s_loopback) {
+        return;
+    }
+
+    // 测量期间只播放咔嗒声，避免音乐触发检测
+    memset(frame, 0, samples * sizeof(int16_t));
+
+    portENTER_CRITICAL(&s_lock);
+    bool inject = (s_lb_state == LOOPBACK_ARMED);
+    if (inject) {
+        s_lb_state = LOOPBACK_WAIT;
+        s_lb_play_us = play_us;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (inject) {
+        for (size_t i = 0; i < samples && i < MIC_CLICK_SAMPLES; i++) {
+            frame[i] = ((i / MIC_CLICK_HALF_PERIOD) & 1) ? -MIC_CLICK_AMPLITUDE : MIC_CLICK_AMPLITUDE;
+        }
+    }
+}
+
+static void mic_loopback_record(uint32_t latency_us) {
+    portENTER_CRITICAL(&s_lock);
+    s_stats.loopback_count++;
+    s_stats.loopback_last_us = latency_us;
+    s_stats.loopback_sum_us += latency_us;
+    if (s_stats.loopback_count == 1 || latency_us < s_stats.loopback_min_us) {
+        s_stats.loopback_min_us = latency_us;
+    }
+    if (latency_us > s_stats.loopback_max_us) {
+        s_stats.loopback_max_us = latency_us;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    ESP_LOGI(TAG, "Loopback latency %.2f ms", latency_us / 1000.0f);
+}
+
+// end_us 为本帧读取返回的时刻，近似最后一个样本的采集时刻
+static void mic_loopback_process(const int16_t* pcm, size_t samples, int64_t end_us) {
+    portENTER_CRITICAL(&s_lock);
+    loopback_state_t state = s_lb_state;
+    int64_t play_us = s_lb_play_us;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (state == LOOPBACK_IDLE) {
+        int32_t peak = 0;
+        for (size_t i = 0; i < samples; i++) {
+            int32_t level = pcm[i] < 0 ? -pcm[i] : pcm[i];
+            if (level > peak) {
+                peak = level;
+            }
+        }
+        s_lb_noise += (peak - s_lb_noise) / 8;
+        if (end_us >= s_lb_next_us) {
+            portENTER_CRITICAL(&s_lock);
+            s_lb_state = LOOPBACK_ARMED;
+            portEXIT_CRITICAL(&s_lock);
+        }
+        return;
+    }
+    if (state != LOOPBACK_WAIT) {
+        return;
+    }
+
+    int32_t threshold = s_lb_noise * MIC_DETECT_NOISE_FACTOR;
+    if (threshold < MIC_DETECT_MIN_LEVEL) {
+        threshold = MIC_DETECT_MIN_LEVEL;
+    }
+
+    bool done = false;
+    for (size_t i = 0; i < samples; i++) {
+        int64_t sample_us = end_us - MIC_SAMPLES_TO_US(samples - i);
+        int32_t level = pcm[i] < 0 ? -pcm[i] : pcm[i];
+        if (sample_us >= play_us && level >= threshold) {
+            mic_loopback_record((uint32_t)(sample_us - play_us));
+            done = true;
+            break;
+        }
+    }
+    if (!done && end_us > play_us + AUDIO_MIC_LOOPBACK_TIMEOUT_MS * 1000LL) {
+        s_stats.loopback_timeouts++;
+        ESP_LOGW(TAG, "Loopback click not detected (threshold %ld)", (long)threshold);
+        done = true;
+    }
+    if (done) {
+        s_lb_next_us = end_us + AUDIO_MIC_LOOPBACK_INTERVAL_MS * 1000LL;
+        portENTER_CRITICAL(&s_lock);
+        s_lb_state = LOOPBACK_IDLE;
+        portEXIT_CRITICAL(&s_lock);
+    }
+}
+
+// ==================== 采集和发送 ====================
+
+static void mic_send_frame(uint32_t seq, uint32_t timestamp, int32_t* adpcm_index) {
+    mic_packet_header_t* header = (mic_packet_header_t*)s_packet;
+    uint8_t* payload = s_packet + sizeof(mic_packet_header_t);
+    size_t payload_len;
+
+    if (s_codec == AUDIO_CODEC_IMA_ADPCM) {
+        int64_t t0 = esp_timer_get_time();
+        payload_len = audio_adpcm_encode_block(s_pcm, AUDIO_MIC_ADPCM_BLOCK_BYTES, payload, adpcm_index);
+        s_stats.encode_us += esp_timer_get_time() - t0;
+    } else {
+        payload_len = sizeof(s_pcm);
+        memcpy(payload, s_pcm, payload_len);
+    }
+
+    header->magic = AUDIO_MIC_PACKET_MAGIC;
+    header->seq = seq;
+    header->timestamp = timestamp;
+    header->samples = AUDIO_MIC_FRAME_SAMPLES;
+    header->codec = (uint8_t)s_codec;
+    header->flags = 0;
+    header->loopback_us = s_stats.loopback_last_us;
+
+    size_t len = sizeof(mic_packet_header_t) + payload_len;
+    int sent = sendto(s_sock, s_packet, len, MSG_DONTWAIT, (struct sockaddr*)&s_dest, sizeof(s_dest));
+    if (sent < 0) {
+        s_stats.send_errors++;
+        return;
+    }
+    s_stats.packets_sent++;
+    s_stats.bytes_sent += sent;
+}
+
+// 采集任务：i2s_tdm_read 按I2S时钟阻塞，每帧返回一次
+static void mic_capture_task(void* arg) {
+    uint32_t seq = 0;
+    uint32_t timestamp = 0;
+    int32_t adpcm_index = 0;
+
+    while (s_running) {
+        size_t bytes_read = 0;
+        esp_err_t ret = i2s_tdm_read(s_pcm, sizeof(s_pcm), &bytes_read);
+        int64_t now = esp_timer_get_time();
+        if (ret != ESP_OK || bytes_read != sizeof(s_pcm)) {
+            s_stats.read_errors++;
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+        s_stats.frames++;
+
+        if (s_loopback) {
+            mic_loopback_process(s_pcm, AUDIO_MIC_FRAME_SAMPLES, now);
+        }
+        // 发送失败也占用序号，接收端能看到这一帧丢了
+        mic_send_frame(seq++, timestamp, &adpcm_index);
+        timestamp += AUDIO_MIC_FRAME_SAMPLES;
+    }
+
+    s_task = NULL;
+    task_placement_delete(NULL);
+}
+
+// ==================== 公共接口 ====================
+
+esp_err_t audio_mic_stream_start(const audio_mic_config_t* config) {
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!i2s_tdm_is_initialized()) {
+        ESP_LOGE(TAG, "I2S not initialized, start audio receiver first");
+        return ESP_ERR_INVALID_STATE;
+    }
+    audio_mic_stream_stop();
+
+    s_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (s_sock < 0) {
+        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+        return ESP_FAIL;
+    }
+    int broadcast = 1;
+    setsockopt(s_sock, SOL_SOCKET, SO_BROADCAST, &broadcast, sizeof(broadcast));
+
+    memset(&s_dest, 0, sizeof(s_dest));
+    s_dest.sin_family = AF_INET;
+    s_dest.sin_addr.s_addr = config->dest_addr;
+    s_dest.sin_port = htons(config->port ? config->port : AUDIO_MIC_UDP_PORT);
+    s_codec = config->codec;
+    s_loopback = config->loopback;
+
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_lb_state = LOOPBACK_IDLE;
+    s_lb_next_us = esp_timer_get_time() + AUDIO_MIC_LOOPBACK_INTERVAL_MS * 1000LL;
+    s_lb_noise = 0;
+
+    s_running = true;
+    if (task_placement_create(mic_capture_task, "mic_capture", NULL, &s_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create capture task");
+        s_running = false;
+        s_task = NULL;
+        close(s_sock);
+        s_sock = -1;
+        return ESP_ERR_NO_MEM;
+    }
+
+    char addr[16];
+    inet_ntoa_r(s_dest.sin_addr, addr, sizeof(addr));
+    ESP_LOGI(TAG, "Mic uplink started: %s:%u, %s%s", addr, ntohs(s_dest.sin_port),
+             s_codec == AUDIO_CODEC_IMA_ADPCM ? "IMA-ADPCM" : "PCM16", s_loopback ? ", loopback" : "");
+    return ESP_OK;
+}
+
+void audio_mic_stream_stop(void) {
+    if (!s_running) {
+        return;
+    }
+    s_running = false;
+
+    // 采集任务最多阻塞一帧
+    while (s_task != NULL) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    if (s_sock >= 0) {
+        close(s_sock);
+        s_sock = -1;
+    }
+
+    ESP_LOGI(TAG, "Mic uplink stopped: %lu frames, %lu sent, %lu send errors, %lu read errors",
+             (unsigned long)s_stats.frames, (unsigned long)s_stats.packets_sent,
+             (unsigned long)s_stats.send_errors, (unsigned long)s_stats.read_errors);
+    if (s_stats.loopback_count > 0) {
+        ESP_LOGI(TAG, "Loopback: %lu ok, %lu timeouts, min/avg/max %.2f/%.2f/%.2f ms",
+                 (unsigned long)s_stats.loopback_count, (unsigned long)s_stats.loopback_timeouts,
+                 s_stats.loopback_min_us / 1000.0f,
+                 (float)s_stats.loopback_sum_us / s_stats.loopback_count / 1000.0f,
+                 s_stats.loopback_max_us / 1000.0f);
+    }
+}
+
+bool audio_mic_stream_is_running(void) {
+    return s_running;
+}
+
+void audio_mic_stream_get_stats(audio_mic_stats_t* out) {
+    if (out == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    *out = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+}
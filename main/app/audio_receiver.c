@@ -7,21 +7,28 @@
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/ringbuf.h"
 #include "lwip/sockets.h"
 #include "i2s_tdm.h"
+#include "task_placement.h"
 #include <stdlib.h>
 #include "esp_heap_caps.h"
 #include <errno.h>
 #include "../UI/inc/status_bar_manager.h"
+#include "audio_receiver.h"
+#include "audio_jitter_buffer.h"
+#include "audio_codec.h"
+#include "audio_mic_stream.h"
+#include "esp_timer.h"
+#include <string.h>
 
 void audio_receiver_stop(void);
 
 static const char* TAG = "AUDIO_RECEIVER";
 
 #define TCP_PORT 7557
-#define BUFFER_SIZE (1024 * 256)  // 缓冲区大小到256KB
-#define SAMPLE_RATE 44100
+#define RX_CHUNK_SIZE 4096        // 单次recv的最大字节数
+#define SAMPLE_RATE AUDIO_JB_SAMPLE_RATE
+#define I2S_QUEUE_SAMPLES (8 * 64)  // I2S DMA队列深度，与 i2s_tdm.c 的 dma_desc_num × dma_frame_num 一致
 
 static int server_sock = -1;
 static int client_sock = -1;
@@ -30,43 +37,205 @@ static bool audio_receiving = false;  // 音频接收状态标志
 static TaskHandle_t playback_task_handle = NULL;
 static TaskHandle_t tcp_server_task_handle = NULL;
 static TaskHandle_t tcp_receive_task_handle = NULL;
-static RingbufHandle_t audio_ringbuf = NULL;
+static uint32_t target_latency_ms = AUDIO_JB_DEFAULT_TARGET_MS;
+static uint64_t bytes_received = 0;     // 本次连接线上收到的字节数
+static uint64_t pcm_samples = 0;        // 本次连接解码出的样本数
+static uint64_t decode_us = 0;          // 本次连接的解码耗时
+static audio_codec_t session_codec = AUDIO_CODEC_PCM16;
 
-// I2S播放任务
+// I2S播放任务：按固定帧长从抖动缓冲取数据，缓冲未就绪时输出静音，I2S时钟决定取数节奏
 static void i2s_playback_task(void* arg) {
+    static int16_t frame[AUDIO_JB_FRAME_SAMPLES];
+
     while (server_running) {
-        size_t item_size;
-        const uint8_t* item = xRingbufferReceive(audio_ringbuf, &item_size, pdMS_TO_TICKS(100));
-        if (item) {
-            size_t bytes_written = 0;
-            esp_err_t ret = i2s_tdm_write((const void*)item, item_size, &bytes_written);
-            if (ret != ESP_OK) {
-                ESP_LOGE(TAG, "I2S write failed: %s", esp_err_to_name(ret));
-            }
-            vRingbufferReturnItem(audio_ringbuf, (void*)item);
+        audio_jb_read_frame(frame);
+        // 上一帧写入返回时DMA队列是满的，这一帧要等队列里的样本放完才开始播放
+        audio_mic_stream_on_playback(frame, AUDIO_JB_FRAME_SAMPLES,
+                                     esp_timer_get_time() + (int64_t)I2S_QUEUE_SAMPLES * 1000000 / SAMPLE_RATE);
+        size_t bytes_written = 0;
+        esp_err_t ret = i2s_tdm_write(frame, sizeof(frame), &bytes_written);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "I2S write failed: %s", esp_err_to_name(ret));
+            vTaskDelay(pdMS_TO_TICKS(10));
         }
     }
     playback_task_handle = NULL;
-    vTaskDelete(NULL);
+    task_placement_delete(NULL);
+}
+
+// ==================== 连接会话：流头协商和解码 ====================
+
+typedef struct {
+    uint32_t peer_addr;          // 对端IPv4地址，麦克风上行发往这里
+    uint8_t rx[RX_CHUNK_SIZE];
+    uint8_t header[sizeof(audio_stream_header_t)];
+    size_t header_fill;
+    bool header_done;
+    audio_codec_t codec;
+    size_t block_bytes;
+    size_t samples_per_block;
+    uint8_t block[AUDIO_ADPCM_MAX_BLOCK_BYTES];
+    size_t block_fill;
+    int16_t pcm[AUDIO_ADPCM_SAMPLES_PER_BLOCK(AUDIO_ADPCM_MAX_BLOCK_BYTES)];
+} audio_session_t;
+
+static const char* codec_name(audio_codec_t codec) {
+    return codec == AUDIO_CODEC_IMA_ADPCM ? "IMA-ADPCM" : "PCM16";
+}
+
+// 本次最多收多少字节：流头只收到头为止，ADPCM只收解码后放得进抖动缓冲的整块
+static size_t session_recv_limit(const audio_session_t* session) {
+    size_t room = audio_jb_writable();
+    size_t limit;
+
+    if (!session->header_done) {
+        limit = sizeof(session->header) - session->header_fill;
+    } else if (session->codec == AUDIO_CODEC_IMA_ADPCM) {
+        size_t blocks = room / (session->samples_per_block * sizeof(int16_t));
+        limit = blocks > 0 ? blocks * session->block_bytes - session->block_fill : 0;
+    } else {
+        limit = room;
+    }
+    return limit < RX_CHUNK_SIZE ? limit : RX_CHUNK_SIZE;
+}
+
+// 解析流头，开头不是魔数时按旧格式的PCM处理
+static esp_err_t session_parse_header(audio_session_t* session) {
+    audio_stream_header_t header;
+    memcpy(&header, session->header, sizeof(header));
+    session->header_done = true;
+
+    if (header.magic != AUDIO_STREAM_MAGIC) {
+        session->codec = AUDIO_CODEC_PCM16;
+        audio_jb_write(session->header, sizeof(session->header));
+        ESP_LOGI(TAG, "No stream header, raw PCM16");
+        return ESP_OK;
+    }
+
+    if (header.version != AUDIO_STREAM_VERSION || header.channels != 1 || header.sample_rate != SAMPLE_RATE) {
+        ESP_LOGE(TAG, "Unsupported stream: version %u, %u channels, %lu Hz", header.version, header.channels,
+                 (unsigned long)header.sample_rate);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    switch (header.codec) {
+        case AUDIO_CODEC_PCM16:
+            session->codec = AUDIO_CODEC_PCM16;
+            break;
+        case AUDIO_CODEC_IMA_ADPCM:
+            // 只收整块解码后放得进抖动缓冲的数据，一块超过最小高水位时目标延迟调低后就再也收不进来
+            if (header.block_bytes < AUDIO_ADPCM_MIN_BLOCK_BYTES || header.block_bytes > AUDIO_ADPCM_MAX_BLOCK_BYTES ||
+                header.samples_per_block != AUDIO_ADPCM_SAMPLES_PER_BLOCK(header.block_bytes) ||
+                header.samples_per_block > AUDIO_JB_MIN_HIGH_WATER_SAMPLES) {
+                ESP_LOGE(TAG, "Bad ADPCM block: %u bytes, %u samples", header.block_bytes, header.samples_per_block);
+                return ESP_ERR_INVALID_ARG;
+            }
+            session->codec = AUDIO_CODEC_IMA_ADPCM;
+            session->block_bytes = header.block_bytes;
+            session->samples_per_block = header.samples_per_block;
+            break;
+        default:
+            ESP_LOGE(TAG, "Unknown codec %u", header.codec);
+            return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    ESP_LOGI(TAG, "Stream header: %s, block %u bytes, flags 0x%02x", codec_name(session->codec),
+             (unsigned)session->block_bytes, header.flags);
+
+    // 对端请求麦克风上行：发回对端，编码与下行一致；失败只影响上行
+    if (header.flags & AUDIO_STREAM_FLAG_MIC_UPLINK) {
+        audio_mic_config_t mic_config = {
+            .dest_addr = session->peer_addr,
+            .port = AUDIO_MIC_UDP_PORT,
+            .codec = session->codec,
+            .loopback = (header.flags & AUDIO_STREAM_FLAG_LOOPBACK) != 0,
+        };
+        esp_err_t ret = audio_mic_stream_start(&mic_config);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Mic uplink not started: %s", esp_err_to_name(ret));
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t session_consume(audio_session_t* session, const uint8_t* data, size_t len) {
+    if (!session->header_done) {
+        memcpy(session->header + session->header_fill, data, len);
+        session->header_fill += len;
+        return session->header_fill < sizeof(session->header) ? ESP_OK : session_parse_header(session);
+    }
+
+    if (session->codec == AUDIO_CODEC_PCM16) {
+        size_t written = audio_jb_write(data, len);
+        if (written < len) {
+            // recv 按可写空间限长，之后目标延迟被调低时才会丢弃，丢弃量计入 dropped_bytes
+            ESP_LOGW(TAG, "Jitter buffer full, dropped %u PCM bytes", (unsigned)(len - written));
+        }
+        pcm_samples += written / sizeof(int16_t);
+        return ESP_OK;
+    }
+
+    while (len > 0) {
+        size_t n = session->block_bytes - session->block_fill;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(session->block + session->block_fill, data, n);
+        session->block_fill += n;
+        data += n;
+        len -= n;
+
+        if (session->block_fill == session->block_bytes) {
+            int64_t t0 = esp_timer_get_time();
+            size_t samples = audio_adpcm_decode_block(session->block, session->block_bytes, session->pcm);
+            decode_us += esp_timer_get_time() - t0;
+            size_t written = audio_jb_write((const uint8_t*)session->pcm, samples * sizeof(int16_t));
+            if (written < samples * sizeof(int16_t)) {
+                ESP_LOGW(TAG, "Jitter buffer full, dropped %u of %u decoded samples",
+                         (unsigned)(samples - written / sizeof(int16_t)), (unsigned)samples);
+            }
+            pcm_samples += written / sizeof(int16_t);
+            session->block_fill = 0;
+        }
+    }
+    return ESP_OK;
 }
 
 // TCP接收任务
 static void tcp_receive_task(void* arg) {
     int sock = (int)(intptr_t)arg;
-    int total_received = 0;
-    
-    char *rx_buffer = heap_caps_malloc(BUFFER_SIZE, MALLOC_CAP_SPIRAM);
-    if (!rx_buffer) {
-        ESP_LOGE(TAG, "Failed to allocate rx_buffer from PSRAM");
-        rx_buffer = malloc(BUFFER_SIZE);
-        if (!rx_buffer) {
-            ESP_LOGE(TAG, "Failed to allocate rx_buffer from internal RAM");
+
+    audio_session_t* session = heap_caps_calloc(1, sizeof(audio_session_t), MALLOC_CAP_SPIRAM);
+    if (!session) {
+        ESP_LOGE(TAG, "Failed to allocate session from PSRAM");
+        session = calloc(1, sizeof(audio_session_t));
+        if (!session) {
+            ESP_LOGE(TAG, "Failed to allocate session from internal RAM");
             goto cleanup;
         }
     }
-    
+
+    struct sockaddr_in peer;
+    socklen_t peer_len = sizeof(peer);
+    if (getpeername(sock, (struct sockaddr*)&peer, &peer_len) == 0) {
+        session->peer_addr = peer.sin_addr.s_addr;
+    }
+
+    // 新连接从预缓冲开始
+    audio_jb_reset();
+    bytes_received = 0;
+    pcm_samples = 0;
+    decode_us = 0;
+    session_codec = AUDIO_CODEC_PCM16;
+
     while (server_running && sock >= 0) {
-        int len = recv(sock, rx_buffer, BUFFER_SIZE, 0);
+        // 只收抖动缓冲放得下的量，其余留在TCP窗口里让发送端减速
+        size_t limit = session_recv_limit(session);
+        if (limit == 0) {
+            vTaskDelay(pdMS_TO_TICKS(5));
+            continue;
+        }
+        int len = recv(sock, session->rx, limit, 0);
         if (len < 0) {
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
                 vTaskDelay(pdMS_TO_TICKS(5)); // 短暂等待，避免忙等
@@ -78,33 +247,48 @@ static void tcp_receive_task(void* arg) {
             ESP_LOGI(TAG, "Connection closed");
             break;
         } else {
-            total_received += len;
-            
+            bytes_received += len;
+
             // 设置音频接收状态
             audio_receiving = true;
             
             // 更新状态栏显示音频接收状态
             status_bar_manager_set_audio_status(true);
             
-            BaseType_t done = xRingbufferSend(audio_ringbuf, rx_buffer, len, pdMS_TO_TICKS(100));
-            if (!done) {
-                ESP_LOGW(TAG, "Ringbuffer full, dropping %d bytes", len);
+            if (session_consume(session, session->rx, len) != ESP_OK) {
+                break;
             }
+            session_codec = session->codec;
         }
     }
 
+    audio_jb_stats_t stats;
+    audio_jb_get_stats(&stats);
+    float seconds = (float)pcm_samples / SAMPLE_RATE;
+    ESP_LOGI(TAG, "Session: %s, %llu bytes for %.1fs (%.0f kbit/s), decode %.2f%% CPU",
+             codec_name(session_codec), (unsigned long long)bytes_received, seconds,
+             seconds > 0 ? bytes_received * 8 / seconds / 1000 : 0.0f,
+             seconds > 0 ? decode_us / (seconds * 1e4f) : 0.0f);
+    ESP_LOGI(TAG, "Session: target %lums, %lu underruns, %lu PLC frames, +%lu/-%lu drift samples, %lu bytes dropped",
+             (unsigned long)stats.target_ms, (unsigned long)stats.underruns,
+             (unsigned long)stats.plc_frames, (unsigned long)stats.inserted_samples,
+             (unsigned long)stats.removed_samples, (unsigned long)stats.dropped_bytes);
+
 cleanup:
+    // 上行随连接结束
+    audio_mic_stream_stop();
+
     // 连接断开时，更新状态
     audio_receiving = false;
     status_bar_manager_set_audio_status(false);
     
-    if (rx_buffer) {
-        free(rx_buffer);
+    if (session) {
+        free(session);
     }
     close(sock);
     client_sock = -1;
     tcp_receive_task_handle = NULL;
-    vTaskDelete(NULL);
+    task_placement_delete(NULL);
 }
 
 // TCP服务器任务
@@ -151,7 +335,7 @@ static void tcp_server_task(void* arg) {
         fcntl(client_sock, F_SETFL, flags | O_NONBLOCK);
 
         // 创建独立的TCP接收任务来处理这个连接
-        xTaskCreatePinnedToCore(tcp_receive_task, "tcp_receive", 4096, (void*)(intptr_t)client_sock, 5, &tcp_receive_task_handle, 0);
+        task_placement_create(tcp_receive_task, "audio_receive", (void*)(intptr_t)client_sock, &tcp_receive_task_handle);
         
         // 等待接收任务完成
         while (tcp_receive_task_handle != NULL && server_running) {
@@ -165,7 +349,7 @@ error:
         server_sock = -1;
     }
     tcp_server_task_handle = NULL;
-    vTaskDelete(NULL);
+    task_placement_delete(NULL);
 }
 
 esp_err_t audio_receiver_start(void) {
@@ -174,19 +358,15 @@ esp_err_t audio_receiver_start(void) {
     }
     server_running = true;
 
-    // 初始化环形缓冲区 - 256KB缓冲区分配到PSRAM
-    audio_ringbuf = xRingbufferCreateWithCaps(BUFFER_SIZE, RINGBUF_TYPE_BYTEBUF, MALLOC_CAP_SPIRAM);
-    if (!audio_ringbuf) {
-        audio_ringbuf = xRingbufferCreate(BUFFER_SIZE, RINGBUF_TYPE_BYTEBUF);
-        if (!audio_ringbuf) {
-            ESP_LOGE(TAG, "Failed to create ring buffer");
-            server_running = false;
-            return ESP_FAIL;
-        }
+    // 抖动缓冲分配到PSRAM
+    esp_err_t ret = audio_jb_init(target_latency_ms);
+    if (ret != ESP_OK) {
+        server_running = false;
+        return ret;
     }
 
     // 初始化I2S
-    esp_err_t ret = i2s_tdm_init();
+    ret = i2s_tdm_init();
     if (ret != ESP_OK) {
         audio_receiver_stop();
         return ret;
@@ -202,22 +382,14 @@ esp_err_t audio_receiver_start(void) {
         return ret;
     }
 
-    const size_t silence_buffer_size = 1024;
-    uint8_t* silence_buffer = (uint8_t*)calloc(1, silence_buffer_size);
-    if (silence_buffer) {
-        size_t bytes_written = 0;
-        i2s_tdm_write(silence_buffer, silence_buffer_size, &bytes_written);
-        free(silence_buffer);
-    }
-
     // 创建播放任务
     if (playback_task_handle == NULL) {
-        xTaskCreatePinnedToCore(i2s_playback_task, "i2s_playback", 4096, NULL, 5, &playback_task_handle, 1);
+        task_placement_create(i2s_playback_task, "i2s_playback", NULL, &playback_task_handle);
     }
 
     // 创建TCP服务器任务
     if (tcp_server_task_handle == NULL) {
-        xTaskCreatePinnedToCore(tcp_server_task, "tcp_server", 4096, NULL, 5, &tcp_server_task_handle, 1);
+        task_placement_create(tcp_server_task, "audio_server", NULL, &tcp_server_task_handle);
     }
 
     return ESP_OK;
@@ -248,10 +420,8 @@ void audio_receiver_stop(void) {
         vTaskDelay(pdMS_TO_TICKS(50));
     }
 
-    if (audio_ringbuf) {
-        vRingbufferDelete(audio_ringbuf);
-        audio_ringbuf = NULL;
-    }
+    audio_mic_stream_stop();
+    audio_jb_deinit();
 
     i2s_tdm_stop();
     i2s_tdm_deinit();
@@ -260,4 +430,24 @@ void audio_receiver_stop(void) {
 
 bool audio_receiver_is_receiving(void) {
     return audio_receiving && server_running && (client_sock >= 0);
-}
\ No newline at end of file
+}
+
+void audio_receiver_set_target_latency_ms(uint32_t target_ms) {
+    target_latency_ms = target_ms;
+    if (server_running) {
+        audio_jb_set_target_ms(target_ms);
+    }
+}
+
+void audio_receiver_get_stats(audio_receiver_stats_t* out) {
+    if (out == NULL) {
+        return;
+    }
+    audio_jb_get_stats(&out->jb);
+    out->latency_ms = out->jb.depth_ms + (I2S_QUEUE_SAMPLES + AUDIO_JB_FRAME_SAMPLES) * 1000 / SAMPLE_RATE;
+    out->bytes_received = bytes_received;
+    out->pcm_samples = pcm_samples;
+    out->decode_us = decode_us;
+    out->codec = session_codec;
+    out->receiving = audio_receiver_is_receiving();
+}
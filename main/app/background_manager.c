@@ -12,6 +12,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "task_placement.h"
 #include "wifi_manager.h"
 #include <string.h>
 
@@ -171,15 +172,7 @@ esp_err_t background_manager_start(void) {
     
     s_task_running = true;
     
-    BaseType_t result = xTaskCreatePinnedToCore(
-        background_manager_task,
-        "Background_Mgr",
-        4096,  // 4KB堆栈
-        NULL,
-        2,     // 优先级2
-        &s_background_task_handle,
-        0      // 运行在Core 0
-    );
+    BaseType_t result = task_placement_create(background_manager_task, "Background_Mgr", NULL, &s_background_task_handle);
     
     if (result != pdPASS) {
         s_task_running = false;
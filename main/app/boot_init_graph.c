@@ -0,0 +1,160 @@
+/**
+ * @file boot_init_graph.c
+ * @brief 按依赖关系并行执行启动初始化步骤
+ * @author TidyCraze
+ * @date 2025-10-18
+ */
+
+#include "boot_init_graph.h"
+#include "boot_profiler.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "task_placement.h"
+
+static const char* TAG = "BOOT_INIT";
+
+// 一次执行的共享状态，位于调用者栈上
+typedef struct {
+    const boot_init_step_t* steps;
+    size_t count;
+    EventBits_t all_mask;
+    EventGroupHandle_t done;     // 第 i 位：步骤 i 已结束（成功、失败或跳过）
+    SemaphoreHandle_t lock;      // 保护 started/failed/first_error
+    SemaphoreHandle_t helper_exit;
+    uint32_t started;
+    uint32_t failed;             // 失败的必需步骤以及被跳过的步骤，其依赖者都将跳过
+    esp_err_t first_error;
+} boot_init_ctx_t;
+
+// 取出一个依赖已全部结束、尚未开始的步骤，没有则返回 -1
+static int pick_ready_step(boot_init_ctx_t* ctx, EventBits_t done, bool* skip) {
+    int pick = -1;
+
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    for (size_t i = 0; i < ctx->count; i++) {
+        const boot_init_step_t* step = &ctx->steps[i];
+        if ((ctx->started & BOOT_INIT_DEP(i)) || (step->deps & done) != step->deps) {
+            continue;
+        }
+        ctx->started |= BOOT_INIT_DEP(i);
+        *skip = (step->deps & ctx->failed) != 0;
+        pick = (int)i;
+        break;
+    }
+    xSemaphoreGive(ctx->lock);
+
+    return pick;
+}
+
+static void run_steps(boot_init_ctx_t* ctx) {
+    while (1) {
+        EventBits_t done = xEventGroupGetBits(ctx->done) & ctx->all_mask;
+        if (done == ctx->all_mask) {
+            return;
+        }
+
+        bool skip = false;
+        int index = pick_ready_step(ctx, done, &skip);
+        if (index < 0) {
+            // 剩下的步骤都在执行或在等依赖，等任意一个未完成的步骤结束后再挑
+            xEventGroupWaitBits(ctx->done, ctx->all_mask & ~done, pdFALSE, pdFALSE, portMAX_DELAY);
+            continue;
+        }
+
+        const boot_init_step_t* step = &ctx->steps[index];
+        esp_err_t ret;
+        if (skip) {
+            ret = ESP_ERR_INVALID_STATE;
+            ESP_LOGW(TAG, "Skip %s: a dependency failed", step->name);
+            boot_profiler_mark(step->name);
+        } else {
+            int prof = boot_profiler_begin(step->name);
+            ret = step->fn();
+            boot_profiler_end(prof, ret);
+        }
+
+        if (ret != ESP_OK) {
+            xSemaphoreTake(ctx->lock, portMAX_DELAY);
+            if (step->required || skip) {
+                ctx->failed |= BOOT_INIT_DEP(index);
+            }
+            if (step->required && ctx->first_error == ESP_OK) {
+                ctx->first_error = ret;
+            }
+            xSemaphoreGive(ctx->lock);
+            if (!skip) {
+                ESP_LOGW(TAG, "%s failed: %s", step->name, esp_err_to_name(ret));
+            }
+        }
+
+        xEventGroupSetBits(ctx->done, BOOT_INIT_DEP(index));
+    }
+}
+
+static void boot_init_helper_task(void* arg) {
+    boot_init_ctx_t* ctx = (boot_init_ctx_t*)arg;
+    run_steps(ctx);
+    xSemaphoreGive(ctx->helper_exit);
+    vTaskDelete(NULL);
+}
+
+esp_err_t boot_init_run(const boot_init_step_t* steps, size_t count, bool parallel) {
+    if (steps == NULL || count == 0 || count > BOOT_INIT_MAX_STEPS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 依赖只能指向前面的步骤，这样不会出现环
+    for (size_t i = 0; i < count; i++) {
+        if (steps[i].fn == NULL || (steps[i].deps & ~(BOOT_INIT_DEP(i) - 1)) != 0) {
+            ESP_LOGE(TAG, "Invalid boot step %u (%s)", (unsigned)i, steps[i].name ? steps[i].name : "?");
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    boot_init_ctx_t ctx = {
+        .steps = steps,
+        .count = count,
+        .all_mask = (EventBits_t)(BOOT_INIT_DEP(count) - 1),
+        .done = xEventGroupCreate(),
+        .lock = xSemaphoreCreateMutex(),
+        .helper_exit = xSemaphoreCreateBinary(),
+        .first_error = ESP_OK,
+    };
+    if (ctx.done == NULL || ctx.lock == NULL || ctx.helper_exit == NULL) {
+        ESP_LOGE(TAG, "Failed to create boot init sync objects");
+        if (ctx.done) {
+            vEventGroupDelete(ctx.done);
+        }
+        if (ctx.lock) {
+            vSemaphoreDelete(ctx.lock);
+        }
+        if (ctx.helper_exit) {
+            vSemaphoreDelete(ctx.helper_exit);
+        }
+        return ESP_ERR_NO_MEM;
+    }
+
+    bool helper_running = false;
+    if (parallel) {
+        // 与调用者相同优先级，核由布局表决定（调用者在Core 0，辅助任务在Core 1）
+        BaseType_t result =
+            task_placement_create_ex(boot_init_helper_task, "Boot_Init", &ctx, 0, uxTaskPriorityGet(NULL), NULL);
+        helper_running = (result == pdPASS);
+        if (!helper_running) {
+            ESP_LOGW(TAG, "Failed to create boot init helper, running steps sequentially");
+        }
+    }
+
+    run_steps(&ctx);
+    if (helper_running) {
+        xSemaphoreTake(ctx.helper_exit, portMAX_DELAY);
+    }
+
+    vEventGroupDelete(ctx.done);
+    vSemaphoreDelete(ctx.lock);
+    vSemaphoreDelete(ctx.helper_exit);
+    return ctx.first_error;
+}
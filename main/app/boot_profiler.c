@@ -0,0 +1,176 @@
+/**
+ * @file boot_profiler.c
+ * @brief 启动时间线记录实现
+ * @author TidyCraze
+ * @date 2025-10-18
+ *
+ * 时间基准为 esp_timer_get_time()，即从 esp_timer 初始化（早于 app_main）开始的微秒数。
+ * 步骤可能在并行初始化的多个任务中同时记录，槽位分配用自旋锁保护，之后每个槽只由其所有者写入。
+ */
+
+#include "boot_profiler.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/task.h"
+#include "nvs.h"
+
+static const char* TAG = "BOOT_PROFILER";
+
+#define BOOT_PROFILER_NVS_NAMESPACE "boot_prof"
+#define BOOT_PROFILER_EWMA_SHIFT 2 // 历史均值按 1/4 权重更新
+
+#define BOOT_EVENT_INTERACTIVE BIT0
+
+// 单个步骤记录
+typedef struct {
+    const char* name;
+    int64_t start_us;
+    int64_t end_us; // 0 表示尚未结束
+    esp_err_t result;
+    int8_t core;
+} boot_step_record_t;
+
+static boot_step_record_t s_steps[BOOT_PROFILER_MAX_STEPS];
+static int s_step_count = 0;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static int64_t s_first_frame_us = 0;
+static int64_t s_interactive_us = 0;
+static EventGroupHandle_t s_events = NULL;
+
+static EventGroupHandle_t get_events(void) {
+    if (s_events == NULL) {
+        EventGroupHandle_t group = xEventGroupCreate();
+        portENTER_CRITICAL(&s_lock);
+        if (s_events == NULL) {
+            s_events = group;
+            group = NULL;
+        }
+        portEXIT_CRITICAL(&s_lock);
+        if (group) {
+            vEventGroupDelete(group);
+        }
+    }
+    return s_events;
+}
+
+int boot_profiler_begin(const char* name) {
+    int64_t now = esp_timer_get_time();
+    int step = -1;
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_step_count < BOOT_PROFILER_MAX_STEPS) {
+        step = s_step_count++;
+        s_steps[step].name = name;
+        s_steps[step].start_us = now;
+        s_steps[step].end_us = 0;
+        s_steps[step].result = ESP_OK;
+        s_steps[step].core = (int8_t)xPortGetCoreID();
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    return step;
+}
+
+void boot_profiler_end(int step, esp_err_t result) {
+    if (step < 0 || step >= BOOT_PROFILER_MAX_STEPS) {
+        return;
+    }
+    s_steps[step].result = result;
+    s_steps[step].end_us = esp_timer_get_time();
+}
+
+void boot_profiler_mark(const char* name) {
+    int step = boot_profiler_begin(name);
+    if (step >= 0) {
+        s_steps[step].end_us = s_steps[step].start_us;
+    }
+}
+
+void boot_profiler_mark_first_frame(void) {
+    if (s_first_frame_us == 0) {
+        s_first_frame_us = esp_timer_get_time();
+        boot_profiler_mark("first_frame");
+    }
+}
+
+void boot_profiler_mark_interactive(void) {
+    if (s_interactive_us == 0) {
+        s_interactive_us = esp_timer_get_time();
+        boot_profiler_mark("interactive");
+        xEventGroupSetBits(get_events(), BOOT_EVENT_INTERACTIVE);
+    }
+}
+
+bool boot_profiler_wait_interactive(uint32_t timeout_ms) {
+    EventBits_t bits =
+        xEventGroupWaitBits(get_events(), BOOT_EVENT_INTERACTIVE, pdFALSE, pdTRUE, pdMS_TO_TICKS(timeout_ms));
+    return (bits & BOOT_EVENT_INTERACTIVE) != 0;
+}
+
+// 与历史均值比较并更新，返回历史均值（没有历史时返回0）
+static uint32_t check_regression(nvs_handle_t nvs, const char* key, const char* label, uint32_t boots,
+                                 int64_t value_us) {
+    if (value_us <= 0) {
+        return 0;
+    }
+
+    uint32_t current = (uint32_t)value_us;
+    uint32_t avg = 0;
+    if (nvs_get_u32(nvs, key, &avg) != ESP_OK || boots == 0) {
+        avg = 0;
+    }
+
+    if (avg > 0 && boots >= BOOT_PROFILER_MIN_HISTORY &&
+        (uint64_t)current * 100 > (uint64_t)avg * (100 + BOOT_PROFILER_REGRESSION_PCT)) {
+        ESP_LOGW(TAG, "Boot regression: %s %lu us vs average %lu us (+%lu%%)", label, (unsigned long)current,
+                 (unsigned long)avg, (unsigned long)((current - avg) * 100 / avg));
+    } else if (avg > 0) {
+        ESP_LOGI(TAG, "%s %lu us (average %lu us over %lu boots)", label, (unsigned long)current,
+                 (unsigned long)avg, (unsigned long)boots);
+    }
+
+    uint32_t updated = (avg == 0) ? current : avg + (int32_t)(current - avg) / (1 << BOOT_PROFILER_EWMA_SHIFT);
+    nvs_set_u32(nvs, key, updated);
+    return avg;
+}
+
+void boot_profiler_report(void) {
+    int count;
+    portENTER_CRITICAL(&s_lock);
+    count = s_step_count;
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "=== Boot timeline (%d steps) ===", count);
+    ESP_LOGI(TAG, "%10s %10s %4s  %s", "start_us", "dur_us", "core", "step");
+    for (int i = 0; i < count; i++) {
+        const boot_step_record_t* s = &s_steps[i];
+        if (s->end_us == 0) {
+            ESP_LOGI(TAG, "%10lld %10s %4d  %s", s->start_us, "running", s->core, s->name);
+        } else if (s->result != ESP_OK) {
+            ESP_LOGW(TAG, "%10lld %10lld %4d  %s (%s)", s->start_us, s->end_us - s->start_us, s->core, s->name,
+                     esp_err_to_name(s->result));
+        } else {
+            ESP_LOGI(TAG, "%10lld %10lld %4d  %s", s->start_us, s->end_us - s->start_us, s->core, s->name);
+        }
+    }
+    ESP_LOGI(TAG, "Time to first frame: %lld us, time to first interactive frame: %lld us", s_first_frame_us,
+             s_interactive_us);
+
+    // 与历史启动比较，结果保存到NVS
+    nvs_handle_t nvs;
+    if (nvs_open(BOOT_PROFILER_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to open NVS, boot history not tracked");
+        return;
+    }
+
+    uint32_t boots = 0;
+    nvs_get_u32(nvs, "boots", &boots);
+    check_regression(nvs, "ff_avg", "first frame", boots, s_first_frame_us);
+    check_regression(nvs, "ti_avg", "first interactive frame", boots, s_interactive_us);
+    nvs_set_u32(nvs, "boots", boots + 1);
+    nvs_commit(nvs);
+    nvs_close(nvs);
+}
@@ -1,16 +1,12 @@
 #include "game.h"
 #include "theme_manager.h"
-#include "ui.h" // For ui_main_menu_create
+#include "ui.h" // For ui_screen_cache_show
 
 // --- 回调函数 ---
 
 // 返回主菜单的回调
 static void back_to_main_menu_cb(lv_event_t* e) {
-    lv_obj_t* screen = lv_scr_act();
-    if (screen) {
-        lv_obj_clean(screen);
-        ui_main_menu_create(screen);
-    }
+    ui_screen_cache_show(UI_SCREEN_MAIN_MENU);
 }
 
 // 启动俄罗斯方块的回调
@@ -20,6 +20,12 @@
 #define BOARD_HEIGHT 20
 #define BLOCK_SIZE 11  // 方块像素大小
 #define BORDER_WIDTH 1 // 方块边框宽度
+#define BOARD_BG_COLOR lv_color_hex(0xcccccc)
+
+// --- 瓦片渲染常量 ---
+#define TILE_EMPTY 0     // 背景瓦片
+#define TILE_COUNT 8     // 背景 + 7种方块颜色
+#define TILE_INVALID 0xFF // 强制重绘标记
 
 // --- LVGL 对象 ---
 static lv_obj_t* canvas;
@@ -59,6 +65,13 @@ static struct {
     uint8_t shape[4][4];
 } next_piece;
 
+// --- 瓦片渲染状态 ---
+// 每种颜色的方块预渲染成精灵，每帧只把内容有变化的格子从精灵拷贝到画布缓冲区
+static lv_color_t tile_sprites[TILE_COUNT][BLOCK_SIZE * BLOCK_SIZE];
+static bool tile_sprites_ready = false;
+static uint8_t drawn_board[BOARD_HEIGHT][BOARD_WIDTH]; // 画布上当前显示的瓦片
+static const Tetromino* drawn_next = NULL;              // 预览画布上当前显示的方块
+
 // --- NVS (非易失性存储) 函数 ---
 
 // 清理游戏资源
@@ -264,7 +277,7 @@ static void clear_lines() {
 
 // --- 绘图函数 ---
 
-// 绘制单个方块
+// 绘制单个方块（仅用于预渲染精灵）
 static void draw_block(int x, int y, lv_color_t color) {
     lv_draw_rect_dsc_t rect_dsc;
     lv_draw_rect_dsc_init(&rect_dsc);
@@ -276,61 +289,109 @@ static void draw_block(int x, int y, lv_color_t color) {
     lv_canvas_draw_rect(canvas, x * BLOCK_SIZE, y * BLOCK_SIZE, BLOCK_SIZE, BLOCK_SIZE, &rect_dsc);
 }
 
-// 绘制下一个方块
-static void draw_next_piece() {
-    if (!next_canvas || !next_piece.p_tetromino)
+// 预渲染方块精灵：借用主画布第0行，第i列绘制第i种瓦片（第0列保持背景色）
+static void tile_sprites_init(void) {
+    if (tile_sprites_ready) {
         return;
+    }
+
+    lv_canvas_fill_bg(canvas, BOARD_BG_COLOR, LV_OPA_COVER);
+    for (int i = 1; i < TILE_COUNT; i++) {
+        draw_block(i, 0, tetrominos[i - 1].color);
+    }
+
+    const int stride = BOARD_WIDTH * BLOCK_SIZE;
+    for (int i = 0; i < TILE_COUNT; i++) {
+        for (int row = 0; row < BLOCK_SIZE; row++) {
+            memcpy(&tile_sprites[i][row * BLOCK_SIZE], &main_canvas_buf[row * stride + i * BLOCK_SIZE],
+                   BLOCK_SIZE * sizeof(lv_color_t));
+        }
+    }
+    tile_sprites_ready = true;
+}
 
-    // 用背景色清空画布
-    lv_canvas_fill_bg(next_canvas, lv_color_hex(0xcccccc), LV_OPA_COVER);
+// 重置已绘制状态，下一帧整盘重绘
+static void tile_renderer_reset(void) {
+    memset(drawn_board, TILE_INVALID, sizeof(drawn_board));
+    drawn_next = NULL;
+}
 
-    // 计算下一个方块在画布中的居中位置
-    int offset_x = 0; // 4x4方块在4x4画布中的偏移
-    int offset_y = 0;
+// 把一个瓦片精灵拷贝到画布缓冲区的指定格子
+static void tile_blit(lv_color_t* buf, int buf_width, int cell_x, int cell_y, uint8_t tile) {
+    const lv_color_t* src = tile_sprites[tile];
+    lv_color_t* dst = buf + (cell_y * BLOCK_SIZE) * buf_width + cell_x * BLOCK_SIZE;
+    for (int row = 0; row < BLOCK_SIZE; row++) {
+        memcpy(dst, src, BLOCK_SIZE * sizeof(lv_color_t));
+        dst += buf_width;
+        src += BLOCK_SIZE;
+    }
+}
 
-    // 绘制下一个方块
+// 绘制下一个方块（仅在方块变化时重绘）
+static void draw_next_piece() {
+    if (!next_canvas || !next_piece.p_tetromino || !next_canvas_buf)
+        return;
+    if (drawn_next == next_piece.p_tetromino)
+        return;
+
+    uint8_t tile = (uint8_t)((next_piece.p_tetromino - tetrominos) + 1);
     for (int y = 0; y < 4; y++) {
         for (int x = 0; x < 4; x++) {
-            if (next_piece.shape[y][x]) {
-                lv_draw_rect_dsc_t rect_dsc;
-                lv_draw_rect_dsc_init(&rect_dsc);
-                rect_dsc.bg_color = next_piece.p_tetromino->color;
-                rect_dsc.radius = 2;
-                rect_dsc.border_width = BORDER_WIDTH;
-                rect_dsc.border_color = lv_color_black();
-
-                lv_canvas_draw_rect(next_canvas, (offset_x + x) * BLOCK_SIZE, (offset_y + y) * BLOCK_SIZE, BLOCK_SIZE,
-                                    BLOCK_SIZE, &rect_dsc);
-            }
+            tile_blit(next_canvas_buf, 4 * BLOCK_SIZE, x, y, next_piece.shape[y][x] ? tile : TILE_EMPTY);
         }
     }
+    drawn_next = next_piece.p_tetromino;
+    lv_obj_invalidate(next_canvas);
 }
 
-// 绘制整个游戏区域
+// 绘制游戏区域：只重绘与上一帧不同的格子，并只刷新这些格子的包围区域
 static void draw_board() {
-    // 用背景色清空画布
-    lv_canvas_fill_bg(canvas, lv_color_hex(0xcccccc), LV_OPA_COVER);
-
-    // 绘制已经固定的方块
-    for (int y = 0; y < BOARD_HEIGHT; y++) {
-        for (int x = 0; x < BOARD_WIDTH; x++) {
-            if (board[y][x]) {
-                draw_block(x, y, tetrominos[board[y][x] - 1].color);
-            }
-        }
-    }
+    if (!canvas || !main_canvas_buf)
+        return;
 
-    // 绘制当前下落的方块
+    // 合成本帧内容：已固定的方块 + 当前下落的方块
+    uint8_t frame[BOARD_HEIGHT][BOARD_WIDTH];
+    memcpy(frame, board, sizeof(frame));
     if (!game_over) {
+        uint8_t tile = (uint8_t)((current_piece.p_tetromino - tetrominos) + 1);
         for (int y = 0; y < 4; y++) {
             for (int x = 0; x < 4; x++) {
-                if (current_piece.shape[y][x]) {
-                    draw_block(current_piece.x + x, current_piece.y + y, current_piece.p_tetromino->color);
+                int board_x = current_piece.x + x;
+                int board_y = current_piece.y + y;
+                if (current_piece.shape[y][x] && board_x >= 0 && board_x < BOARD_WIDTH && board_y >= 0 &&
+                    board_y < BOARD_HEIGHT) {
+                    frame[board_y][board_x] = tile;
                 }
             }
         }
     }
 
+    // 拷贝变化的格子并记录包围盒
+    int min_x = BOARD_WIDTH, min_y = BOARD_HEIGHT, max_x = -1, max_y = -1;
+    for (int y = 0; y < BOARD_HEIGHT; y++) {
+        for (int x = 0; x < BOARD_WIDTH; x++) {
+            if (frame[y][x] == drawn_board[y][x]) {
+                continue;
+            }
+            tile_blit(main_canvas_buf, BOARD_WIDTH * BLOCK_SIZE, x, y, frame[y][x]);
+            drawn_board[y][x] = frame[y][x];
+            if (x < min_x) min_x = x;
+            if (x > max_x) max_x = x;
+            if (y < min_y) min_y = y;
+            if (y > max_y) max_y = y;
+        }
+    }
+
+    if (max_x >= 0) {
+        lv_area_t area;
+        lv_obj_get_coords(canvas, &area);
+        area.x2 = area.x1 + (max_x + 1) * BLOCK_SIZE - 1;
+        area.y2 = area.y1 + (max_y + 1) * BLOCK_SIZE - 1;
+        area.x1 += min_x * BLOCK_SIZE;
+        area.y1 += min_y * BLOCK_SIZE;
+        lv_obj_invalidate_area(canvas, &area);
+    }
+
     // 更新下一个方块显示
     draw_next_piece();
 }
@@ -667,6 +728,11 @@ static void start_game_cb(lv_event_t* e) {
     lv_obj_center(btn_label);
 
     // --- 启动游戏 ---
+    // 画布位置确定后再做局部刷新；首帧整盘重绘
+    lv_obj_update_layout(parent);
+    tile_sprites_init();
+    tile_renderer_reset();
+    lv_obj_invalidate(canvas);
     game_init();
     draw_board();
 
@@ -0,0 +1,79 @@
+/**
+ * @file audio_codec.h
+ * @brief TCP音频流头和IMA-ADPCM编解码
+ * @author TidyCraze
+ * @date 2025-10-18
+ *
+ * 连接建立后发送端可以先发一个 audio_stream_header_t 协商编码，之后是连续的音频数据：
+ *  - AUDIO_CODEC_PCM16：16位小端单声道PCM
+ *  - AUDIO_CODEC_IMA_ADPCM：固定长度的IMA-ADPCM块，与WAV单声道IMA-ADPCM块相同，
+ *    [预测值:2B 小端][步长索引:1B][保留:1B][4位样本，低半字节在前]，
+ *    每块 1 + (block_bytes - 4) * 2 个样本，块头的预测值就是第一个样本
+ * 开头4字节不是魔数时按旧格式当作PCM处理，旧的发送端不用改。
+ * 流头的 flags 可以请求麦克风上行（UDP发回对端，同一编码）和回环延迟测量，见 audio_mic_stream.h。
+ */
+
+#ifndef AUDIO_CODEC_H
+#define AUDIO_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_STREAM_MAGIC 0x53445541    // "AUDS" 小端
+#define AUDIO_STREAM_VERSION 1
+
+#define AUDIO_ADPCM_HEADER_BYTES 4
+#define AUDIO_ADPCM_MIN_BLOCK_BYTES 8
+#define AUDIO_ADPCM_MAX_BLOCK_BYTES 2048
+#define AUDIO_ADPCM_SAMPLES_PER_BLOCK(block_bytes) (1 + ((block_bytes) - AUDIO_ADPCM_HEADER_BYTES) * 2)
+
+#define AUDIO_STREAM_FLAG_MIC_UPLINK (1 << 0)  // 连接期间把麦克风发回对端
+#define AUDIO_STREAM_FLAG_LOOPBACK (1 << 1)    // 同时进入回环延迟测量模式
+
+typedef enum {
+    AUDIO_CODEC_PCM16 = 0,
+    AUDIO_CODEC_IMA_ADPCM = 1,
+} audio_codec_t;
+
+// 流头，所有字段小端
+typedef struct __attribute__((packed)) {
+    uint32_t magic;              // AUDIO_STREAM_MAGIC
+    uint8_t version;             // AUDIO_STREAM_VERSION
+    uint8_t codec;               // audio_codec_t
+    uint8_t channels;            // 目前只支持1
+    uint8_t flags;               // AUDIO_STREAM_FLAG_*
+    uint32_t sample_rate;        // 必须与播放采样率一致
+    uint16_t block_bytes;        // ADPCM块字节数，PCM时为0
+    uint16_t samples_per_block;  // ADPCM每块样本数，PCM时为0
+} audio_stream_header_t;
+
+_Static_assert(sizeof(audio_stream_header_t) == 16, "audio_stream_header_t must be 16 bytes");
+
+/**
+ * @brief 解码一个单声道IMA-ADPCM块
+ * @param in 块数据
+ * @param block_bytes 块字节数，不小于 AUDIO_ADPCM_MIN_BLOCK_BYTES
+ * @param out 输出，至少 AUDIO_ADPCM_SAMPLES_PER_BLOCK(block_bytes) 个样本
+ * @return size_t 输出的样本数
+ */
+size_t audio_adpcm_decode_block(const uint8_t* in, size_t block_bytes, int16_t* out);
+
+/**
+ * @brief 编码一个单声道IMA-ADPCM块
+ * @param in 输入，AUDIO_ADPCM_SAMPLES_PER_BLOCK(block_bytes) 个样本
+ * @param block_bytes 块字节数，不小于 AUDIO_ADPCM_MIN_BLOCK_BYTES
+ * @param out 输出，block_bytes 字节
+ * @param index 步长索引，跨块延续，首块前置0
+ * @return size_t 输出的字节数
+ */
+size_t audio_adpcm_encode_block(const int16_t* in, size_t block_bytes, uint8_t* out, int32_t* index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_CODEC_H
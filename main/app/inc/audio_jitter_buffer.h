@@ -0,0 +1,108 @@
+/**
+ * @file audio_jitter_buffer.h
+ * @brief TCP音频抖动缓冲：预缓冲、欠载补偿、时钟漂移校正
+ * @author TidyCraze
+ * @date 2025-10-18
+ *
+ * 单生产者（TCP接收任务）单消费者（I2S播放任务）的16位单声道PCM缓冲。
+ *  - 预缓冲：缓冲深度达到目标延迟后才开始播放，之前输出静音
+ *  - 欠载：取不够一帧时用上一帧重复并淡出补齐（PLC），之后输出静音并重新预缓冲
+ *  - 自适应：每次欠载提高目标延迟，长时间无欠载后逐步降回配置值
+ *  - 漂移：深度均值偏离目标时每帧多取或少取一个样本，按帧线性插值到固定帧长，
+ *    发送端时钟偏快时加速播放，偏慢时减速播放
+ * 写入侧只接受到高水位（目标延迟的两倍）为止，多出的数据留在TCP窗口里，由TCP流控限速发送端。
+ */
+
+#ifndef AUDIO_JITTER_BUFFER_H
+#define AUDIO_JITTER_BUFFER_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_JB_SAMPLE_RATE 44100
+#define AUDIO_JB_FRAME_SAMPLES 256   // 每次播放的样本数，约5.8ms
+#define AUDIO_JB_CAPACITY_MS 1000    // 缓冲容量
+#define AUDIO_JB_MIN_TARGET_MS 20
+#define AUDIO_JB_MAX_TARGET_MS 480   // 高水位为目标的两倍，不能超过容量
+// 高水位的最小值（目标延迟取下限时），写入侧一次需要的连续空间不能超过它，否则永远写不进去
+#define AUDIO_JB_MIN_HIGH_WATER_SAMPLES (2 * AUDIO_JB_MIN_TARGET_MS * AUDIO_JB_SAMPLE_RATE / 1000)
+
+#ifndef AUDIO_JB_DEFAULT_TARGET_MS
+#define AUDIO_JB_DEFAULT_TARGET_MS 80
+#endif
+
+typedef struct {
+    uint32_t depth_ms;         // 当前缓冲深度
+    uint32_t target_ms;        // 当前目标延迟（自适应后）
+    uint32_t base_target_ms;   // 配置的目标延迟，自适应的下限
+    uint32_t underruns;        // 播放中取不够一帧的次数
+    uint32_t plc_frames;       // 含补偿样本的帧数
+    uint32_t silence_frames;   // 预缓冲和补偿结束后输出的静音帧数
+    uint32_t inserted_samples; // 漂移校正插入的样本数
+    uint32_t removed_samples;  // 漂移校正删除的样本数
+    int32_t drift_ppm;         // 当前校正速率，正值为加速播放
+    uint32_t dropped_bytes;    // 超过可写空间被丢弃的字节数（写入期间目标延迟被调低等）
+    bool playing;              // 已完成预缓冲
+} audio_jb_stats_t;
+
+/**
+ * @brief 分配缓冲区
+ * @param target_ms 目标延迟，超出范围时截断到 [AUDIO_JB_MIN_TARGET_MS, AUDIO_JB_MAX_TARGET_MS]
+ * @return esp_err_t 内存不足返回 ESP_ERR_NO_MEM
+ */
+esp_err_t audio_jb_init(uint32_t target_ms);
+
+/**
+ * @brief 释放缓冲区，调用前需停止读写两侧的任务
+ */
+void audio_jb_deinit(void);
+
+/**
+ * @brief 清空缓冲并清零统计，新连接建立时由写入侧调用
+ * 播放侧在下一次取帧时重新进入预缓冲
+ */
+void audio_jb_reset(void);
+
+/**
+ * @brief 设置目标延迟，同时作为自适应目标的下限
+ * @param target_ms 目标延迟，超出范围时截断
+ */
+void audio_jb_set_target_ms(uint32_t target_ms);
+
+/**
+ * @brief 高水位以下还能写入的字节数，写入侧按此决定本次 recv 的长度
+ * @return size_t 可写字节数
+ */
+size_t audio_jb_writable(void);
+
+/**
+ * @brief 写入PCM字节流，可以不按样本对齐，多出的半个样本留到下次拼接
+ * @param data PCM数据，16位小端单声道
+ * @param len 字节数
+ * @return size_t 实际写入的字节数，超过可写空间的部分丢弃
+ */
+size_t audio_jb_write(const uint8_t* data, size_t len);
+
+/**
+ * @brief 取出一帧 AUDIO_JB_FRAME_SAMPLES 个样本，总能填满输出
+ * @param out 输出缓冲
+ */
+void audio_jb_read_frame(int16_t* out);
+
+/**
+ * @brief 获取统计
+ * @param out 输出
+ */
+void audio_jb_get_stats(audio_jb_stats_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_JITTER_BUFFER_H
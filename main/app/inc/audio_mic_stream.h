@@ -0,0 +1,110 @@
+/**
+ * @file audio_mic_stream.h
+ * @brief 麦克风采集和UDP上行，回环延迟测量
+ * @author TidyCraze
+ * @date 2025-10-18
+ *
+ * 从 I2S TDM 的麦克风时隙按帧采集，可选IMA-ADPCM压缩后加序号用UDP发出，与 audio_receiver 的播放
+ * 共用同一组I2S时钟同时运行（全双工）。I2S由 audio_receiver 初始化，上行只在其运行期间可用；
+ * 通常由TCP音频流头的 AUDIO_STREAM_FLAG_MIC_UPLINK 请求，发往TCP对端的 AUDIO_MIC_UDP_PORT。
+ *
+ * 每个UDP包：[mic_packet_header_t][负载]，负载为一帧 AUDIO_MIC_FRAME_SAMPLES 个样本，
+ * PCM16 为小端样本，IMA-ADPCM 为一个 AUDIO_MIC_ADPCM_BLOCK_BYTES 字节的块（格式见 audio_codec.h）。
+ *
+ * 回环模式：播放静音，每隔 AUDIO_MIC_LOOPBACK_INTERVAL_MS 在播放帧里插入一段咔嗒声，在麦克风
+ * 采集中检测到它的时刻与其开始播放的时刻之差即本机扬声器到麦克风的回环延迟（含DMA和声学路径），
+ * 精度约为一个DMA缓冲（64个样本，1.5ms）。结果写入后续UDP包头并计入统计。
+ */
+
+#ifndef AUDIO_MIC_STREAM_H
+#define AUDIO_MIC_STREAM_H
+
+#include "audio_codec.h"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_MIC_UDP_PORT 7558
+#define AUDIO_MIC_PACKET_MAGIC 0x5343494D  // "MICS" 小端
+#define AUDIO_MIC_ADPCM_BLOCK_BYTES 256
+#define AUDIO_MIC_FRAME_SAMPLES AUDIO_ADPCM_SAMPLES_PER_BLOCK(AUDIO_MIC_ADPCM_BLOCK_BYTES)  // 505个样本，约11.5ms
+#define AUDIO_MIC_LOOPBACK_INTERVAL_MS 1000
+#define AUDIO_MIC_LOOPBACK_TIMEOUT_MS 500   // 超过这么久没检测到咔嗒声记为一次超时
+
+// UDP包头，所有字段小端
+typedef struct __attribute__((packed)) {
+    uint32_t magic;        // AUDIO_MIC_PACKET_MAGIC
+    uint32_t seq;          // 包序号，每包加1，接收端据此统计丢包和乱序
+    uint32_t timestamp;    // 本帧第一个样本的采样序号
+    uint16_t samples;      // 本帧样本数
+    uint8_t codec;         // audio_codec_t
+    uint8_t flags;         // 保留
+    uint32_t loopback_us;  // 最近一次回环延迟，未测量时为0
+} mic_packet_header_t;
+
+_Static_assert(sizeof(mic_packet_header_t) == 20, "mic_packet_header_t must be 20 bytes");
+
+typedef struct {
+    uint32_t dest_addr;    // 目的IPv4地址，网络字节序
+    uint16_t port;         // 目的端口，0 表示 AUDIO_MIC_UDP_PORT
+    audio_codec_t codec;
+    bool loopback;         // 回环延迟测量模式
+} audio_mic_config_t;
+
+typedef struct {
+    uint32_t frames;           // 采集的帧数
+    uint32_t packets_sent;
+    uint32_t send_errors;      // sendto 失败（lwIP缓冲不足等），该帧丢弃
+    uint32_t read_errors;
+    uint64_t bytes_sent;
+    uint64_t encode_us;        // 编码累计耗时
+    uint32_t loopback_count;   // 回环测量成功次数
+    uint32_t loopback_timeouts;
+    uint32_t loopback_last_us;
+    uint32_t loopback_min_us;
+    uint32_t loopback_max_us;
+    uint64_t loopback_sum_us;
+} audio_mic_stats_t;
+
+/**
+ * @brief 启动麦克风上行，已在运行时先停止再按新配置启动
+ * @param config 配置
+ * @return esp_err_t I2S未初始化（audio_receiver 未运行）时返回 ESP_ERR_INVALID_STATE
+ */
+esp_err_t audio_mic_stream_start(const audio_mic_config_t* config);
+
+/**
+ * @brief 停止麦克风上行并等待采集任务退出，必须在I2S停止前调用
+ */
+void audio_mic_stream_stop(void);
+
+/**
+ * @brief 是否正在上行
+ * @return bool
+ */
+bool audio_mic_stream_is_running(void);
+
+/**
+ * @brief 获取统计，每次启动时清零
+ * @param out 输出
+ */
+void audio_mic_stream_get_stats(audio_mic_stats_t* out);
+
+/**
+ * @brief 播放任务在写入I2S前调用；回环模式下把这一帧换成静音，需要时插入咔嗒声
+ * @param frame 即将写入I2S的播放帧
+ * @param samples 样本数
+ * @param play_us 这一帧第一个样本预计开始播放的时刻（esp_timer 时间）
+ */
+void audio_mic_stream_on_playback(int16_t* frame, size_t samples, int64_t play_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_MIC_STREAM_H
@@ -0,0 +1,47 @@
+/**
+ * @file boot_init_graph.h
+ * @brief 按依赖关系并行执行启动初始化步骤
+ * @author TidyCraze
+ * @date 2025-10-18
+ */
+
+#ifndef BOOT_INIT_GRAPH_H
+#define BOOT_INIT_GRAPH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define BOOT_INIT_MAX_STEPS 24         // 受 FreeRTOS 事件组可用位数限制
+#define BOOT_INIT_DEP(index) (1UL << (index))
+
+// 初始化步骤
+typedef struct {
+    const char* name;        // 步骤名称（静态字符串，记录到启动时间线）
+    esp_err_t (*fn)(void);   // 初始化函数
+    uint32_t deps;           // 依赖的步骤，BOOT_INIT_DEP(i) 的组合，只能依赖排在前面的步骤
+    bool required;           // 失败时 boot_init_run 返回错误，依赖它的步骤被跳过
+} boot_init_step_t;
+
+/**
+ * @brief 执行初始化步骤表
+ * 调用者任务和一个辅助任务（"Boot_Init"，核见任务布局表）一起从表中取出依赖已满足的步骤执行，
+ * 互不依赖的步骤（例如 I2C 外设和 SPIFFS 挂载）因此可以在两个核上同时进行。
+ * 每个步骤的耗时记录到启动时间线。
+ * @param steps 步骤表
+ * @param count 步骤数量，不超过 BOOT_INIT_MAX_STEPS
+ * @param parallel 是否创建辅助任务，false 表示顺序执行
+ * @return ESP_OK 全部必需步骤成功；否则返回第一个失败的必需步骤的错误码
+ */
+esp_err_t boot_init_run(const boot_init_step_t* steps, size_t count, bool parallel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BOOT_INIT_GRAPH_H
@@ -0,0 +1,69 @@
+/**
+ * @file boot_profiler.h
+ * @brief 启动时间线记录 - 记录每个初始化步骤的耗时、首帧和可交互时间，并与历史启动比较
+ * @author TidyCraze
+ * @date 2025-10-18
+ */
+
+#ifndef BOOT_PROFILER_H
+#define BOOT_PROFILER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BOOT_PROFILER_MAX_STEPS 48       // 时间线最多记录的步骤数
+#define BOOT_PROFILER_REGRESSION_PCT 15  // 超过历史均值多少百分比判定为启动变慢
+#define BOOT_PROFILER_MIN_HISTORY 3      // 至少积累多少次启动后才做回归判断
+
+/**
+ * @brief 开始记录一个启动步骤，可在任意任务中调用
+ * @param name 步骤名称，必须是静态字符串
+ * @return 步骤句柄，记录已满时返回 -1
+ */
+int boot_profiler_begin(const char* name);
+
+/**
+ * @brief 结束一个启动步骤
+ * @param step boot_profiler_begin 返回的句柄
+ * @param result 步骤结果
+ */
+void boot_profiler_end(int step, esp_err_t result);
+
+/**
+ * @brief 记录一个瞬时事件（耗时为0）
+ * @param name 事件名称，必须是静态字符串
+ */
+void boot_profiler_mark(const char* name);
+
+/**
+ * @brief 标记第一帧已送显（由LVGL任务调用）
+ */
+void boot_profiler_mark_first_frame(void);
+
+/**
+ * @brief 标记首个可交互界面已送显（主菜单显示后由LVGL任务调用）
+ */
+void boot_profiler_mark_interactive(void);
+
+/**
+ * @brief 等待首个可交互界面
+ * @param timeout_ms 超时时间
+ * @return true 已到达可交互状态
+ */
+bool boot_profiler_wait_interactive(uint32_t timeout_ms);
+
+/**
+ * @brief 打印启动时间线，并把首帧/可交互时间与 NVS 中的历史均值比较后更新
+ */
+void boot_profiler_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BOOT_PROFILER_H
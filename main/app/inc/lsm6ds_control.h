@@ -15,6 +15,11 @@ extern TaskHandle_t s_lsm6ds3_control_task;
  */
 esp_err_t init_lsm6ds3_control_task(void);
 
+/**
+ * @brief 停止LSM6DS3控制任务并关闭传感器，等待任务退出
+ */
+esp_err_t stop_lsm6ds3_control_task(void);
+
 /**
  * @brief 安全地获取姿态数据
  * @param data 指向 attitude_data_t 结构体的指针，用于存储获取的数据
@@ -0,0 +1,93 @@
+/**
+ * @file service_lifecycle.h
+ * @brief 后台服务生命周期管理 - 按当前界面按需启动服务，闲置后挂起并统计回收的内存和CPU
+ * @author TidyCraze
+ * @date 2025-10-18
+ */
+
+#ifndef SERVICE_LIFECYCLE_H
+#define SERVICE_LIFECYCLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp_err.h"
+#include "ui_state_manager.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SERVICE_PARK_GRACE_MS 5000 // 离开界面后多久挂起服务，避免来回切换时反复启停
+
+// 受管理的服务
+typedef enum {
+    SERVICE_AUDIO_RECEIVER = 0, // 音频接收播放 (TCP 7557 + I2S)
+    SERVICE_SERIAL_DISPLAY,     // 串口显示 TCP 服务器 (8080) 和串口任务
+    SERVICE_TELEMETRY,          // 遥测服务
+    SERVICE_IMU,                // LSM6DS3 姿态任务
+    SERVICE_MAX
+} service_id_t;
+
+// 服务状态
+typedef enum {
+    SERVICE_STATE_PARKED = 0, // 未运行
+    SERVICE_STATE_RUNNING,    // 运行中
+    SERVICE_STATE_FAILED,     // 启动失败，下次进入界面时重试
+} service_state_t;
+
+// 服务统计
+typedef struct {
+    service_state_t state;
+    uint32_t starts;               // 启动次数
+    uint32_t parks;                // 挂起次数
+    int32_t last_internal_reclaimed; // 最近一次挂起回收的内部RAM (字节)
+    int32_t last_psram_reclaimed;    // 最近一次挂起回收的PSRAM (字节)
+    uint32_t last_cpu_permille;      // 挂起前运行期间占用单个核的千分比（与 task_profiler 一致）
+    int64_t total_internal_reclaimed;
+    int64_t total_psram_reclaimed;
+} service_stats_t;
+
+/**
+ * @brief 初始化生命周期管理器并创建挂起任务，服务此时都不启动
+ * @return ESP_OK 成功
+ */
+esp_err_t service_lifecycle_init(void);
+
+/**
+ * @brief 界面切换通知（在新界面创建之前调用）
+ * 新界面需要的服务在调用者任务中同步启动，服务正在挂起时先等待挂起完成；不再需要的服务在宽限期后
+ * 由后台任务挂起，独占界面（图传）会立即挂起其他所有服务。
+ * @param screen 即将显示的界面
+ * @return ESP_OK 成功；ESP_ERR_TIMEOUT 需要的服务挂起未能及时完成，调用者不应切换界面
+ */
+esp_err_t service_lifecycle_on_screen(ui_screen_type_t screen);
+
+/**
+ * @brief 通知 TCP/IP 协议栈已初始化（WiFi 管理任务调用）
+ * 网络服务在此之前只记录为待启动，之后由后台任务启动当前界面需要的服务。
+ */
+void service_lifecycle_notify_network_ready(void);
+
+/**
+ * @brief 立即挂起所有服务（关机或停止所有任务时调用，同步执行）
+ */
+void service_lifecycle_park_all(void);
+
+/**
+ * @brief 获取服务统计
+ * @param id 服务
+ * @param stats 输出统计
+ * @return ESP_OK 成功
+ */
+esp_err_t service_lifecycle_get_stats(service_id_t id, service_stats_t* stats);
+
+/**
+ * @brief 打印所有服务状态和回收统计
+ */
+void service_lifecycle_log_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SERVICE_LIFECYCLE_H
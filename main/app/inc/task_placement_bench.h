@@ -0,0 +1,73 @@
+/**
+ * @file task_placement_bench.h
+ * @brief 任务布局方案对比测试 - 在每个方案下测量JPEG解码帧率和界面刷新帧率
+ * @author TidyCraze
+ * @date 2025-10-18
+ *
+ * 测试时按布局表创建 "jpeg_decode" 任务，以固定的源帧率解码一张合成的JPEG图像，
+ * 解码结果显示在顶层图像上，同时统计LVGL实际完成的刷新次数。
+ */
+
+#ifndef TASK_PLACEMENT_BENCH_H
+#define TASK_PLACEMENT_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp_err.h"
+#include "task_placement.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TASK_PLACEMENT_BENCH_DURATION_MS 5000 // 每个方案的测试时长
+#define TASK_PLACEMENT_BENCH_SOURCE_FPS 60     // 模拟的图传源帧率，超过解码能力时丢帧
+#define TASK_PLACEMENT_BENCH_WIDTH 240
+#define TASK_PLACEMENT_BENCH_HEIGHT 176
+
+// 单个方案的测试结果
+typedef struct {
+    task_profile_t profile;
+    esp_err_t status;        // ESP_OK 表示该方案测试完成
+    uint32_t decoded_frames; // 解码完成的帧数
+    uint32_t dropped_frames; // 解码来不及而丢弃的源帧数
+    uint32_t avg_decode_us;  // 平均单帧解码耗时
+    float decode_fps;
+    uint32_t ui_frames;      // LVGL完成的刷新次数
+    float ui_fps;
+} task_placement_bench_result_t;
+
+/**
+ * @brief 测试完成回调，在LVGL任务上下文中调用
+ * @param results 每个方案一项，共 TASK_PROFILE_MAX 项
+ */
+typedef void (*task_placement_bench_done_cb_t)(const task_placement_bench_result_t* results, size_t count,
+                                               void* user_data);
+
+/**
+ * @brief 依次在每个布局方案下运行测试，结束后恢复原方案
+ * 必须在LVGL任务上下文中调用（例如按钮事件回调），测试由 lv_timer 异步推进，不阻塞界面。
+ * @param done_cb 完成回调，可为NULL
+ * @param user_data 回调参数
+ * @return ESP_OK 已开始；ESP_ERR_INVALID_STATE 测试正在进行或图传正在运行
+ */
+esp_err_t task_placement_bench_start(task_placement_bench_done_cb_t done_cb, void* user_data);
+
+/**
+ * @brief 测试是否正在进行
+ */
+bool task_placement_bench_is_running(void);
+
+/**
+ * @brief 把测试结果格式化为多行文本（用于界面显示）
+ * @return 写入的字符数
+ */
+size_t task_placement_bench_format(const task_placement_bench_result_t* results, size_t count, char* buf,
+                                   size_t buf_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TASK_PLACEMENT_BENCH_H
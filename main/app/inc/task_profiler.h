@@ -0,0 +1,105 @@
+/**
+ * @file task_profiler.h
+ * @brief 任务运行统计采样 - 周期性记录每个任务的CPU占用、栈余量和每个核的负载
+ * @author TidyCraze
+ * @date 2025-10-18
+ */
+
+#ifndef TASK_PROFILER_H
+#define TASK_PROFILER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TASK_PROFILER_DEFAULT_PERIOD_MS 1000
+#define TASK_PROFILER_MIN_PERIOD_MS 100
+#define TASK_PROFILER_MAX_TASKS 32 // 每次采样最多记录的任务数，超出部分按CPU占用从低到高丢弃
+#define TASK_PROFILER_HISTORY 60   // 环形缓冲区中的采样数（默认周期下为1分钟）
+
+// 单个任务的采样
+typedef struct {
+    char name[configMAX_TASK_NAME_LEN];
+    uint16_t cpu_permille; // 采样周期内占用单个核的千分比
+    uint32_t stack_free;   // 栈历史最小剩余 (字节)
+    uint8_t priority;
+    int8_t core; // 绑定的核，-1 表示未绑定
+} task_profiler_task_t;
+
+// 一次采样
+typedef struct {
+    uint32_t seq;          // 采样序号，从1开始
+    uint32_t timestamp_ms; // 采样时刻（自启动）
+    uint32_t period_ms;    // 实际采样间隔
+    uint16_t core_load_permille[portNUM_PROCESSORS];
+    uint32_t free_internal;
+    uint32_t free_psram;
+    uint8_t task_count;  // 系统中的任务总数
+    uint8_t entry_count; // tasks[] 中的有效条目，按CPU占用降序
+    task_profiler_task_t tasks[TASK_PROFILER_MAX_TASKS];
+} task_profiler_sample_t;
+
+/**
+ * @brief 启动采样任务，环形缓冲区分配在PSRAM中
+ * @param period_ms 采样周期，不小于 TASK_PROFILER_MIN_PERIOD_MS
+ * @return ESP_OK 成功
+ */
+esp_err_t task_profiler_start(uint32_t period_ms);
+
+/**
+ * @brief 停止采样任务（保留已记录的历史）
+ */
+void task_profiler_stop(void);
+
+/**
+ * @brief 采样任务是否在运行
+ */
+bool task_profiler_is_running(void);
+
+/**
+ * @brief 最近一次采样的序号，0 表示还没有采样（用于廉价地判断是否有新数据）
+ */
+uint32_t task_profiler_get_seq(void);
+
+/**
+ * @brief 获取最近一次采样
+ * @param out 输出采样
+ * @return ESP_OK 成功；ESP_ERR_NOT_FOUND 还没有采样
+ */
+esp_err_t task_profiler_get_latest(task_profiler_sample_t* out);
+
+/**
+ * @brief 获取某个核的负载历史（从旧到新）
+ * @param core 核编号
+ * @param out 输出负载千分比
+ * @param max out 的容量
+ * @return 写入的点数
+ */
+size_t task_profiler_get_core_history(int core, uint16_t* out, size_t max);
+
+/**
+ * @brief 获取某个任务的CPU和栈余量历史（从旧到新），该任务未出现在某次采样中时记为0
+ * @param name 任务名
+ * @param cpu_out 输出CPU千分比，可为NULL
+ * @param stack_out 输出栈剩余字节，可为NULL
+ * @param max 输出数组容量
+ * @return 写入的点数
+ */
+size_t task_profiler_get_task_history(const char* name, uint16_t* cpu_out, uint32_t* stack_out, size_t max);
+
+/**
+ * @brief 打印最近一次采样
+ */
+void task_profiler_log_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TASK_PROFILER_H
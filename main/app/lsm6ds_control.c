@@ -15,6 +15,7 @@
 #include "freertos/semphr.h"
 #include "esp_log.h"
 #include "lsm6ds_control.h"
+#include "task_placement.h"
 
 static char* TAG = "LSM6DS3_CTRL";
 
@@ -31,6 +32,8 @@ static float gyro_bias_y = 0.0f;
 static float gyro_bias_z = 0.0f;
 
 TaskHandle_t s_lsm6ds3_control_task = NULL;
+static volatile bool s_stop_requested = false;
+static bool s_gyro_calibrated = false; // 零偏只在第一次启动时校准
 
 static void lsm6ds_calibrate_gyro(void)
 {
@@ -66,6 +69,7 @@ static void lsm6ds3_control_task(void* pvParameters)
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to configure accelerometer");
         lsm6ds3_deinit();
+        s_lsm6ds3_control_task = NULL;
         vTaskDelete(NULL);
     }
     
@@ -74,6 +78,7 @@ static void lsm6ds3_control_task(void* pvParameters)
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to configure gyroscope");
         lsm6ds3_deinit();
+        s_lsm6ds3_control_task = NULL;
         vTaskDelete(NULL);
     }
     
@@ -81,10 +86,13 @@ static void lsm6ds3_control_task(void* pvParameters)
     lsm6ds3_accel_enable(true);
     lsm6ds3_gyro_enable(true);
 
-    // 在任务开始时执行校准
-    lsm6ds_calibrate_gyro();
-    
-    while (1) {
+    // 在任务第一次启动时执行校准
+    if (!s_gyro_calibrated) {
+        lsm6ds_calibrate_gyro();
+        s_gyro_calibrated = true;
+    }
+
+    while (!s_stop_requested) {
 
         ret = lsm6ds3_read_all(&sensor_data);
         if (ret == ESP_OK) {
@@ -106,6 +114,13 @@ static void lsm6ds3_control_task(void* pvParameters)
         //10hz更新频率
         vTaskDelay(pdMS_TO_TICKS(100));
     }
+
+    // 停止：关闭加速度计和陀螺仪进入低功耗，再删除自身
+    lsm6ds3_accel_enable(false);
+    lsm6ds3_gyro_enable(false);
+    ESP_LOGI(TAG, "LSM6DS3 control task stopped, sensor powered down");
+    s_lsm6ds3_control_task = NULL;
+    vTaskDelete(NULL);
 }
 
 void lsm6ds_control_get_attitude(attitude_data_t* data)
@@ -131,21 +146,35 @@ esp_err_t init_lsm6ds3_control_task(void)
         ESP_LOGW(TAG, "LSM6DS3 control task already running");
         return ESP_OK;
     }
+    s_stop_requested = false;
     // 创建LSM6DS3控制任务
-    BaseType_t result = xTaskCreatePinnedToCore(lsm6ds3_control_task, 
-                                                "lsm6ds3_control",
-                                                4096,
-                                                NULL,
-                                                5,
-                                                &s_lsm6ds3_control_task,
-                                                0);
+    BaseType_t result = task_placement_create(lsm6ds3_control_task, "lsm6ds3_control", NULL, &s_lsm6ds3_control_task);
 
     if (result != pdPASS) {
         ESP_LOGE(TAG, "Failed to create LSM6DS3 control task");
         return ESP_ERR_NO_MEM;
     }
 
-    ESP_LOGI(TAG, "LSM6DS3 control task created successfully on Core 0");
+    ESP_LOGI(TAG, "LSM6DS3 control task created successfully");
+    return ESP_OK;
+}
+
+esp_err_t stop_lsm6ds3_control_task(void)
+{
+    if (s_lsm6ds3_control_task == NULL) {
+        return ESP_OK;
+    }
+
+    // 通知任务在本轮采样后退出，最多等一个采样周期加校准的余量
+    s_stop_requested = true;
+    for (int i = 0; i < 150 && s_lsm6ds3_control_task != NULL; i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    if (s_lsm6ds3_control_task != NULL) {
+        ESP_LOGW(TAG, "LSM6DS3 control task did not stop in time");
+        return ESP_ERR_TIMEOUT;
+    }
     return ESP_OK;
 }
 
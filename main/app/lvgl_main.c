@@ -4,6 +4,7 @@
  * @author Your Name
  * @date 2025-08-14
  */
+#include "boot_profiler.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
@@ -14,11 +15,16 @@
 #include "settings_manager.h"
 #include "theme_manager.h"
 #include "ui.h"
-#include "st7789.h"
 
 
 // 动画完成后的回调函数
-static void show_main_menu_cb(void) { ui_main_menu_create(lv_scr_act()); }
+static void show_main_menu_cb(void) {
+    ui_screen_cache_show(UI_SCREEN_MAIN_MENU);
+
+    // 立即渲染并送显主菜单，作为首个可交互帧
+    lv_refr_now(NULL);
+    boot_profiler_mark_interactive();
+}
 
 static void lv_tick_task(void* arg) {
     (void)arg;
@@ -30,13 +36,24 @@ void lvgl_main_task(void* pvParameters) {
     const char* TAG = "LVGL_DEMO";
     ESP_LOGI(TAG, "LVGL task started on core %d", xPortGetCoreID());
 
-    lv_init();   // 初始化LVGL
+    int prof = boot_profiler_begin("lvgl_init");
+    lv_init(); // 初始化LVGL
+    boot_profiler_end(prof, ESP_OK);
+
+    prof = boot_profiler_begin("font_init");
     font_init(); // 初始化字体
+    boot_profiler_end(prof, ESP_OK);
+
+    prof = boot_profiler_begin("display_init");
     lv_port_disp_init();
+    boot_profiler_end(prof, ESP_OK);
+
+    prof = boot_profiler_begin("indev_init");
     lv_port_indev_init();
+    boot_profiler_end(prof, ESP_OK);
 
     // 在屏幕硬件和设置都初始化完成后，应用背光
-    st7789_set_backlight(settings_get_backlight());
+    lv_port_disp_set_backlight(settings_get_backlight());
 
     // 初始化主题管理器
     theme_manager_init();
@@ -56,6 +73,10 @@ void lvgl_main_task(void* pvParameters) {
 
     ESP_LOGI(TAG, "LVGL UI flow started with animation");
 
+    // 第一帧（开机动画）
+    lv_refr_now(NULL);
+    boot_profiler_mark_first_frame();
+
     // LVGL主循环 - 专用任务处理
     while (1) {
         lv_timer_handler();
@@ -11,6 +11,7 @@
 #include "freertos/task.h"
 #include "lwip/netdb.h"
 #include "lwip/sockets.h"
+#include "task_placement.h"
 #include <string.h>
 #include <sys/time.h>
 #include <time.h>
@@ -150,24 +151,24 @@ esp_err_t p2p_udp_image_transfer_start(void) {
     ESP_ERROR_CHECK(udp_socket_init());
 
     // 创建接收任务
-    if (xTaskCreate(udp_rx_task, "udp_rx", 8192, NULL, 5, &g_rx_task_handle) != pdPASS) {
+    if (task_placement_create(udp_rx_task, "udp_rx", NULL, &g_rx_task_handle) != pdPASS) {
         ESP_LOGE(TAG, "Failed to create RX task");
         return ESP_ERR_NO_MEM;
     }
 
-    // 创建解码任务，优先级略高于网络任务
-    if (xTaskCreate(jpeg_decode_task, "jpeg_decode", 4096, NULL, 6, &g_decode_task_handle) != pdPASS) {
+    // 创建解码任务，核和优先级随布局方案变化
+    if (task_placement_create(jpeg_decode_task, "jpeg_decode", NULL, &g_decode_task_handle) != pdPASS) {
         ESP_LOGE(TAG, "Failed to create decode task");
-        vTaskDelete(g_rx_task_handle);
+        task_placement_delete(g_rx_task_handle);
         g_rx_task_handle = NULL;
         return ESP_ERR_NO_MEM;
     }
 
     /*
     // 创建发送任务
-    if (xTaskCreate(udp_tx_task, "udp_tx", 4096, NULL, 5, &g_tx_task_handle) != pdPASS) {
+    if (task_placement_create(udp_tx_task, "udp_tx", NULL, &g_tx_task_handle) != pdPASS) {
         ESP_LOGE(TAG, "Failed to create TX task");
-        vTaskDelete(g_rx_task_handle);
+        task_placement_delete(g_rx_task_handle);
         g_rx_task_handle = NULL;
         return ESP_ERR_NO_MEM;
     }
@@ -188,11 +189,11 @@ void p2p_udp_image_transfer_stop(void) {
 
     // 停止任务
     if (g_rx_task_handle) {
-        vTaskDelete(g_rx_task_handle);
+        task_placement_delete(g_rx_task_handle);
         g_rx_task_handle = NULL;
     }
     if (g_decode_task_handle) {
-        vTaskDelete(g_decode_task_handle);
+        task_placement_delete(g_decode_task_handle);
         g_decode_task_handle = NULL;
     }
     
@@ -308,7 +309,7 @@ static void udp_rx_task(void* pvParameters) {
     uint8_t* rx_buffer = malloc(P2P_UDP_MAX_PACKET_SIZE);
     if (!rx_buffer) {
         ESP_LOGE(TAG, "Failed to allocate RX buffer");
-        vTaskDelete(NULL);
+        task_placement_delete(NULL);
         return;
     }
 
@@ -337,7 +338,7 @@ static void udp_rx_task(void* pvParameters) {
 
     free(rx_buffer);
     ESP_LOGI(TAG, "UDP RX task ended");
-    vTaskDelete(NULL);
+    task_placement_delete(NULL);
 }
 /*
 static void udp_tx_task(void* pvParameters) {
@@ -368,7 +369,7 @@ static void udp_tx_task(void* pvParameters) {
     }
 
     ESP_LOGI(TAG, "UDP TX task ended");
-    vTaskDelete(NULL);
+    task_placement_delete(NULL);
 }
 */
 /*
@@ -788,7 +789,7 @@ static void jpeg_decode_task(void* pvParameters)
         }
     }
     ESP_LOGI(TAG, "JPEG decode task stopped");
-    vTaskDelete(NULL);
+    task_placement_delete(NULL);
 }
 
 // 事件处理器实现
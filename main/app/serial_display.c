@@ -23,6 +23,7 @@
 
 #include "esp_heap_caps.h"
 #include "serial_display.h"
+#include "task_placement.h"
 #include "ui_serial_display.h"
 
 static const char* TAG = "SERIAL_DISPLAY";
@@ -162,7 +163,7 @@ static void serial_task(void* pvParameters) {
     local_buffer = (uint8_t*)heap_caps_malloc(MAX_DISPLAY_DATA_SIZE, MALLOC_CAP_8BIT);
     if (local_buffer == NULL) {
         ESP_LOGE(TAG, "Failed to allocate local buffer for serial task");
-        vTaskDelete(NULL);
+        task_placement_delete(NULL);
         return;
     }
 
@@ -197,7 +198,7 @@ static void serial_task(void* pvParameters) {
     }
 
     ESP_LOGI(TAG, "Serial task stopped");
-    vTaskDelete(NULL);
+    task_placement_delete(NULL);
 }
 
 // TCP服务器任务
@@ -218,7 +219,7 @@ static void tcp_server_task(void* pvParameters) {
     if (listen_sock < 0) {
         ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
         s_server_running = false;
-        vTaskDelete(NULL);
+        task_placement_delete(NULL);
         return;
     }
     ESP_LOGI(TAG, "Socket created");
@@ -315,7 +316,7 @@ CLEAN_UP:
     close(listen_sock);
     s_server_running = false;
     free(port_param);
-    vTaskDelete(NULL);
+    task_placement_delete(NULL);
 }
 
 // 公共API函数
@@ -338,8 +339,10 @@ esp_err_t serial_display_init(void) {
         return ret;
     }
 
-    // 创建互斥锁
-    s_buffer_mutex = xSemaphoreCreateMutex();
+    // 创建互斥锁（停止后再次启动时复用）
+    if (s_buffer_mutex == NULL) {
+        s_buffer_mutex = xSemaphoreCreateMutex();
+    }
     if (s_buffer_mutex == NULL) {
         ESP_LOGE(TAG, "Failed to create mutex");
         cleanup_psram_buffer();
@@ -366,7 +369,7 @@ bool serial_display_start(uint16_t port) {
 
     // 启动串口任务
     s_serial_running = true;
-    if (xTaskCreatePinnedToCore(serial_task, "serial_task", 4096, NULL, 4, &s_serial_task_handle, 1) != pdPASS) {
+    if (task_placement_create(serial_task, "serial_task", NULL, &s_serial_task_handle) != pdPASS) {
         ESP_LOGE(TAG, "Failed to create serial task");
         s_serial_running = false;
         free(port_param);
@@ -374,11 +377,10 @@ bool serial_display_start(uint16_t port) {
     }
 
     // 启动TCP服务器任务
-    if (xTaskCreatePinnedToCore(tcp_server_task, "tcp_server", 4096, port_param, 4, &s_tcp_server_task_handle, 1) !=
-        pdPASS) {
+    if (task_placement_create(tcp_server_task, "serial_server", port_param, &s_tcp_server_task_handle) != pdPASS) {
         ESP_LOGE(TAG, "Failed to create TCP server task");
         s_serial_running = false;
-        vTaskDelete(s_serial_task_handle);
+        task_placement_delete(s_serial_task_handle);
         s_serial_task_handle = NULL;
         free(port_param);
         return false;
@@ -404,7 +406,7 @@ void serial_display_stop(void) {
         if (s_tcp_server_task_handle != NULL) {
             // 检查任务状态
             if (eTaskGetState(s_tcp_server_task_handle) != eDeleted) {
-                vTaskDelete(s_tcp_server_task_handle);
+                task_placement_delete(s_tcp_server_task_handle);
             }
             s_tcp_server_task_handle = NULL;
         }
@@ -417,7 +419,7 @@ void serial_display_stop(void) {
         if (s_serial_task_handle != NULL) {
             // 检查任务状态
             if (eTaskGetState(s_serial_task_handle) != eDeleted) {
-                vTaskDelete(s_serial_task_handle);
+                task_placement_delete(s_serial_task_handle);
             }
             s_serial_task_handle = NULL;
         }
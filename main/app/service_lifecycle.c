@@ -0,0 +1,400 @@
+/**
+ * @file service_lifecycle.c
+ * @brief 后台服务生命周期管理实现
+ * @author TidyCraze
+ * @date 2025-10-18
+ *
+ * 服务启动很快（分配缓冲区、建任务），在界面切换时由 LVGL 任务同步完成，页面创建时服务已可用；
+ * 停止通常要等待任务退出（几百毫秒），交给后台挂起任务执行，不阻塞界面。
+ * lock 只保护运行状态字段，持有时间很短；挂起过程由 park_lock 串行化，不持有 lock。
+ * 界面要求启动的服务正在挂起时，界面切换等待挂起完成后同步启动（最多 SERVICE_START_PARK_WAIT_MS），
+ * 超时则拒绝切换，该服务挂起完成后保持挂起。
+ * 回收的内存为挂起前后空闲堆之差，CPU 为服务任务自启动以来的运行时间占单个核的千分比，与
+ * task_profiler 的口径一致（依赖 CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS）。
+ */
+
+#include "service_lifecycle.h"
+#include "audio_receiver.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "lsm6ds_control.h"
+#include "serial_display.h"
+#include "task_placement.h"
+#include "telemetry_main.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* TAG = "SVC_LIFECYCLE";
+
+#define SERVICE_MAX_TASK_NAMES 4
+#define SERVICE_RECLAIM_SETTLE_MS 50 // 等待空闲任务回收已删除任务的栈
+#define SERVICE_START_PARK_WAIT_MS 3000 // 界面切换等待正在进行的挂起完成的上限
+#define SERIAL_DISPLAY_PORT 8080
+
+#define SCREEN_BIT(s) (1UL << (s))
+#define ALL_SCREENS ((1UL << UI_SCREEN_MAX) - 1)
+// 独占界面：进入时立即挂起其他所有服务
+#define EXCLUSIVE_SCREENS SCREEN_BIT(UI_SCREEN_IMAGE_TRANSFER)
+
+// 服务描述
+typedef struct {
+    const char* name;
+    esp_err_t (*start)(void);
+    void (*park)(void);
+    uint32_t screens;                               // 需要该服务的界面
+    bool needs_network;                             // 需要 TCP/IP 协议栈，协议栈就绪前推迟启动
+    const char* task_names[SERVICE_MAX_TASK_NAMES]; // 服务创建的任务，用于统计CPU
+} service_desc_t;
+
+// 服务运行状态
+typedef struct {
+    service_stats_t stats;
+    SemaphoreHandle_t lock;      // 保护本结构的字段和启动过程，不在挂起期间持有
+    SemaphoreHandle_t park_lock; // 串行化挂起过程（后台任务和 park_all）
+    int64_t started_us;
+    int64_t park_due_us; // 0 表示未计划挂起
+    bool start_pending;  // 等待网络就绪或挂起完成后由后台任务启动
+    bool parking;        // 正在挂起
+} service_runtime_t;
+
+// ==================== 服务适配 ====================
+
+static esp_err_t audio_service_start(void) { return audio_receiver_start(); }
+
+static void audio_service_park(void) { audio_receiver_stop(); }
+
+static esp_err_t serial_service_start(void) {
+    esp_err_t ret = serial_display_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (!serial_display_start(SERIAL_DISPLAY_PORT)) {
+        serial_display_stop();
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static void serial_service_park(void) { serial_display_stop(); }
+
+static esp_err_t telemetry_lifecycle_start(void) { return telemetry_service_init() == 0 ? ESP_OK : ESP_FAIL; }
+
+static void telemetry_lifecycle_park(void) { telemetry_service_deinit(); }
+
+static esp_err_t imu_service_start(void) { return init_lsm6ds3_control_task(); }
+
+static void imu_service_park(void) { stop_lsm6ds3_control_task(); }
+
+// 服务表：音频在除图传外的界面常驻；其他服务只在使用它们的界面运行
+static const service_desc_t s_services[SERVICE_MAX] = {
+    [SERVICE_AUDIO_RECEIVER] = {"audio_receiver",
+                                audio_service_start,
+                                audio_service_park,
+                                ALL_SCREENS & ~SCREEN_BIT(UI_SCREEN_IMAGE_TRANSFER),
+                                true,
+                                {"audio_server", "audio_receive", "i2s_playback", "mic_capture"}},
+    [SERVICE_SERIAL_DISPLAY] = {"serial_display",
+                                serial_service_start,
+                                serial_service_park,
+                                SCREEN_BIT(UI_SCREEN_SERIAL_DISPLAY),
+                                true,
+                                {"serial_server", "serial_task", NULL}},
+    [SERVICE_TELEMETRY] = {"telemetry",
+                           telemetry_lifecycle_start,
+                           telemetry_lifecycle_park,
+                           SCREEN_BIT(UI_SCREEN_TELEMETRY),
+                           true,
+                           {"telemetry_server", "telemetry_data", NULL}},
+    [SERVICE_IMU] = {"imu",
+                     imu_service_start,
+                     imu_service_park,
+                     SCREEN_BIT(UI_SCREEN_CALIBRATION) | SCREEN_BIT(UI_SCREEN_TELEMETRY),
+                     false,
+                     {"lsm6ds3_control", NULL, NULL}},
+};
+
+static service_runtime_t s_runtime[SERVICE_MAX];
+static TaskHandle_t s_park_task = NULL;
+static volatile bool s_network_ready = false;
+
+// ==================== 统计 ====================
+
+static bool task_name_matches(const char* task_name, const char* pattern) {
+    // 任务名会被截断到 configMAX_TASK_NAME_LEN - 1
+    return strncmp(task_name, pattern, configMAX_TASK_NAME_LEN - 1) == 0;
+}
+
+// 服务任务自启动以来占单个核的千分比（与 task_profiler 一致），任务分布在两个核上时可以超过 1000
+static uint32_t service_cpu_permille(service_id_t id) {
+    const service_desc_t* desc = &s_services[id];
+    int64_t elapsed_us = esp_timer_get_time() - s_runtime[id].started_us;
+    if (elapsed_us <= 0) {
+        return 0;
+    }
+
+    UBaseType_t count = uxTaskGetNumberOfTasks();
+    TaskStatus_t* tasks = malloc(count * sizeof(TaskStatus_t));
+    if (tasks == NULL) {
+        return 0;
+    }
+    count = uxTaskGetSystemState(tasks, count, NULL);
+
+    uint64_t busy_us = 0;
+    for (UBaseType_t i = 0; i < count; i++) {
+        for (int n = 0; n < SERVICE_MAX_TASK_NAMES && desc->task_names[n]; n++) {
+            if (task_name_matches(tasks[i].pcTaskName, desc->task_names[n])) {
+                busy_us += tasks[i].ulRunTimeCounter;
+                break;
+            }
+        }
+    }
+    free(tasks);
+
+    return (uint32_t)(busy_us * 1000 / (uint64_t)elapsed_us);
+}
+
+// ==================== 启动和挂起 ====================
+
+// park_wait 为等待正在进行的挂起完成的时长，为 0 或超时时只记为待启动并返回 ESP_ERR_TIMEOUT，
+// 挂起完成后由后台任务启动（调用者可撤销）。启动失败不算错误，状态记为 FAILED，下次进入界面时重试
+static esp_err_t service_start(service_id_t id, TickType_t park_wait) {
+    service_runtime_t* rt = &s_runtime[id];
+
+    xSemaphoreTake(rt->lock, portMAX_DELAY);
+    rt->park_due_us = 0;
+    while (rt->parking) {
+        rt->start_pending = true;
+        xSemaphoreGive(rt->lock);
+        // park_lock 在挂起结束时释放，拿到即说明挂起已完成
+        if (park_wait == 0 || xSemaphoreTake(rt->park_lock, park_wait) != pdTRUE) {
+            xTaskNotifyGive(s_park_task);
+            return ESP_ERR_TIMEOUT;
+        }
+        xSemaphoreGive(rt->park_lock);
+        xSemaphoreTake(rt->lock, portMAX_DELAY);
+    }
+    rt->start_pending = false;
+    if (rt->stats.state != SERVICE_STATE_RUNNING) {
+        esp_err_t ret = s_services[id].start();
+        if (ret == ESP_OK) {
+            rt->stats.state = SERVICE_STATE_RUNNING;
+            rt->stats.starts++;
+            rt->started_us = esp_timer_get_time();
+            ESP_LOGI(TAG, "Started %s", s_services[id].name);
+        } else {
+            rt->stats.state = SERVICE_STATE_FAILED;
+            ESP_LOGE(TAG, "Failed to start %s: %s", s_services[id].name, esp_err_to_name(ret));
+        }
+    }
+    xSemaphoreGive(rt->lock);
+    return ESP_OK;
+}
+
+// force 为 false 时只挂起仍然到期的服务（计划后界面可能又要求启动，取消了挂起）
+static void service_park(service_id_t id, bool force) {
+    service_runtime_t* rt = &s_runtime[id];
+
+    xSemaphoreTake(rt->park_lock, portMAX_DELAY);
+    xSemaphoreTake(rt->lock, portMAX_DELAY);
+    if (!force && (rt->park_due_us == 0 || rt->park_due_us > esp_timer_get_time())) {
+        xSemaphoreGive(rt->lock);
+        xSemaphoreGive(rt->park_lock);
+        return;
+    }
+    rt->park_due_us = 0;
+    rt->start_pending = false;
+    if (rt->stats.state != SERVICE_STATE_RUNNING) {
+        rt->stats.state = SERVICE_STATE_PARKED;
+        xSemaphoreGive(rt->lock);
+        xSemaphoreGive(rt->park_lock);
+        return;
+    }
+    rt->parking = true;
+    xSemaphoreGive(rt->lock);
+
+    // 停止服务要等任务退出，不持有 lock，界面线程的启动请求不会被阻塞
+    uint32_t cpu_permille = service_cpu_permille(id);
+    size_t internal_before = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    size_t psram_before = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+
+    s_services[id].park();
+    vTaskDelay(pdMS_TO_TICKS(SERVICE_RECLAIM_SETTLE_MS));
+
+    xSemaphoreTake(rt->lock, portMAX_DELAY);
+    rt->stats.state = SERVICE_STATE_PARKED;
+    rt->stats.parks++;
+    rt->stats.last_cpu_permille = cpu_permille;
+    rt->stats.last_internal_reclaimed = (int32_t)(heap_caps_get_free_size(MALLOC_CAP_INTERNAL) - internal_before);
+    rt->stats.last_psram_reclaimed = (int32_t)(heap_caps_get_free_size(MALLOC_CAP_SPIRAM) - psram_before);
+    rt->stats.total_internal_reclaimed += rt->stats.last_internal_reclaimed;
+    rt->stats.total_psram_reclaimed += rt->stats.last_psram_reclaimed;
+
+    ESP_LOGI(TAG, "Parked %s: reclaimed %ld B internal, %ld B PSRAM, %lu.%lu%% CPU", s_services[id].name,
+             (long)rt->stats.last_internal_reclaimed, (long)rt->stats.last_psram_reclaimed,
+             (unsigned long)(cpu_permille / 10), (unsigned long)(cpu_permille % 10));
+    rt->parking = false;
+    bool restart = rt->start_pending;
+    xSemaphoreGive(rt->lock);
+    xSemaphoreGive(rt->park_lock);
+
+    if (restart) {
+        xTaskNotifyGive(s_park_task); // 挂起期间界面又要求启动
+    }
+}
+
+// 后台任务：网络就绪后补启动推迟的服务，到期后挂起不再需要的服务
+static void service_park_task(void* arg) {
+    (void)arg;
+    while (1) {
+        int64_t now = esp_timer_get_time();
+        int64_t next_due = 0;
+
+        for (int i = 0; i < SERVICE_MAX; i++) {
+            service_runtime_t* rt = &s_runtime[i];
+            xSemaphoreTake(rt->lock, portMAX_DELAY);
+            bool start = rt->start_pending && !rt->parking && (s_network_ready || !s_services[i].needs_network);
+            int64_t due = rt->park_due_us;
+            xSemaphoreGive(rt->lock);
+
+            if (start) {
+                service_start((service_id_t)i, 0);
+                continue;
+            }
+            if (due == 0) {
+                continue;
+            }
+            if (due <= now) {
+                service_park((service_id_t)i, false);
+            } else if (next_due == 0 || due < next_due) {
+                next_due = due;
+            }
+        }
+
+        TickType_t wait = portMAX_DELAY;
+        if (next_due != 0) {
+            // 挂起耗时可能已越过下一个到期时间，剩余时间为负时立即再检查
+            int64_t remaining_us = next_due - esp_timer_get_time();
+            wait = remaining_us > 0 ? pdMS_TO_TICKS(remaining_us / 1000) + 1 : 0;
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+// ==================== 公共接口 ====================
+
+esp_err_t service_lifecycle_init(void) {
+    if (s_park_task != NULL) {
+        return ESP_OK;
+    }
+
+    for (int i = 0; i < SERVICE_MAX; i++) {
+        s_runtime[i].lock = xSemaphoreCreateMutex();
+        s_runtime[i].park_lock = xSemaphoreCreateMutex();
+        if (s_runtime[i].lock == NULL || s_runtime[i].park_lock == NULL) {
+            ESP_LOGE(TAG, "Failed to create service lock");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    BaseType_t result = task_placement_create(service_park_task, "Svc_Lifecycle", NULL, &s_park_task);
+    if (result != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create service lifecycle task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Service lifecycle manager initialized, services start on first use");
+    return ESP_OK;
+}
+
+esp_err_t service_lifecycle_on_screen(ui_screen_type_t screen) {
+    if (screen >= UI_SCREEN_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_park_task == NULL) {
+        return ESP_OK;
+    }
+
+    bool exclusive = (EXCLUSIVE_SCREENS & SCREEN_BIT(screen)) != 0;
+    int64_t now = esp_timer_get_time();
+    bool wake = false;
+
+    for (int i = 0; i < SERVICE_MAX; i++) {
+        service_runtime_t* rt = &s_runtime[i];
+        if (s_services[i].screens & SCREEN_BIT(screen)) {
+            if (!s_services[i].needs_network || s_network_ready) {
+                if (service_start((service_id_t)i, pdMS_TO_TICKS(SERVICE_START_PARK_WAIT_MS)) != ESP_OK) {
+                    // 界面仍停留在当前页面，撤销待启动，挂起完成后服务保持挂起
+                    xSemaphoreTake(rt->lock, portMAX_DELAY);
+                    rt->start_pending = false;
+                    xSemaphoreGive(rt->lock);
+                    ESP_LOGW(TAG, "%s still parking after %d ms, screen %d refused", s_services[i].name,
+                             SERVICE_START_PARK_WAIT_MS, screen);
+                    return ESP_ERR_TIMEOUT;
+                }
+                continue;
+            }
+            xSemaphoreTake(rt->lock, portMAX_DELAY);
+            rt->park_due_us = 0;
+            rt->start_pending = true;
+            xSemaphoreGive(rt->lock);
+            continue;
+        }
+
+        xSemaphoreTake(rt->lock, portMAX_DELAY);
+        if (rt->start_pending) {
+            rt->start_pending = false;
+        } else if (rt->stats.state == SERVICE_STATE_RUNNING && !rt->parking) {
+            int64_t due = exclusive ? now : now + (int64_t)SERVICE_PARK_GRACE_MS * 1000;
+            if (rt->park_due_us == 0 || due < rt->park_due_us) {
+                rt->park_due_us = due;
+                wake = true;
+            }
+        }
+        xSemaphoreGive(rt->lock);
+    }
+
+    if (wake) {
+        xTaskNotifyGive(s_park_task);
+    }
+    return ESP_OK;
+}
+
+void service_lifecycle_notify_network_ready(void) {
+    s_network_ready = true;
+    if (s_park_task != NULL) {
+        xTaskNotifyGive(s_park_task);
+    }
+}
+
+void service_lifecycle_park_all(void) {
+    for (int i = 0; i < SERVICE_MAX; i++) {
+        service_park((service_id_t)i, true);
+    }
+}
+
+esp_err_t service_lifecycle_get_stats(service_id_t id, service_stats_t* stats) {
+    if (id >= SERVICE_MAX || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(s_runtime[id].lock, portMAX_DELAY);
+    *stats = s_runtime[id].stats;
+    xSemaphoreGive(s_runtime[id].lock);
+    return ESP_OK;
+}
+
+void service_lifecycle_log_report(void) {
+    static const char* state_names[] = {"parked", "running", "failed"};
+
+    ESP_LOGI(TAG, "=== Service lifecycle ===");
+    for (int i = 0; i < SERVICE_MAX; i++) {
+        const service_stats_t* st = &s_runtime[i].stats;
+        ESP_LOGI(TAG, "%-15s %-8s starts=%lu parks=%lu reclaimed: internal=%lld B psram=%lld B (last cpu %lu.%lu%%)",
+                 s_services[i].name, state_names[st->state], (unsigned long)st->starts, (unsigned long)st->parks,
+                 st->total_internal_reclaimed, st->total_psram_reclaimed,
+                 (unsigned long)(st->last_cpu_permille / 10), (unsigned long)(st->last_cpu_permille % 10));
+    }
+}
@@ -32,6 +32,9 @@ typedef struct {
     
     // 图标数组
     status_icon_t icons[STATUS_ICON_MAX];
+
+    // 音频延迟/欠载文字，接收音频时显示在图标左侧
+    lv_obj_t* audio_stats_label;
     
     // 状态标志
     bool wifi_connected;
@@ -65,6 +68,7 @@ static void update_icon_positions(void);
 static esp_err_t create_icon_label(status_icon_type_t icon_type);
 static void hide_all_wifi_icons(void);
 static void check_and_update_states(void);
+static void update_audio_stats_label(bool show);
 
 /**
  * @brief 初始化状态栏管理器（基本初始化）
@@ -170,12 +174,41 @@ void status_bar_manager_deinit(void) {
             lv_obj_del(g_manager->icons[i].label);
         }
     }
+    if (g_manager->audio_stats_label != NULL && lv_obj_is_valid(g_manager->audio_stats_label)) {
+        lv_obj_del(g_manager->audio_stats_label);
+    }
 
     free(g_manager);
     g_manager = NULL;
     ESP_LOGI(TAG, "Status bar manager deinitialized");
 }
 
+/**
+ * @brief 解除与状态栏容器的绑定（容器所在屏幕即将被删除时调用）
+ * 停止更新定时器并丢弃图标标签引用，标签随屏幕一起删除；下次 set_container 后按当前状态重新创建
+ */
+void status_bar_manager_detach(void) {
+    if (g_manager == NULL) {
+        return;
+    }
+
+    if (g_manager->update_timer != NULL) {
+        xTimerStop(g_manager->update_timer, portMAX_DELAY);
+    }
+
+    for (int i = 0; i < STATUS_ICON_MAX; i++) {
+        g_manager->icons[i].label = NULL;
+        g_manager->icons[i].visible = false;
+        g_manager->icons[i].x_offset = 0;
+    }
+    g_manager->audio_stats_label = NULL;
+    g_manager->status_bar_container = NULL;
+    g_manager->time_label = NULL;
+    g_manager->battery_label = NULL;
+
+    ESP_LOGI(TAG, "Status bar manager detached from container");
+}
+
 /**
  * @brief 设置时间和电池标签对象
  */
@@ -393,6 +426,11 @@ static void update_icon_positions(void) {
         }
     }
 
+    // 音频统计文字接在最左侧图标之后
+    if (g_manager->audio_stats_label != NULL) {
+        lv_obj_align(g_manager->audio_stats_label, LV_ALIGN_RIGHT_MID, -current_offset, 0);
+    }
+
     // 更新图标位置
 }
 
@@ -411,6 +449,11 @@ static esp_err_t create_icon_label(status_icon_type_t icon_type) {
         return ESP_OK;
     }
 
+    if (g_manager->status_bar_container == NULL) {
+        // 尚未绑定容器（主菜单不在屏幕上）
+        return ESP_ERR_INVALID_STATE;
+    }
+
     // 创建新标签
     icon->label = lv_label_create(g_manager->status_bar_container);
     if (icon->label == NULL) {
@@ -476,9 +519,47 @@ static void check_and_update_states(void) {
     // 检查音频接收状态
     bool audio_active = audio_receiver_is_receiving();
     status_bar_manager_set_audio_status(audio_active);
+    update_audio_stats_label(audio_active);
 
     // 这里可以添加AP状态检查
     // TODO: 添加AP状态检查函数
     // bool ap_active = wifi_manager_is_ap_running();
     // status_bar_manager_set_ap_status(ap_active);
 }
+
+/**
+ * @brief 更新音频延迟和欠载次数文字，例如 "85ms" 或 "120ms U3"
+ */
+static void update_audio_stats_label(bool show) {
+    if (g_manager == NULL || g_manager->status_bar_container == NULL) {
+        return;
+    }
+
+    if (!show) {
+        if (g_manager->audio_stats_label != NULL) {
+            lv_obj_add_flag(g_manager->audio_stats_label, LV_OBJ_FLAG_HIDDEN);
+        }
+        return;
+    }
+
+    if (g_manager->audio_stats_label == NULL) {
+        g_manager->audio_stats_label = lv_label_create(g_manager->status_bar_container);
+        if (g_manager->audio_stats_label == NULL) {
+            ESP_LOGE(TAG, "Failed to create audio stats label");
+            return;
+        }
+        lv_obj_set_style_text_font(g_manager->audio_stats_label, &lv_font_montserrat_12, 0);
+        lv_obj_set_style_text_color(g_manager->audio_stats_label, lv_color_hex(0x000000), 0);
+    }
+
+    audio_receiver_stats_t stats;
+    audio_receiver_get_stats(&stats);
+    if (stats.jb.underruns > 0) {
+        lv_label_set_text_fmt(g_manager->audio_stats_label, "%lums U%lu", (unsigned long)stats.latency_ms,
+                              (unsigned long)stats.jb.underruns);
+    } else {
+        lv_label_set_text_fmt(g_manager->audio_stats_label, "%lums", (unsigned long)stats.latency_ms);
+    }
+    lv_obj_clear_flag(g_manager->audio_stats_label, LV_OBJ_FLAG_HIDDEN);
+    update_icon_positions();
+}
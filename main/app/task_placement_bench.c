@@ -0,0 +1,383 @@
+/**
+ * @file task_placement_bench.c
+ * @brief 任务布局方案对比测试实现
+ * @author TidyCraze
+ * @date 2025-10-18
+ *
+ * 解码任务与真实图传一样阻塞等待"帧到达"（由 esp_timer 按源帧率释放信号量），
+ * 因此高优先级的解码任务不会把同核的LVGL任务完全饿死，测得的界面帧率可以反映方案差异。
+ */
+
+#include "task_placement_bench.h"
+#include "esp_heap_caps.h"
+#include "esp_jpeg_dec.h"
+#include "esp_jpeg_enc.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "lvgl.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* TAG = "PLACEMENT_BENCH";
+
+#define BENCH_FRAME_BUFFERS 3     // 解码中、待显示、显示中各一个，互不覆盖
+#define BENCH_SOURCE_QUEUE_DEPTH 2 // 与图传接收队列深度一致，积压超过后丢帧
+#define BENCH_UI_TIMER_MS 10
+#define BENCH_JPEG_QUALITY 60
+#define BENCH_FRAME_BYTES (TASK_PLACEMENT_BENCH_WIDTH * TASK_PLACEMENT_BENCH_HEIGHT * 2)
+
+typedef enum {
+    BENCH_PHASE_IDLE = 0,
+    BENCH_PHASE_RUNNING, // 解码任务运行中
+    BENCH_PHASE_STOPPING // 等待解码任务退出
+} bench_phase_t;
+
+// 测试状态，除标注外只在LVGL任务中访问
+static bench_phase_t s_phase = BENCH_PHASE_IDLE;
+static int s_profile_index = 0;
+static task_profile_t s_saved_profile = TASK_PROFILE_CONTROL;
+static task_placement_bench_result_t s_results[TASK_PROFILE_MAX];
+static task_placement_bench_done_cb_t s_done_cb = NULL;
+static void* s_done_user_data = NULL;
+static lv_timer_t* s_timer = NULL;
+static lv_obj_t* s_img = NULL;
+static lv_img_dsc_t s_img_dsc[BENCH_FRAME_BUFFERS];
+static int8_t s_shown = -1;
+static int64_t s_phase_start_us = 0;
+static void (*s_prev_monitor_cb)(lv_disp_drv_t*, uint32_t, uint32_t) = NULL;
+static volatile uint32_t s_ui_frames = 0;
+
+// 合成的JPEG图像和解码缓冲区（PSRAM）
+static uint8_t* s_jpeg = NULL;
+static int s_jpeg_len = 0;
+static uint8_t* s_frames[BENCH_FRAME_BUFFERS] = {NULL};
+
+// 与解码任务共享
+static volatile bool s_decode_stop = false;
+static volatile int8_t s_ready = -1;          // 最新解码完成的缓冲区
+static volatile uint32_t s_decoded = 0;
+static volatile uint32_t s_dropped = 0;
+static volatile uint64_t s_decode_us_total = 0;
+static TaskHandle_t s_decode_task = NULL;
+static SemaphoreHandle_t s_frame_sem = NULL;
+static esp_timer_handle_t s_source_timer = NULL;
+
+// 生成一帧渐变加色块的图像并编码为JPEG，作为每一帧的解码输入
+static esp_err_t bench_encode_source(void) {
+    const size_t rgb_len = TASK_PLACEMENT_BENCH_WIDTH * TASK_PLACEMENT_BENCH_HEIGHT * 3;
+    uint8_t* rgb = heap_caps_malloc(rgb_len, MALLOC_CAP_SPIRAM);
+    s_jpeg = heap_caps_malloc(rgb_len, MALLOC_CAP_SPIRAM);
+    if (rgb == NULL || s_jpeg == NULL) {
+        free(rgb);
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (int y = 0; y < TASK_PLACEMENT_BENCH_HEIGHT; y++) {
+        for (int x = 0; x < TASK_PLACEMENT_BENCH_WIDTH; x++) {
+            uint8_t* p = &rgb[(y * TASK_PLACEMENT_BENCH_WIDTH + x) * 3];
+            bool block = ((x / 16) + (y / 16)) & 1;
+            p[0] = (uint8_t)(x * 255 / TASK_PLACEMENT_BENCH_WIDTH);
+            p[1] = (uint8_t)(y * 255 / TASK_PLACEMENT_BENCH_HEIGHT);
+            p[2] = block ? 200 : 40;
+        }
+    }
+
+    jpeg_enc_config_t cfg = DEFAULT_JPEG_ENC_CONFIG();
+    cfg.width = TASK_PLACEMENT_BENCH_WIDTH;
+    cfg.height = TASK_PLACEMENT_BENCH_HEIGHT;
+    cfg.src_type = JPEG_PIXEL_FORMAT_RGB888;
+    cfg.subsampling = JPEG_SUBSAMPLE_420;
+    cfg.quality = BENCH_JPEG_QUALITY;
+
+    jpeg_enc_handle_t enc = NULL;
+    jpeg_error_t ret = jpeg_enc_open(&cfg, &enc);
+    if (ret == JPEG_ERR_OK) {
+        ret = jpeg_enc_process(enc, rgb, rgb_len, s_jpeg, rgb_len, &s_jpeg_len);
+        jpeg_enc_close(enc);
+    }
+    free(rgb);
+
+    if (ret != JPEG_ERR_OK || s_jpeg_len <= 0) {
+        ESP_LOGE(TAG, "Failed to encode bench source: %d", ret);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Bench source: %dx%d, %d bytes JPEG", TASK_PLACEMENT_BENCH_WIDTH, TASK_PLACEMENT_BENCH_HEIGHT,
+             s_jpeg_len);
+    return ESP_OK;
+}
+
+static void bench_free_buffers(void) {
+    free(s_jpeg);
+    s_jpeg = NULL;
+    s_jpeg_len = 0;
+    for (int i = 0; i < BENCH_FRAME_BUFFERS; i++) {
+        if (s_frames[i]) {
+            jpeg_free_align(s_frames[i]);
+            s_frames[i] = NULL;
+        }
+    }
+}
+
+// 模拟帧到达：队列已满时丢弃该帧
+static void source_timer_cb(void* arg) {
+    (void)arg;
+    if (uxSemaphoreGetCount(s_frame_sem) >= BENCH_SOURCE_QUEUE_DEPTH) {
+        s_dropped++;
+        return;
+    }
+    xSemaphoreGive(s_frame_sem);
+}
+
+static void bench_decode_task(void* arg) {
+    (void)arg;
+    jpeg_dec_config_t config = DEFAULT_JPEG_DEC_CONFIG();
+    config.output_type = JPEG_PIXEL_FORMAT_RGB565_BE;
+
+    jpeg_dec_handle_t dec = NULL;
+    jpeg_dec_io_t io = {0};
+    jpeg_dec_header_info_t info = {0};
+
+    if (jpeg_dec_open(&config, &dec) != JPEG_ERR_OK) {
+        ESP_LOGE(TAG, "Failed to open JPEG decoder");
+        s_decode_task = NULL;
+        vTaskDelete(NULL);
+        return;
+    }
+
+    while (!s_decode_stop) {
+        if (xSemaphoreTake(s_frame_sem, pdMS_TO_TICKS(100)) != pdTRUE) {
+            continue;
+        }
+
+        // 选一个既不在显示也不待显示的缓冲区
+        int8_t shown = s_shown;
+        int8_t ready = s_ready;
+        int target = 0;
+        while (target == shown || target == ready) {
+            target++;
+        }
+
+        int64_t start = esp_timer_get_time();
+        io.inbuf = s_jpeg;
+        io.inbuf_len = s_jpeg_len;
+        io.outbuf = s_frames[target];
+        if (jpeg_dec_parse_header(dec, &io, &info) == JPEG_ERR_OK && jpeg_dec_process(dec, &io) == JPEG_ERR_OK) {
+            s_decode_us_total += esp_timer_get_time() - start;
+            s_ready = (int8_t)target;
+            s_decoded++;
+        }
+    }
+
+    jpeg_dec_close(dec);
+    s_decode_task = NULL;
+    vTaskDelete(NULL);
+}
+
+// 统计LVGL实际完成的刷新，保留原有的监视回调
+static void bench_monitor_cb(lv_disp_drv_t* drv, uint32_t time, uint32_t px) {
+    s_ui_frames++;
+    if (s_prev_monitor_cb) {
+        s_prev_monitor_cb(drv, time, px);
+    }
+}
+
+static esp_err_t bench_phase_start(void) {
+    task_profile_t profile = (task_profile_t)s_profile_index;
+    task_placement_set_profile(profile);
+
+    s_decode_stop = false;
+    s_decoded = 0;
+    s_dropped = 0;
+    s_decode_us_total = 0;
+    s_ui_frames = 0;
+    s_ready = -1;
+    xSemaphoreTake(s_frame_sem, 0);
+    xSemaphoreTake(s_frame_sem, 0);
+
+    // 任务名同时是布局表的键，与图传解码任务使用同一行布局
+    if (task_placement_create(bench_decode_task, "jpeg_decode", NULL, &s_decode_task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_timer_start_periodic(s_source_timer, 1000000 / TASK_PLACEMENT_BENCH_SOURCE_FPS);
+
+    s_phase_start_us = esp_timer_get_time();
+    s_phase = BENCH_PHASE_RUNNING;
+    ESP_LOGI(TAG, "Benchmarking profile %s", task_placement_profile_name(profile));
+    return ESP_OK;
+}
+
+static void bench_phase_record(void) {
+    task_placement_bench_result_t* r = &s_results[s_profile_index];
+    float seconds = (float)(esp_timer_get_time() - s_phase_start_us) / 1000000.0f;
+
+    r->profile = (task_profile_t)s_profile_index;
+    r->status = ESP_OK;
+    r->decoded_frames = s_decoded;
+    r->dropped_frames = s_dropped;
+    r->avg_decode_us = s_decoded ? (uint32_t)(s_decode_us_total / s_decoded) : 0;
+    r->decode_fps = seconds > 0 ? s_decoded / seconds : 0;
+    r->ui_frames = s_ui_frames;
+    r->ui_fps = seconds > 0 ? s_ui_frames / seconds : 0;
+
+    ESP_LOGI(TAG, "%s: decode %.1f fps (%lu us/frame, %lu dropped), UI %.1f fps",
+             task_placement_profile_name(r->profile), r->decode_fps, (unsigned long)r->avg_decode_us,
+             (unsigned long)r->dropped_frames, r->ui_fps);
+}
+
+static void bench_finish(void) {
+    lv_disp_t* disp = lv_disp_get_default();
+    disp->driver->monitor_cb = s_prev_monitor_cb;
+    s_prev_monitor_cb = NULL;
+
+    lv_timer_del(s_timer);
+    s_timer = NULL;
+    lv_obj_del(s_img);
+    s_img = NULL;
+    s_shown = -1;
+
+    esp_timer_delete(s_source_timer);
+    s_source_timer = NULL;
+    vSemaphoreDelete(s_frame_sem);
+    s_frame_sem = NULL;
+    bench_free_buffers();
+
+    task_placement_set_profile(s_saved_profile);
+    s_phase = BENCH_PHASE_IDLE;
+
+    if (s_done_cb) {
+        s_done_cb(s_results, TASK_PROFILE_MAX, s_done_user_data);
+    }
+}
+
+static void bench_timer_cb(lv_timer_t* timer) {
+    (void)timer;
+
+    if (s_phase == BENCH_PHASE_RUNNING) {
+        // 显示最新解码的帧
+        int8_t ready = s_ready;
+        if (ready >= 0 && ready != s_shown) {
+            s_shown = ready;
+            lv_img_set_src(s_img, &s_img_dsc[ready]);
+            lv_obj_invalidate(s_img);
+        }
+
+        if (esp_timer_get_time() - s_phase_start_us >= (int64_t)TASK_PLACEMENT_BENCH_DURATION_MS * 1000) {
+            esp_timer_stop(s_source_timer);
+            bench_phase_record();
+            s_decode_stop = true;
+            s_phase = BENCH_PHASE_STOPPING;
+        }
+        return;
+    }
+
+    if (s_phase == BENCH_PHASE_STOPPING && s_decode_task == NULL) {
+        s_profile_index++;
+        if (s_profile_index >= TASK_PROFILE_MAX) {
+            bench_finish();
+            return;
+        }
+        if (bench_phase_start() != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to start profile %s", task_placement_profile_name((task_profile_t)s_profile_index));
+            bench_finish();
+        }
+    }
+}
+
+esp_err_t task_placement_bench_start(task_placement_bench_done_cb_t done_cb, void* user_data) {
+    if (s_phase != BENCH_PHASE_IDLE) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xTaskGetHandle("jpeg_decode") != NULL) {
+        ESP_LOGW(TAG, "Image transfer is running, stop it before benchmarking");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = bench_encode_source();
+    if (ret != ESP_OK) {
+        bench_free_buffers();
+        return ret;
+    }
+    for (int i = 0; i < BENCH_FRAME_BUFFERS; i++) {
+        s_frames[i] = jpeg_calloc_align(BENCH_FRAME_BYTES, 16);
+        if (s_frames[i] == NULL) {
+            bench_free_buffers();
+            return ESP_ERR_NO_MEM;
+        }
+        s_img_dsc[i] = (lv_img_dsc_t){
+            .header.always_zero = 0,
+            .header.w = TASK_PLACEMENT_BENCH_WIDTH,
+            .header.h = TASK_PLACEMENT_BENCH_HEIGHT,
+            .header.cf = LV_IMG_CF_TRUE_COLOR,
+            .data_size = BENCH_FRAME_BYTES,
+            .data = s_frames[i],
+        };
+    }
+
+    s_frame_sem = xSemaphoreCreateCounting(BENCH_SOURCE_QUEUE_DEPTH, 0);
+    const esp_timer_create_args_t timer_args = {
+        .callback = source_timer_cb,
+        .name = "bench_source",
+    };
+    if (s_frame_sem == NULL || esp_timer_create(&timer_args, &s_source_timer) != ESP_OK) {
+        if (s_frame_sem) {
+            vSemaphoreDelete(s_frame_sem);
+            s_frame_sem = NULL;
+        }
+        bench_free_buffers();
+        return ESP_ERR_NO_MEM;
+    }
+
+    memset(s_results, 0, sizeof(s_results));
+    for (int i = 0; i < TASK_PROFILE_MAX; i++) {
+        s_results[i].profile = (task_profile_t)i;
+        s_results[i].status = ESP_ERR_NOT_FINISHED;
+    }
+    s_done_cb = done_cb;
+    s_done_user_data = user_data;
+    s_saved_profile = task_placement_get_profile();
+    s_profile_index = 0;
+
+    // 图像放在顶层，覆盖当前页面
+    s_img = lv_img_create(lv_layer_top());
+    lv_obj_align(s_img, LV_ALIGN_TOP_MID, 0, 0);
+
+    lv_disp_t* disp = lv_disp_get_default();
+    s_prev_monitor_cb = disp->driver->monitor_cb;
+    disp->driver->monitor_cb = bench_monitor_cb;
+
+    s_timer = lv_timer_create(bench_timer_cb, BENCH_UI_TIMER_MS, NULL);
+
+    ret = bench_phase_start();
+    if (ret != ESP_OK) {
+        bench_finish();
+    }
+    return ret;
+}
+
+bool task_placement_bench_is_running(void) { return s_phase != BENCH_PHASE_IDLE; }
+
+size_t task_placement_bench_format(const task_placement_bench_result_t* results, size_t count, char* buf,
+                                   size_t buf_size) {
+    if (results == NULL || buf == NULL || buf_size == 0) {
+        return 0;
+    }
+
+    int len = snprintf(buf, buf_size, "Task placement (%dx%d @%d fps src)", TASK_PLACEMENT_BENCH_WIDTH,
+                       TASK_PLACEMENT_BENCH_HEIGHT, TASK_PLACEMENT_BENCH_SOURCE_FPS);
+    for (size_t i = 0; i < count && len < (int)buf_size; i++) {
+        const task_placement_bench_result_t* r = &results[i];
+        if (r->status != ESP_OK) {
+            len += snprintf(buf + len, buf_size - len, "\n%s: %s", task_placement_profile_name(r->profile),
+                            esp_err_to_name(r->status));
+            continue;
+        }
+        len += snprintf(buf + len, buf_size - len, "\n%s: dec %.1f fps %lu us drop %lu\n  UI %.1f fps",
+                        task_placement_profile_name(r->profile), r->decode_fps, (unsigned long)r->avg_decode_us,
+                        (unsigned long)r->dropped_frames, r->ui_fps);
+    }
+    return len < (int)buf_size ? (size_t)len : buf_size - 1;
+}
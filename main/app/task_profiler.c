@@ -0,0 +1,309 @@
+/**
+ * @file task_profiler.c
+ * @brief 任务运行统计采样实现
+ * @author TidyCraze
+ * @date 2025-10-18
+ *
+ * 依赖 CONFIG_FREERTOS_USE_TRACE_FACILITY 和 CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS（esp_timer 计时）。
+ * 每个周期调用一次 uxTaskGetSystemState，用本次与上次的运行时间计数之差得到各任务的CPU占用，
+ * 每个核的负载由该核空闲任务的占用反推。任务按 xTaskNumber 区分，重名或重建的任务不会混淆。
+ */
+
+#include "task_profiler.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "task_placement.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+
+static const char* TAG = "TASK_PROFILER";
+
+#define TASK_PROFILER_PREV_SLOTS (TASK_PROFILER_MAX_TASKS * 2) // 上次运行时间表，留出余量给新建的任务
+
+// 上次采样时每个任务的运行时间计数
+typedef struct {
+    UBaseType_t task_number;
+    configRUN_TIME_COUNTER_TYPE runtime;
+} task_runtime_t;
+
+static task_profiler_sample_t* s_history = NULL; // 环形缓冲区 (PSRAM)
+static uint32_t s_head = 0;                      // 下一次写入的位置
+static uint32_t s_count = 0;
+static uint32_t s_seq = 0;
+static SemaphoreHandle_t s_lock = NULL;
+
+static TaskHandle_t s_task = NULL;
+static volatile bool s_running = false;
+static uint32_t s_period_ms = TASK_PROFILER_DEFAULT_PERIOD_MS;
+
+static task_runtime_t s_prev[TASK_PROFILER_PREV_SLOTS];
+static size_t s_prev_count = 0;
+static configRUN_TIME_COUNTER_TYPE s_prev_total = 0;
+
+static bool find_prev_runtime(UBaseType_t task_number, configRUN_TIME_COUNTER_TYPE* runtime) {
+    for (size_t i = 0; i < s_prev_count; i++) {
+        if (s_prev[i].task_number == task_number) {
+            *runtime = s_prev[i].runtime;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 按CPU占用降序插入，满了丢弃占用最低的
+static void insert_task(task_profiler_sample_t* sample, const task_profiler_task_t* task) {
+    int pos = sample->entry_count;
+    if (pos == TASK_PROFILER_MAX_TASKS) {
+        if (sample->tasks[pos - 1].cpu_permille >= task->cpu_permille) {
+            return;
+        }
+        pos--;
+    } else {
+        sample->entry_count++;
+    }
+    while (pos > 0 && sample->tasks[pos - 1].cpu_permille < task->cpu_permille) {
+        sample->tasks[pos] = sample->tasks[pos - 1];
+        pos--;
+    }
+    sample->tasks[pos] = *task;
+}
+
+// 采样一次，写入 sample。第一次调用只建立基准，返回 false
+static bool take_sample(task_profiler_sample_t* sample, TaskStatus_t* status, UBaseType_t capacity) {
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t count = uxTaskGetSystemState(status, capacity, &total);
+    if (count == 0) {
+        // 任务数超过了缓冲区容量
+        return false;
+    }
+
+    bool have_baseline = (s_prev_count > 0);
+    uint32_t elapsed = (uint32_t)(total - s_prev_total); // 微秒，无符号相减处理计数回绕
+
+    memset(sample, 0, sizeof(*sample));
+    sample->timestamp_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    sample->period_ms = elapsed / 1000;
+    sample->task_count = (uint8_t)(count > UINT8_MAX ? UINT8_MAX : count);
+    sample->free_internal = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    sample->free_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+
+    size_t prev_count = 0;
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskStatus_t* ts = &status[i];
+        configRUN_TIME_COUNTER_TYPE prev_runtime = 0;
+        uint32_t delta = 0;
+        if (have_baseline && elapsed > 0) {
+            // 新出现的任务从0开始计
+            find_prev_runtime(ts->xTaskNumber, &prev_runtime);
+            delta = (uint32_t)(ts->ulRunTimeCounter - prev_runtime);
+        }
+
+        task_profiler_task_t task = {0};
+        strlcpy(task.name, ts->pcTaskName, sizeof(task.name));
+        task.cpu_permille = elapsed > 0 ? (uint16_t)MIN((uint64_t)delta * 1000 / elapsed, 1000) : 0;
+        task.stack_free = ts->usStackHighWaterMark; // ESP-IDF 中栈以字节为单位
+        task_placement_note_stack(ts->pcTaskName, task.stack_free);
+        task.priority = (uint8_t)ts->uxCurrentPriority;
+        BaseType_t core_id = xTaskGetCoreID(ts->xHandle);
+        task.core = (core_id == tskNO_AFFINITY) ? -1 : (int8_t)core_id;
+        insert_task(sample, &task);
+
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            if (ts->xHandle == xTaskGetIdleTaskHandleForCore(core)) {
+                sample->core_load_permille[core] = 1000 - task.cpu_permille;
+            }
+        }
+
+        if (prev_count < TASK_PROFILER_PREV_SLOTS) {
+            s_prev[prev_count].task_number = ts->xTaskNumber;
+            s_prev[prev_count].runtime = ts->ulRunTimeCounter;
+            prev_count++;
+        }
+    }
+
+    // 基准表整体替换，已删除的任务自然被丢弃
+    s_prev_count = prev_count;
+    s_prev_total = total;
+    return have_baseline && elapsed > 0;
+}
+
+static void task_profiler_task(void* arg) {
+    (void)arg;
+    UBaseType_t capacity = TASK_PROFILER_PREV_SLOTS;
+    TaskStatus_t* status = heap_caps_malloc(capacity * sizeof(TaskStatus_t), MALLOC_CAP_SPIRAM);
+    task_profiler_sample_t* sample = heap_caps_malloc(sizeof(task_profiler_sample_t), MALLOC_CAP_SPIRAM);
+    if (status == NULL || sample == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate sampling buffers");
+        goto exit;
+    }
+
+    s_prev_count = 0;
+    TickType_t last_wake = xTaskGetTickCount();
+    while (s_running) {
+        if (take_sample(sample, status, capacity)) {
+            xSemaphoreTake(s_lock, portMAX_DELAY);
+            sample->seq = ++s_seq;
+            s_history[s_head] = *sample;
+            s_head = (s_head + 1) % TASK_PROFILER_HISTORY;
+            if (s_count < TASK_PROFILER_HISTORY) {
+                s_count++;
+            }
+            xSemaphoreGive(s_lock);
+        }
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(s_period_ms));
+    }
+
+exit:
+    free(status);
+    free(sample);
+    s_running = false;
+    s_task = NULL;
+    task_placement_delete(NULL);
+}
+
+esp_err_t task_profiler_start(uint32_t period_ms) {
+    if (s_task != NULL) {
+        s_period_ms = MAX(period_ms, TASK_PROFILER_MIN_PERIOD_MS);
+        return ESP_OK;
+    }
+
+    if (s_lock == NULL) {
+        s_lock = xSemaphoreCreateMutex();
+        if (s_lock == NULL) {
+            ESP_LOGE(TAG, "Failed to create profiler lock");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if (s_history == NULL) {
+        s_history = heap_caps_calloc(TASK_PROFILER_HISTORY, sizeof(task_profiler_sample_t), MALLOC_CAP_SPIRAM);
+        if (s_history == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate profiler history (%u bytes)",
+                     (unsigned)(TASK_PROFILER_HISTORY * sizeof(task_profiler_sample_t)));
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    s_period_ms = MAX(period_ms, TASK_PROFILER_MIN_PERIOD_MS);
+    s_running = true;
+    BaseType_t result = task_placement_create(task_profiler_task, "task_profiler", NULL, &s_task);
+    if (result != pdPASS) {
+        s_running = false;
+        ESP_LOGE(TAG, "Failed to create profiler task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Task profiler started, period %lu ms, history %d samples", (unsigned long)s_period_ms,
+             TASK_PROFILER_HISTORY);
+    return ESP_OK;
+}
+
+void task_profiler_stop(void) {
+    if (s_task == NULL) {
+        return;
+    }
+    s_running = false;
+    // 采样任务在当前周期结束时退出
+    for (int i = 0; i < 50 && s_task != NULL; i++) {
+        vTaskDelay(pdMS_TO_TICKS(s_period_ms / 10 + 1));
+    }
+    ESP_LOGI(TAG, "Task profiler stopped");
+}
+
+bool task_profiler_is_running(void) { return s_running && s_task != NULL; }
+
+uint32_t task_profiler_get_seq(void) { return s_seq; }
+
+esp_err_t task_profiler_get_latest(task_profiler_sample_t* out) {
+    if (out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_lock == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (s_count > 0) {
+        *out = s_history[(s_head + TASK_PROFILER_HISTORY - 1) % TASK_PROFILER_HISTORY];
+        ret = ESP_OK;
+    }
+    xSemaphoreGive(s_lock);
+    return ret;
+}
+
+size_t task_profiler_get_core_history(int core, uint16_t* out, size_t max) {
+    if (out == NULL || core < 0 || core >= portNUM_PROCESSORS || s_lock == NULL) {
+        return 0;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    size_t n = MIN(max, s_count);
+    uint32_t start = (s_head + TASK_PROFILER_HISTORY - n) % TASK_PROFILER_HISTORY;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = s_history[(start + i) % TASK_PROFILER_HISTORY].core_load_permille[core];
+    }
+    xSemaphoreGive(s_lock);
+    return n;
+}
+
+size_t task_profiler_get_task_history(const char* name, uint16_t* cpu_out, uint32_t* stack_out, size_t max) {
+    if (name == NULL || s_lock == NULL) {
+        return 0;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    size_t n = MIN(max, s_count);
+    uint32_t start = (s_head + TASK_PROFILER_HISTORY - n) % TASK_PROFILER_HISTORY;
+    for (size_t i = 0; i < n; i++) {
+        const task_profiler_sample_t* sample = &s_history[(start + i) % TASK_PROFILER_HISTORY];
+        uint16_t cpu = 0;
+        uint32_t stack = 0;
+        for (int t = 0; t < sample->entry_count; t++) {
+            if (strncmp(sample->tasks[t].name, name, configMAX_TASK_NAME_LEN - 1) == 0) {
+                cpu = sample->tasks[t].cpu_permille;
+                stack = sample->tasks[t].stack_free;
+                break;
+            }
+        }
+        if (cpu_out) {
+            cpu_out[i] = cpu;
+        }
+        if (stack_out) {
+            stack_out[i] = stack;
+        }
+    }
+    xSemaphoreGive(s_lock);
+    return n;
+}
+
+void task_profiler_log_report(void) {
+    task_profiler_sample_t* sample = heap_caps_malloc(sizeof(task_profiler_sample_t), MALLOC_CAP_SPIRAM);
+    if (sample == NULL) {
+        return;
+    }
+    if (task_profiler_get_latest(sample) != ESP_OK) {
+        ESP_LOGI(TAG, "No profiler samples yet");
+        free(sample);
+        return;
+    }
+
+    ESP_LOGI(TAG, "=== Task profile #%lu (%lu ms, %u tasks) ===", (unsigned long)sample->seq,
+             (unsigned long)sample->period_ms, sample->task_count);
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        ESP_LOGI(TAG, "Core %d load: %u.%u%%", core, sample->core_load_permille[core] / 10,
+                 sample->core_load_permille[core] % 10);
+    }
+    ESP_LOGI(TAG, "Free internal: %lu B, free PSRAM: %lu B", (unsigned long)sample->free_internal,
+             (unsigned long)sample->free_psram);
+    ESP_LOGI(TAG, "%-16s %7s %10s %4s %4s", "task", "cpu", "stack_free", "prio", "core");
+    for (int i = 0; i < sample->entry_count; i++) {
+        const task_profiler_task_t* t = &sample->tasks[i];
+        ESP_LOGI(TAG, "%-16s %5u.%u%% %10lu %4u %4d", t->name, t->cpu_permille / 10, t->cpu_permille % 10,
+                 (unsigned long)t->stack_free, t->priority, t->core);
+    }
+    free(sample);
+}
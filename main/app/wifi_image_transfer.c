@@ -12,6 +12,7 @@
 #include "esp_jpeg_dec.h"
 
 #include "esp_heap_caps.h"
+#include "task_placement.h"
 #include "ui_image_transfer.h"
 #include "wifi_image_transfer.h"
 #include "freertos/event_groups.h"
@@ -88,7 +89,7 @@ static void tcp_recv_task(void* pvParameters) {
     if (s_listen_sock < 0) {
         ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
         cleanup_resources();
-        vTaskDelete(NULL);
+        task_placement_delete(NULL);
         return;
     }
     ESP_LOGI(TAG, "Socket created");
@@ -99,7 +100,7 @@ static void tcp_recv_task(void* pvParameters) {
         ESP_LOGE(TAG, "Failed to set SO_REUSEADDR: errno %d", errno);
         close(s_listen_sock);
         cleanup_resources();
-        vTaskDelete(NULL);
+        task_placement_delete(NULL);
         return;
     }
 
@@ -115,7 +116,7 @@ static void tcp_recv_task(void* pvParameters) {
         ESP_LOGE(TAG, "Socket unable to bind: errno %d", errno);
         close(s_listen_sock);
         cleanup_resources();
-        vTaskDelete(NULL);
+        task_placement_delete(NULL);
         return;
     }
     ESP_LOGI(TAG, "Socket bound, port %d", port);
@@ -125,7 +126,7 @@ static void tcp_recv_task(void* pvParameters) {
         ESP_LOGE(TAG, "Error occurred during listen: errno %d", errno);
         close(s_listen_sock);
         cleanup_resources();
-        vTaskDelete(NULL);
+        task_placement_delete(NULL);
         return;
     }
     ESP_LOGI(TAG, "Socket listening");
@@ -267,7 +268,7 @@ static void tcp_recv_task(void* pvParameters) {
     }
     s_server_running = false;
     s_tcp_server_task_handle = NULL;
-    vTaskDelete(NULL);
+    task_placement_delete(NULL);
 }
 
 static void jpeg_decode_task(void* pvParameters) {
@@ -280,7 +281,7 @@ static void jpeg_decode_task(void* pvParameters) {
     if (dec_ret != JPEG_ERR_OK) {
         ESP_LOGE(TAG, "Failed to open JPEG decoder: %d", dec_ret);
         s_jpeg_decode_task_handle = NULL;
-        vTaskDelete(NULL);
+        task_placement_delete(NULL);
         return;
     }
 
@@ -382,7 +383,7 @@ static void jpeg_decode_task(void* pvParameters) {
 
     ESP_LOGI(TAG, "JPEG decode task stopped");
     s_jpeg_decode_task_handle = NULL;
-    vTaskDelete(NULL);
+    task_placement_delete(NULL);
 }
 
 static void handle_decoded_image(uint8_t* img_buf, int width, int height) {
@@ -417,11 +418,11 @@ static void cleanup_resources(void)
 
     // Delete tasks if they are running
     if (s_tcp_server_task_handle != NULL) {
-        vTaskDelete(s_tcp_server_task_handle);
+        task_placement_delete(s_tcp_server_task_handle);
         s_tcp_server_task_handle = NULL;
     }
     if (s_jpeg_decode_task_handle != NULL) {
-        vTaskDelete(s_jpeg_decode_task_handle);
+        task_placement_delete(s_jpeg_decode_task_handle);
         s_jpeg_decode_task_handle = NULL;
     }
 
@@ -504,14 +505,14 @@ bool wifi_image_transfer_start(uint16_t port) {
     s_jpeg_decode_task_handle = NULL;
 
     // Start the JPEG decode task first
-    if (xTaskCreate(jpeg_decode_task, "jpeg_decode", 8192, NULL, 4, &s_jpeg_decode_task_handle) != pdPASS) {
+    if (task_placement_create(jpeg_decode_task, "jpeg_decode", NULL, &s_jpeg_decode_task_handle) != pdPASS) {
         ESP_LOGE(TAG, "Failed to create JPEG decode task");
         cleanup_resources();
         return false;
     }
 
     // Start the TCP receive task
-    if (xTaskCreate(tcp_recv_task, "tcp_recv", 8192, &port, 5, &s_tcp_server_task_handle) != pdPASS) {
+    if (task_placement_create(tcp_recv_task, "tcp_recv", &port, &s_tcp_server_task_handle) != pdPASS) {
         ESP_LOGE(TAG, "Failed to create TCP receive task");
         cleanup_resources();
         return false;
@@ -19,6 +19,8 @@
 #include "nvs_flash.h"
 
 #include "battery_monitor.h"
+#include "boot_init_graph.h"
+#include "boot_profiler.h"
 #include "bsp_i2c.h"
 #include "calibration_manager.h"
 #include "ft6336g.h"
@@ -88,87 +90,137 @@ void spiffs_deinit(void) {
     ESP_LOGI(TAG, "SPIFFS unmounted");
 }
 
-/**
- * @brief 初始化所有必要组件
- * @return esp_err_t ESP_OK成功，其他错误码失败
- */
-esp_err_t components_init(void) {
-    esp_err_t ret;
+// ==================== 启动步骤 ====================
 
-    // 初始化NVS
-    ret = nvs_flash_init();
+static esp_err_t init_nvs_step(void) {
+    esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_ERROR_CHECK(nvs_flash_erase());
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+    return ret;
+}
 
-    // 初始化I2C总线
-    ret = bsp_i2c_init();
+static esp_err_t init_i2c_step(void) {
+    esp_err_t ret = bsp_i2c_init();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize I2C bus");
-        return ret;
     }
+    return ret;
+}
 
-    // 初始化SPIFFS文件系统
-    ret = spiffs_init();
+static esp_err_t init_spiffs_step(void) {
+    esp_err_t ret = spiffs_init();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize SPIFFS");
-        return ret;
     }
+    return ret;
+}
 
-    // 初始化校准管理器
-    ret = calibration_manager_init();
+static esp_err_t init_calibration_step(void) {
+    esp_err_t ret = calibration_manager_init();
     if (ret == ESP_OK) {
         ESP_LOGI(TAG, "Calibration manager initialized");
-    } else {
-        ESP_LOGW(TAG, "Calibration manager init failed: %s", esp_err_to_name(ret));
     }
+    return ret;
+}
 
-    // 初始化电池监测模块
-    ret = battery_monitor_init();
+static esp_err_t init_battery_step(void) {
+    esp_err_t ret = battery_monitor_init();
     if (ret == ESP_OK) {
         ESP_LOGI(TAG, "Battery monitor initialized");
-    } else {
-        ESP_LOGW(TAG, "Battery monitor init failed: %s", esp_err_to_name(ret));
     }
+    return ret;
+}
 
-    // 初始化LSM6DS3传感器
-    ret = lsm6ds3_init();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "LSM6DS3 initialization failed: %s", esp_err_to_name(ret));
-    } else {
+static esp_err_t init_lsm6ds3_step(void) {
+    esp_err_t ret = lsm6ds3_init();
+    if (ret == ESP_OK) {
         ESP_LOGI(TAG, "LSM6DS3 initialized successfully");
     }
+    return ret;
+}
 
 #if USE_FT6336G_TOUCH
-    // 初始化FT6336G触摸控制器
-    ret = ft6336g_init();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "FT6336G initialization failed: %s", esp_err_to_name(ret));
-    } else {
+static esp_err_t init_ft6336g_step(void) {
+    esp_err_t ret = ft6336g_init();
+    if (ret == ESP_OK) {
         ESP_LOGI(TAG, "FT6336G initialized successfully");
     }
+    return ret;
+}
 #endif
 
-    // 初始化UI状态管理器
+static esp_err_t init_ui_state_step(void) {
     ui_state_manager_init();
     ESP_LOGI(TAG, "UI state manager initialized");
+    return ESP_OK;
+}
 
-    // 初始化设置管理器
+static esp_err_t init_settings_step(void) {
     settings_manager_init();
     ESP_LOGI(TAG, "Settings manager initialized.");
+    return ESP_OK;
+}
 
-    // 初始化状态栏管理器
-    ret = status_bar_manager_init();
+static esp_err_t init_status_bar_step(void) {
+    esp_err_t ret = status_bar_manager_init();
     if (ret == ESP_OK) {
         ESP_LOGI(TAG, "Status bar manager initialized");
-    } else {
-        ESP_LOGW(TAG, "Status bar manager init failed: %s", esp_err_to_name(ret));
     }
+    return ret;
+}
+
+// 步骤下标，用于声明依赖
+enum {
+    STEP_NVS = 0,
+    STEP_I2C,
+    STEP_SPIFFS,
+    STEP_CALIBRATION,
+    STEP_BATTERY,
+    STEP_LSM6DS3,
+#if USE_FT6336G_TOUCH
+    STEP_FT6336G,
+#endif
+    STEP_UI_STATE,
+    STEP_SETTINGS,
+    STEP_STATUS_BAR,
+};
+
+// 启动依赖图：没有依赖关系的步骤由两个核并行执行
+// I2C 上的外设串行初始化，避免在同一总线上相互等待
+static const boot_init_step_t s_init_steps[] = {
+    [STEP_NVS] = {"nvs", init_nvs_step, 0, true},
+    [STEP_I2C] = {"i2c_bus", init_i2c_step, 0, true},
+    [STEP_SPIFFS] = {"spiffs", init_spiffs_step, 0, true},
+    [STEP_CALIBRATION] = {"calibration", init_calibration_step, BOOT_INIT_DEP(STEP_NVS), false},
+    [STEP_BATTERY] = {"battery_monitor", init_battery_step, BOOT_INIT_DEP(STEP_NVS), false},
+    [STEP_LSM6DS3] = {"lsm6ds3", init_lsm6ds3_step, BOOT_INIT_DEP(STEP_I2C), false},
+#if USE_FT6336G_TOUCH
+    [STEP_FT6336G] = {"ft6336g", init_ft6336g_step, BOOT_INIT_DEP(STEP_I2C) | BOOT_INIT_DEP(STEP_LSM6DS3), false},
+#endif
+    [STEP_UI_STATE] = {"ui_state_manager", init_ui_state_step, 0, false},
+    [STEP_SETTINGS] = {"settings_manager", init_settings_step, BOOT_INIT_DEP(STEP_NVS), false},
+    [STEP_STATUS_BAR] = {"status_bar_manager", init_status_bar_step, 0, false},
+};
 
-    // 其他组件初始化可以在这里添加
+/**
+ * @brief 初始化所有必要组件
+ * @return esp_err_t ESP_OK成功，其他错误码失败
+ */
+esp_err_t components_init(void) {
+    int prof = boot_profiler_begin("components_init");
+
+    // 主任务运行在Core 0，辅助初始化任务放到Core 1
+    esp_err_t ret = boot_init_run(s_init_steps, sizeof(s_init_steps) / sizeof(s_init_steps[0]), true);
+
+    boot_profiler_end(prof, ret);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Component initialization failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
 
     ESP_LOGI(TAG, "All components initialized successfully");
     return ESP_OK;
-}
\ No newline at end of file
+}
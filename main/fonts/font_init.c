@@ -1,4 +1,5 @@
 #include "my_font.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "esp_partition.h"
 #include "esp_spi_flash.h"
@@ -9,6 +10,99 @@
 static const char *TAG = "FONT_INIT";
 lv_font_t *font_cn = NULL;
 
+// ==================== LVGL 二进制字体格式 (与 lv_font_loader.c 一致) ====================
+
+typedef struct {
+    uint32_t version;
+    uint16_t tables_count;
+    uint16_t font_size;
+    uint16_t ascent;
+    int16_t descent;
+    uint16_t typo_ascent;
+    int16_t typo_descent;
+    uint16_t typo_line_gap;
+    int16_t min_y;
+    int16_t max_y;
+    uint16_t default_advance_width;
+    uint16_t kerning_scale;
+    uint8_t index_to_loc_format;
+    uint8_t glyph_id_format;
+    uint8_t advance_width_format;
+    uint8_t bits_per_pixel;
+    uint8_t xy_bits;
+    uint8_t wh_bits;
+    uint8_t advance_width_bits;
+    uint8_t compression_id;
+    uint8_t subpixels_mode;
+    uint8_t padding;
+    int16_t underline_position;
+    uint16_t underline_thickness;
+} font_header_bin_t;
+
+typedef struct {
+    uint32_t data_offset;
+    uint32_t range_start;
+    uint16_t range_length;
+    uint16_t glyph_id_start;
+    uint16_t data_entries_count;
+    uint8_t format_type;
+    uint8_t padding;
+} cmap_table_bin_t;
+
+// 字形描述中 bitmap_index 只有 20 位
+#define GLYPH_BITMAP_INDEX_MAX (1UL << 20)
+
+// 直接映射的字体：点阵不能交给 lv_font_get_bitmap_fmt_txt 时 (字形头不按字节对齐，或 glyf 段超出
+// bitmap_index 范围) 由 font_mmap_get_bitmap 按 loca 表从 flash 取点阵，需要时移位对齐到 bitmap_buf
+typedef struct {
+    lv_font_t font; // 必须是第一个成员，释放时按 lv_font_t 指针释放
+    const uint8_t *loca;
+    uint32_t loca_entry_size;
+    uint32_t loca_count;
+    const uint8_t *glyf;
+    const uint8_t *glyf_end;
+    uint32_t header_bits; // 字形头位数
+    uint8_t *bitmap_buf;  // 对齐后的点阵，与 LVGL 解压缓冲一样只保证到下一次取点阵前有效
+} mmap_font_t;
+
+// ==================== 字形点阵 LRU 缓存 ====================
+
+#define GLYPH_CACHE_NIL 0xFFFF
+#define GLYPH_CACHE_BUCKETS 128 // 2 的幂
+#define GLYPH_CACHE_MAX_FONTS 2  // 子集字体和分区字体
+
+typedef const uint8_t *(*glyph_bitmap_getter_t)(const lv_font_t *, uint32_t);
+
+// 挂上缓存的字体及其原来的取点阵函数，两个字体的取法不同 (fmt_txt 或 font_mmap_get_bitmap)
+typedef struct {
+    const lv_font_t *font;
+    glyph_bitmap_getter_t get_bitmap;
+} glyph_cache_font_t;
+
+// 缓存条目按 (字体, 码点) 区分，同一码点在子集和回退字体中可能都被缓存
+typedef struct {
+    const lv_font_t *font;
+    uint32_t letter;
+    uint16_t lru_prev;
+    uint16_t lru_next;
+    uint16_t hash_next;
+    uint8_t *bitmap;
+} glyph_cache_entry_t;
+
+static glyph_cache_entry_t *s_cache_entries = NULL;
+static uint8_t *s_cache_pool = NULL;
+static uint16_t s_cache_buckets[GLYPH_CACHE_BUCKETS];
+static uint16_t s_lru_head = GLYPH_CACHE_NIL; // 最近使用
+static uint16_t s_lru_tail = GLYPH_CACHE_NIL; // 最久未使用
+static font_glyph_cache_stats_t s_cache_stats;
+static glyph_cache_font_t s_cache_fonts[GLYPH_CACHE_MAX_FONTS];
+static uint32_t s_cache_font_count = 0;
+
+#if FONT_SUBSET_EMBEDDED
+extern const uint8_t _binary_font_subset_bin_start[] asm("_binary_font_subset_bin_start");
+extern const uint8_t _binary_font_subset_bin_end[] asm("_binary_font_subset_bin_end");
+#endif
+
 typedef struct {
     const uint8_t *data_ptr;
     size_t size;
@@ -81,12 +175,537 @@ static lv_fs_res_t mmap_tell(lv_fs_drv_t* drv, void* file_p, uint32_t* pos_p) {
     return LV_FS_RES_OK;
 }
 
-void font_init(void) {
-    
+// ==================== 直接映射加载 ====================
+
+// 检查段标签，返回段长度 (包含 8 字节段头)，失败返回 -1
+static int32_t mmap_read_label(const uint8_t *base, size_t size, uint32_t start, const char *label) {
+    if (start + 8 > size) {
+        return -1;
+    }
+    uint32_t length;
+    memcpy(&length, base + start, sizeof(length));
+    if (memcmp(base + start + 4, label, 4) != 0 || length < 8 || start + length > size) {
+        return -1;
+    }
+    return (int32_t)length;
+}
+
+// 按位读取 (高位在前)，与 lv_font_loader 的 bit_iterator 一致
+typedef struct {
+    const uint8_t *data;
+    uint32_t bit_pos;
+} bit_reader_t;
+
+static uint32_t read_bits(bit_reader_t *br, int n) {
+    uint32_t value = 0;
+    for (int i = 0; i < n; i++) {
+        uint8_t byte = br->data[br->bit_pos >> 3];
+        value = (value << 1) | ((byte >> (7 - (br->bit_pos & 7))) & 1);
+        br->bit_pos++;
+    }
+    return value;
+}
+
+static int32_t read_bits_signed(bit_reader_t *br, int n) {
+    uint32_t value = read_bits(br, n);
+    if (n > 0 && n < 32 && (value & (1UL << (n - 1)))) {
+        value |= ~0UL << n;
+    }
+    return (int32_t)value;
+}
+
+static void font_mmap_free(lv_font_t *font) {
+    if (font == NULL) {
+        return;
+    }
+    lv_mem_free(((mmap_font_t *)font)->bitmap_buf);
+    lv_font_fmt_txt_dsc_t *dsc = (lv_font_fmt_txt_dsc_t *)font->dsc;
+    if (dsc) {
+        if (dsc->cmaps) {
+            for (uint32_t i = 0; i < dsc->cmap_num; i++) {
+                lv_mem_free((void *)dsc->cmaps[i].unicode_list);
+                lv_mem_free((void *)dsc->cmaps[i].glyph_id_ofs_list);
+            }
+            lv_mem_free((void *)dsc->cmaps);
+        }
+        lv_mem_free((void *)dsc->glyph_dsc);
+        lv_mem_free(dsc);
+    }
+    lv_mem_free(font);
+}
+
+// 码点 -> 字形ID，与 lv_font_fmt_txt.c 中的查找一致 (不做缓存)
+static uint32_t font_mmap_glyph_id(const lv_font_fmt_txt_dsc_t *dsc, uint32_t letter) {
+    for (uint16_t i = 0; i < dsc->cmap_num; i++) {
+        const lv_font_fmt_txt_cmap_t *cmap = &dsc->cmaps[i];
+        uint32_t rcp = letter - cmap->range_start;
+        if (letter < cmap->range_start || rcp >= cmap->range_length) {
+            continue;
+        }
+        switch (cmap->type) {
+            case LV_FONT_FMT_TXT_CMAP_FORMAT0_TINY:
+                return cmap->glyph_id_start + rcp;
+            case LV_FONT_FMT_TXT_CMAP_FORMAT0_FULL: {
+                const uint8_t *ofs = cmap->glyph_id_ofs_list;
+                return cmap->glyph_id_start + ofs[rcp];
+            }
+            case LV_FONT_FMT_TXT_CMAP_SPARSE_TINY:
+            case LV_FONT_FMT_TXT_CMAP_SPARSE_FULL: {
+                uint32_t lo = 0;
+                uint32_t hi = cmap->list_length;
+                while (lo < hi) {
+                    uint32_t mid = (lo + hi) / 2;
+                    if (cmap->unicode_list[mid] < rcp) {
+                        lo = mid + 1;
+                    } else {
+                        hi = mid;
+                    }
+                }
+                if (lo == cmap->list_length || cmap->unicode_list[lo] != rcp) {
+                    return 0;
+                }
+                if (cmap->type == LV_FONT_FMT_TXT_CMAP_SPARSE_TINY) {
+                    return cmap->glyph_id_start + lo;
+                }
+                const uint16_t *ofs = cmap->glyph_id_ofs_list;
+                return cmap->glyph_id_start + ofs[lo];
+            }
+            default:
+                return 0;
+        }
+    }
+    return 0;
+}
+
+// 替换 lv_font_get_bitmap_fmt_txt：点阵起点由 loca 表给出，位于字形头之后，可能不在字节边界上
+static const uint8_t *font_mmap_get_bitmap(const lv_font_t *font, uint32_t letter) {
+    const mmap_font_t *mf = (const mmap_font_t *)font;
+    const lv_font_fmt_txt_dsc_t *dsc = font->dsc;
+    if (letter == '\t') {
+        letter = ' ';
+    }
+    uint32_t gid = font_mmap_glyph_id(dsc, letter);
+    if (gid == 0 || gid >= mf->loca_count) {
+        return NULL;
+    }
+
+    uint32_t offset = 0;
+    memcpy(&offset, mf->loca + gid * mf->loca_entry_size, mf->loca_entry_size);
+    const uint8_t *src = mf->glyf + offset + mf->header_bits / 8;
+    uint32_t shift = mf->header_bits % 8;
+    if (shift == 0) {
+        return src;
+    }
+
+    const lv_font_fmt_txt_glyph_dsc_t *gdsc = &dsc->glyph_dsc[gid];
+    uint32_t bits = (uint32_t)gdsc->box_w * gdsc->box_h * dsc->bpp;
+    uint32_t bytes = (bits + 7) / 8;
+    for (uint32_t i = 0; i < bytes; i++) {
+        uint8_t next = src + i + 1 < mf->glyf_end ? src[i + 1] : 0;
+        mf->bitmap_buf[i] = (uint8_t)((src[i] << shift) | (next >> (8 - shift)));
+    }
+    // 最后一个字节中点阵之后的位属于下一个字形，清零 (与 lv_font_load 的结果一致)
+    if (bytes > 0 && bits % 8 != 0) {
+        mf->bitmap_buf[bytes - 1] &= (uint8_t)(0xFF << (8 - bits % 8));
+    }
+    return mf->bitmap_buf;
+}
+
+/**
+ * 直接从 mmap 区解析 LVGL 二进制字体。
+ * 字符映射表和字形描述 (解码后的位域) 放在 PSRAM，点阵数据直接指向 flash 映射区，不做拷贝。
+ * 字形头按字节对齐且 glyf 段在 bitmap_index 范围内时由 LVGL 直接取点阵；否则 (lv_font_conv 默认
+ * 输出的字体字形头通常是 26/30 位) 换成 font_mmap_get_bitmap 按字形移位对齐，只拷贝正在绘制的字形。
+ * 后一种情况不支持压缩点阵，返回 NULL 由调用者回退到 lv_font_load。
+ */
+static lv_font_t *font_load_mmap(const uint8_t *base, size_t size) {
+    int32_t head_length = mmap_read_label(base, size, 0, "head");
+    if (head_length < (int32_t)(8 + sizeof(font_header_bin_t))) {
+        ESP_LOGW(TAG, "mmap font: invalid head section");
+        return NULL;
+    }
+    font_header_bin_t header;
+    memcpy(&header, base + 8, sizeof(header));
+
+    int nbits = header.advance_width_bits + 2 * header.xy_bits + 2 * header.wh_bits;
+
+    mmap_font_t *mf = lv_mem_alloc(sizeof(mmap_font_t));
+    lv_font_fmt_txt_dsc_t *dsc = lv_mem_alloc(sizeof(lv_font_fmt_txt_dsc_t));
+    if (mf == NULL || dsc == NULL) {
+        lv_mem_free(mf);
+        lv_mem_free(dsc);
+        return NULL;
+    }
+    memset(mf, 0, sizeof(mmap_font_t));
+    memset(dsc, 0, sizeof(lv_font_fmt_txt_dsc_t));
+    lv_font_t *font = &mf->font;
+    font->dsc = dsc;
+
+    font->base_line = -header.descent;
+    font->line_height = header.ascent - header.descent;
+    font->get_glyph_dsc = lv_font_get_glyph_dsc_fmt_txt;
+    font->get_glyph_bitmap = lv_font_get_bitmap_fmt_txt;
+    font->subpx = header.subpixels_mode;
+    font->underline_position = header.underline_position;
+    font->underline_thickness = header.underline_thickness;
+    dsc->bpp = header.bits_per_pixel;
+    dsc->kern_scale = header.kerning_scale;
+    dsc->bitmap_format = header.compression_id;
+
+    // 字符映射表 (数据量小，拷贝一份以避免 flash 上的非对齐 16 位访问)
+    uint32_t cmaps_start = head_length;
+    int32_t cmaps_length = mmap_read_label(base, size, cmaps_start, "cmap");
+    if (cmaps_length < 12) {
+        goto fail;
+    }
+    uint32_t cmap_count;
+    memcpy(&cmap_count, base + cmaps_start + 8, sizeof(cmap_count));
+    if (cmap_count == 0 || cmap_count > 511 || 12 + cmap_count * sizeof(cmap_table_bin_t) > (uint32_t)cmaps_length) {
+        goto fail;
+    }
+    lv_font_fmt_txt_cmap_t *cmaps = lv_mem_alloc(cmap_count * sizeof(lv_font_fmt_txt_cmap_t));
+    if (cmaps == NULL) {
+        goto fail;
+    }
+    memset(cmaps, 0, cmap_count * sizeof(lv_font_fmt_txt_cmap_t));
+    dsc->cmaps = cmaps;
+    dsc->cmap_num = cmap_count;
+
+    for (uint32_t i = 0; i < cmap_count; i++) {
+        cmap_table_bin_t table;
+        memcpy(&table, base + cmaps_start + 12 + i * sizeof(cmap_table_bin_t), sizeof(table));
+        // format0 tiny 表没有数据，lv_font_conv 把它的 data_offset 写成段尾，其余格式检查数据范围
+        uint32_t data_size = 0;
+        if (table.format_type == LV_FONT_FMT_TXT_CMAP_FORMAT0_FULL) {
+            data_size = table.data_entries_count;
+        } else if (table.format_type == LV_FONT_FMT_TXT_CMAP_SPARSE_TINY) {
+            data_size = sizeof(uint16_t) * table.data_entries_count;
+        } else if (table.format_type == LV_FONT_FMT_TXT_CMAP_SPARSE_FULL) {
+            data_size = 2 * sizeof(uint16_t) * table.data_entries_count;
+        }
+        if (table.data_offset > (uint32_t)cmaps_length || data_size > (uint32_t)cmaps_length - table.data_offset) {
+            goto fail;
+        }
+        const uint8_t *data = base + cmaps_start + table.data_offset;
+        lv_font_fmt_txt_cmap_t *cmap = &cmaps[i];
+        cmap->range_start = table.range_start;
+        cmap->range_length = table.range_length;
+        cmap->glyph_id_start = table.glyph_id_start;
+        cmap->type = table.format_type;
+
+        switch (table.format_type) {
+            case LV_FONT_FMT_TXT_CMAP_FORMAT0_FULL: {
+                uint8_t *ofs_list = lv_mem_alloc(table.data_entries_count);
+                if (ofs_list == NULL) {
+                    goto fail;
+                }
+                memcpy(ofs_list, data, table.data_entries_count);
+                cmap->glyph_id_ofs_list = ofs_list;
+                cmap->list_length = cmap->range_length;
+                break;
+            }
+            case LV_FONT_FMT_TXT_CMAP_FORMAT0_TINY:
+                break;
+            case LV_FONT_FMT_TXT_CMAP_SPARSE_FULL:
+            case LV_FONT_FMT_TXT_CMAP_SPARSE_TINY: {
+                uint32_t list_size = sizeof(uint16_t) * table.data_entries_count;
+                uint16_t *unicode_list = lv_mem_alloc(list_size);
+                if (unicode_list == NULL) {
+                    goto fail;
+                }
+                memcpy(unicode_list, data, list_size);
+                cmap->unicode_list = unicode_list;
+                cmap->list_length = table.data_entries_count;
+                if (table.format_type == LV_FONT_FMT_TXT_CMAP_SPARSE_FULL) {
+                    uint16_t *ofs_list = lv_mem_alloc(list_size);
+                    if (ofs_list == NULL) {
+                        goto fail;
+                    }
+                    memcpy(ofs_list, data + list_size, list_size);
+                    cmap->glyph_id_ofs_list = ofs_list;
+                }
+                break;
+            }
+            default:
+                goto fail;
+        }
+    }
+
+    // 字形偏移表
+    uint32_t loca_start = cmaps_start + cmaps_length;
+    int32_t loca_length = mmap_read_label(base, size, loca_start, "loca");
+    if (loca_length < 12) {
+        goto fail;
+    }
+    uint32_t loca_count;
+    memcpy(&loca_count, base + loca_start + 8, sizeof(loca_count));
+    uint32_t loca_entry_size = header.index_to_loc_format == 0 ? 2 : 4;
+    if (header.index_to_loc_format > 1 || loca_count == 0 ||
+        12 + loca_count * loca_entry_size > (uint32_t)loca_length) {
+        goto fail;
+    }
+    const uint8_t *loca = base + loca_start + 12;
+
+    // 字形描述：解码位域，点阵索引指向 glyf 段内 (即 flash 映射区)
+    uint32_t glyph_start = loca_start + loca_length;
+    int32_t glyph_length = mmap_read_label(base, size, glyph_start, "glyf");
+    if (glyph_length < 0) {
+        goto fail;
+    }
+    bool lvgl_bitmap = nbits % 8 == 0 && (uint32_t)glyph_length <= GLYPH_BITMAP_INDEX_MAX;
+    if (!lvgl_bitmap && header.compression_id != LV_FONT_FMT_TXT_PLAIN) {
+        ESP_LOGW(TAG, "mmap font: compressed bitmaps need a byte aligned glyph header (%d bits) and glyf under %lu bytes",
+                 nbits, (unsigned long)GLYPH_BITMAP_INDEX_MAX);
+        goto fail;
+    }
+
+    lv_font_fmt_txt_glyph_dsc_t *glyph_dsc = lv_mem_alloc(loca_count * sizeof(lv_font_fmt_txt_glyph_dsc_t));
+    if (glyph_dsc == NULL) {
+        goto fail;
+    }
+    memset(glyph_dsc, 0, loca_count * sizeof(lv_font_fmt_txt_glyph_dsc_t));
+    dsc->glyph_dsc = glyph_dsc;
+    dsc->glyph_bitmap = base + glyph_start;
+
+    uint32_t max_bitmap_bytes = 0;
+    for (uint32_t i = 1; i < loca_count; i++) { // 0 号字形固定为空
+        uint32_t offset = 0;
+        memcpy(&offset, loca + i * loca_entry_size, loca_entry_size);
+        if (offset + (nbits + 7) / 8 > (uint32_t)glyph_length) {
+            goto fail;
+        }
+        bit_reader_t br = {.data = base + glyph_start + offset, .bit_pos = 0};
+        lv_font_fmt_txt_glyph_dsc_t *gdsc = &glyph_dsc[i];
+        gdsc->adv_w = header.advance_width_bits == 0 ? header.default_advance_width
+                                                      : read_bits(&br, header.advance_width_bits);
+        if (header.advance_width_format == 0) {
+            gdsc->adv_w *= 16;
+        }
+        gdsc->ofs_x = read_bits_signed(&br, header.xy_bits);
+        gdsc->ofs_y = read_bits_signed(&br, header.xy_bits);
+        gdsc->box_w = read_bits(&br, header.wh_bits);
+        gdsc->box_h = read_bits(&br, header.wh_bits);
+        gdsc->bitmap_index = lvgl_bitmap ? offset + nbits / 8 : 0;
+
+        // 未压缩的点阵不能越过 glyf 段
+        uint32_t bitmap_bits = (uint32_t)gdsc->box_w * gdsc->box_h * dsc->bpp;
+        uint32_t bitmap_bytes = (bitmap_bits + 7) / 8;
+        if (header.compression_id == LV_FONT_FMT_TXT_PLAIN &&
+            (uint64_t)offset * 8 + nbits + bitmap_bits > (uint64_t)glyph_length * 8) {
+            goto fail;
+        }
+        if (bitmap_bytes > max_bitmap_bytes) {
+            max_bitmap_bytes = bitmap_bytes;
+        }
+    }
+
+    if (!lvgl_bitmap) {
+        mf->loca = loca;
+        mf->loca_entry_size = loca_entry_size;
+        mf->loca_count = loca_count;
+        mf->glyf = base + glyph_start;
+        mf->glyf_end = mf->glyf + glyph_length;
+        mf->header_bits = nbits;
+        if (nbits % 8 != 0) {
+            mf->bitmap_buf = lv_mem_alloc(max_bitmap_bytes > 0 ? max_bitmap_bytes : 1);
+            if (mf->bitmap_buf == NULL) {
+                goto fail;
+            }
+        }
+        dsc->glyph_bitmap = NULL;
+        font->get_glyph_bitmap = font_mmap_get_bitmap;
+    }
+
+    if (header.tables_count >= 4) {
+        ESP_LOGW(TAG, "mmap font: kerning table ignored");
+    }
+    dsc->kern_dsc = NULL;
+    dsc->kern_classes = 0;
+
+    ESP_LOGI(TAG, "mmap font: %lu glyphs, %u bpp, line height %d, glyph data %ld bytes in flash, %d-bit glyph header%s",
+             (unsigned long)loca_count, (unsigned)dsc->bpp, font->line_height, (long)glyph_length, nbits,
+             lvgl_bitmap ? "" : " (bitmaps read through loca)");
+    return font;
+
+fail:
+    ESP_LOGW(TAG, "mmap font: failed to parse font partition");
+    font_mmap_free(font);
+    return NULL;
+}
+
+// ==================== 字形缓存实现 ====================
+
+// 点阵字节数 (压缩字体解压后 3bpp 按 4bpp 存放)
+static uint32_t glyph_bitmap_size(const lv_font_t *font, uint16_t box_w, uint16_t box_h) {
+    const lv_font_fmt_txt_dsc_t *fdsc = (const lv_font_fmt_txt_dsc_t *)font->dsc;
+    uint32_t bpp = fdsc->bpp;
+    if (fdsc->bitmap_format != LV_FONT_FMT_TXT_PLAIN && bpp == 3) {
+        bpp = 4;
+    }
+    return ((uint32_t)box_w * box_h * bpp + 7) / 8;
+}
+
+static void glyph_cache_lru_unlink(uint16_t idx) {
+    glyph_cache_entry_t *e = &s_cache_entries[idx];
+    if (e->lru_prev != GLYPH_CACHE_NIL) {
+        s_cache_entries[e->lru_prev].lru_next = e->lru_next;
+    } else {
+        s_lru_head = e->lru_next;
+    }
+    if (e->lru_next != GLYPH_CACHE_NIL) {
+        s_cache_entries[e->lru_next].lru_prev = e->lru_prev;
+    } else {
+        s_lru_tail = e->lru_prev;
+    }
+}
+
+static void glyph_cache_lru_push_front(uint16_t idx) {
+    glyph_cache_entry_t *e = &s_cache_entries[idx];
+    e->lru_prev = GLYPH_CACHE_NIL;
+    e->lru_next = s_lru_head;
+    if (s_lru_head != GLYPH_CACHE_NIL) {
+        s_cache_entries[s_lru_head].lru_prev = idx;
+    }
+    s_lru_head = idx;
+    if (s_lru_tail == GLYPH_CACHE_NIL) {
+        s_lru_tail = idx;
+    }
+}
+
+static void glyph_cache_hash_remove(uint16_t idx) {
+    uint16_t *link = &s_cache_buckets[s_cache_entries[idx].letter & (GLYPH_CACHE_BUCKETS - 1)];
+    while (*link != GLYPH_CACHE_NIL) {
+        if (*link == idx) {
+            *link = s_cache_entries[idx].hash_next;
+            return;
+        }
+        link = &s_cache_entries[*link].hash_next;
+    }
+}
+
+static glyph_bitmap_getter_t glyph_cache_orig_getter(const lv_font_t *font) {
+    for (uint32_t i = 0; i < s_cache_font_count; i++) {
+        if (s_cache_fonts[i].font == font) {
+            return s_cache_fonts[i].get_bitmap;
+        }
+    }
+    return NULL;
+}
+
+// 替换字体的 get_glyph_bitmap：命中直接返回 PSRAM 中的点阵，未命中从字体取出后拷贝进缓存
+static const uint8_t *cached_get_glyph_bitmap(const lv_font_t *font, uint32_t letter) {
+    uint16_t *bucket = &s_cache_buckets[letter & (GLYPH_CACHE_BUCKETS - 1)];
+    for (uint16_t idx = *bucket; idx != GLYPH_CACHE_NIL; idx = s_cache_entries[idx].hash_next) {
+        if (s_cache_entries[idx].letter == letter && s_cache_entries[idx].font == font) {
+            s_cache_stats.hits++;
+            if (idx != s_lru_head) {
+                glyph_cache_lru_unlink(idx);
+                glyph_cache_lru_push_front(idx);
+            }
+            return s_cache_entries[idx].bitmap;
+        }
+    }
+
+    s_cache_stats.misses++;
+    glyph_bitmap_getter_t get_bitmap = glyph_cache_orig_getter(font);
+    if (get_bitmap == NULL) {
+        return NULL;
+    }
+    const uint8_t *src = get_bitmap(font, letter);
+    if (src == NULL) {
+        return NULL;
+    }
+
+    lv_font_glyph_dsc_t g;
+    if (!font->get_glyph_dsc(font, &g, letter, 0)) {
+        return src;
+    }
+    uint32_t bmp_size = glyph_bitmap_size(font, g.box_w, g.box_h);
+    if (bmp_size == 0 || bmp_size > s_cache_stats.slot_size) {
+        s_cache_stats.bypass++;
+        return src;
+    }
+
+    uint16_t idx;
+    if (s_cache_stats.entries < s_cache_stats.capacity) {
+        idx = (uint16_t)s_cache_stats.entries++;
+        s_cache_entries[idx].bitmap = s_cache_pool + (uint32_t)idx * s_cache_stats.slot_size;
+    } else {
+        idx = s_lru_tail;
+        glyph_cache_lru_unlink(idx);
+        glyph_cache_hash_remove(idx);
+        s_cache_stats.evictions++;
+    }
+
+    glyph_cache_entry_t *e = &s_cache_entries[idx];
+    e->font = font;
+    e->letter = letter;
+    memcpy(e->bitmap, src, bmp_size);
+    e->hash_next = *bucket;
+    *bucket = idx;
+    glyph_cache_lru_push_front(idx);
+    return e->bitmap;
+}
+
+// 记下字体原来的取点阵函数并换成缓存版本
+static void glyph_cache_hook(lv_font_t *font) {
+    if (s_cache_font_count >= GLYPH_CACHE_MAX_FONTS) {
+        ESP_LOGW(TAG, "Glyph cache font table full, font not cached");
+        return;
+    }
+    s_cache_fonts[s_cache_font_count].font = font;
+    s_cache_fonts[s_cache_font_count].get_bitmap = font->get_glyph_bitmap;
+    s_cache_font_count++;
+    font->get_glyph_bitmap = cached_get_glyph_bitmap;
+}
+
+// 为字体挂上字形缓存，只支持 lv_font_fmt_txt 格式
+static void glyph_cache_attach(lv_font_t *font) {
+    if (FONT_GLYPH_CACHE_ENTRIES <= 0 || FONT_GLYPH_CACHE_ENTRIES >= GLYPH_CACHE_NIL ||
+        (font->get_glyph_bitmap != lv_font_get_bitmap_fmt_txt && font->get_glyph_bitmap != font_mmap_get_bitmap)) {
+        return;
+    }
+
+    // 缓存已经建立：子集字体和回退字体共用槽位，各自的取点阵函数和条目按字体区分
+    if (s_cache_entries != NULL) {
+        glyph_cache_hook(font);
+        return;
+    }
+
+    // 每个槽按行高的正方形点阵预留空间，超出的字形直接绕过缓存
+    lv_coord_t side = font->line_height + 2;
+    uint32_t slot_size = (glyph_bitmap_size(font, side, side) + 3) & ~3UL;
+
+    s_cache_entries = heap_caps_malloc(FONT_GLYPH_CACHE_ENTRIES * sizeof(glyph_cache_entry_t), MALLOC_CAP_SPIRAM);
+    s_cache_pool = heap_caps_malloc(FONT_GLYPH_CACHE_ENTRIES * slot_size, MALLOC_CAP_SPIRAM);
+    if (s_cache_entries == NULL || s_cache_pool == NULL) {
+        ESP_LOGW(TAG, "Failed to allocate glyph cache, running without it");
+        heap_caps_free(s_cache_entries);
+        heap_caps_free(s_cache_pool);
+        s_cache_entries = NULL;
+        s_cache_pool = NULL;
+        return;
+    }
+
+    memset(s_cache_buckets, 0xFF, sizeof(s_cache_buckets));
+    s_lru_head = GLYPH_CACHE_NIL;
+    s_lru_tail = GLYPH_CACHE_NIL;
+    memset(&s_cache_stats, 0, sizeof(s_cache_stats));
+    s_cache_stats.capacity = FONT_GLYPH_CACHE_ENTRIES;
+    s_cache_stats.slot_size = slot_size;
+
+    glyph_cache_hook(font);
+
+    ESP_LOGI(TAG, "Glyph cache: %d entries x %lu bytes in PSRAM", FONT_GLYPH_CACHE_ENTRIES,
+             (unsigned long)slot_size);
+}
+
+// 加载 font 分区中的完整字体
+static lv_font_t *font_load_partition(void) {
     const esp_partition_t *font_partition = esp_partition_find_first(0x40, 0, "font");
     if (font_partition == NULL) {
         ESP_LOGE(TAG, "Font partition 'font' not found!");
-        return;
+        return NULL;
     }
     
     font_partition_size = font_partition->size;
@@ -94,8 +713,18 @@ void font_init(void) {
     esp_err_t err = esp_partition_mmap(font_partition, 0, font_partition->size, SPI_FLASH_MMAP_DATA, &mmap_ptr, &mmap_handle);
     if (err != ESP_OK || mmap_ptr == NULL) {
         ESP_LOGE(TAG, "Failed to mmap font partition: %s", esp_err_to_name(err));
-        return;
+        return NULL;
+    }
+
+    lv_font_t *font = NULL;
+#if FONT_LOAD_MMAP_DIRECT
+    font = font_load_mmap((const uint8_t *)mmap_ptr, font_partition_size);
+    if (font) {
+        ESP_LOGI(TAG, "Font mapped directly from partition!");
+        return font;
     }
+    ESP_LOGW(TAG, "Falling back to lv_font_load");
+#endif
 
     static lv_fs_drv_t drv;
     lv_fs_drv_init(&drv);
@@ -108,13 +737,41 @@ void font_init(void) {
     drv.tell_cb = mmap_tell;
     lv_fs_drv_register(&drv);
     
-    font_cn = lv_font_load("P:font.bin");
+    font = lv_font_load("P:font.bin");
     
-    if (font_cn) {
+    if (font) {
         ESP_LOGI(TAG, "Font loaded successfully from partition!");
     } else {
         ESP_LOGE(TAG, "Failed to load font from partition.");
     }
+    return font;
+}
+
+void font_init(void) {
+    lv_font_t *partition_font = font_load_partition();
+    font_cn = partition_font;
+
+#if FONT_SUBSET_EMBEDDED
+    // 构建时由 others/font_tools/font_subset.py 生成，只包含UI字符串中用到的字形，
+    // 字形头按字节对齐，可以直接从 flash 映射使用；其余字符回退到分区中的完整字体
+    size_t subset_size = _binary_font_subset_bin_end - _binary_font_subset_bin_start;
+    lv_font_t *subset = font_load_mmap(_binary_font_subset_bin_start, subset_size);
+    if (subset) {
+        subset->fallback = partition_font;
+        font_cn = subset;
+        ESP_LOGI(TAG, "UI font subset loaded (%u bytes), partition font %s", (unsigned)subset_size,
+                 partition_font ? "used as fallback" : "unavailable");
+    } else {
+        ESP_LOGW(TAG, "Failed to load embedded font subset, using partition font");
+    }
+#endif
+
+    if (font_cn) {
+        glyph_cache_attach(font_cn);
+    }
+    if (partition_font && partition_font != font_cn) {
+        glyph_cache_attach(partition_font);
+    }
 }
 
 bool is_font_loaded(void) {
@@ -124,3 +781,16 @@ bool is_font_loaded(void) {
 lv_font_t *get_loaded_font(void) {
     return font_cn;
 }
+
+void font_get_glyph_cache_stats(font_glyph_cache_stats_t *stats) {
+    if (stats) {
+        *stats = s_cache_stats;
+    }
+}
+
+void font_reset_glyph_cache_stats(void) {
+    s_cache_stats.hits = 0;
+    s_cache_stats.misses = 0;
+    s_cache_stats.evictions = 0;
+    s_cache_stats.bypass = 0;
+}
@@ -12,6 +12,28 @@
 
 #include "lvgl.h"
 #include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * 字体加载方式:
+ * 1 - 直接解析 mmap 的字体分区，字形点阵从 flash 映射区读取，不拷贝整个字体 (字形头不按字节对齐时逐字形移位，
+ *     解析失败自动回退到 lv_font_load；others/font_tools/font_mmap_check.py 可在主机上检查字体能否直接映射)
+ * 0 - 通过 lv_fs 驱动调用 lv_font_load，把整个字体拷贝到 PSRAM
+ */
+#define FONT_LOAD_MMAP_DIRECT 1
+
+/* 字形点阵 LRU 缓存 (PSRAM)，条目数为 0 时关闭缓存 */
+#define FONT_GLYPH_CACHE_ENTRIES 256
+
+typedef struct {
+    uint32_t hits;      // 命中次数
+    uint32_t misses;    // 未命中次数
+    uint32_t evictions; // 淘汰次数
+    uint32_t bypass;    // 点阵超过缓存槽大小而未缓存的次数
+    uint32_t entries;   // 当前缓存的字形数
+    uint32_t capacity;  // 缓存容量
+    uint32_t slot_size; // 每个缓存槽字节数
+} font_glyph_cache_stats_t;
 
 extern const lv_font_t Mysymbol;
 extern lv_font_t* font_cn;
@@ -45,4 +67,14 @@ bool is_font_loaded(void);
  */
 lv_font_t* get_loaded_font(void);
 
+/**
+ * @brief 获取字形缓存统计
+ */
+void font_get_glyph_cache_stats(font_glyph_cache_stats_t* stats);
+
+/**
+ * @brief 清零字形缓存命中/未命中计数
+ */
+void font_reset_glyph_cache_stats(void);
+
 #endif // MY_FONT_H
\ No newline at end of file
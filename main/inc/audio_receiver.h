@@ -12,7 +12,20 @@ extern "C" {
 #endif
 
 #include "esp_err.h"
+#include "audio_jitter_buffer.h"
+#include "audio_codec.h"
 #include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    audio_jb_stats_t jb;       // 抖动缓冲统计
+    uint32_t latency_ms;       // 端到端播放延迟估计：缓冲深度 + 当前帧 + I2S DMA队列
+    uint64_t bytes_received;   // 本次连接线上收到的字节数
+    uint64_t pcm_samples;      // 本次连接解码出的样本数，与 bytes_received 之比即压缩率
+    uint64_t decode_us;        // 本次连接的解码耗时
+    audio_codec_t codec;       // 流头协商的编码，无流头时为PCM16
+    bool receiving;            // 是否有连接在发送
+} audio_receiver_stats_t;
 
 /**
  * @brief 启动音频接收服务
@@ -31,6 +44,18 @@ void audio_receiver_stop(void);
  */
 bool audio_receiver_is_receiving(void);
 
+/**
+ * @brief 设置抖动缓冲目标延迟，运行中立即生效，也作为自适应目标的下限
+ * @param target_ms 目标延迟，超出 [AUDIO_JB_MIN_TARGET_MS, AUDIO_JB_MAX_TARGET_MS] 时截断
+ */
+void audio_receiver_set_target_latency_ms(uint32_t target_ms);
+
+/**
+ * @brief 获取播放延迟和欠载统计，统计在每次新连接时清零
+ * @param out 输出
+ */
+void audio_receiver_get_stats(audio_receiver_stats_t* out);
+
 #ifdef __cplusplus
 }
 #endif
@@ -19,9 +19,13 @@
 #include "freertos/task.h"
 
 #include "esp_heap_caps.h"
+#include "heap_tracer.h"
+#include "jpeg_stream_encoder.h"
 #include "led_status_manager.h"
 #include "spi_slave_receiver.h"
+#include "task_placement.h"
 #include "usb_device_receiver.h"
+#include "video_output.h"
 #include "wifi_pairing_manager.h"
 #include "task.h"
 
@@ -42,11 +46,17 @@ void app_main(void) {
         return;
     }
 
+    // 读取任务布局方案，之后创建的任务都按该方案分核
+    task_placement_load_profile();
+
+    // 内部RAM/PSRAM碎片化趋势采样，分配跟踪用 heaptrace 命令按需开启
+    heap_tracer_init();
+
     log_heap_info("Initial");
 
-    // 初始化LED管理器
+    // 初始化LED管理器（任务优先级和栈使用任务布局表）
     led_manager_config_t led_manager_config = {
-        .led_count = 1, .queue_size = 1, .task_priority = 2, .task_stack_size = 2048};
+        .led_count = 1, .queue_size = 1, .task_priority = 0, .task_stack_size = 0};
     if (led_status_manager_init(&led_manager_config) == ESP_OK) {
         led_status_set_style(LED_STYLE_RED_SOLID, LED_PRIORITY_LOW, 0);
         log_heap_info("After LED Manager Init");
@@ -54,6 +64,11 @@ void app_main(void) {
         ESP_LOGE(TAG, "Failed to initialize LED Status Manager");
     }
 
+    // 编码后的JPEG帧通过 UDP/TCP/USB 输出
+    if (video_output_init() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize video output");
+    }
+
     // 初始化 SPI 从机并启动接收任务
     if (spi_receiver_init() == ESP_OK) {
         spi_receiver_start();
@@ -77,8 +92,8 @@ void app_main(void) {
     // 初始化WiFi配对管理器
     wifi_pairing_config_t wifi_config = {
         .scan_interval_ms = 1000,
-        .task_priority = 3,
-        .task_stack_size = 4096,
+        .task_priority = 0,   // 使用任务布局表
+        .task_stack_size = 0, // 使用任务布局表
         .connection_timeout_ms = 10000,
         .target_ssid_prefix = "tidy_",
         .default_password = "22989822",
@@ -95,6 +110,25 @@ void app_main(void) {
     while (1) {
         ESP_LOGI(TAG, "Receiver running, free heap: %lu bytes",
                  (unsigned long)esp_get_free_heap_size());
+        // 记录各任务栈的历史最小剩余，用 stacks 命令查看推荐栈大小
+        task_placement_sample_stacks();
+        jpeg_stream_stats_t jpeg_stats;
+        jpeg_stream_encoder_get_stats(&jpeg_stats);
+        ESP_LOGI(TAG, "Pixel stream: %lu encoded, %lu dropped, %lu crc errors, %lu blocks skipped, %lu format mismatch",
+                 (unsigned long)jpeg_stats.frames_encoded, (unsigned long)jpeg_stats.frames_dropped,
+                 (unsigned long)jpeg_stats.crc_errors, (unsigned long)jpeg_stats.blocks_skipped,
+                 (unsigned long)jpeg_stats.format_mismatch);
+        spi_rx_stats_t spi_stats;
+        spi_receiver_get_stats(&spi_stats);
+        ESP_LOGI(TAG, "SPI rx: %lu trans, %lu queue empty, %lu truncated, %lu underruns, %lu feed drops, min queued %lu",
+                 (unsigned long)spi_stats.transactions, (unsigned long)spi_stats.queue_empty_events,
+                 (unsigned long)spi_stats.truncated, (unsigned long)spi_stats.underruns,
+                 (unsigned long)spi_stats.feed_drops, (unsigned long)spi_stats.min_queued);
+        // 拼帧等待占比高说明编码跟不上，编码占用低且拼帧不等待说明瓶颈在 SPI 输入
+        jpeg_pipeline_util_t util;
+        jpeg_stream_encoder_get_pipeline_util(&util);
+        ESP_LOGI(TAG, "JPEG pipeline (%lu ms): feed %.1f%%, feed stall %.1f%%, encode %.1f%%",
+                 (unsigned long)util.window_ms, util.feed_busy_pct, util.feed_stall_pct, util.encode_busy_pct);
         vTaskDelay(pdMS_TO_TICKS(30000));
     }
 }
@@ -113,13 +147,17 @@ void app_main(void) {
 #include "freertos/task.h"
 
 // 项目组件头文件
+#include "boot_profiler.h"
 #include "task_init.h"
 
 static const char* TAG = "MAIN";
 
 extern esp_err_t components_init(void);
 
+#define BOOT_INTERACTIVE_TIMEOUT_MS 15000 // 等待主菜单显示的最长时间（包含开机动画）
+
 void app_main(void) {
+    boot_profiler_mark("app_main");
 
     // 初始化所有组件
     esp_err_t ret = components_init();
@@ -129,14 +167,21 @@ void app_main(void) {
     }
 
     // 初始化任务管理
+    int prof = boot_profiler_begin("init_all_tasks");
     ret = init_all_tasks();
+    boot_profiler_end(prof, ret);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize tasks: %s", esp_err_to_name(ret));
         return;
     }
 
+    // 等主菜单显示后打印启动时间线，并与历史启动时间比较
+    if (!boot_profiler_wait_interactive(BOOT_INTERACTIVE_TIMEOUT_MS)) {
+        ESP_LOGW(TAG, "Main menu not shown within %d ms", BOOT_INTERACTIVE_TIMEOUT_MS);
+    }
+    boot_profiler_report();
+
     // 显示当前运行的任务
-    vTaskDelay(pdMS_TO_TICKS(1000)); // 等待任务启动
     list_running_tasks();
 
     // 主任务进入轻量级监控循环
@@ -6,16 +6,14 @@
 // 项目本地头文件  
 #include "task_init.h"
 #include "background_manager.h"
-#include "lsm6ds_control.h" 
+#include "heap_tracer.h"
 #include "joystick_adc.h"
 #include "lvgl_main.h"
 #include "power_management.h"
+#include "service_lifecycle.h"
+#include "task_placement.h"
+#include "task_profiler.h"
 #include "wifi_manager.h"
-#include "serial_display.h"
-
-// 声明音频接收函数
-extern esp_err_t audio_receiver_start(void);
-extern void audio_receiver_stop(void);
 
 static const char* TAG = "TASK_INIT";
 
@@ -26,8 +24,6 @@ static TaskHandle_t s_monitor_task_handle = NULL;
 static TaskHandle_t s_battery_task_handle = NULL;
 static TaskHandle_t s_joystick_task_handle = NULL;
 static TaskHandle_t s_wifi_task_handle = NULL;
-static TaskHandle_t s_audio_receiver_task_handle = NULL;
-static TaskHandle_t s_serial_display_task_handle = NULL;
 
 // 摇杆ADC采样任务（200Hz）
 static void joystick_adc_task(void* pvParameters) {
@@ -92,6 +88,8 @@ static void wifi_manager_task(void* pvParameters) {
     esp_err_t ret = wifi_manager_init(NULL);
     if (ret == ESP_OK) {
         ESP_LOGI(TAG, "WiFi manager initialized");
+        // 协议栈已就绪，可以启动网络服务
+        service_lifecycle_notify_network_ready();
         ret = wifi_manager_start();
         if (ret != ESP_OK) {
             ESP_LOGW(TAG, "WiFi start failed: %s", esp_err_to_name(ret));
@@ -142,21 +140,14 @@ esp_err_t init_lvgl_task(void) {
         return ESP_OK;
     }
 
-    BaseType_t result = xTaskCreatePinnedToCore(lvgl_main_task,      // 任务函数
-                                                "LVGL_Main",         // 任务名称
-                                                TASK_STACK_LARGE,    // 堆栈大小 (8KB)
-                                                NULL,                // 参数
-                                                TASK_PRIORITY_HIGH,  // 高优先级
-                                                &s_lvgl_task_handle, // 任务句柄
-                                                1                    // 绑定到Core 1 (用户核心)
-    );
+    BaseType_t result = task_placement_create(lvgl_main_task, "LVGL_Main", NULL, &s_lvgl_task_handle);
 
     if (result != pdPASS) {
         ESP_LOGE(TAG, "Failed to create LVGL task");
         return ESP_ERR_NO_MEM;
     }
 
-    ESP_LOGI(TAG, "LVGL task created successfully on Core 1");
+    ESP_LOGI(TAG, "LVGL task created successfully");
     return ESP_OK;
 }
 
@@ -166,20 +157,14 @@ esp_err_t init_joystick_adc_task(void) {
         return ESP_OK;
     }
 
-    BaseType_t result = xTaskCreatePinnedToCore(joystick_adc_task,       // 任务函数
-                                                "Joystick_ADC",          // 任务名称
-                                                TASK_STACK_MEDIUM,       // 堆栈大小 (4KB，避免栈溢出)
-                                                NULL,                    // 参数
-                                                TASK_PRIORITY_NORMAL,    // 普通优先级
-                                                &s_joystick_task_handle, // 任务句柄
-                                                0);                      // 绑定到Core 0
+    BaseType_t result = task_placement_create(joystick_adc_task, "Joystick_ADC", NULL, &s_joystick_task_handle);
 
     if (result != pdPASS) {
         ESP_LOGE(TAG, "Failed to create Joystick ADC task");
         return ESP_ERR_NO_MEM;
     }
 
-    ESP_LOGI(TAG, "Joystick ADC task created successfully on Core 0");
+    ESP_LOGI(TAG, "Joystick ADC task created successfully");
     return ESP_OK;
 }
 
@@ -189,21 +174,14 @@ esp_err_t init_power_management_task(void) {
         return ESP_OK;
     }
 
-    BaseType_t result = xTaskCreatePinnedToCore(power_management_task, // 任务函数
-                                                "Power_Mgmt",          // 任务名称
-                                                TASK_STACK_MEDIUM,     // 堆栈大小 (4KB)
-                                                NULL,                  // 参数
-                                                TASK_PRIORITY_LOW,     // 低优先级
-                                                &s_power_task_handle,  // 任务句柄
-                                                0                      // 绑定到Core 0 (系统核心)
-    );
+    BaseType_t result = task_placement_create(power_management_task, "Power_Mgmt", NULL, &s_power_task_handle);
 
     if (result != pdPASS) {
         ESP_LOGE(TAG, "Failed to create power management task");
         return ESP_ERR_NO_MEM;
     }
 
-    ESP_LOGI(TAG, "Power management task created successfully on Core 0");
+    ESP_LOGI(TAG, "Power management task created successfully");
     return ESP_OK;
 }
 
@@ -213,21 +191,14 @@ esp_err_t init_system_monitor_task(void) {
         return ESP_OK;
     }
 
-    BaseType_t result = xTaskCreatePinnedToCore(system_monitor_task,    // 任务函数
-                                                "Sys_Monitor",          // 任务名称
-                                                TASK_STACK_SMALL,       // 堆栈大小 (2KB)
-                                                NULL,                   // 参数
-                                                TASK_PRIORITY_LOW,      // 低优先级
-                                                &s_monitor_task_handle, // 任务句柄
-                                                0                       // 绑定到Core 0
-    );
+    BaseType_t result = task_placement_create(system_monitor_task, "Sys_Monitor", NULL, &s_monitor_task_handle);
 
     if (result != pdPASS) {
         ESP_LOGE(TAG, "Failed to create system monitor task");
         return ESP_ERR_NO_MEM;
     }
 
-    ESP_LOGI(TAG, "System monitor task created successfully on Core 0");
+    ESP_LOGI(TAG, "System monitor task created successfully");
     return ESP_OK;
 }
 
@@ -237,21 +208,14 @@ esp_err_t init_wifi_manager_task(void) {
         return ESP_OK;
     }
 
-    BaseType_t result = xTaskCreatePinnedToCore(wifi_manager_task,    // 任务函数
-                                                "WiFi_Manager",       // 任务名称
-                                                TASK_STACK_MEDIUM,    // 堆栈大小 (4KB)
-                                                NULL,                 // 参数
-                                                TASK_PRIORITY_NORMAL, // 普通优先级
-                                                &s_wifi_task_handle,  // 任务句柄
-                                                0                     // 绑定到Core 0
-    );
+    BaseType_t result = task_placement_create(wifi_manager_task, "WiFi_Manager", NULL, &s_wifi_task_handle);
 
     if (result != pdPASS) {
         ESP_LOGE(TAG, "Failed to create WiFi manager task");
         return ESP_ERR_NO_MEM;
     }
 
-    ESP_LOGI(TAG, "WiFi manager task created successfully on Core 0");
+    ESP_LOGI(TAG, "WiFi manager task created successfully");
     return ESP_OK;
 }
 
@@ -261,132 +225,41 @@ esp_err_t init_battery_monitor_task(void) {
         return ESP_OK;
     }
 
-    BaseType_t result = xTaskCreatePinnedToCore(battery_monitor_task,   // 任务函数
-                                                "Battery_Monitor",      // 任务名称
-                                                TASK_STACK_MEDIUM,      // 堆栈大小 (4KB)
-                                                NULL,                   // 参数
-                                                TASK_PRIORITY_LOW,      // 低优先级
-                                                &s_battery_task_handle, // 任务句柄
-                                                0                       // 绑定到Core 0
-    );
+    BaseType_t result = task_placement_create(battery_monitor_task, "Battery_Monitor", NULL, &s_battery_task_handle);
 
     if (result != pdPASS) {
         ESP_LOGE(TAG, "Failed to create battery monitor task");
         return ESP_ERR_NO_MEM;
     }
 
-    ESP_LOGI(TAG, "Battery monitor task created successfully on Core 0");
+    ESP_LOGI(TAG, "Battery monitor task created successfully");
     return ESP_OK;
 }
 
-// 音频接收任务包装
-static void audio_receiver_task(void* pvParameters) {
-    ESP_LOGI(TAG, "Audio Receiver Task started on core %d", xPortGetCoreID());
-    
-    // 等待WiFi连接
-    vTaskDelay(pdMS_TO_TICKS(5000));
-    
-    esp_err_t ret = audio_receiver_start();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to start audio receiver: %s", esp_err_to_name(ret));
-    } else {
-        ESP_LOGI(TAG, "Audio receiver started successfully on TCP port 7557");
-    }
-    
-    // 任务保持运行，监控音频接收状态
-    while (1) {
-        vTaskDelay(pdMS_TO_TICKS(30000)); // 30秒检查一次
-        ESP_LOGI(TAG, "Audio receiver running normally");
-    }
-}
-
-// 串口显示任务包装
-static void serial_display_task(void* pvParameters) {
-    ESP_LOGI(TAG, "Serial Display Task started on core %d", xPortGetCoreID());
-    
-    // 等待WiFi连接
-    vTaskDelay(pdMS_TO_TICKS(5000));
-    
-    esp_err_t ret = serial_display_init();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to init serial display: %s", esp_err_to_name(ret));
-        vTaskDelete(NULL);
-        return;
-    }
-    
-    if (!serial_display_start(8080)) {
-        ESP_LOGE(TAG, "Failed to start serial display server on port 8080");
-        vTaskDelete(NULL);
-        return;
-    }
-    
-    ESP_LOGI(TAG, "Serial display server started successfully on TCP port 8080");
-    
-    // 任务保持运行，监控串口显示状态
-    while (1) {
-        vTaskDelay(pdMS_TO_TICKS(30000)); // 30秒检查一次
-        if (serial_display_is_running()) {
-            ESP_LOGI(TAG, "Serial display server running normally");
-        } else {
-            ESP_LOGW(TAG, "Serial display server stopped, attempting restart");
-            serial_display_start(8080);
-        }
-    }
-}
-
-esp_err_t init_audio_receiver_task(void) {
-    if (s_audio_receiver_task_handle != NULL) {
-        ESP_LOGW(TAG, "Audio receiver task already running");
-        return ESP_OK;
-    }
+esp_err_t init_all_tasks(void) {
+    ESP_LOGI(TAG, "Initializing all tasks...");
 
-    BaseType_t result = xTaskCreatePinnedToCore(audio_receiver_task,            // 任务函数
-                                                "Audio_Receiver",               // 任务名称
-                                                TASK_STACK_LARGE,               // 堆栈大小 (8KB)
-                                                NULL,                           // 参数
-                                                TASK_PRIORITY_NORMAL,           // 普通优先级
-                                                &s_audio_receiver_task_handle,  // 任务句柄
-                                                1                               // 绑定到Core 1
-    );
+    esp_err_t ret;
 
-    if (result != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create audio receiver task");
-        return ESP_ERR_NO_MEM;
-    }
+    // 读取任务布局方案，之后创建的任务都按该方案分核
+    task_placement_load_profile();
 
-    ESP_LOGI(TAG, "Audio receiver task created successfully on Core 1");
-    return ESP_OK;
-}
+    // 内部RAM/PSRAM碎片化趋势采样，分配跟踪在测试页面按需开启
+    heap_tracer_init();
 
-esp_err_t init_serial_display_task(void) {
-    if (s_serial_display_task_handle != NULL) {
-        ESP_LOGW(TAG, "Serial display task already running");
-        return ESP_OK;
+    // 后台服务（音频、串口显示、遥测、姿态）由生命周期管理器按界面按需启动，
+    // 需在LVGL显示主菜单之前就绪
+    ret = service_lifecycle_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to init service lifecycle manager");
+        return ret;
     }
 
-    BaseType_t result = xTaskCreatePinnedToCore(serial_display_task,            // 任务函数
-                                                "Serial_Display",               // 任务名称
-                                                TASK_STACK_MEDIUM,              // 堆栈大小 (4KB)
-                                                NULL,                           // 参数
-                                                TASK_PRIORITY_NORMAL,           // 普通优先级
-                                                &s_serial_display_task_handle,  // 任务句柄
-                                                0                               // 绑定到Core 0
-    );
-
-    if (result != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create serial display task");
-        return ESP_ERR_NO_MEM;
+    // 任务运行统计采样（调试浮层和遥测统计帧的数据源），失败不影响其他功能
+    if (task_profiler_start(TASK_PROFILER_DEFAULT_PERIOD_MS) != ESP_OK) {
+        ESP_LOGW(TAG, "Task profiler not started");
     }
 
-    ESP_LOGI(TAG, "Serial display task created successfully on Core 0");
-    return ESP_OK;
-}
-
-esp_err_t init_all_tasks(void) {
-    ESP_LOGI(TAG, "Initializing all tasks...");
-
-    esp_err_t ret;
-
     // 初始化LVGL任务
     ret = init_lvgl_task();
     if (ret != ESP_OK) {
@@ -429,26 +302,6 @@ esp_err_t init_all_tasks(void) {
         return ret;
     }
 
-    ret = init_lsm6ds3_control_task();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to init LSM6DS3 control task");
-        return ret;
-    }
-
-    // 初始化音频接收任务（后台服务）
-    ret = init_audio_receiver_task();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to init audio receiver task");
-        return ret;
-    }
-
-    // 初始化串口显示任务（后台服务）
-    ret = init_serial_display_task();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to init serial display task");
-        return ret;
-    }
-
     ESP_LOGI(TAG, "All tasks initialized successfully");
     return ESP_OK;
 }
@@ -497,26 +350,9 @@ esp_err_t stop_all_tasks(void) {
         ESP_LOGI(TAG, "WiFi manager task stopped");
     }
 
-    if (s_audio_receiver_task_handle) {
-        audio_receiver_stop(); // 先停止音频接收服务
-        vTaskDelete(s_audio_receiver_task_handle);
-        s_audio_receiver_task_handle = NULL;
-        ESP_LOGI(TAG, "Audio receiver task stopped");
-    }
-
-    if (s_serial_display_task_handle) {
-        serial_display_stop(); // 先停止串口显示服务
-        vTaskDelete(s_serial_display_task_handle);
-        s_serial_display_task_handle = NULL;
-        ESP_LOGI(TAG, "Serial display task stopped");
-    }
-
-    if (s_lsm6ds3_control_task != NULL)
-    {
-        vTaskDelete(s_lsm6ds3_control_task);
-        s_lsm6ds3_control_task = NULL;
-        ESP_LOGI(TAG, "LSM6DS3 control task stopped");
-    }
+    // 后台服务由各自的停止接口退出任务并释放资源
+    service_lifecycle_park_all();
+    ESP_LOGI(TAG, "Background services parked");
 
     ESP_LOGI(TAG, "All tasks stopped");
     return ESP_OK;
@@ -530,9 +366,15 @@ void list_running_tasks(void) {
     ESP_LOGI(TAG, "Joystick Task: %s", s_joystick_task_handle ? "Running" : "Stopped");
     ESP_LOGI(TAG, "Battery Task: %s", s_battery_task_handle ? "Running" : "Stopped");
     ESP_LOGI(TAG, "WiFi Task: %s", s_wifi_task_handle ? "Running" : "Stopped");
-    ESP_LOGI(TAG, "Audio Receiver Task: %s", s_audio_receiver_task_handle ? "Running" : "Stopped");
-    ESP_LOGI(TAG, "Serial Display Task: %s", s_serial_display_task_handle ? "Running" : "Stopped");
     ESP_LOGI(TAG, "==================");
+    service_lifecycle_log_report();
+    task_profiler_log_report();
+    task_placement_log();
+    task_placement_log_stacks();
+    heap_tracer_dump_trend(NULL, NULL, 10);
+    if (heap_tracer_is_running()) {
+        heap_tracer_dump(NULL, NULL, 16);
+    }
 }
 
 // 任务句柄获取函数
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""
+字体直接映射检查
+按固件 font_load_mmap() (main/fonts/font_init.c) 的规则检查 LVGL 二进制字体，确认烧录到 font 分区
+或嵌入固件的字体能走直接映射路径，而不是在开机时回退到 lv_font_load 把整个字体拷贝到 PSRAM。
+规则改动时两边需要同步修改。
+
+用法:
+    python font_mmap_check.py font/font_noto_sans_sc_16_2bpp.bin [build/font_subset.bin ...]
+任一字体不能直接映射时返回 1。
+"""
+
+import argparse
+import struct
+import sys
+
+from font_subset import CMAP_TABLE_FMT, CMAP_TABLE_SIZE, HEADER_FIELDS, HEADER_FMT, HEADER_SIZE, BitReader
+
+CMAP_FORMAT0_FULL = 0
+CMAP_SPARSE_FULL = 1
+CMAP_FORMAT0_TINY = 2
+CMAP_SPARSE_TINY = 3
+
+GLYPH_BITMAP_INDEX_MAX = 1 << 20  # 字形描述中 bitmap_index 只有 20 位
+CMAP_MAX = 511                    # cmap_num 是 9 位位域
+COMPRESSION_PLAIN = 0
+
+
+def read_label(data, start, label):
+    """与 mmap_read_label 一致，返回段长度 (含段头)，失败返回 -1"""
+    if start + 8 > len(data):
+        return -1
+    length, tag = struct.unpack_from("<I4s", data, start)
+    if tag != label.encode() or length < 8 or start + length > len(data):
+        return -1
+    return length
+
+
+def check_font(data):
+    """返回 (能否直接映射, 说明)"""
+    head_len = read_label(data, 0, "head")
+    if head_len < 8 + HEADER_SIZE:
+        return False, "invalid head section"
+    header = dict(zip(HEADER_FIELDS, struct.unpack_from(HEADER_FMT, data, 8)))
+    nbits = header["advance_width_bits"] + 2 * header["xy_bits"] + 2 * header["wh_bits"]
+
+    cmap_start = head_len
+    cmap_len = read_label(data, cmap_start, "cmap")
+    if cmap_len < 12:
+        return False, "invalid cmap section"
+    (cmap_count,) = struct.unpack_from("<I", data, cmap_start + 8)
+    if cmap_count == 0 or cmap_count > CMAP_MAX or 12 + cmap_count * CMAP_TABLE_SIZE > cmap_len:
+        return False, f"bad cmap table count {cmap_count}"
+    for i in range(cmap_count):
+        data_offset, _, _, _, entries, fmt, _ = struct.unpack_from(
+            CMAP_TABLE_FMT, data, cmap_start + 12 + i * CMAP_TABLE_SIZE)
+        sizes = {CMAP_FORMAT0_FULL: entries, CMAP_FORMAT0_TINY: 0,
+                 CMAP_SPARSE_TINY: 2 * entries, CMAP_SPARSE_FULL: 4 * entries}
+        if fmt not in sizes:
+            return False, f"cmap {i}: unsupported format {fmt}"
+        if data_offset > cmap_len or sizes[fmt] > cmap_len - data_offset:
+            return False, f"cmap {i}: data out of section (offset {data_offset}, format {fmt})"
+
+    loca_start = cmap_start + cmap_len
+    loca_len = read_label(data, loca_start, "loca")
+    if loca_len < 12:
+        return False, "invalid loca section"
+    (loca_count,) = struct.unpack_from("<I", data, loca_start + 8)
+    if header["index_to_loc_format"] > 1:
+        return False, f"unsupported index_to_loc_format {header['index_to_loc_format']}"
+    entry = 2 if header["index_to_loc_format"] == 0 else 4
+    if loca_count == 0 or 12 + loca_count * entry > loca_len:
+        return False, f"bad loca count {loca_count}"
+    offsets = struct.unpack_from(f"<{loca_count}{'H' if entry == 2 else 'I'}", data, loca_start + 12)
+
+    glyf_start = loca_start + loca_len
+    glyf_len = read_label(data, glyf_start, "glyf")
+    if glyf_len < 0:
+        return False, "invalid glyf section"
+    lvgl_bitmap = nbits % 8 == 0 and glyf_len <= GLYPH_BITMAP_INDEX_MAX
+    if not lvgl_bitmap and header["compression_id"] != COMPRESSION_PLAIN:
+        return False, (f"compressed bitmaps with a {nbits}-bit glyph header and {glyf_len}-byte glyf "
+                       "section are not supported")
+
+    bpp = header["bits_per_pixel"]
+    for gid in range(1, loca_count):
+        offset = offsets[gid]
+        if offset + (nbits + 7) // 8 > glyf_len:
+            return False, f"glyph {gid}: header out of glyf section"
+        br = BitReader(data, glyf_start + offset)
+        br.read(header["advance_width_bits"] + 2 * header["xy_bits"])
+        box_w = br.read(header["wh_bits"])
+        box_h = br.read(header["wh_bits"])
+        if header["compression_id"] == COMPRESSION_PLAIN and offset * 8 + nbits + box_w * box_h * bpp > glyf_len * 8:
+            return False, f"glyph {gid}: bitmap out of glyf section"
+
+    path = "LVGL bitmaps" if lvgl_bitmap else "bitmaps read through loca"
+    return True, f"{loca_count} glyphs, {bpp} bpp, {nbits}-bit glyph header, glyf {glyf_len} bytes, {path}"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="检查字体能否被固件直接映射加载")
+    parser.add_argument("fonts", nargs="+", help="LVGL .bin 字体")
+    args = parser.parse_args()
+
+    ok = True
+    for path in args.fonts:
+        with open(path, "rb") as f:
+            direct, detail = check_font(f.read())
+        print(f"font_mmap_check: {path}: {'mmap direct' if direct else 'FALLBACK to lv_font_load'} ({detail})")
+        ok = ok and direct
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,333 @@
+#!/usr/bin/env python3
+"""
+字体子集生成工具
+扫描 UI 源码中的字符串常量，从 LVGL 二进制字体 (lv_font_conv 生成的 .bin) 中
+抽取用到的字形，生成只包含这些字符的子集字体。
+
+输出的字形头会被重新编码为按字节对齐，固件可以直接从 flash 映射使用 (不拷贝)。
+子集中不包含的字符由固件回退到 font 分区中的完整字体显示。
+
+用法:
+    python font_subset.py --font font/font_noto_sans_sc_16_2bpp.bin \
+        --src "main/UI/*.c" --out build/font_subset.bin
+"""
+
+import argparse
+import glob
+import struct
+import sys
+
+HEADER_FMT = "<IHHHhHhHhhHHBBBBBBBBBBhH"
+HEADER_SIZE = struct.calcsize(HEADER_FMT)  # 40
+HEADER_FIELDS = (
+    "version", "tables_count", "font_size", "ascent", "descent", "typo_ascent",
+    "typo_descent", "typo_line_gap", "min_y", "max_y", "default_advance_width",
+    "kerning_scale", "index_to_loc_format", "glyph_id_format", "advance_width_format",
+    "bits_per_pixel", "xy_bits", "wh_bits", "advance_width_bits", "compression_id",
+    "subpixels_mode", "padding", "underline_position", "underline_thickness",
+)
+CMAP_TABLE_FMT = "<IIHHHBB"
+CMAP_TABLE_SIZE = struct.calcsize(CMAP_TABLE_FMT)  # 16
+
+CMAP_FORMAT0_FULL = 0
+CMAP_SPARSE_FULL = 1
+CMAP_FORMAT0_TINY = 2
+CMAP_SPARSE_TINY = 3
+
+
+# ==================== 字符串扫描 ====================
+
+def _decode_escapes(body):
+    """处理字符串常量中的转义，只关心最终的字符"""
+    out = []
+    i = 0
+    while i < len(body):
+        c = body[i]
+        if c != "\\" or i + 1 >= len(body):
+            out.append(c)
+            i += 1
+            continue
+        n = body[i + 1]
+        if n in "uU":
+            width = 4 if n == "u" else 8
+            try:
+                out.append(chr(int(body[i + 2:i + 2 + width], 16)))
+            except ValueError:
+                pass
+            i += 2 + width
+        elif n == "x":
+            j = i + 2
+            while j < len(body) and body[j] in "0123456789abcdefABCDEF":
+                j += 1
+            i = j  # 十六进制转义多为字节序列，忽略
+        else:
+            out.append({"n": "\n", "t": "\t", "r": "\r"}.get(n, n))
+            i += 2
+    return "".join(out)
+
+
+def extract_strings(text):
+    """提取C源码中的字符串常量 (跳过注释和字符常量)"""
+    strings = []
+    i = 0
+    length = len(text)
+    while i < length:
+        c = text[i]
+        if text.startswith("//", i):
+            j = text.find("\n", i)
+            i = length if j < 0 else j
+        elif text.startswith("/*", i):
+            j = text.find("*/", i + 2)
+            i = length if j < 0 else j + 2
+        elif c == "'":
+            j = i + 1
+            while j < length and text[j] != "'":
+                j += 2 if text[j] == "\\" else 1
+            i = j + 1
+        elif c == '"':
+            j = i + 1
+            while j < length and text[j] != '"':
+                j += 2 if text[j] == "\\" else 1
+            strings.append(_decode_escapes(text[i + 1:j]))
+            i = j + 1
+        else:
+            i += 1
+    return strings
+
+
+def collect_codepoints(patterns, extra_chars):
+    codepoints = set(range(0x20, 0x7F))  # 始终保留可打印ASCII
+    files = []
+    for pattern in patterns:
+        files.extend(sorted(glob.glob(pattern)))
+    for path in files:
+        with open(path, "r", encoding="utf-8", errors="ignore") as f:
+            for s in extract_strings(f.read()):
+                codepoints.update(ord(ch) for ch in s if ord(ch) >= 0x20)
+    codepoints.update(ord(ch) for ch in extra_chars)
+    return codepoints, files
+
+
+# ==================== 二进制字体读写 ====================
+
+class BitReader:
+    def __init__(self, data, offset):
+        self.data = data
+        self.bit_pos = offset * 8
+
+    def read(self, n):
+        value = 0
+        for _ in range(n):
+            byte = self.data[self.bit_pos >> 3]
+            value = (value << 1) | ((byte >> (7 - (self.bit_pos & 7))) & 1)
+            self.bit_pos += 1
+        return value
+
+    def read_signed(self, n):
+        value = self.read(n)
+        if n and value & (1 << (n - 1)):
+            value -= 1 << n
+        return value
+
+
+class BitWriter:
+    def __init__(self):
+        self.bits = []
+
+    def write(self, value, n):
+        value &= (1 << n) - 1 if n else 0
+        for k in range(n - 1, -1, -1):
+            self.bits.append((value >> k) & 1)
+
+    def to_bytes(self):
+        bits = self.bits + [0] * (-len(self.bits) % 8)
+        out = bytearray()
+        for k in range(0, len(bits), 8):
+            byte = 0
+            for b in bits[k:k + 8]:
+                byte = (byte << 1) | b
+            out.append(byte)
+        return bytes(out)
+
+
+def read_section(data, start, label):
+    length, tag = struct.unpack_from("<I4s", data, start)
+    if tag != label.encode():
+        raise ValueError(f"expected section '{label}' at 0x{start:X}, got {tag!r}")
+    return length
+
+
+def load_font(data):
+    head_len = read_section(data, 0, "head")
+    header = dict(zip(HEADER_FIELDS, struct.unpack_from(HEADER_FMT, data, 8)))
+
+    # cmap: 码点 -> 字形ID
+    cmap_start = head_len
+    cmap_len = read_section(data, cmap_start, "cmap")
+    (cmap_count,) = struct.unpack_from("<I", data, cmap_start + 8)
+    glyph_of = {}
+    for i in range(cmap_count):
+        data_offset, range_start, range_length, glyph_id_start, entries, fmt, _ = struct.unpack_from(
+            CMAP_TABLE_FMT, data, cmap_start + 12 + i * CMAP_TABLE_SIZE)
+        base = cmap_start + data_offset
+        if fmt == CMAP_FORMAT0_TINY:
+            for k in range(range_length):
+                glyph_of[range_start + k] = glyph_id_start + k
+        elif fmt == CMAP_FORMAT0_FULL:
+            for k in range(range_length):
+                ofs = data[base + k]
+                if ofs or k == 0:
+                    glyph_of[range_start + k] = glyph_id_start + ofs
+        elif fmt in (CMAP_SPARSE_TINY, CMAP_SPARSE_FULL):
+            unicode_list = struct.unpack_from(f"<{entries}H", data, base)
+            if fmt == CMAP_SPARSE_FULL:
+                ofs_list = struct.unpack_from(f"<{entries}H", data, base + 2 * entries)
+            else:
+                ofs_list = range(entries)
+            for u, ofs in zip(unicode_list, ofs_list):
+                glyph_of[range_start + u] = glyph_id_start + ofs
+        else:
+            raise ValueError(f"unsupported cmap format {fmt}")
+
+    # loca
+    loca_start = cmap_start + cmap_len
+    loca_len = read_section(data, loca_start, "loca")
+    (loca_count,) = struct.unpack_from("<I", data, loca_start + 8)
+    if header["index_to_loc_format"] == 0:
+        offsets = list(struct.unpack_from(f"<{loca_count}H", data, loca_start + 12))
+    else:
+        offsets = list(struct.unpack_from(f"<{loca_count}I", data, loca_start + 12))
+
+    # glyf
+    glyf_start = loca_start + loca_len
+    glyf_len = read_section(data, glyf_start, "glyf")
+    offsets.append(glyf_len)
+
+    return header, glyph_of, offsets, glyf_start
+
+
+def decode_glyph(data, header, glyf_start, offsets, gid):
+    """解码字形头，返回 (adv_w, ofs_x, ofs_y, box_w, box_h, 点阵位流)"""
+    start = glyf_start + offsets[gid]
+    end = glyf_start + offsets[gid + 1]
+    br = BitReader(data, start)
+    aw_bits = header["advance_width_bits"]
+    adv_w = br.read(aw_bits) if aw_bits else header["default_advance_width"]
+    ofs_x = br.read_signed(header["xy_bits"])
+    ofs_y = br.read_signed(header["xy_bits"])
+    box_w = br.read(header["wh_bits"])
+    box_h = br.read(header["wh_bits"])
+    bitmap_bits = [(data[p >> 3] >> (7 - (p & 7))) & 1 for p in range(br.bit_pos, end * 8)]
+    return adv_w, ofs_x, ofs_y, box_w, box_h, bitmap_bits
+
+
+def aligned_adv_bits(header):
+    """选择 advance_width_bits 使字形头总位数为 8 的倍数，点阵因而按字节对齐"""
+    xy, wh = header["xy_bits"], header["wh_bits"]
+    aw = header["advance_width_bits"]
+    min_aw = aw if aw else max(1, header["default_advance_width"].bit_length())
+    aw = min_aw
+    while (aw + 2 * xy + 2 * wh) % 8:
+        aw += 1
+    return aw
+
+
+def build_cmaps(codepoints):
+    """把排好序的码点分成若干个 sparse tiny 表 (range_length 和表内偏移都是 16 位，表跨度不超过 0xFFFF)"""
+    groups = []
+    for cp in codepoints:
+        if groups and cp - groups[-1][0] < 0xFFFF:
+            groups[-1].append(cp)
+        else:
+            groups.append([cp])
+    return groups
+
+
+def write_font(header, glyphs, codepoints):
+    """glyphs: 按新字形ID顺序排列的 (adv_w, ofs_x, ofs_y, box_w, box_h, bits)，第0个为空字形"""
+    aw_bits = aligned_adv_bits(header)
+    xy, wh = header["xy_bits"], header["wh_bits"]
+
+    # glyf
+    glyf = bytearray()
+    offsets = []
+    for adv_w, ofs_x, ofs_y, box_w, box_h, bits in glyphs:
+        offsets.append(8 + len(glyf))
+        bw = BitWriter()
+        bw.write(adv_w, aw_bits)
+        bw.write(ofs_x, xy)
+        bw.write(ofs_y, xy)
+        bw.write(box_w, wh)
+        bw.write(box_h, wh)
+        bw.bits.extend(bits)
+        glyf += bw.to_bytes()
+    glyf += b"\0" * (-len(glyf) % 4)
+    glyf_sec = struct.pack("<I4s", 8 + len(glyf), b"glyf") + glyf
+
+    # loca (32位偏移)
+    loca = struct.pack("<I", len(offsets)) + struct.pack(f"<{len(offsets)}I", *offsets)
+    loca_sec = struct.pack("<I4s", 8 + len(loca), b"loca") + loca
+
+    # cmap
+    groups = build_cmaps(codepoints)
+    tables = bytearray()
+    payload = bytearray()
+    payload_base = 12 + CMAP_TABLE_SIZE * len(groups)
+    glyph_id = 1
+    for group in groups:
+        range_start = group[0]
+        tables += struct.pack(CMAP_TABLE_FMT, payload_base + len(payload), range_start,
+                              group[-1] - range_start + 1, glyph_id, len(group), CMAP_SPARSE_TINY, 0)
+        payload += struct.pack(f"<{len(group)}H", *[cp - range_start for cp in group])
+        payload += b"\0" * (-len(payload) % 4)
+        glyph_id += len(group)
+    cmap = struct.pack("<I", len(groups)) + tables + payload
+    cmap_sec = struct.pack("<I4s", 8 + len(cmap), b"cmap") + cmap
+
+    # head: 去掉 kern 表，偏移改为32位，字形头对齐
+    new_header = dict(header)
+    new_header.update(tables_count=3, index_to_loc_format=1, advance_width_bits=aw_bits)
+    head = struct.pack(HEADER_FMT, *[new_header[k] for k in HEADER_FIELDS])
+    head += b"\0" * (-len(head) % 4)
+    head_sec = struct.pack("<I4s", 8 + len(head), b"head") + head
+
+    return head_sec + cmap_sec + loca_sec + glyf_sec
+
+
+def main():
+    parser = argparse.ArgumentParser(description="根据UI字符串生成LVGL子集字体")
+    parser.add_argument("--font", required=True, help="完整字体 (LVGL .bin 格式，与 font 分区中的一致)")
+    parser.add_argument("--src", action="append", default=[], help="扫描的源文件通配符，可多次指定")
+    parser.add_argument("--chars", default="", help="额外需要包含的字符")
+    parser.add_argument("--out", required=True, help="输出的子集字体文件")
+    args = parser.parse_args()
+
+    patterns = args.src or ["main/UI/*.c"]
+    wanted, files = collect_codepoints(patterns, args.chars)
+
+    with open(args.font, "rb") as f:
+        data = f.read()
+    header, glyph_of, offsets, glyf_start = load_font(data)
+
+    codepoints = sorted(cp for cp in wanted if cp in glyph_of)
+    missing = sorted(cp for cp in wanted if cp not in glyph_of and cp >= 0x80)
+
+    glyphs = [(0, 0, 0, 0, 0, [])]
+    for cp in codepoints:
+        glyphs.append(decode_glyph(data, header, glyf_start, offsets, glyph_of[cp]))
+
+    out = write_font(header, glyphs, codepoints)
+    with open(args.out, "wb") as f:
+        f.write(out)
+
+    print(f"font_subset: {len(files)} files, {len(codepoints)} glyphs, "
+          f"{len(data)} -> {len(out)} bytes ({args.out})")
+    if missing:
+        # 字体中没有的字符(比如图标字体的私有区码点)由其他字体负责，这里只提示
+        print(f"font_subset: {len(missing)} code points not in source font, e.g. "
+              + " ".join(f"U+{cp:04X}" for cp in missing[:8]))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
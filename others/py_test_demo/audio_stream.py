@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+音频流公共定义：TCP流头、麦克风UDP包头和IMA-ADPCM编解码
+与 main/app/inc/audio_codec.h、audio_mic_stream.h 保持一致，供 test_audio_sender.py 和 mic_udp_receiver.py 使用。
+"""
+
+import struct
+
+# 流头，与 audio_codec.h 的 audio_stream_header_t 一致
+STREAM_HEADER = struct.Struct("<IBBBBIHH")
+STREAM_MAGIC = 0x53445541  # "AUDS"
+STREAM_VERSION = 1
+CODEC_PCM16 = 0
+CODEC_IMA_ADPCM = 1
+FLAG_MIC_UPLINK = 1 << 0
+FLAG_LOOPBACK = 1 << 1
+
+ADPCM_BLOCK_BYTES = 256
+ADPCM_SAMPLES_PER_BLOCK = 1 + (ADPCM_BLOCK_BYTES - 4) * 2
+
+# 麦克风上行UDP包头，与 audio_mic_stream.h 的 mic_packet_header_t 一致
+MIC_UDP_PORT = 7558
+MIC_PACKET_HEADER = struct.Struct("<IIIHBBI")
+MIC_PACKET_MAGIC = 0x5343494D  # "MICS"
+
+IMA_STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88,
+    97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+    724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660,
+    4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818,
+    18500, 20350, 22385, 24623, 27086, 29794, 32767]
+IMA_INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8]
+
+
+def adpcm_encode(pcm_data):
+    """编码为单声道IMA-ADPCM块（与WAV相同的块格式），最后一块补零，返回块列表"""
+    samples = struct.unpack(f"<{len(pcm_data) // 2}h", pcm_data[:len(pcm_data) // 2 * 2])
+    blocks = []
+    index = 0
+    for base in range(0, len(samples), ADPCM_SAMPLES_PER_BLOCK):
+        block_samples = list(samples[base:base + ADPCM_SAMPLES_PER_BLOCK])
+        block_samples += [0] * (ADPCM_SAMPLES_PER_BLOCK - len(block_samples))
+        predictor = block_samples[0]
+        block = bytearray(struct.pack("<hBB", predictor, index, 0))
+        nibbles = []
+        for sample in block_samples[1:]:
+            step = IMA_STEP_TABLE[index]
+            diff = sample - predictor
+            nibble = 0
+            if diff < 0:
+                nibble = 8
+                diff = -diff
+            vpdiff = step >> 3
+            if diff >= step:
+                nibble |= 4
+                diff -= step
+                vpdiff += step
+            step >>= 1
+            if diff >= step:
+                nibble |= 2
+                diff -= step
+                vpdiff += step
+            step >>= 1
+            if diff >= step:
+                nibble |= 1
+                vpdiff += step
+            predictor = predictor - vpdiff if nibble & 8 else predictor + vpdiff
+            predictor = max(-32768, min(32767, predictor))
+            index = max(0, min(88, index + IMA_INDEX_TABLE[nibble]))
+            nibbles.append(nibble)
+        block += bytes(nibbles[i] | (nibbles[i + 1] << 4) for i in range(0, len(nibbles), 2))
+        blocks.append(bytes(block))
+    return blocks
+
+
+def adpcm_decode_block(block):
+    """解码一个单声道IMA-ADPCM块，返回样本列表"""
+    predictor, index = struct.unpack_from("<hB", block)
+    index = min(index, 88)
+    out = [predictor]
+    for byte in block[4:]:
+        for nibble in (byte & 0x0F, byte >> 4):
+            step = IMA_STEP_TABLE[index]
+            diff = step >> 3
+            if nibble & 4:
+                diff += step
+            if nibble & 2:
+                diff += step >> 1
+            if nibble & 1:
+                diff += step >> 2
+            predictor = predictor - diff if nibble & 8 else predictor + diff
+            predictor = max(-32768, min(32767, predictor))
+            index = max(0, min(88, index + IMA_INDEX_TABLE[nibble]))
+            out.append(predictor)
+    return out
+
+
+def pack_stream_header(codec, sample_rate, flags=0):
+    """生成16字节TCP流头"""
+    if codec == CODEC_IMA_ADPCM:
+        return STREAM_HEADER.pack(STREAM_MAGIC, STREAM_VERSION, codec, 1, flags, sample_rate,
+                                  ADPCM_BLOCK_BYTES, ADPCM_SAMPLES_PER_BLOCK)
+    return STREAM_HEADER.pack(STREAM_MAGIC, STREAM_VERSION, codec, 1, flags, sample_rate, 0, 0)
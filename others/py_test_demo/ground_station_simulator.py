@@ -13,6 +13,11 @@ FRAME_HEADER = 0xAA55
 FRAME_TYPE_REMOTE_CONTROL = 0x01
 FRAME_TYPE_TELEMETRY = 0x02
 FRAME_TYPE_HEARTBEAT = 0x03
+FRAME_TYPE_TASK_STATS = 0x05
+
+# 任务统计帧: 必须与C语言中的 task_stats_payload_t / task_stats_entry_t 完全匹配
+TASK_STATS_HEADER_FMT = '<IIHHHIIBB'
+TASK_STATS_ENTRY_FMT = '<10sHHB'
 
 # CRC16 Modbus
 crc16_func = crcmod.predefined.mkPredefinedCrcFun('modbus')
@@ -82,11 +87,32 @@ def parse_and_handle_frame(data):
         status, = struct.unpack('<B', payload)
         status_map = {0: "空闲", 1: "正常运行", 2: "错误"}
         print(f"收到心跳: 设备状态={status_map.get(status, '未知')}")
+    elif frame_type == FRAME_TYPE_TASK_STATS:
+        print_task_stats(payload)
     else:
         print(f"收到未知类型的帧: {frame_type}")
         
     return True
 
+def print_task_stats(payload):
+    """ 打印任务统计帧 (每个核的负载、空闲内存、CPU占用最高的任务) """
+    header_size = struct.calcsize(TASK_STATS_HEADER_FMT)
+    entry_size = struct.calcsize(TASK_STATS_ENTRY_FMT)
+    (seq, timestamp_ms, period_ms, load0, load1, free_internal, free_psram,
+     task_count, entry_count) = struct.unpack(TASK_STATS_HEADER_FMT, payload[:header_size])
+
+    print(f"收到任务统计 #{seq} t={timestamp_ms}ms 周期={period_ms}ms 任务数={task_count}")
+    print(f"    Core0 {load0 / 10:.1f}%  Core1 {load1 / 10:.1f}%  "
+          f"内部RAM空闲 {free_internal} B  PSRAM空闲 {free_psram} B")
+    for i in range(entry_count):
+        offset = header_size + i * entry_size
+        name, cpu, stack_free, core_prio = struct.unpack(TASK_STATS_ENTRY_FMT, payload[offset:offset + entry_size])
+        core = core_prio >> 6
+        core_str = "-" if core == 3 else str(core)
+        task_name = name.rstrip(b'\0').decode(errors='replace')
+        print(f"    {task_name:<10} {cpu / 10:5.1f}%  "
+              f"栈剩余 {stack_free:5d} B  核 {core_str}  优先级 {core_prio & 0x3F}")
+
 # ----------------- TCP 客户端任务 -----------------
 
 def sender_task(sock, stop_event):
@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+麦克风上行接收测试
+连接设备的音频TCP端口并在流头里请求麦克风上行，接收设备发回的UDP包，按序号统计丢包和乱序，
+解码后保存为WAV。加 --loopback 时设备进入回环测量模式（播放静音和周期性的咔嗒声），
+打印设备测得的扬声器到麦克风延迟。
+
+用法:
+    python mic_udp_receiver.py 192.168.1.100 --seconds 20 --wav mic.wav
+    python mic_udp_receiver.py 192.168.1.100 --codec pcm --loopback
+"""
+
+import argparse
+import os
+import socket
+import statistics
+import struct
+import sys
+import time
+import wave
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from audio_stream import (CODEC_IMA_ADPCM, CODEC_PCM16, FLAG_LOOPBACK, FLAG_MIC_UPLINK,  # noqa: E402
+                          MIC_PACKET_HEADER, MIC_PACKET_MAGIC, MIC_UDP_PORT, adpcm_decode_block,
+                          pack_stream_header)
+
+AUDIO_TCP_PORT = 7557
+SAMPLE_RATE = 44100
+
+
+class SequenceTracker:
+    """按包序号统计丢包、乱序和重复"""
+
+    def __init__(self):
+        self.expected = None
+        self.received = 0
+        self.lost = 0
+        self.late = 0
+
+    def update(self, seq):
+        """返回本包之前缺失的包数，迟到或重复的包返回 None"""
+        self.received += 1
+        if self.expected is None:
+            self.expected = seq + 1
+            return 0
+        if seq < self.expected:
+            # 迟到的包之前已按丢失补了静音，这里只计数
+            self.late += 1
+            return None
+        gap = seq - self.expected
+        self.lost += gap
+        self.expected = seq + 1
+        return gap
+
+
+def main():
+    parser = argparse.ArgumentParser(description="麦克风上行接收测试")
+    parser.add_argument("device", help="设备IP")
+    parser.add_argument("--codec", choices=["adpcm", "pcm"], default="adpcm", help="上行编码")
+    parser.add_argument("--loopback", action="store_true", help="回环延迟测量模式")
+    parser.add_argument("--seconds", type=float, default=10.0, help="接收时长")
+    parser.add_argument("--wav", help="保存解码后的音频")
+    args = parser.parse_args()
+
+    codec = CODEC_IMA_ADPCM if args.codec == "adpcm" else CODEC_PCM16
+    flags = FLAG_MIC_UPLINK | (FLAG_LOOPBACK if args.loopback else 0)
+
+    udp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    udp.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    udp.bind(("0.0.0.0", MIC_UDP_PORT))
+    udp.settimeout(0.2)
+
+    # 上行随TCP连接存在，连接期间不发送音频，设备只播放静音
+    tcp = socket.create_connection((args.device, AUDIO_TCP_PORT), timeout=5)
+    tcp.sendall(pack_stream_header(codec, SAMPLE_RATE, flags))
+    print(f"Connected to {args.device}:{AUDIO_TCP_PORT}, uplink {args.codec}"
+          f"{', loopback' if args.loopback else ''}, listening on UDP {MIC_UDP_PORT}")
+
+    tracker = SequenceTracker()
+    pcm = bytearray()
+    loopback_values = []
+    last_loopback = 0
+    total_bytes = 0
+    window_bytes = 0
+    window_packets = 0
+    start = time.time()
+    window_start = start
+
+    try:
+        while time.time() - start < args.seconds:
+            try:
+                data, _ = udp.recvfrom(4096)
+            except socket.timeout:
+                continue
+            if len(data) < MIC_PACKET_HEADER.size:
+                continue
+            magic, seq, timestamp, samples, pkt_codec, _, loopback_us = MIC_PACKET_HEADER.unpack_from(data)
+            if magic != MIC_PACKET_MAGIC:
+                continue
+            payload = data[MIC_PACKET_HEADER.size:]
+            total_bytes += len(data)
+            window_bytes += len(data)
+            window_packets += 1
+
+            gap = tracker.update(seq)
+            if gap is not None:
+                pcm += bytes(gap * samples * 2)  # 丢失的帧补静音，保持时间轴
+                if pkt_codec == CODEC_IMA_ADPCM:
+                    pcm += struct.pack(f"<{samples}h", *adpcm_decode_block(payload)[:samples])
+                else:
+                    pcm += payload[:samples * 2]
+
+            if loopback_us and loopback_us != last_loopback:
+                last_loopback = loopback_us
+                loopback_values.append(loopback_us / 1000)
+                print(f"  loopback {loopback_us / 1000:.2f} ms")
+
+            now = time.time()
+            if now - window_start >= 1.0:
+                print(f"  {now - start:5.1f}s  {window_packets / (now - window_start):5.1f} pkt/s  "
+                      f"{window_bytes * 8 / (now - window_start) / 1000:6.1f} kbit/s  "
+                      f"lost {tracker.lost}  late {tracker.late}")
+                window_bytes = 0
+                window_packets = 0
+                window_start = now
+    finally:
+        tcp.close()
+        udp.close()
+
+    elapsed = time.time() - start
+    expected = tracker.received - tracker.late + tracker.lost
+    print(f"\n{tracker.received} packets, {total_bytes} bytes in {elapsed:.1f}s "
+          f"({total_bytes * 8 / elapsed / 1000:.1f} kbit/s)")
+    if expected:
+        print(f"lost {tracker.lost} ({tracker.lost * 100 / expected:.2f}%), late/duplicate {tracker.late}")
+    if loopback_values:
+        print(f"loopback {len(loopback_values)} samples: min {min(loopback_values):.2f} "
+              f"median {statistics.median(loopback_values):.2f} max {max(loopback_values):.2f} ms")
+
+    if args.wav and pcm:
+        with wave.open(args.wav, "wb") as wav:
+            wav.setnchannels(1)
+            wav.setsampwidth(2)
+            wav.setframerate(SAMPLE_RATE)
+            wav.writeframes(bytes(pcm))
+        print(f"saved {len(pcm) // 2 / SAMPLE_RATE:.1f}s to {args.wav}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+SPI2 总线仲裁策略模型
+在主机上模拟 ST7789 像素流 (8KB 分块、4 级 DMA 流水线) 与 XPT2046 触摸采样共用总线，
+比较两种策略下的触摸等待时间和显示吞吐：
+  buslock - 只依赖 SPI 驱动的总线锁，触摸要等到整块像素流结束
+  yield   - spi_bus_arbiter 的策略，显示在分块边界发现触摸等待时排空在途事务后让出
+
+yield 策略的触摸最大等待时间应不超过 队列深度 x 分块传输时间 + 一次触摸事务，
+超出时脚本返回非零退出码。
+
+用法:
+    python spi_bus_arbiter_model.py --frames 300 --seed 1
+"""
+
+import argparse
+import random
+import sys
+
+DISPLAY_CLOCK_HZ = 80_000_000
+TOUCH_CLOCK_HZ = 2_000_000
+TRANS_OVERHEAD_US = 8.0          # 每个SPI事务的软件/中断开销
+TOUCH_BITS = 72                  # xpt2046_read_sample 的一次9字节传输
+TOUCH_PERIOD_US = 10_000         # 按下期间的采样周期
+DISP_WIDTH = 240
+DISP_HEIGHT = 320                # LVGL 使用整屏绘制缓冲，一次刷新即一个脏区域
+
+
+def chunk_time_us(nbytes):
+    return nbytes * 8 * 1e6 / DISPLAY_CLOCK_HZ + TRANS_OVERHEAD_US
+
+
+def touch_time_us():
+    return TOUCH_BITS * 1e6 / TOUCH_CLOCK_HZ + TRANS_OVERHEAD_US
+
+
+def make_workload(frames, seed):
+    """生成显示刷新序列 (开始时间, 字节数) 和触摸请求时间"""
+    rng = random.Random(seed)
+    flushes = []
+    t = 0.0
+    for _ in range(frames):
+        t += rng.uniform(2_000, 16_000)  # 渲染时间
+        # 脏区域：多数是局部控件，偶尔整屏 (切换页面、滚动)
+        dirty_rows = rng.choice([16, 24, 40, 64, 120, DISP_HEIGHT])
+        dirty_cols = DISP_WIDTH if dirty_rows >= 120 else rng.choice([60, 120, DISP_WIDTH])
+        flushes.append((t, dirty_cols * dirty_rows * 2))
+        t += rng.uniform(300, 1_500)
+    end = t
+
+    touches = []
+    t = rng.uniform(0, 50_000)
+    while t < end:
+        press_len = rng.uniform(100_000, 600_000)
+        s = t
+        while s < min(t + press_len, end):
+            touches.append(s + rng.uniform(-300, 300))
+            s += TOUCH_PERIOD_US
+        t += press_len + rng.uniform(50_000, 400_000)
+    touches.sort()
+    return flushes, touches
+
+
+def simulate(flushes, touches, chunk, depth, policy):
+    tt = touch_time_us()
+    bus_free = 0.0
+    waits = []
+    display_stall = 0.0
+    display_busy = 0.0
+    ti = 0
+
+    def serve_touches_until(t_limit):
+        """总线空闲期间到达的触摸请求立即服务"""
+        nonlocal ti, bus_free
+        while ti < len(touches) and touches[ti] <= t_limit:
+            start = max(touches[ti], bus_free)
+            waits.append(start - touches[ti])
+            bus_free = start + tt
+            ti += 1
+
+    for flush_start, nbytes in flushes:
+        serve_touches_until(flush_start)
+        t = max(flush_start, bus_free)
+        first = t
+        completions = []
+        left = nbytes
+        while left > 0:
+            # 队列满时等最早的事务完成空出slot
+            if len(completions) >= depth:
+                t = max(t, completions[-depth])
+            # 分块边界的让出检查 (只在 yield 策略下)，与 st7789_write_bytes_async 一致在空出slot后检查
+            if policy == "yield" and ti < len(touches) and touches[ti] <= t:
+                drained = max(completions[-1] if completions else t, t)
+                start = max(drained, bus_free)
+                waits.append(start - touches[ti])
+                bus_free = start + tt
+                display_stall += tt
+                ti += 1
+                t = bus_free
+                completions = []
+            n = min(chunk, left)
+            start = max(t, bus_free)
+            bus_free = start + chunk_time_us(n)
+            completions.append(bus_free)
+            left -= n
+        # 整块像素流结束后总线锁释放，之前到达的触摸请求排队执行
+        display_busy += bus_free - first
+        serve_touches_until(bus_free)
+
+    serve_touches_until(float("inf"))
+    return waits, display_stall, display_busy
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(len(ordered) * p / 100))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="SPI2 总线仲裁策略模型")
+    parser.add_argument("--frames", type=int, default=300, help="模拟的帧数")
+    parser.add_argument("--seed", type=int, default=1, help="随机种子")
+    parser.add_argument("--chunk", type=int, default=8192, help="DMA分块字节数 (ST7789_DMA_CHUNK_BYTES)")
+    parser.add_argument("--depth", type=int, default=4, help="DMA队列深度 (ST7789_DMA_QUEUE_DEPTH)")
+    args = parser.parse_args()
+
+    flushes, touches = make_workload(args.frames, args.seed)
+    bound = args.depth * chunk_time_us(args.chunk) + touch_time_us()
+
+    print(f"flushes={len(flushes)} touch_samples={len(touches)} "
+          f"chunk={args.chunk}B depth={args.depth} bound={bound:.0f}us")
+    print(f"{'policy':<8} {'avg':>8} {'p99':>8} {'max':>8} {'disp stall':>11} {'disp busy':>10}")
+
+    ok = True
+    for policy in ("buslock", "yield"):
+        waits, stall, busy = simulate(flushes, touches, args.chunk, args.depth, policy)
+        avg = sum(waits) / len(waits) if waits else 0.0
+        worst = max(waits) if waits else 0.0
+        print(f"{policy:<8} {avg:>6.0f}us {percentile(waits, 99):>6.0f}us {worst:>6.0f}us "
+              f"{stall / 1000:>9.2f}ms {busy / 1000:>8.1f}ms")
+        if policy == "yield" and worst > bound + 1e-6:
+            print(f"FAIL: yield policy touch wait {worst:.0f}us exceeds bound {bound:.0f}us")
+            ok = False
+
+    if ok:
+        print("PASS: touch wait bounded under yield policy")
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
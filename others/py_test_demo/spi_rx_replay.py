@@ -0,0 +1,480 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+SPI 从机接收路径回放工具
+按 spi_slave_receiver.c / jpeg_stream_encoder.c 的逻辑在主机上重放 SPI 事务流：
+事务分类和截断、AA55 命令帧跨事务续接、像素块 CRC 校验和按帧号拼帧，
+输出与固件 spirx 命令和 "Pixel stream" 日志同名的统计。
+
+抓包文件格式：按片选划分的事务依次存放，每个事务为 [长度:4B 小端][数据]，
+可由逻辑分析仪的 SPI 解码结果导出，也可以用 --generate 生成。
+
+用法:
+    # 生成带故障注入的合成抓包并回放，统计与预期不符时返回非零退出码
+    python spi_rx_replay.py --selftest
+    # 回放抓包，按固件的事务大小截断
+    python spi_rx_replay.py capture.bin --trans-size 16384 --dump-frames frames/
+    # 生成一段干净的抓包
+    python spi_rx_replay.py --generate capture.bin --frames 30
+    # 时序模型：主机连续发送、接收端偶发调度延迟时，不同队列深度和事务大小的溢出情况
+    python spi_rx_replay.py --timing --configs 2x512,4x4096,4x16384,8x32768
+"""
+
+import argparse
+import os
+import random
+import struct
+import sys
+
+# 与 spi_slave_receiver.h / jpeg_stream_encoder.h / pixel_stream_protocol.h 保持一致
+DEFAULT_QUEUE_SIZE = 4
+DEFAULT_TRANS_SIZE = 16 * 1024
+FRAME_WIDTH = 240
+FRAME_HEIGHT = 188
+FRAME_BPP = 2  # PIXEL_FORMAT_RGB565
+FRAME_STRIDE = FRAME_WIDTH * FRAME_BPP
+FRAME_SIZE = FRAME_STRIDE * FRAME_HEIGHT
+
+PIXEL_MAGIC = b"\xa5\x5a"
+PIXEL_FLAG_SOF = 0x01
+PIXEL_FLAG_EOF = 0x02
+PIXEL_FORMAT_RGBA8888 = 0
+PIXEL_FORMAT_RGB565 = 1
+PIXEL_HEADER = struct.Struct("<2sHBBHHHH")  # pixel_block_header_t，14 字节
+PIXEL_CRC_START = 4                          # offsetof(pixel_block_header_t, flags)
+
+FRAME_HEADER = b"\xaa\x55"
+FRAME_TYPE_COMMAND = 0x01
+FRAME_TYPE_TELEMETRY = 0x02
+FRAME_TYPE_HEARTBEAT = 0x03
+FRAME_TYPE_EXTENDED = 0x04
+PROTOCOL_HEADER_SIZE = 4  # protocol_header_t
+MIN_FRAME_SIZE = 7
+
+
+def crc16_modbus(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+# ==================== 发送端：生成事务流 ====================
+
+def build_command_frame(frame_type, payload):
+    """AA55 命令帧：[AA 55][length=1+N][type][payload][CRC 小端]，CRC 覆盖 length 到负载结束"""
+    body = bytes([1 + len(payload), frame_type]) + payload
+    return FRAME_HEADER + body + struct.pack("<H", crc16_modbus(body))
+
+
+def build_pixel_blocks(frame_id, frame, block_payload, fmt=PIXEL_FORMAT_RGB565):
+    """把一帧切成按顺序发送的像素块"""
+    blocks = []
+    pos = 0
+    while pos < len(frame):
+        n = min(block_payload, len(frame) - pos)
+        flags = 0
+        if pos == 0:
+            flags |= PIXEL_FLAG_SOF
+        if pos + n == len(frame):
+            flags |= PIXEL_FLAG_EOF
+        line, offset = divmod(pos, FRAME_STRIDE)
+        payload = frame[pos:pos + n]
+        tail = struct.pack("<BBHHHH", flags, fmt, frame_id & 0xFFFF, line, offset, n) + payload
+        blocks.append(PIXEL_MAGIC + struct.pack("<H", crc16_modbus(tail)) + tail)
+        pos += n
+    return blocks
+
+
+def pack_transactions(blocks, trans_size):
+    """按主机的做法把块装进事务：块不跨事务，装不下就开始新事务"""
+    transactions = []
+    cur = b""
+    for blk in blocks:
+        if cur and len(cur) + len(blk) > trans_size:
+            transactions.append(cur)
+            cur = b""
+        cur += blk
+    if cur:
+        transactions.append(cur)
+    return transactions
+
+
+def make_frame(rng):
+    # 渐变加噪声，避免全零数据掩盖偏移错误
+    row = bytes(rng.randrange(256) for _ in range(FRAME_STRIDE))
+    return b"".join(row[y % FRAME_STRIDE:] + row[:y % FRAME_STRIDE] for y in range(FRAME_HEIGHT))
+
+
+def block_payload_for(trans_size):
+    # 每个事务装满整数个块，最大 4KB 一块
+    return min(4096, trans_size) - PIXEL_HEADER.size
+
+
+# ==================== 接收端：回放模型 ====================
+
+class SpiRxModel:
+    """spi_rx_task + jpeg_encode_feed_task 的主机端模型"""
+
+    def __init__(self, trans_size, dump_dir=None):
+        self.trans_size = trans_size
+        self.dump_dir = dump_dir
+        self.stats = dict(transactions=0, bytes=0, pixel_transactions=0, command_transactions=0,
+                          truncated=0, underruns=0, commands_ok=0, commands_bad=0,
+                          frames_encoded=0, frames_dropped=0, crc_errors=0, blocks_skipped=0,
+                          format_mismatch=0)
+        self.parse_buf = b""
+        self.frame_active = False
+        self.frame_id = 0
+        self.frame = bytearray()
+
+    # ---- spi_rx_account ----
+    def feed_transaction(self, data):
+        st = self.stats
+        st["transactions"] += 1
+        if len(data) > self.trans_size:
+            st["truncated"] += 1
+            data = data[:self.trans_size]
+        st["bytes"] += len(data)
+        is_pixel = data[:2] == PIXEL_MAGIC
+        if not data or (is_pixel and len(data) < PIXEL_HEADER.size):
+            st["underruns"] += 1
+            return
+        if is_pixel:
+            st["pixel_transactions"] += 1
+            self.parse_buf = b""  # 命令帧不会跨到像素事务中
+            self.feed_blocks(data)
+        else:
+            st["command_transactions"] += 1
+            self.parse_commands(data)
+
+    # ---- spi_parse_and_dispatch / spi_parse_carry ----
+    @staticmethod
+    def command_frame_size(header):
+        return 3 + header[2] + 2
+
+    def dispatch(self, frame):
+        ok = (len(frame) >= MIN_FRAME_SIZE and frame[:2] == FRAME_HEADER
+              and frame[3] in (FRAME_TYPE_COMMAND, FRAME_TYPE_TELEMETRY, FRAME_TYPE_HEARTBEAT, FRAME_TYPE_EXTENDED)
+              and len(frame) == self.command_frame_size(frame)
+              and struct.unpack_from("<H", frame, len(frame) - 2)[0] == crc16_modbus(frame[2:-2]))
+        self.stats["commands_ok" if ok else "commands_bad"] += 1
+
+    def parse_commands(self, data):
+        pos = 0
+        if self.parse_buf:
+            buf = self.parse_buf
+            take = 0
+            if len(buf) < PROTOCOL_HEADER_SIZE:
+                take = min(PROTOCOL_HEADER_SIZE - len(buf), len(data))
+                buf += data[:take]
+                if len(buf) < PROTOCOL_HEADER_SIZE:
+                    self.parse_buf = buf
+                    return
+            if buf[:2] != FRAME_HEADER:
+                self.parse_buf = b""
+                take = 0
+            else:
+                size = self.command_frame_size(buf)
+                more = min(size - len(buf), len(data) - take)
+                buf += data[take:take + more]
+                take += more
+                if len(buf) == size:
+                    self.dispatch(buf)
+                    self.parse_buf = b""
+                else:
+                    self.parse_buf = buf
+                    return
+            pos = take
+
+        while pos < len(data):
+            if data[pos] != 0xAA or (pos + 1 < len(data) and data[pos + 1] != 0x55):
+                pos += 1
+                continue
+            if pos + PROTOCOL_HEADER_SIZE > len(data):
+                break
+            size = self.command_frame_size(data[pos:pos + PROTOCOL_HEADER_SIZE])
+            if pos + size > len(data):
+                break
+            self.dispatch(data[pos:pos + size])
+            pos += size
+        self.parse_buf = data[pos:]
+
+    # ---- jpeg_feed_blocks / jpeg_place_block ----
+    def frame_abort(self):
+        if self.frame_active:
+            self.stats["frames_dropped"] += 1
+        self.frame_active = False
+        self.frame = bytearray()
+
+    def feed_blocks(self, data):
+        pos = 0
+        while pos + PIXEL_HEADER.size <= len(data):
+            if data[pos:pos + 2] != PIXEL_MAGIC:
+                break
+            hdr = PIXEL_HEADER.unpack_from(data, pos)
+            length = hdr[7]
+            size = PIXEL_HEADER.size + length
+            if length == 0 or pos + size > len(data):
+                self.stats["crc_errors"] += 1
+                self.frame_abort()
+                break
+            self.place_block(hdr, data[pos:pos + size])
+            pos += size
+
+    def place_block(self, hdr, block):
+        _, crc, flags, fmt, frame_id, line, offset, length = hdr
+        st = self.stats
+        if crc16_modbus(block[PIXEL_CRC_START:]) != crc:
+            st["crc_errors"] += 1
+            self.frame_abort()
+            return
+        if flags & PIXEL_FLAG_SOF:
+            self.frame_abort()
+            if fmt != PIXEL_FORMAT_RGB565:
+                st["format_mismatch"] += 1
+                return
+            self.frame_active = True
+            self.frame_id = frame_id
+        elif not self.frame_active:
+            st["blocks_skipped"] += 1
+            return
+        elif frame_id != self.frame_id:
+            self.frame_abort()
+            st["blocks_skipped"] += 1
+            return
+
+        at = line * FRAME_STRIDE + offset
+        if offset >= FRAME_STRIDE or at != len(self.frame) or at + length > FRAME_SIZE:
+            self.frame_abort()
+            return
+        completes = at + length == FRAME_SIZE
+        if flags & PIXEL_FLAG_EOF and not completes:
+            self.frame_abort()
+            return
+        self.frame += block[PIXEL_HEADER.size:]
+        if completes:
+            st["frames_encoded"] += 1
+            if self.dump_dir:
+                path = os.path.join(self.dump_dir, f"frame_{st['frames_encoded']:05d}_{self.frame_id}.rgb565")
+                with open(path, "wb") as f:
+                    f.write(self.frame)
+            self.frame_active = False
+            self.frame = bytearray()
+
+
+# ==================== 抓包读写 ====================
+
+def write_capture(path, transactions):
+    with open(path, "wb") as f:
+        for t in transactions:
+            f.write(struct.pack("<I", len(t)))
+            f.write(t)
+
+
+def read_capture(path):
+    transactions = []
+    with open(path, "rb") as f:
+        while True:
+            head = f.read(4)
+            if len(head) < 4:
+                break
+            (n,) = struct.unpack("<I", head)
+            data = f.read(n)
+            if len(data) < n:
+                print(f"WARN: capture truncated in last transaction ({len(data)}/{n} bytes)")
+                transactions.append(data)
+                break
+            transactions.append(data)
+    return transactions
+
+
+def generate_clean(frames, trans_size, seed):
+    rng = random.Random(seed)
+    payload = block_payload_for(trans_size)
+    transactions = []
+    for fid in range(frames):
+        transactions += pack_transactions(build_pixel_blocks(fid, make_frame(rng), payload), trans_size)
+    return transactions
+
+
+# ==================== 自检 ====================
+
+def selftest(trans_size, seed):
+    """构造已知故障的事务流，检查回放统计与预期一致"""
+    rng = random.Random(seed)
+    payload = block_payload_for(trans_size)
+    nblocks = (FRAME_SIZE + payload - 1) // payload
+    drop_at, corrupt_at = 3, 5
+    transactions = []
+
+    def send_frame(fid, fmt=PIXEL_FORMAT_RGB565, drop=None, corrupt=None):
+        blocks = build_pixel_blocks(fid, make_frame(rng), payload, fmt)
+        if corrupt is not None:
+            b = bytearray(blocks[corrupt])
+            b[-1] ^= 0xFF
+            blocks[corrupt] = bytes(b)
+        if drop is not None:
+            del blocks[drop]
+        transactions.extend(pack_transactions(blocks, trans_size))
+
+    heartbeat = build_command_frame(FRAME_TYPE_HEARTBEAT, struct.pack("<BI", 1, 123456))
+    extended = build_command_frame(FRAME_TYPE_EXTENDED, bytes([0x10, 2, 0x01, 0x02]))
+
+    send_frame(0)
+    send_frame(1, drop=drop_at)
+    send_frame(2, corrupt=corrupt_at)
+    # 命令帧跨两个命令事务，第二个事务里紧跟一个完整命令帧
+    transactions.append(b"\x00" * 8 + heartbeat[:3])
+    transactions.append(heartbeat[3:] + extended)
+    send_frame(3)
+    send_frame(4, fmt=PIXEL_FORMAT_RGBA8888)
+    transactions.append(b"")                        # 片选抖动的空事务
+    transactions.append(b"\x00" * (trans_size + 100))  # 超过事务缓冲的发送
+    send_frame(5)
+
+    model = SpiRxModel(trans_size)
+    for t in transactions:
+        model.feed_transaction(t)
+
+    expected = dict(
+        frames_encoded=3,
+        frames_dropped=2,
+        crc_errors=1,
+        format_mismatch=1,
+        # 丢块后下一块触发放弃，其后的块都在等待 SOF；CRC 错误块本身触发放弃；格式不符的整帧跳过
+        blocks_skipped=(nblocks - 1 - (drop_at + 1)) + (nblocks - 1 - corrupt_at) + (nblocks - 1),
+        commands_ok=2,
+        commands_bad=0,
+        underruns=1,
+        truncated=1,
+    )
+    print_stats(model.stats, trans_size)
+    ok = True
+    for key, want in expected.items():
+        got = model.stats[key]
+        if got != want:
+            print(f"FAIL: {key} = {got}, expected {want}")
+            ok = False
+    if ok:
+        print(f"PASS: {len(transactions)} transactions replayed, stats match")
+    return ok
+
+
+# ==================== 时序模型 ====================
+
+def simulate_timing(queue_size, trans_size, frames, sclk_hz, gap_us, overhead_us, us_per_kb,
+                    hiccup_prob, hiccup_us, seed):
+    """
+    主机按固定 SCLK 连续发送，每个事务之间留 gap_us 的片选间隔。接收端每个事务必须在开始前
+    已排队，否则整段数据丢失（固件 spirx 的“队列空”只统计排空次数，是这里丢失数的上限）。
+    处理任务按顺序处理完成的缓冲，处理时间为固定开销加按字节的 CRC/复制开销，偶尔被更高优先级任务延迟 hiccup_us。
+    """
+    rng = random.Random(seed)
+    payload = block_payload_for(trans_size)
+    per_frame = [len(t) for t in pack_transactions(
+        build_pixel_blocks(0, bytes(FRAME_SIZE), payload), trans_size)]
+
+    free_at = [0.0] * queue_size  # 每个缓冲重新排队的时间
+    consumer_free = 0.0
+    t = 0.0
+    lost = 0
+    lost_frames = 0
+    total = 0
+    min_queued = queue_size
+    for _ in range(frames):
+        frame_lost = False
+        for nbytes in per_frame:
+            total += 1
+            ready = [i for i, ft in enumerate(free_at) if ft <= t]
+            min_queued = min(min_queued, len(ready))
+            duration = nbytes * 8 * 1e6 / sclk_hz
+            if not ready:
+                lost += 1
+                frame_lost = True
+                t += duration + gap_us
+                continue
+            # 驱动按排队顺序使用缓冲
+            idx = min(ready, key=lambda i: free_at[i])
+            done = t + duration
+            start = max(done, consumer_free)
+            service = overhead_us + nbytes / 1024 * us_per_kb
+            if rng.random() < hiccup_prob:
+                service += hiccup_us
+            consumer_free = start + service
+            free_at[idx] = consumer_free
+            t = done + gap_us
+        lost_frames += frame_lost
+    elapsed_s = t / 1e6
+    return dict(lost=lost, total=total, lost_frames=lost_frames, min_queued=min_queued,
+                fps=(frames - lost_frames) / elapsed_s if elapsed_s > 0 else 0.0)
+
+
+def run_timing(args):
+    print(f"sclk={args.sclk / 1e6:.0f}MHz gap={args.gap_us}us overhead={args.overhead_us}us "
+          f"cost={args.us_per_kb}us/KB hiccup={args.hiccup_us}us@{args.hiccup_prob * 100:.1f}%")
+    print(f"{'config':<10} {'trans':>7} {'lost':>8} {'lost fr':>8} {'minq':>5} {'fps':>6}")
+    for cfg in args.configs.split(","):
+        depth, size = (int(v) for v in cfg.lower().split("x"))
+        r = simulate_timing(depth, size, args.frames, args.sclk, args.gap_us, args.overhead_us,
+                            args.us_per_kb, args.hiccup_prob, args.hiccup_us, args.seed)
+        print(f"{cfg:<10} {r['total']:>7} {r['lost']:>8} {r['lost_frames']:>8} {r['min_queued']:>5} "
+              f"{r['fps']:>6.1f}")
+    return True
+
+
+# ==================== 入口 ====================
+
+def print_stats(st, trans_size):
+    print(f"trans_size={trans_size}B transactions={st['transactions']} "
+          f"(pixel {st['pixel_transactions']}, command {st['command_transactions']}) bytes={st['bytes']}")
+    print(f"truncated={st['truncated']} underruns={st['underruns']} "
+          f"commands ok={st['commands_ok']} bad={st['commands_bad']}")
+    print(f"frames encoded={st['frames_encoded']} dropped={st['frames_dropped']} crc_errors={st['crc_errors']} "
+          f"blocks_skipped={st['blocks_skipped']} format_mismatch={st['format_mismatch']}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="SPI 从机接收路径回放")
+    parser.add_argument("capture", nargs="?", help="抓包文件，每个事务为 [长度:4B 小端][数据]")
+    parser.add_argument("--trans-size", type=int, default=DEFAULT_TRANS_SIZE, help="SPI_RX_TRANSACTION_SZ")
+    parser.add_argument("--dump-frames", metavar="DIR", help="把拼好的帧写成 .rgb565 文件")
+    parser.add_argument("--generate", metavar="OUT", help="生成干净的合成抓包")
+    parser.add_argument("--selftest", action="store_true", help="故障注入回放自检")
+    parser.add_argument("--timing", action="store_true", help="队列深度/事务大小时序模型")
+    parser.add_argument("--configs", default="2x512,4x4096,4x16384,8x32768", help="时序模型配置，深度x字节")
+    parser.add_argument("--frames", type=int, default=30, help="生成或模拟的帧数")
+    parser.add_argument("--sclk", type=float, default=40e6, help="主机 SCLK 频率")
+    parser.add_argument("--gap-us", type=float, default=5.0, help="事务间片选间隔")
+    parser.add_argument("--overhead-us", type=float, default=40.0, help="每个事务的中断/唤醒/重新排队开销")
+    parser.add_argument("--us-per-kb", type=float, default=60.0, help="拼帧任务每KB的CRC和复制时间")
+    parser.add_argument("--hiccup-prob", type=float, default=0.01, help="处理被延迟的概率")
+    parser.add_argument("--hiccup-us", type=float, default=3000.0, help="一次延迟的时长")
+    parser.add_argument("--seed", type=int, default=1, help="随机种子")
+    args = parser.parse_args()
+
+    if args.selftest:
+        return 0 if selftest(args.trans_size, args.seed) else 1
+    if args.timing:
+        return 0 if run_timing(args) else 1
+    if args.generate:
+        transactions = generate_clean(args.frames, args.trans_size, args.seed)
+        write_capture(args.generate, transactions)
+        print(f"wrote {len(transactions)} transactions ({args.frames} frames) to {args.generate}")
+        return 0
+    if not args.capture:
+        parser.error("需要抓包文件，或使用 --selftest / --timing / --generate")
+
+    if args.dump_frames:
+        os.makedirs(args.dump_frames, exist_ok=True)
+    model = SpiRxModel(args.trans_size, args.dump_frames)
+    for t in read_capture(args.capture):
+        model.feed_transaction(t)
+    print_stats(model.stats, args.trans_size)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,19 +1,45 @@
 # test_audio_sender.py
 # 用于测试发送MP3解码后的PCM数据到ESP32
+# 可选IMA-ADPCM压缩（约4:1），连接后先发16字节流头协商编码，格式见 main/app/inc/audio_codec.h
 # 依赖: pip install pydub
 # 还需要安装ffmpeg: https://ffmpeg.org/download.html
 
 import socket
 import sys
+import time
 from pydub import AudioSegment
 import os
 import tkinter as tk
-from tkinter import filedialog, simpledialog
+from tkinter import filedialog, messagebox, simpledialog
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from audio_stream import (ADPCM_SAMPLES_PER_BLOCK, CODEC_IMA_ADPCM, CODEC_PCM16, adpcm_encode,  # noqa: E402
+                          pack_stream_header)
 
 ESP32_IP = "192.168.76.247"
 
 # 采样率（与ESP32一致）
 SAMPLE_RATE = 44100
+BYTES_PER_SECOND = SAMPLE_RATE * 2
+
+# 按实时速率发送，只领先播放进度这么多秒；一次性灌满时设备的抖动缓冲会一直顶在高水位，
+# 测不出真实的延迟和欠载
+SEND_LEAD_SECONDS = 0.2
+
+def build_chunks(pcm_data, use_adpcm):
+    """返回 (流头, [(数据, 样本数)])，每个分块约4KB线上字节或约2048个样本"""
+    if use_adpcm:
+        blocks = adpcm_encode(pcm_data)
+        header = pack_stream_header(CODEC_IMA_ADPCM, SAMPLE_RATE)
+        per_chunk = 8
+        chunks = [(b"".join(blocks[i:i + per_chunk]), len(blocks[i:i + per_chunk]) * ADPCM_SAMPLES_PER_BLOCK)
+                  for i in range(0, len(blocks), per_chunk)]
+    else:
+        header = pack_stream_header(CODEC_PCM16, SAMPLE_RATE)
+        chunk_size = 4096
+        chunks = [(pcm_data[i:i + chunk_size], len(pcm_data[i:i + chunk_size]) // 2)
+                  for i in range(0, len(pcm_data), chunk_size)]
+    return header, chunks
 
 def send_audio():
     root = tk.Tk()
@@ -46,18 +72,33 @@ def send_audio():
 
     print(f"Audio loaded: {len(pcm_data)} bytes, sample rate: {SAMPLE_RATE}")
 
+    use_adpcm = messagebox.askyesno("编码", "使用IMA-ADPCM压缩发送？（约4:1）")
+    t0 = time.perf_counter()
+    header, chunks = build_chunks(pcm_data, use_adpcm)
+    encode_seconds = time.perf_counter() - t0
+    duration = len(pcm_data) / BYTES_PER_SECOND
+    wire_bytes = len(header) + sum(len(data) for data, _ in chunks)
+    print(f"{'IMA-ADPCM' if use_adpcm else 'PCM16'}: {wire_bytes} bytes on wire, "
+          f"{wire_bytes * 8 / duration / 1000:.0f} kbit/s, ratio {len(pcm_data) / wire_bytes:.2f}:1, "
+          f"encode {encode_seconds:.2f}s for {duration:.1f}s audio")
+
     # 创建TCP socket
     with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as sock:
         try:
             sock.connect((ESP32_IP, ESP32_PORT))
             print(f"Connected to {ESP32_IP}:{ESP32_PORT}")
 
-            # 分块发送数据
-            chunk_size = 4096
-            for i in range(0, len(pcm_data), chunk_size):
-                chunk = pcm_data[i:i + chunk_size]
-                sock.sendall(chunk)
-                print(f"Sent {len(chunk)} bytes")
+            # 先发流头，再按实时速率分块发送
+            sock.sendall(header)
+            sent_samples = 0
+            start = time.monotonic()
+            for data, samples in chunks:
+                ahead = sent_samples / SAMPLE_RATE - (time.monotonic() - start)
+                if ahead > SEND_LEAD_SECONDS:
+                    time.sleep(ahead - SEND_LEAD_SECONDS)
+                sock.sendall(data)
+                sent_samples += samples
+            print(f"Sent {wire_bytes} bytes in {time.monotonic() - start:.1f}s")
 
             print("All data sent")
         except Exception as e:
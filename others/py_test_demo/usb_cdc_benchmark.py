@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+USB CDC 像素流吞吐测试
+向接收端的 USB CDC 端口连续发送 pixel_stream_protocol.h 格式的 RGB565 帧，测量持续写入速率。
+设备读得慢时 USB 会 NAK，主机写入随之变慢，所以主机侧的写入速率就是设备的接收速率。
+前后各发送一次 usbrx 命令，打印设备侧计数以便核对编码丢弃和重新同步。
+
+ESP32-S3 是 USB 全速设备，批量传输上限约 1.1 MB/s，即 240x188 RGB565 约 12 fps。
+
+依赖: pip install pyserial
+
+用法:
+    python usb_cdc_benchmark.py COM5 --seconds 20
+    python usb_cdc_benchmark.py /dev/ttyACM0 --block 8192 --write-size 65536
+"""
+
+import argparse
+import os
+import random
+import statistics
+import sys
+import time
+
+try:
+    import serial
+except ImportError:
+    print("需要 pyserial: pip install pyserial")
+    sys.exit(1)
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from spi_rx_replay import FRAME_SIZE, PIXEL_HEADER, build_pixel_blocks, make_frame  # noqa: E402
+
+USB_RX_CHUNK_SIZE = 16 * 1024  # 与 usb_device_receiver.h 一致，单块不能超过该大小
+
+
+def send_command(port, line, wait=0.3):
+    """发送一行命令并返回设备回复的文本行"""
+    port.reset_input_buffer()
+    port.write((line + "\r\n").encode())
+    port.flush()
+    deadline = time.time() + wait
+    data = b""
+    while time.time() < deadline:
+        data += port.read(port.in_waiting or 1)
+    return [ln for ln in data.decode("utf-8", errors="replace").splitlines() if ln.strip()]
+
+
+def build_stream(frames, block_payload, seed):
+    """预先生成若干帧的块流循环发送（Python 算 CRC 跟不上 USB 速率），接收端只要求同一帧内帧号一致"""
+    rng = random.Random(seed)
+    return [b"".join(build_pixel_blocks(fid, make_frame(rng), block_payload)) for fid in range(frames)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="USB CDC 像素流吞吐测试")
+    parser.add_argument("port", help="串口名，例如 COM5 或 /dev/ttyACM0")
+    parser.add_argument("--seconds", type=float, default=10.0, help="测试时长")
+    parser.add_argument("--block", type=int, default=4096, help="像素块总字节数（含14字节块头）")
+    parser.add_argument("--write-size", type=int, default=64 * 1024, help="每次 write 的字节数")
+    parser.add_argument("--warmup", type=float, default=1.0, help="不计入统计的开头秒数")
+    parser.add_argument("--keep-vout", action="store_true", help="不关闭设备的 USB 图传输出")
+    parser.add_argument("--seed", type=int, default=1, help="随机种子")
+    args = parser.parse_args()
+
+    if not PIXEL_HEADER.size < args.block <= USB_RX_CHUNK_SIZE:
+        parser.error(f"--block 必须在 {PIXEL_HEADER.size + 1}..{USB_RX_CHUNK_SIZE} 之间")
+    payload = args.block - PIXEL_HEADER.size
+
+    port = serial.Serial(args.port, 115200, timeout=0.05, write_timeout=5)
+    port.dtr = True
+    port.rts = True
+    time.sleep(0.2)
+
+    if not args.keep_vout:
+        # 编码后的帧默认也从 USB 回传，会和本测试抢带宽并混入回复
+        for ln in send_command(port, "vout usb off"):
+            print(f"< {ln}")
+    before = send_command(port, "usbrx")
+
+    frames = build_stream(8, payload, args.seed)
+    print(f"block={args.block}B write={args.write_size}B frame={FRAME_SIZE}B, 发送 {args.seconds:.0f}s ...")
+
+    total = 0
+    frame_id = 0
+    window_bytes = 0
+    window_start = time.time()
+    start = window_start
+    samples = []
+    pending = b""
+    stalled = False
+    while time.time() - start < args.seconds:
+        if len(pending) < args.write_size:
+            pending += frames[frame_id % len(frames)]
+            frame_id += 1
+        chunk, pending = pending[:args.write_size], pending[args.write_size:]
+        try:
+            port.write(chunk)
+        except serial.SerialTimeoutException:
+            stalled = True
+            print("设备停止读取（写入超时）")
+            break
+        total += len(chunk)
+        window_bytes += len(chunk)
+        now = time.time()
+        if now - window_start >= 1.0:
+            rate = window_bytes / (now - window_start) / 1e6
+            if now - start > args.warmup:
+                samples.append(rate)
+            print(f"  {now - start:5.1f}s  {rate:6.3f} MB/s")
+            window_bytes = 0
+            window_start = now
+    if pending and not stalled:
+        # 把最后一帧发完，否则设备会把之后的命令当作未收完的块负载
+        port.write(pending)
+        total += len(pending)
+    port.flush()
+    elapsed = time.time() - start
+    time.sleep(0.5)  # 等设备处理完 FIFO 中的数据
+
+    print(f"\n总计 {total / 1e6:.2f} MB / {elapsed:.1f}s = {total / elapsed / 1e6:.3f} MB/s, "
+          f"{frame_id} 帧")
+    if samples:
+        sustained = statistics.median(samples)
+        print(f"持续速率(中位数) {sustained:.3f} MB/s, 最低 {min(samples):.3f} MB/s, "
+              f"约 {sustained * 1e6 / (FRAME_SIZE * (1 + PIXEL_HEADER.size / payload)):.1f} fps")
+
+    print("\n设备统计（测试前）:")
+    for ln in before:
+        print(f"  {ln}")
+    print("设备统计（测试后）:")
+    for ln in send_command(port, "usbrx"):
+        print(f"  {ln}")
+    port.close()
+    return 1 if stalled else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())